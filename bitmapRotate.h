@@ -0,0 +1,171 @@
+#ifndef BITMAP_ROTATE_H
+#define BITMAP_ROTATE_H
+
+#include <stdint.h>
+#include <stddef.h>     // size_t
+#include <pthread.h>    // Optional worker threads
+
+#include "transpose.h"
+#include "diagToHorizontal.h" // reverseBitsLUT
+
+// Transposing & rotating 1 bit-per-pixel images of any size.
+// Pixel 'x' of a row is bit 'x % 8' of byte 'x / 8' (same as a bitboard: LSB is the left), rows are 'stride' bytes apart.
+//
+// The image is cut into 8x8 tiles, each gathered from 8 rows into a u64 so it can be transposed like a bitboard.
+// The transposed tile's bytes are then the rows of the output, so they are scattered one byte per row.
+// Rotating by 90 or 270 only changes the order of the gathered rows or the scattered rows.
+
+// Clockwise, the output is 'height' pixels wide and 'width' tall (except 180)
+enum BitmapRotation {
+    BITMAP_TRANSPOSE,
+    BITMAP_ROT90,
+    BITMAP_ROT180,
+    BITMAP_ROT270,
+};
+
+// A block of tiles is done before moving on, so the 8*64 input rows (and output rows) it touches stay in cache.
+// 64 bytes is a cache line: with a 64-byte aligned 'dst' & 'dstStride', threads never write to the same line
+#define BITMAP_BLOCK_TILES 64
+
+typedef struct {
+    const uint8_t *src; size_t srcStride;
+    uint8_t *dst;       size_t dstStride;
+    size_t width, height;
+    enum BitmapRotation rotation;
+    size_t firstBlock, endBlock; // Rows of blocks (or pixel rows for 180)
+} BitmapRotateJob;
+
+
+// Tile row 'tileY' starts at 'y0', which is negative when rotating by 90 so the output bytes stay aligned
+static inline void bitmapRotate_tileRow(const BitmapRotateJob *job, const size_t tileY, const size_t firstTileX, const size_t endTileX) {
+    const size_t padY = (job->rotation == BITMAP_ROT90)? (8 - job->height % 8) % 8 : 0;
+    const size_t tilesTall = (job->height + 7) / 8;
+    const ptrdiff_t y0 = (ptrdiff_t)(tileY * 8) - (ptrdiff_t)padY;
+
+    uint64_t tiles[BITMAP_BLOCK_TILES] = {0};
+    const size_t tileCount = endTileX - firstTileX;
+
+    // Rotating by 90 is a transpose of the vertically flipped image, so the rows are gathered in reverse
+    for (size_t i = 0; i < tileCount; i++) {
+        uint64_t tile = 0;
+        for (size_t r = 0; r < 8; r++) {
+            const ptrdiff_t y = y0 + (ptrdiff_t)r;
+            if (y < 0 || y >= (ptrdiff_t)job->height)
+                continue;
+
+            const uint64_t row = job->src[(size_t)y * job->srcStride + firstTileX + i];
+            tile |= row << 8*((job->rotation == BITMAP_ROT90)? 7 - r : r);
+        }
+        tiles[i] = tile;
+    }
+
+    diagTranspose_batch(tiles, tiles, tileCount);
+
+    // Byte 'c' of a transposed tile is column 'x0 + c', the bits past the width are never written
+    const size_t dstByte = (job->rotation == BITMAP_ROT90)? tilesTall - 1 - tileY : tileY;
+    for (size_t i = 0; i < tileCount; i++) {
+        const size_t x0 = (firstTileX + i) * 8;
+
+        for (size_t c = 0; c < 8 && x0 + c < job->width; c++) {
+            // Rotating by 270 is a vertical flip of the transpose
+            const size_t dstRow = (job->rotation == BITMAP_ROT270)? job->width - 1 - (x0 + c) : x0 + c;
+            job->dst[dstRow * job->dstStride + dstByte] = (uint8_t)(tiles[i] >> 8*c);
+        }
+    }
+}
+
+// Both the order of the rows and of the bits in them are reversed. Pixels past the width are the lowest bits
+// once reversed, so the row is shifted down by the padding.
+static inline void bitmapRotate_180Row(const BitmapRotateJob *job, const size_t y) {
+    const size_t rowBytes = (job->width + 7) / 8;
+    const unsigned padX = (8 - job->width % 8) % 8;
+    const uint8_t lastMask = (uint8_t)(UINT8_MAX >> padX);
+
+    const uint8_t *srcRow = job->src + y * job->srcStride;
+    uint8_t *dstRow = job->dst + (job->height - 1 - y) * job->dstStride;
+
+    for (size_t j = 0; j < rowBytes; j++) {
+        // Reversed row's byte 'j' (& the one above it) from the source's byte 'rowBytes-1 - j'
+        const size_t srcIdx = rowBytes - 1 - j;
+        const uint8_t srcLo = (srcIdx == rowBytes - 1)? srcRow[srcIdx] & lastMask : srcRow[srcIdx];
+
+        unsigned reversed = reverseBitsLUT[srcLo] >> padX;
+        if (srcIdx > 0)
+            reversed |= (unsigned)reverseBitsLUT[srcRow[srcIdx - 1]] << (8 - padX);
+
+        dstRow[j] = (uint8_t)reversed;
+    }
+}
+
+static inline void *bitmapRotate_worker(void *jobPtr) {
+    const BitmapRotateJob *job = (const BitmapRotateJob*)jobPtr;
+
+    if (job->rotation == BITMAP_ROT180) {
+        for (size_t y = job->firstBlock; y < job->endBlock; y++)
+            bitmapRotate_180Row(job, y);
+        return NULL;
+    }
+
+    // Rows of 8x8 tiles (including the padding needed by 90) & the bytes of each
+    const size_t tilesTall = (job->height + 7) / 8;
+    const size_t tilesWide = (job->width + 7) / 8;
+
+    for (size_t block = job->firstBlock; block < job->endBlock; block++) {
+        const size_t firstTileY = block * BITMAP_BLOCK_TILES;
+        const size_t endTileY = (firstTileY + BITMAP_BLOCK_TILES < tilesTall)? firstTileY + BITMAP_BLOCK_TILES : tilesTall;
+
+        for (size_t firstTileX = 0; firstTileX < tilesWide; firstTileX += BITMAP_BLOCK_TILES) {
+            const size_t endTileX = (firstTileX + BITMAP_BLOCK_TILES < tilesWide)? firstTileX + BITMAP_BLOCK_TILES : tilesWide;
+
+            for (size_t tileY = firstTileY; tileY < endTileY; tileY++)
+                bitmapRotate_tileRow(job, tileY, firstTileX, endTileX);
+        }
+    }
+    return NULL;
+}
+
+
+// 'threads' <= 1 runs on the calling thread. 'dst' must not overlap 'src'.
+// Returns 0 on success, or the error from 'pthread_create' (the work is still finished on this thread)
+static inline int bitmapRotate(
+    const uint8_t *src, const size_t srcStride, uint8_t *dst, const size_t dstStride,
+    const size_t width, const size_t height, const enum BitmapRotation rotation, unsigned threads
+) {
+    enum {MAX_THREADS = 64};
+    BitmapRotateJob jobs[MAX_THREADS];
+    pthread_t workers[MAX_THREADS];
+
+    // Threads split by rows of blocks, so they write disjoint bytes of the output. Their cache lines are only
+    // disjoint too when 'dst' & 'dstStride' are 64-byte aligned, otherwise neighbours share the lines at their edges
+    const size_t workItems = (rotation == BITMAP_ROT180)
+        ? height
+        : ((height + 7) / 8 + BITMAP_BLOCK_TILES - 1) / BITMAP_BLOCK_TILES;
+
+    if (threads > MAX_THREADS) threads = MAX_THREADS;
+    if (threads > workItems) threads = (unsigned)workItems;
+    if (threads == 0) threads = 1;
+
+    for (unsigned t = 0; t < threads; t++) {
+        jobs[t] = (BitmapRotateJob){src, srcStride, dst, dstStride, width, height, rotation,
+            workItems * t / threads, workItems * (t + 1) / threads};
+    }
+
+    int error = 0;
+    unsigned started = 1;
+    for (; started < threads; started++) {
+        error = pthread_create(&workers[started], NULL, bitmapRotate_worker, &jobs[started]);
+        if (error) break;
+    }
+
+    bitmapRotate_worker(&jobs[0]);
+    for (unsigned t = 1; t < started; t++)
+        pthread_join(workers[t], NULL);
+
+    // Whatever couldn't be given to a thread
+    for (unsigned t = started; t < threads; t++)
+        bitmapRotate_worker(&jobs[t]);
+
+    return error;
+}
+
+#endif
@@ -0,0 +1,154 @@
+#ifndef BOARD_GEOMETRY_H
+#define BOARD_GEOMETRY_H
+
+#include <stdint.h>
+#include <limits.h>     // For masking
+
+#include "cpuFeatures.h"    // DIAG_IS_CONSTANT & DIAG_INLINE
+#ifdef DIAG_X86
+#include <emmintrin.h>  // SSE2
+#endif
+
+// Diagonal shifts, extract & deposit for boards other than 8x8, e.g. 4x4, 6x6, 7x7 or 8x4 packed into one word.
+// Row 'r' is bits 'r*W' to 'r*W + W-1' (so the 8x8 layout when W = 8), up to 8 columns and 8 rows.
+//
+// Every mask & multiplier is a constant expression of W & H, so 'BOARD_GEOMETRY(name, type, W, H)' defines
+// kernels with only constants in them: the same instructions as the hand-written 8x8 ones, nothing is looked up at runtime.
+// Bits of the word past the board are ignored by the kernels and are 0 in their results.
+
+// ==================
+//       Masks
+// ==================
+#define GEOM_ROW(W)             ((1ULL << (W)) - 1)
+// Row 'r' in place, 0 past the top (every generator goes up to 8 rows)
+#define GEOM_ROW_AT(W, H, r)    (((r) < (H))? GEOM_ROW(W) << (((r) < (H))? (r)*(W) : 0) : 0)
+#define GEOM_FOR_ROWS(W, H, rowMacro, ...) ( \
+    rowMacro(W, H, 0, __VA_ARGS__) | rowMacro(W, H, 1, __VA_ARGS__) | rowMacro(W, H, 2, __VA_ARGS__) | rowMacro(W, H, 3, __VA_ARGS__) | \
+    rowMacro(W, H, 4, __VA_ARGS__) | rowMacro(W, H, 5, __VA_ARGS__) | rowMacro(W, H, 6, __VA_ARGS__) | rowMacro(W, H, 7, __VA_ARGS__))
+
+#define GEOM_BOARD_ROW(W, H, r, unused) GEOM_ROW_AT(W, H, r)
+#define GEOM_BOARD(W, H)        GEOM_FOR_ROWS(W, H, GEOM_BOARD_ROW, 0)
+
+// Bit 0 of every row, multiplying a row's pattern by it copies the pattern to every row (like 'FILE_A')
+#define GEOM_FILE_ROW(W, H, r, unused) (GEOM_ROW_AT(W, H, r) & (GEOM_ROW_AT(W, H, r) >> ((W) - 1)))
+#define GEOM_FILE(W, H)         GEOM_FOR_ROWS(W, H, GEOM_FILE_ROW, 0)
+
+// Columns 's' and up / below 'W - s' of every row, what is left of a row after a shift left / right by 's'
+#define GEOM_COLUMNS_LEFT(W, H, s)  (GEOM_FILE(W, H) * ((GEOM_ROW(W) << (s)) & GEOM_ROW(W)))
+#define GEOM_COLUMNS_RIGHT(W, H, s) (GEOM_FILE(W, H) * (GEOM_ROW(W) >> (s)))
+
+// How far row 'r' moves: the bottom row the most (\ -> | left, / -> | right), or the top row
+#define GEOM_FROM_BOTTOM(H, r)  ((H) - 1 - (r))
+#define GEOM_FROM_TOP(H, r)     (r)
+
+// Rows that move by 's' in the "binary" method
+#define GEOM_STEP_ROW(W, H, r, amount, s) ((((r) < (H)) && (amount(H, r) & (s)))? GEOM_ROW_AT(W, H, r) : 0)
+#define GEOM_STEP_ROWS(W, H, amount, s)   GEOM_FOR_ROWS(W, H, GEOM_STEP_ROW, amount, s)
+
+// Main diagonals: (\) starts at the bottom left, (/) at the bottom right.
+// Rows are built directly, 'GEOM_FOR_ROWS' can't be used inside itself
+#define GEOM_ON_DIAG(W, H, r)   ((r) < (W) && (r) < (H))
+#define GEOM_BACK_ROW(W, H, r, unused) (GEOM_ON_DIAG(W, H, r)? 1ULL << (GEOM_ON_DIAG(W, H, r)? (r)*(W) + (r) : 0) : 0)
+#define GEOM_FWD_ROW(W, H, r, unused)  (GEOM_ON_DIAG(W, H, r)? 1ULL << (GEOM_ON_DIAG(W, H, r)? (r)*(W) + (W) - 1 - (r) : 0) : 0)
+#define GEOM_BACK_DIAG(W, H)    GEOM_FOR_ROWS(W, H, GEOM_BACK_ROW, 0)
+#define GEOM_FWD_DIAG(W, H)     GEOM_FOR_ROWS(W, H, GEOM_FWD_ROW, 0)
+
+
+
+// ==================
+//  "Binary" method
+// ==================
+// Same as 'diagShift_bl_bin': shift by 4, 2 then 1, each step only keeps its moved rows' bits still on the board.
+// Steps no row needs have a 0 mask, and are folded away.
+#define GEOM_SHIFT_STEP(result, W, H, amount, op, columns, s) \
+    result = (result & (GEOM_BOARD(W, H) & ~GEOM_STEP_ROWS(W, H, amount, s))) \
+        | ((result op (s)) & (GEOM_STEP_ROWS(W, H, amount, s) & columns(W, H, s)));
+
+#define GEOM_SHIFT_BIN(name, type, W, H, amount, op, columns) \
+    DIAG_INLINE type name(const type toShift) { \
+        uint64_t result = toShift; \
+        GEOM_SHIFT_STEP(result, W, H, amount, op, columns, 4) \
+        GEOM_SHIFT_STEP(result, W, H, amount, op, columns, 2) \
+        GEOM_SHIFT_STEP(result, W, H, amount, op, columns, 1) \
+        return (type)result; \
+    }
+
+
+
+// ==================
+//  Extract/deposit
+// ==================
+// The multiply adds every row into the top one (1 bit per column so no carries), same as 'diagExtract_back_mul'.
+// Both are by column, so (/) is in the reverse order of 'diagToHorizontal_fwd_*' (same as '_SAD_ANTI')
+#define GEOM_EXTRACT(name, type, W, H, diagonal) \
+    DIAG_INLINE uint8_t name(const type board) { \
+        return (((board & diagonal(W, H)) * GEOM_FILE(W, H)) >> ((H) - 1)*(W)) & GEOM_ROW(W); \
+    }
+
+// Broadcast to every row & mask, same as 'toDiag_back_mul'
+#define GEOM_DEPOSIT(name, type, W, H, diagonal) \
+    DIAG_INLINE type name(const uint8_t input) { \
+        return (type)(((input & GEOM_ROW(W)) * GEOM_FILE(W, H)) & diagonal(W, H)); \
+    }
+
+
+
+// Shifts (\ -> |) and (/ -> |) both ways, extract & deposit of both main diagonals:
+// 'name_shift_bl', 'name_shift_tl', 'name_shift_br', 'name_shift_tr', 'name_extract_back', 'name_extract_fwd',
+// 'name_deposit_back' & 'name_deposit_fwd'. 'type' must hold W*H bits
+#define BOARD_GEOMETRY(name, type, W, H) \
+    GEOM_SHIFT_BIN(name##_shift_bl, type, W, H, GEOM_FROM_BOTTOM, <<, GEOM_COLUMNS_LEFT) \
+    GEOM_SHIFT_BIN(name##_shift_tl, type, W, H, GEOM_FROM_TOP, <<, GEOM_COLUMNS_LEFT) \
+    GEOM_SHIFT_BIN(name##_shift_br, type, W, H, GEOM_FROM_BOTTOM, >>, GEOM_COLUMNS_RIGHT) \
+    GEOM_SHIFT_BIN(name##_shift_tr, type, W, H, GEOM_FROM_TOP, >>, GEOM_COLUMNS_RIGHT) \
+    GEOM_EXTRACT(name##_extract_back, type, W, H, GEOM_BACK_DIAG) \
+    GEOM_EXTRACT(name##_extract_fwd, type, W, H, GEOM_FWD_DIAG) \
+    GEOM_DEPOSIT(name##_deposit_back, type, W, H, GEOM_BACK_DIAG) \
+    GEOM_DEPOSIT(name##_deposit_fwd, type, W, H, GEOM_FWD_DIAG)
+
+
+
+// ==================
+//     SSE based
+// ==================
+// Rows are bytes only when 8 wide, so 8xH boards can also use the SSE multiplies ('name_shift_bl_SSE' etc.).
+// The per row powers are built the same way as the binary masks, rows past the top are multiplied by 1.
+// Use after 'BOARD_GEOMETRY(name, type, 8, H)': boards known at compile time take its binary versions, which fold.
+#ifdef DIAG_X86
+#define GEOM_POWER(H, r, amount)    (1 << (((r) < (H))? amount(H, r) : 0))
+#define GEOM_POWERS(H, amount) _mm_set_epi16( \
+    GEOM_POWER(H, 7, amount), GEOM_POWER(H, 6, amount), GEOM_POWER(H, 5, amount), GEOM_POWER(H, 4, amount), \
+    GEOM_POWER(H, 3, amount), GEOM_POWER(H, 2, amount), GEOM_POWER(H, 1, amount), GEOM_POWER(H, 0, amount))
+// Right by 'n' is the high half of a multiply by '1 << (8 - n)'
+#define GEOM_POWER_RIGHT(H, r, amount)  (1 << (8 - (((r) < (H))? amount(H, r) : 0)))
+#define GEOM_POWERS_RIGHT(H, amount) _mm_set_epi16( \
+    GEOM_POWER_RIGHT(H, 7, amount), GEOM_POWER_RIGHT(H, 6, amount), GEOM_POWER_RIGHT(H, 5, amount), GEOM_POWER_RIGHT(H, 4, amount), \
+    GEOM_POWER_RIGHT(H, 3, amount), GEOM_POWER_RIGHT(H, 2, amount), GEOM_POWER_RIGHT(H, 1, amount), GEOM_POWER_RIGHT(H, 0, amount))
+
+// Same as 'diagShift_bl_SSE'
+#define GEOM_SHIFT_SSE_LEFT(name, portable, type, H, amount) \
+    DIAG_INLINE type name(const type toShift) { \
+        if (DIAG_IS_CONSTANT(toShift)) return portable(toShift); \
+        __m128i interleaved = _mm_unpacklo_epi8(_mm_cvtsi64_si128((uint64_t)toShift & GEOM_BOARD(8, H)), _mm_setzero_si128()); \
+        __m128i interShifted = _mm_mullo_epi16(interleaved, GEOM_POWERS(H, amount)); \
+        __m128i shiftedLower = _mm_and_si128(interShifted, _mm_set1_epi16(UINT8_MAX)); \
+        return (type)_mm_cvtsi128_si64(_mm_packus_epi16(shiftedLower, shiftedLower)); \
+    }
+
+// Same as 'diagShift_br_SSE'
+#define GEOM_SHIFT_SSE_RIGHT(name, portable, type, H, amount) \
+    DIAG_INLINE type name(const type toShift) { \
+        if (DIAG_IS_CONSTANT(toShift)) return portable(toShift); \
+        __m128i interleaved = _mm_unpacklo_epi8(_mm_setzero_si128(), _mm_cvtsi64_si128((uint64_t)toShift & GEOM_BOARD(8, H))); \
+        __m128i interShifted = _mm_mulhi_epu16(interleaved, GEOM_POWERS_RIGHT(H, amount)); \
+        return (type)_mm_cvtsi128_si64(_mm_packus_epi16(interShifted, interShifted)); \
+    }
+
+#define BOARD_GEOMETRY_SSE(name, type, H) \
+    GEOM_SHIFT_SSE_LEFT(name##_shift_bl_SSE, name##_shift_bl, type, H, GEOM_FROM_BOTTOM) \
+    GEOM_SHIFT_SSE_LEFT(name##_shift_tl_SSE, name##_shift_tl, type, H, GEOM_FROM_TOP) \
+    GEOM_SHIFT_SSE_RIGHT(name##_shift_br_SSE, name##_shift_br, type, H, GEOM_FROM_BOTTOM) \
+    GEOM_SHIFT_SSE_RIGHT(name##_shift_tr_SSE, name##_shift_tr, type, H, GEOM_FROM_TOP)
+#endif
+
+#endif
@@ -0,0 +1,350 @@
+#ifndef BOARD_STREAM_H
+#define BOARD_STREAM_H
+
+#include <stdint.h>
+#include <stddef.h>     // size_t
+#include <stdio.h>      // FILE
+#include <stdlib.h>     // malloc
+#include <string.h>     // strcmp
+#include <errno.h>
+#include <pthread.h>
+
+#include "diagBitboard.h"
+
+// Applying one batched operation to a whole file of boards (flat 'uint64_t's in the machine's byte order, or a byte
+// per row for the deposits' input & the extracts' output), on every core:
+//     boardStream_file(boardStream_find("transpose"), "boards.bin", "transposed.bin", 0, NULL);
+//
+// The boards are cut into chunks of BOARD_STREAM_CHUNK, dealt out evenly to the threads of a 'BoardStreamPool'. Each
+// takes its own from the front, then steals from the back of the others' once it runs out, so a thread slowed down
+// (page faults, another process) doesn't hold the rest up. The chunks are read from & written to the memory mapped
+// files as they are, without a copy in between.
+// 'boardStream_blocks' does the same on a stream (stdin to stdout), a block at a time.
+
+// 64K boards (512KB, 64KB of extracts): long enough for the thread's prefetchers, short enough to balance
+#define BOARD_STREAM_CHUNK ((size_t)1 << 16)
+#define BOARD_STREAM_MAX_THREADS 256
+
+#if defined(__unix__) || defined(__APPLE__)
+    #include <fcntl.h>      // open
+    #include <unistd.h>     // close, ftruncate, sysconf
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #define BOARD_STREAM_MMAP
+#endif
+
+
+// ==================
+//     Operations
+// ==================
+typedef struct {
+    const char *name;
+    size_t inSize, outSize;     // Bytes per board, 8 or 1
+    void (*batch)(const void *in, void *out, size_t n);
+} BoardStreamOp;
+
+#define BOARD_STREAM_OP(name, In, Out) \
+    static void boardStream_##name(const void *in, void *out, size_t n) { diag_##name##_batch((const In*)in, (Out*)out, n); }
+
+BOARD_STREAM_OP(shift_bl, uint64_t, uint64_t)
+BOARD_STREAM_OP(shift_tl, uint64_t, uint64_t)
+BOARD_STREAM_OP(shift_br, uint64_t, uint64_t)
+BOARD_STREAM_OP(shift_tr, uint64_t, uint64_t)
+BOARD_STREAM_OP(transpose, uint64_t, uint64_t)
+BOARD_STREAM_OP(extract_back, uint64_t, uint8_t)
+BOARD_STREAM_OP(extract_fwd, uint64_t, uint8_t)
+BOARD_STREAM_OP(toDiag_back, uint8_t, uint64_t)
+BOARD_STREAM_OP(toDiag_fwd, uint8_t, uint64_t)
+BOARD_STREAM_OP(toVertical, uint8_t, uint64_t)
+
+static const BoardStreamOp BOARD_STREAM_OPS[] = {
+    {"shift_bl", 8, 8, boardStream_shift_bl},
+    {"shift_tl", 8, 8, boardStream_shift_tl},
+    {"shift_br", 8, 8, boardStream_shift_br},
+    {"shift_tr", 8, 8, boardStream_shift_tr},
+    {"transpose", 8, 8, boardStream_transpose},
+    {"extract_back", 8, 1, boardStream_extract_back},
+    {"extract_fwd", 8, 1, boardStream_extract_fwd},
+    {"toDiag_back", 1, 8, boardStream_toDiag_back},
+    {"toDiag_fwd", 1, 8, boardStream_toDiag_fwd},
+    {"toVertical", 1, 8, boardStream_toVertical},
+};
+#define BOARD_STREAM_OP_COUNT (sizeof(BOARD_STREAM_OPS) / sizeof(BOARD_STREAM_OPS[0]))
+
+// NULL when there's no operation of that name
+static inline const BoardStreamOp *boardStream_find(const char *name) {
+    for (size_t o=0; o < BOARD_STREAM_OP_COUNT; o++)
+        if (!strcmp(BOARD_STREAM_OPS[o].name, name)) return &BOARD_STREAM_OPS[o];
+    return NULL;
+}
+
+
+// ==================
+//    Thread pool
+// ==================
+// A thread's chunks, taken from the front by itself & from the back by the others.
+// Stolen chunks are rare & long, so a lock costs nothing next to them. A cache line each, so they don't share one
+typedef struct {
+    _Alignas(64) pthread_mutex_t lock;
+    size_t next, end;
+} BoardStreamQueue;
+
+typedef struct BoardStreamPool BoardStreamPool;
+
+typedef struct {
+    BoardStreamPool *pool;
+    unsigned index;
+} BoardStreamWorker;
+
+struct BoardStreamPool {
+    unsigned threads;           // Including the caller, which is worker 0
+    pthread_mutex_t lock;
+    pthread_cond_t start, done;
+    unsigned generation, busy;  // 'generation' counts the runs, 'busy' the workers still on this one
+    int stop;
+
+    // The current run
+    const BoardStreamOp *op;
+    const uint8_t *in;
+    uint8_t *out;
+    size_t count;
+
+    BoardStreamQueue queues[BOARD_STREAM_MAX_THREADS];
+    BoardStreamWorker workers[BOARD_STREAM_MAX_THREADS];
+    pthread_t handles[BOARD_STREAM_MAX_THREADS];
+};
+
+// SIZE_MAX once there's nothing left to take or steal
+static inline size_t boardStreamPool_take(BoardStreamPool *pool, const unsigned index) {
+    BoardStreamQueue *own = &pool->queues[index];
+    size_t chunk = SIZE_MAX;
+
+    pthread_mutex_lock(&own->lock);
+    if (own->next < own->end) chunk = own->next++;
+    pthread_mutex_unlock(&own->lock);
+
+    // The others', starting with the next thread so the thieves spread out
+    for (unsigned i = 1; chunk == SIZE_MAX && i < pool->threads; i++) {
+        BoardStreamQueue *victim = &pool->queues[(index + i) % pool->threads];
+        pthread_mutex_lock(&victim->lock);
+        if (victim->next < victim->end) chunk = --victim->end;
+        pthread_mutex_unlock(&victim->lock);
+    }
+    return chunk;
+}
+
+static inline void boardStreamPool_work(BoardStreamPool *pool, const unsigned index) {
+    const BoardStreamOp *op = pool->op;
+
+    for (size_t chunk; (chunk = boardStreamPool_take(pool, index)) != SIZE_MAX;) {
+        const size_t first = chunk * BOARD_STREAM_CHUNK;
+        const size_t n = (pool->count - first < BOARD_STREAM_CHUNK)? pool->count - first : BOARD_STREAM_CHUNK;
+        op->batch(pool->in + first * op->inSize, pool->out + first * op->outSize, n);
+    }
+}
+
+static inline void *boardStreamPool_thread(void *workerPtr) {
+    const BoardStreamWorker *worker = (const BoardStreamWorker*)workerPtr;
+    BoardStreamPool *pool = worker->pool;
+    unsigned seen = 0;
+
+    pthread_mutex_lock(&pool->lock);
+    for (;;) {
+        while (!pool->stop && pool->generation == seen)
+            pthread_cond_wait(&pool->start, &pool->lock);
+        if (pool->stop) break;
+        seen = pool->generation;
+        pthread_mutex_unlock(&pool->lock);
+
+        boardStreamPool_work(pool, worker->index);
+
+        pthread_mutex_lock(&pool->lock);
+        if (--pool->busy == 0)
+            pthread_cond_signal(&pool->done);
+    }
+    pthread_mutex_unlock(&pool->lock);
+    return NULL;
+}
+
+// 'threads' == 0 takes every online CPU. Returns 0 on success, or the error from 'pthread_create': the pool then
+// has the threads that did start (at least the caller)
+static inline int boardStreamPool_init(BoardStreamPool *pool, unsigned threads) {
+#ifdef BOARD_STREAM_MMAP
+    if (threads == 0) {
+        const long online = sysconf(_SC_NPROCESSORS_ONLN);
+        threads = (online > 0)? (unsigned)online : 1;
+    }
+#endif
+    if (threads == 0) threads = 1;
+    if (threads > BOARD_STREAM_MAX_THREADS) threads = BOARD_STREAM_MAX_THREADS;
+
+    pthread_mutex_init(&pool->lock, NULL);
+    pthread_cond_init(&pool->start, NULL);
+    pthread_cond_init(&pool->done, NULL);
+    pool->generation = pool->busy = 0;
+    pool->stop = 0;
+    for (unsigned t = 0; t < threads; t++) {
+        pthread_mutex_init(&pool->queues[t].lock, NULL);
+        pool->queues[t].next = pool->queues[t].end = 0;
+        pool->workers[t] = (BoardStreamWorker){pool, t};
+    }
+
+    int error = 0;
+    pool->threads = 1;
+    for (; pool->threads < threads; pool->threads++) {
+        error = pthread_create(&pool->handles[pool->threads], NULL, boardStreamPool_thread, &pool->workers[pool->threads]);
+        if (error) break;
+    }
+    return error;
+}
+
+static inline void boardStreamPool_free(BoardStreamPool *pool) {
+    pthread_mutex_lock(&pool->lock);
+    pool->stop = 1;
+    pthread_cond_broadcast(&pool->start);
+    pthread_mutex_unlock(&pool->lock);
+
+    for (unsigned t = 1; t < pool->threads; t++)
+        pthread_join(pool->handles[t], NULL);
+    for (unsigned t = 0; t < pool->threads; t++)
+        pthread_mutex_destroy(&pool->queues[t].lock);
+    pthread_cond_destroy(&pool->done);
+    pthread_cond_destroy(&pool->start);
+    pthread_mutex_destroy(&pool->lock);
+}
+
+// 'count' boards of 'in' to 'out' (which must not overlap), on all of the pool's threads & the caller's
+static inline void boardStreamPool_run(BoardStreamPool *pool, const BoardStreamOp *op, const void *in, void *out, const size_t count) {
+    const size_t chunks = (count + BOARD_STREAM_CHUNK - 1) / BOARD_STREAM_CHUNK;
+    if (pool->threads == 1 || chunks <= 1) {
+        op->batch(in, out, count);
+        return;
+    }
+
+    pool->op = op;
+    pool->in = (const uint8_t*)in;
+    pool->out = (uint8_t*)out;
+    pool->count = count;
+    // The workers are all waiting, so the queues are only touched by this thread until the broadcast
+    for (unsigned t = 0; t < pool->threads; t++) {
+        pool->queues[t].next = chunks * t / pool->threads;
+        pool->queues[t].end = chunks * (t + 1) / pool->threads;
+    }
+
+    pthread_mutex_lock(&pool->lock);
+    pool->generation++;
+    pool->busy = pool->threads - 1;
+    pthread_cond_broadcast(&pool->start);
+    pthread_mutex_unlock(&pool->lock);
+
+    boardStreamPool_work(pool, 0);
+
+    pthread_mutex_lock(&pool->lock);
+    while (pool->busy)
+        pthread_cond_wait(&pool->done, &pool->lock);
+    pthread_mutex_unlock(&pool->lock);
+}
+
+
+// ==================
+//      Streams
+// ==================
+// The same as 'boardStreamPool_run' with a pool of its own
+static inline int boardStream_run(const BoardStreamOp *op, const void *in, void *out, const size_t count, const unsigned threads) {
+    static BoardStreamPool pool; // Too large for the stack, & only one run at a time uses it
+    static pthread_mutex_t inUse = PTHREAD_MUTEX_INITIALIZER;
+
+    pthread_mutex_lock(&inUse);
+    const int error = boardStreamPool_init(&pool, threads);
+    boardStreamPool_run(&pool, op, in, out, count);
+    boardStreamPool_free(&pool);
+    pthread_mutex_unlock(&inUse);
+    return error;
+}
+
+// Reads 'in' a block of 'blockBoards' at a time, writes each transformed block to 'out'.
+// Returns 0 on success, EINVAL when the input ends partway through a board, or the 'errno' of a failed read or write
+static inline int boardStream_blocks(BoardStreamPool *pool, const BoardStreamOp *op, FILE *in, FILE *out, size_t blockBoards) {
+    if (blockBoards == 0) blockBoards = BOARD_STREAM_CHUNK;
+    uint8_t *inBlock = (uint8_t*)malloc(blockBoards * op->inSize);
+    uint8_t *outBlock = (uint8_t*)malloc(blockBoards * op->outSize);
+    int error = (!inBlock || !outBlock)? ENOMEM : 0;
+
+    while (!error) {
+        errno = 0;
+        // 'fread' only returns less than asked at the end of the input (or on an error)
+        const size_t bytes = fread(inBlock, 1, blockBoards * op->inSize, in);
+        const size_t count = bytes / op->inSize;
+
+        boardStreamPool_run(pool, op, inBlock, outBlock, count);
+        if (fwrite(outBlock, op->outSize, count, out) != count)
+            error = errno? errno : EIO;
+        else if (bytes < blockBoards * op->inSize) {
+            if (ferror(in)) error = errno? errno : EIO;
+            else if (bytes % op->inSize) error = EINVAL;
+            break;
+        }
+    }
+
+    free(inBlock);
+    free(outBlock);
+    if (!error && fflush(out)) error = errno? errno : EIO;
+    return error;
+}
+
+#ifdef BOARD_STREAM_MMAP
+// Maps the whole of 'inPath' & writes the results to 'outPath' (created, or resized), straight into its mapping.
+// Returns 0 on success, EINVAL when the input's size isn't a whole number of boards, EEXIST when 'outPath' is 'inPath'
+// (or a link to it, which would be emptied before it's read), or the 'errno' of the failed call.
+// On an error, '*failedPath' (unless NULL) is the path it concerns
+static inline int boardStream_file(const BoardStreamOp *op, const char *inPath, const char *outPath, const unsigned threads,
+                                   const char **failedPath) {
+    int error = 0;
+    const char *failed = inPath;
+    void *in = MAP_FAILED, *out = MAP_FAILED;
+    size_t count = 0;
+    struct stat inStat, outStat;
+
+    const int inFd = open(inPath, O_RDONLY);
+    int outFd = -1;
+    if (inFd < 0 || fstat(inFd, &inStat))
+        error = errno;
+    else if ((size_t)inStat.st_size % op->inSize)
+        error = EINVAL;
+    else if ((outFd = open(outPath, O_RDWR | O_CREAT, 0644)) < 0 || fstat(outFd, &outStat)) {
+        error = errno;
+        failed = outPath;
+    } else if (outStat.st_dev == inStat.st_dev && outStat.st_ino == inStat.st_ino) {
+        error = EEXIST;
+        failed = outPath;
+    } else if (ftruncate(outFd, (off_t)((count = (size_t)inStat.st_size / op->inSize) * op->outSize))) {
+        error = errno;
+        failed = outPath;
+    } else if (count > 0) {
+        // Read once, front to back: the kernel reads ahead of every thread
+        if ((in = mmap(NULL, count * op->inSize, PROT_READ, MAP_PRIVATE, inFd, 0)) == MAP_FAILED)
+            error = errno;
+        else if ((out = mmap(NULL, count * op->outSize, PROT_READ | PROT_WRITE, MAP_SHARED, outFd, 0)) == MAP_FAILED) {
+            error = errno;
+            failed = outPath;
+        }
+    }
+
+    if (!error && count) {
+        madvise(in, count * op->inSize, MADV_SEQUENTIAL);
+        error = boardStream_run(op, in, out, count, threads);
+    }
+
+    if (out != MAP_FAILED) munmap(out, count * op->outSize);
+    if (in != MAP_FAILED) munmap(in, count * op->inSize);
+    if (outFd >= 0 && close(outFd) && !error) {
+        error = errno;
+        failed = outPath;
+    }
+    if (inFd >= 0) close(inFd);
+    if (error && failedPath) *failedPath = failed;
+    return error;
+}
+#endif
+
+#endif
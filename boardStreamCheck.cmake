@@ -0,0 +1,54 @@
+# The file (mmapped) & stdin (blocks) paths of 'boardstream' on the same input, run by ctest:
+#     cmake -DBOARDSTREAM=path/to/boardstream -DOP=transpose -DDIR=scratch/dir -P boardStreamCheck.cmake
+# Both outputs must match. An output that is the input is refused (the input is kept), a partial board exits with 1
+foreach(variable BOARDSTREAM OP DIR)
+    if(NOT DEFINED ${variable})
+        message(FATAL_ERROR "${variable} isn't set")
+    endif()
+endforeach()
+
+file(MAKE_DIRECTORY ${DIR})
+set(input ${DIR}/${OP}_in.bin)
+
+# 70001 boards (a byte each for the deposits): a chunk & a partial one for the file, uneven blocks for stdin
+if(OP MATCHES "^to")
+    set(bytes 70001)
+else()
+    math(EXPR bytes "70001 * 8")
+endif()
+string(RANDOM LENGTH ${bytes} RANDOM_SEED 1 boards)
+file(WRITE ${input} "${boards}")
+
+execute_process(COMMAND ${BOARDSTREAM} ${OP} ${input} ${DIR}/${OP}_file.bin --threads 4 RESULT_VARIABLE result)
+if(NOT result EQUAL 0)
+    message(FATAL_ERROR "${OP}: the file path failed (${result})")
+endif()
+execute_process(COMMAND ${BOARDSTREAM} ${OP} --threads 4 --block 1000
+    INPUT_FILE ${input} OUTPUT_FILE ${DIR}/${OP}_stdin.bin RESULT_VARIABLE result)
+if(NOT result EQUAL 0)
+    message(FATAL_ERROR "${OP}: the stdin path failed (${result})")
+endif()
+execute_process(COMMAND ${CMAKE_COMMAND} -E compare_files ${DIR}/${OP}_file.bin ${DIR}/${OP}_stdin.bin RESULT_VARIABLE result)
+if(NOT result EQUAL 0)
+    message(FATAL_ERROR "${OP}: the file & stdin outputs differ")
+endif()
+
+# The output is the input
+execute_process(COMMAND ${BOARDSTREAM} ${OP} ${input} ${input} RESULT_VARIABLE result ERROR_VARIABLE error)
+file(SIZE ${input} size)
+if(result EQUAL 0 OR NOT size EQUAL bytes)
+    message(FATAL_ERROR "${OP}: the output being the input wasn't refused (${result}, ${size} bytes left)")
+endif()
+
+# A partial board (the deposits' boards are a byte, so only the others have one)
+if(NOT OP MATCHES "^to")
+    file(WRITE ${DIR}/${OP}_partial.bin "0123456789abc")
+    execute_process(COMMAND ${BOARDSTREAM} ${OP} ${DIR}/${OP}_partial.bin ${DIR}/${OP}_partial_out.bin
+        RESULT_VARIABLE fileResult ERROR_VARIABLE fileError)
+    execute_process(COMMAND ${BOARDSTREAM} ${OP} INPUT_FILE ${DIR}/${OP}_partial.bin OUTPUT_QUIET
+        RESULT_VARIABLE stdinResult ERROR_VARIABLE stdinError)
+    if(NOT fileResult EQUAL 1 OR NOT fileError MATCHES "not a whole number of boards"
+       OR NOT stdinResult EQUAL 1 OR NOT stdinError MATCHES "not a whole number of boards")
+        message(FATAL_ERROR "${OP}: a partial board wasn't refused (${fileResult}: ${fileError}, ${stdinResult}: ${stdinError})")
+    endif()
+endif()
@@ -0,0 +1,177 @@
+// 'boardstream': applies one operation of 'boardStream.h' to a file of boards, or to stdin in blocks, on every core.
+//     boardstream transpose boards.bin transposed.bin
+//     cat boards.bin | boardstream extract_back > diagonals.bin
+//     boardstream shift_bl --scaling --threads 16
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "boardStream.h"
+
+static double secondsSince(const struct timespec start) {
+    struct timespec end;
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    return (double)(end.tv_sec - start.tv_sec) + (double)(end.tv_nsec - start.tv_nsec) * 1e-9;
+}
+
+static uint64_t splitmix64(uint64_t *state) {
+    uint64_t z = (*state += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+// GB/s (read + written) of the best of 'reps' runs with 1 to 'maxThreads' threads, on 'count' random boards (rows for
+// the deposits). Every thread count's output is checked against the single thread one: returns 1 on a mismatch
+static int scalingReport(const BoardStreamOp *op, const size_t count, unsigned maxThreads, const int reps) {
+    static BoardStreamPool pool;
+    uint8_t *in = (uint8_t*)malloc(count * op->inSize);
+    uint8_t *out = (uint8_t*)malloc(count * op->outSize);
+    uint8_t *expected = (uint8_t*)malloc(count * op->outSize);
+    if (!in || !out || !expected) {
+        fprintf(stderr, "boardstream: can't allocate %zu boards\n", count);
+        free(in);
+        free(out);
+        free(expected);
+        return 1;
+    }
+
+    uint64_t state = 1;
+    for (size_t i=0; i < count * op->inSize; i += 8) {
+        const uint64_t random = splitmix64(&state);
+        memcpy(in + i, &random, (count * op->inSize - i < 8)? count * op->inSize - i : 8);
+    }
+    op->batch(in, expected, count);
+
+    const double bytes = (double)count * (double)(op->inSize + op->outSize);
+    printf("%s, %zu boards (%.0f MB read & written)\n", op->name, count, bytes * 1e-6);
+    printf("%8s %10s %10s %10s\n", "Threads", "ms", "GB/s", "Speedup");
+
+    int mismatches = 0;
+    double singleThread = 0;
+    for (unsigned threads = 1; threads <= maxThreads; threads++) {
+        if (boardStreamPool_init(&pool, threads)) {
+            boardStreamPool_free(&pool);
+            fprintf(stderr, "boardstream: only %u threads could be started\n", pool.threads);
+            break;
+        }
+
+        memset(out, 0, count * op->outSize);
+        boardStreamPool_run(&pool, op, in, out, count); // Warmup, & the pages of the output
+        double best = 0;
+        for (int r=0; r < reps; r++) {
+            struct timespec start;
+            clock_gettime(CLOCK_MONOTONIC, &start);
+            boardStreamPool_run(&pool, op, in, out, count);
+            const double seconds = secondsSince(start);
+            if (r == 0 || seconds < best) best = seconds;
+        }
+        boardStreamPool_free(&pool);
+
+        if (threads == 1) singleThread = best;
+        if (memcmp(out, expected, count * op->outSize)) {
+            fprintf(stderr, "MISMATCH: %s with %u threads\n", op->name, threads);
+            mismatches++;
+        }
+        printf("%8u %10.2f %10.2f %10.2f\n", threads, best * 1e3, bytes / best * 1e-9, singleThread / best);
+    }
+
+    free(in);
+    free(out);
+    free(expected);
+    return mismatches? 1 : 0;
+}
+
+static void printUsage(const char *program) {
+    printf(
+        "Usage: %s OPERATION [INPUT OUTPUT] [options]\n"
+        "  INPUT OUTPUT       files of boards (8 bytes each, or 1 for the deposits' input & the extracts' output),\n"
+        "                     both memory mapped. Without them (or '-'), stdin to stdout in blocks\n"
+        "  --threads N        worker threads, including the main one, at most %d (default: every online CPU)\n"
+        "  --block N          boards per block from stdin (default: %zu)\n"
+        "  --scaling          GB/s with 1 to --threads threads instead, on random boards\n"
+        "  --boards N         boards for --scaling (default: 33554432)\n"
+        "  --reps N           runs per thread count for --scaling, the fastest is reported (default: 5)\n"
+        "Operations:",
+        program, BOARD_STREAM_MAX_THREADS, (size_t)BOARD_STREAM_CHUNK
+    );
+    for (size_t o=0; o < BOARD_STREAM_OP_COUNT; o++)
+        printf(" %s", BOARD_STREAM_OPS[o].name);
+    printf("\n");
+}
+
+int main(int argc, char **argv) {
+    const char *paths[2] = {NULL, NULL};
+    const BoardStreamOp *op = NULL;
+    unsigned threads = 0;
+    size_t block = BOARD_STREAM_CHUNK, boards = (size_t)1 << 25;
+    int scaling = 0, reps = 5, pathCount = 0;
+
+    for (int i=1; i < argc; i++) {
+        const char *arg = argv[i], *value = (i + 1 < argc)? argv[i + 1] : "";
+
+        if (!strcmp(arg, "--threads"))      { threads = (unsigned)atoi(value); i++; }
+        else if (!strcmp(arg, "--block"))   { block = strtoull(value, NULL, 10); i++; }
+        else if (!strcmp(arg, "--boards"))  { boards = strtoull(value, NULL, 10); i++; }
+        else if (!strcmp(arg, "--reps"))    { reps = atoi(value); i++; }
+        else if (!strcmp(arg, "--scaling")) scaling = 1;
+        else if (!op && boardStream_find(arg)) op = boardStream_find(arg);
+        else if (op && pathCount < 2 && (arg[0] != '-' || !strcmp(arg, "-"))) paths[pathCount++] = arg;
+        else {
+            printUsage(argv[0]);
+            return !!strcmp(arg, "--help");
+        }
+    }
+    if (!op || pathCount == 1) {
+        printUsage(argv[0]);
+        return 1;
+    }
+#ifdef BOARD_STREAM_MMAP
+    if (scaling && threads == 0) threads = (unsigned)sysconf(_SC_NPROCESSORS_ONLN);
+#endif
+    // Pools are capped at BOARD_STREAM_MAX_THREADS, so --scaling would report the capped pool as the larger counts
+    if (threads > BOARD_STREAM_MAX_THREADS) threads = BOARD_STREAM_MAX_THREADS;
+
+    if (scaling) {
+        if (threads == 0) threads = 1;
+        return scalingReport(op, boards? boards : 1, threads, (reps < 1)? 1 : reps);
+    }
+
+    int error;
+    const char *inName = (pathCount == 2 && strcmp(paths[0], "-"))? paths[0] : "stdin";
+    const char *outName = (pathCount == 2 && strcmp(paths[1], "-"))? paths[1] : "stdout";
+    const char *failed = inName;
+#ifdef BOARD_STREAM_MMAP
+    if (pathCount == 2 && strcmp(paths[0], "-") && strcmp(paths[1], "-"))
+        error = boardStream_file(op, paths[0], paths[1], threads, &failed);
+    else
+#endif
+    {
+        static BoardStreamPool pool;
+        FILE *in = (pathCount == 2 && strcmp(paths[0], "-"))? fopen(paths[0], "rb") : stdin;
+        FILE *out = NULL;
+        if (!in)
+            error = errno;
+        else if (!(out = (pathCount == 2 && strcmp(paths[1], "-"))? fopen(paths[1], "wb") : stdout)) {
+            error = errno;
+            failed = outName;
+        } else {
+            boardStreamPool_init(&pool, threads);
+            error = boardStream_blocks(&pool, op, in, out, block);
+            boardStreamPool_free(&pool);
+            // A partial board is the input's, a failed read or write the side's it happened on (ENOMEM neither's)
+            if (error && error != EINVAL)
+                failed = ferror(in)? inName : ferror(out)? outName : NULL;
+        }
+        if (in && in != stdin) fclose(in);
+        if (out && out != stdout) fclose(out);
+    }
+
+    if (error) {
+        fprintf(stderr, "boardstream: %s%s%s\n", failed? failed : "", failed? ": " : "",
+            (error == EINVAL && failed == inName)? "not a whole number of boards" : (error == EEXIST)? "the output is the input" : strerror(error));
+        return 1;
+    }
+    return 0;
+}
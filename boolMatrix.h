@@ -0,0 +1,316 @@
+#ifndef BOOL_MATRIX_H
+#define BOOL_MATRIX_H
+
+#include <stdint.h>
+#include <stddef.h>     // size_t
+#include <string.h>     // memcpy
+
+#include "cpuFeatures.h"
+#include "transpose.h"  // Column access
+#ifdef DIAG_X86
+#include <immintrin.h>  // SSE2, AVX2, AVX512bw, GFNI
+#endif
+
+// A board as the adjacency matrix of 8 nodes: bit 'j' of row 'i' is an edge from 'i' to 'j'.
+// The boolean product 'a·b' (AND, then OR) has the paths of an 'a' edge then a 'b' one, and the transitive closure
+// every node reachable through 1 or more edges.
+//
+// 'c[i][j]' is 'row i of a & column j of b' being non zero. The transpose ('diagTranspose_*') makes the columns of 'b'
+// rows, then every row of 'a' is broadcast over the 8 bytes of a vector & tested against all of them at once.
+//
+// 64 nodes are 64 of those as 8x8 tiles ('uint64_t m[64]'): tile 'I*8 + J' has the edges from nodes 8I to 8I+7
+// to nodes 8J to 8J+7, in the same layout. Each tile of the product is 'OR over K of tile IK · tile KJ': the ANDs
+// are ORed together before a single test per tile, and 'b' is transposed once.
+
+
+// ==================
+//       Naive
+// ==================
+static inline uint64_t boolMatMul_naive(const uint64_t a, const uint64_t b) {
+    uint64_t product = 0;
+    for (unsigned i=0; i < 8; i++)
+        for (unsigned j=0; j < 8; j++)
+            for (unsigned k=0; k < 8; k++)
+                if ((a >> (8*i + k) & 1) && (b >> (8*k + j) & 1)) {
+                    product |= 1ULL << (8*i + j);
+                    break;
+                }
+    return product;
+}
+
+// Warshall's algorithm: every node 'k' in turn may be passed through
+static inline uint64_t boolClosure_naive(uint64_t reach) {
+    for (unsigned k=0; k < 8; k++)
+        for (unsigned i=0; i < 8; i++)
+            if (reach >> (8*i + k) & 1)
+                reach |= (reach >> 8*k & UINT8_MAX) << 8*i;
+    return reach;
+}
+
+#define BOOL_MATRIX64_BIT(m, row, column) ((m)[((row) >> 3) * 8 + ((column) >> 3)] >> (((row) & 7) * 8 + ((column) & 7)) & 1)
+
+static inline void boolMatMul64_naive(const uint64_t *a, const uint64_t *b, uint64_t *product) {
+    uint64_t result[64] = {0};
+    for (unsigned i=0; i < 64; i++)
+        for (unsigned j=0; j < 64; j++)
+            for (unsigned k=0; k < 64; k++)
+                if (BOOL_MATRIX64_BIT(a, i, k) && BOOL_MATRIX64_BIT(b, k, j)) {
+                    result[(i >> 3) * 8 + (j >> 3)] |= 1ULL << ((i & 7) * 8 + (j & 7));
+                    break;
+                }
+    memcpy(product, result, sizeof(result));
+}
+
+// Row 'k' ORed into row 'i' 8 columns (a tile) at a time
+static inline void boolClosure64_naive(uint64_t *reach) {
+    for (unsigned k=0; k < 64; k++)
+        for (unsigned i=0; i < 64; i++)
+            if (BOOL_MATRIX64_BIT(reach, i, k))
+                for (unsigned column=0; column < 8; column++)
+                    reach[(i >> 3) * 8 + column] |= (reach[(k >> 3) * 8 + column] >> (k & 7) * 8 & UINT8_MAX) << (i & 7) * 8;
+}
+
+
+// ==================
+//  "Binary" method
+// ==================
+// No transpose: row 'k' of 'b' is ORed into every row with an edge to 'k', both spread by a multiply
+DIAG_INLINE uint64_t boolMatMul_bin(const uint64_t a, const uint64_t b) {
+    uint64_t product = 0;
+    for (unsigned k=0; k < 8; k++) {
+        const uint64_t rowsToK = ((a >> k) & 0x0101010101010101ULL) * UINT8_MAX;
+        const uint64_t rowK = (b >> 8*k & UINT8_MAX) * 0x0101010101010101ULL;
+        product |= rowsToK & rowK;
+    }
+    return product;
+}
+
+static inline void boolMatMul64_bin(const uint64_t *a, const uint64_t *b, uint64_t *product) {
+    uint64_t result[64];
+    for (size_t i=0; i < 8; i++)
+        for (size_t j=0; j < 8; j++) {
+            uint64_t tile = 0;
+            for (size_t k=0; k < 8; k++)
+                tile |= boolMatMul_bin(a[8*i + k], b[8*k + j]);
+            result[8*i + j] = tile;
+        }
+    memcpy(product, result, sizeof(result));
+}
+
+
+// ==================
+//      Vectors
+// ==================
+// The rows of 'a' each broadcast over a 64-bit lane ('_rows'), ANDed with the transposed 'b' broadcast to every lane,
+// and the bytes that are 0 are the missing edges ('_any')
+#ifdef DIAG_X86
+DIAG_INLINE void boolMatMul_rows_sse(const uint64_t a, __m128i rows[4]) {
+    __m128i doubled = _mm_unpacklo_epi8(_mm_cvtsi64_si128((long long)a), _mm_cvtsi64_si128((long long)a));
+    __m128i rows0to3 = _mm_unpacklo_epi16(doubled, doubled), rows4to7 = _mm_unpackhi_epi16(doubled, doubled);
+    rows[0] = _mm_unpacklo_epi32(rows0to3, rows0to3);
+    rows[1] = _mm_unpackhi_epi32(rows0to3, rows0to3);
+    rows[2] = _mm_unpacklo_epi32(rows4to7, rows4to7);
+    rows[3] = _mm_unpackhi_epi32(rows4to7, rows4to7);
+}
+
+DIAG_INLINE uint64_t boolMatMul_any_sse(const __m128i masked[4]) {
+    uint64_t missing = 0;
+    for (unsigned q=0; q < 4; q++)
+        missing |= (uint64_t)_mm_movemask_epi8(_mm_cmpeq_epi8(masked[q], _mm_setzero_si128())) << 16*q;
+    return ~missing;
+}
+
+// 'bt' is the transpose of 'b'
+DIAG_INLINE uint64_t boolMatMul_transposed_sse(const uint64_t a, const uint64_t bt) {
+    const __m128i columns = _mm_set1_epi64x((long long)bt);
+    __m128i rows[4];
+    boolMatMul_rows_sse(a, rows);
+    for (unsigned q=0; q < 4; q++)
+        rows[q] = _mm_and_si128(rows[q], columns);
+    return boolMatMul_any_sse(rows);
+}
+
+DIAG_INLINE uint64_t boolMatMul_sse(const uint64_t a, const uint64_t b) {
+    return boolMatMul_transposed_sse(a, diagTranspose_sse(b));
+}
+
+static inline void boolMatMul64_sse(const uint64_t *a, const uint64_t *b, uint64_t *product) {
+    uint64_t bt[64], result[64];
+    for (size_t t=0; t < 64; t++)
+        bt[t] = diagTranspose_sse(b[t]);
+
+    for (size_t i=0; i < 8; i++) {
+        __m128i rows[8][4];
+        for (size_t k=0; k < 8; k++)
+            boolMatMul_rows_sse(a[8*i + k], rows[k]);
+
+        for (size_t j=0; j < 8; j++) {
+            __m128i masked[4] = {_mm_setzero_si128(), _mm_setzero_si128(), _mm_setzero_si128(), _mm_setzero_si128()};
+            for (size_t k=0; k < 8; k++) {
+                const __m128i columns = _mm_set1_epi64x((long long)bt[8*k + j]);
+                for (unsigned q=0; q < 4; q++)
+                    masked[q] = _mm_or_si128(masked[q], _mm_and_si128(rows[k][q], columns));
+            }
+            result[8*i + j] = boolMatMul_any_sse(masked);
+        }
+    }
+    memcpy(product, result, sizeof(result));
+}
+#endif
+
+#ifdef COMPILE_AVX2
+// 'pshufb' broadcasts byte 'r' over lane 'r' (rows 0 to 3, then 4 to 7): 'a' is in both halves of every 128-bit lane
+static inline TARGET_AVX2 void boolMatMul_rows_avx2(const uint64_t a, __m256i rows[2]) {
+    const __m256i broadcast = _mm256_set1_epi64x((long long)a);
+    rows[0] = _mm256_shuffle_epi8(broadcast, _mm256_set_epi64x(0x0303030303030303LL, 0x0202020202020202LL, 0x0101010101010101LL, 0));
+    rows[1] = _mm256_shuffle_epi8(broadcast, _mm256_set_epi64x(0x0707070707070707LL, 0x0606060606060606LL, 0x0505050505050505LL, 0x0404040404040404LL));
+}
+
+static inline TARGET_AVX2 uint64_t boolMatMul_any_avx2(const __m256i masked[2]) {
+    const uint32_t missingLow = (uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(masked[0], _mm256_setzero_si256()));
+    const uint32_t missingHigh = (uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(masked[1], _mm256_setzero_si256()));
+    return ~((uint64_t)missingHigh << 32 | missingLow);
+}
+
+static inline TARGET_AVX2 uint64_t boolMatMul_transposed_avx2(const uint64_t a, const uint64_t bt) {
+    const __m256i columns = _mm256_set1_epi64x((long long)bt);
+    __m256i rows[2];
+    boolMatMul_rows_avx2(a, rows);
+    rows[0] = _mm256_and_si256(rows[0], columns);
+    rows[1] = _mm256_and_si256(rows[1], columns);
+    return boolMatMul_any_avx2(rows);
+}
+
+static inline TARGET_AVX2 uint64_t boolMatMul_avx2(const uint64_t a, const uint64_t b) {
+    return boolMatMul_transposed_avx2(a, diagTranspose_avx2(b));
+}
+
+static inline TARGET_AVX2 void boolMatMul64_avx2(const uint64_t *a, const uint64_t *b, uint64_t *product) {
+    uint64_t bt[64], result[64];
+    for (size_t t=0; t < 64; t++)
+        bt[t] = diagTranspose_avx2(b[t]);
+
+    for (size_t i=0; i < 8; i++) {
+        __m256i rows[8][2];
+        for (size_t k=0; k < 8; k++)
+            boolMatMul_rows_avx2(a[8*i + k], rows[k]);
+
+        for (size_t j=0; j < 8; j++) {
+            __m256i masked[2] = {_mm256_setzero_si256(), _mm256_setzero_si256()};
+            for (size_t k=0; k < 8; k++) {
+                const __m256i columns = _mm256_set1_epi64x((long long)bt[8*k + j]);
+                masked[0] = _mm256_or_si256(masked[0], _mm256_and_si256(rows[k][0], columns));
+                masked[1] = _mm256_or_si256(masked[1], _mm256_and_si256(rows[k][1], columns));
+            }
+            result[8*i + j] = boolMatMul_any_avx2(masked);
+        }
+    }
+    memcpy(product, result, sizeof(result));
+}
+#endif
+
+#ifdef COMPILE_AVX512
+// Every row in one register, & 'vptestmb' is the whole test: its mask is the product
+static inline TARGET_AVX512 __m512i boolMatMul_rows_avx512(const uint64_t a) {
+    const __m512i rowIndex = _mm512_set_epi64(0x0707070707070707LL, 0x0606060606060606LL, 0x0505050505050505LL, 0x0404040404040404LL,
+                                              0x0303030303030303LL, 0x0202020202020202LL, 0x0101010101010101LL, 0);
+    return _mm512_shuffle_epi8(_mm512_set1_epi64((long long)a), rowIndex);
+}
+
+static inline TARGET_AVX512 uint64_t boolMatMul_transposed_avx512(const uint64_t a, const uint64_t bt) {
+    return _mm512_test_epi8_mask(boolMatMul_rows_avx512(a), _mm512_set1_epi64((long long)bt));
+}
+
+static inline TARGET_AVX512 uint64_t boolMatMul_avx512(const uint64_t a, const uint64_t b) {
+    return boolMatMul_transposed_avx512(a, diagTranspose_avx512(b));
+}
+
+static inline TARGET_AVX512 void boolMatMul64_avx512(const uint64_t *a, const uint64_t *b, uint64_t *product) {
+    uint64_t bt[64], result[64];
+    for (size_t t=0; t < 64; t++)
+        bt[t] = diagTranspose_avx512(b[t]);
+
+    for (size_t i=0; i < 8; i++) {
+        __m512i rows[8];
+        for (size_t k=0; k < 8; k++)
+            rows[k] = boolMatMul_rows_avx512(a[8*i + k]);
+
+        for (size_t j=0; j < 8; j++) {
+            __m512i masked = _mm512_setzero_si512();
+            for (size_t k=0; k < 8; k++)
+                masked = _mm512_or_si512(masked, _mm512_and_si512(rows[k], _mm512_set1_epi64((long long)bt[8*k + j])));
+            result[8*i + j] = _mm512_test_epi8_mask(masked, masked);
+        }
+    }
+    memcpy(product, result, sizeof(result));
+}
+#endif
+
+// 'gf2p8affine' sums over GF(2) (a xor, so the parity of the paths), not the OR this needs: it only does the transpose
+#ifdef COMPILE_GFNI
+static inline TARGET_GFNI uint64_t boolMatMul_gfni(const uint64_t a, const uint64_t b) {
+    return boolMatMul_transposed_sse(a, diagTranspose_gfni(b));
+}
+#endif
+
+
+// ==================
+//      Closure
+// ==================
+// Squaring: 'reach | reach·reach' doubles the longest path it has, so 3 steps cover the 8 edges any node is reached in
+// (6 for 64 nodes, which stop early once nothing changes)
+#define BOOL_CLOSURE(method, target) \
+    static inline target uint64_t boolClosure_##method(uint64_t reach) { \
+        for (unsigned step=0; step < 3; step++) \
+            reach |= boolMatMul_##method(reach, reach); \
+        return reach; \
+    }
+
+#define BOOL_CLOSURE64(method, target) \
+    static inline target void boolClosure64_##method(uint64_t *reach) { \
+        for (unsigned step=0; step < 6; step++) { \
+            uint64_t square[64], changed = 0; \
+            boolMatMul64_##method(reach, reach, square); \
+            for (size_t t=0; t < 64; t++) { \
+                changed |= square[t] & ~reach[t]; \
+                reach[t] |= square[t]; \
+            } \
+            if (!changed) break; \
+        } \
+    }
+
+BOOL_CLOSURE(bin, )
+BOOL_CLOSURE64(bin, )
+#ifdef DIAG_X86
+BOOL_CLOSURE(sse, )
+BOOL_CLOSURE64(sse, )
+#endif
+#ifdef COMPILE_AVX2
+BOOL_CLOSURE(avx2, TARGET_AVX2)
+BOOL_CLOSURE64(avx2, TARGET_AVX2)
+#endif
+#ifdef COMPILE_AVX512
+BOOL_CLOSURE(avx512, TARGET_AVX512)
+BOOL_CLOSURE64(avx512, TARGET_AVX512)
+#endif
+#ifdef COMPILE_GFNI
+BOOL_CLOSURE(gfni, TARGET_GFNI)
+#endif
+
+
+// GFNI only does the transpose, slower than the AVX2 shuffles that follow it, so it is never the default
+#if defined(DIAG_PORTABLE)
+    #define BOOL_MATRIX_METHOD(op) op##_bin
+#elif defined(CPU_HAS_AVX512)
+    #define BOOL_MATRIX_METHOD(op) op##_avx512
+#elif defined(CPU_HAS_AVX2)
+    #define BOOL_MATRIX_METHOD(op) op##_avx2
+#else
+    #define BOOL_MATRIX_METHOD(op) op##_sse
+#endif
+#define boolMatMul      BOOL_MATRIX_METHOD(boolMatMul)
+#define boolClosure     BOOL_MATRIX_METHOD(boolClosure)
+#define boolMatMul64    BOOL_MATRIX_METHOD(boolMatMul64)
+#define boolClosure64   BOOL_MATRIX_METHOD(boolClosure64)
+
+#endif
@@ -0,0 +1,305 @@
+#ifndef BYTE_SHIFT_H
+#define BYTE_SHIFT_H
+
+#include <stdint.h>
+#include <stddef.h>     // size_t
+
+#include "cpuFeatures.h"
+#ifdef DIAG_X86
+#include <immintrin.h>  // SSE2, SSSE3, AVX2, AVX512bw/vl
+#endif
+
+// Every row (byte) of a board shifted by its own amount: 'shifts[r]' > 0 moves row 'r' to the left (higher columns,
+// like '<<'), < 0 to the right, and the bits moved off the row are dropped (so 8 or more clears it).
+// The diagonal shifts are fixed cases of it: 'diagShift_bl' is {7, 6, 5, 4, 3, 2, 1, 0}, 'diagShift_tr' {0, -1, ..., -7}.
+//
+// 'byteShiftVar(board, shifts)' takes the shifts at runtime, 'byteShiftConst(board, s0, ..., s7)' known at compile time
+// (folded into constant multipliers like 'diagShift_*_SSE', or counts), 'byteShiftVar_batch(in, out, n, shifts)' the same
+// shifts for every board.
+
+// The shifts as the bytes of a u64, row 0 in the low byte
+#define BYTE_SHIFTS(s0, s1, s2, s3, s4, s5, s6, s7) \
+    ((uint64_t)(uint8_t)(s0)       | (uint64_t)(uint8_t)(s1) << 8  | (uint64_t)(uint8_t)(s2) << 16 | (uint64_t)(uint8_t)(s3) << 24 | \
+     (uint64_t)(uint8_t)(s4) << 32 | (uint64_t)(uint8_t)(s5) << 40 | (uint64_t)(uint8_t)(s6) << 48 | (uint64_t)(uint8_t)(s7) << 56)
+
+DIAG_INLINE uint64_t byteShifts_pack(const int8_t shifts[8]) {
+    uint64_t packed = 0;
+    for (size_t r=0; r < 8; r++)
+        packed |= (uint64_t)(uint8_t)shifts[r] << 8*r;
+    return packed;
+}
+
+
+// ==================
+//       Linear
+// ==================
+DIAG_INLINE uint64_t byteShiftVar_lin(const uint64_t board, const int8_t shifts[8]) {
+    uint64_t result = 0;
+    for (size_t r=0; r < 8; r++) {
+        const int shift = shifts[r];
+        const unsigned row = (board >> 8*r) & UINT8_MAX;
+
+        unsigned shifted = 0;
+        if (shift >= 0 && shift < 8) shifted = row << shift;
+        else if (shift < 0 && shift > -8) shifted = row >> -shift;
+
+        result |= (uint64_t)(shifted & UINT8_MAX) << 8*r;
+    }
+    return result;
+}
+
+
+// ==================
+//  "Binary" method
+// ==================
+// 'diagShift_*_bin' with the rows of each step worked out from the shifts: left or right by 4, 2 then 1.
+// Known shifts fold into constant masks
+typedef struct {
+    uint64_t left[3], right[3];     // Rows taking the shift by 4, 2 & 1 (0xFF bytes)
+    uint64_t kept;                  // Rows not shifted off the board
+} ByteShiftMasks;
+
+// What's kept of every row shifted left or right by 'n'
+#define BYTE_SHIFT_KEEP_LEFT(n)     (0x0101010101010101ULL * (uint8_t)(UINT8_MAX << (n)))
+#define BYTE_SHIFT_KEEP_RIGHT(n)    (0x0101010101010101ULL * (uint8_t)(UINT8_MAX >> (n)))
+
+DIAG_INLINE ByteShiftMasks byteShift_masks(const uint64_t shifts) {
+    ByteShiftMasks masks = {{0, 0, 0}, {0, 0, 0}, 0};
+    for (size_t r=0; r < 8; r++) {
+        const int shift = (int8_t)(shifts >> 8*r);
+        const uint64_t row = (uint64_t)UINT8_MAX << 8*r;
+        if (shift <= -8 || shift >= 8) continue;
+
+        masks.kept |= row;
+        for (size_t step=0; step < 3; step++) {
+            if (shift > 0 && (shift & (4 >> step))) masks.left[step] |= row;
+            if (shift < 0 && (-shift & (4 >> step))) masks.right[step] |= row;
+        }
+    }
+    return masks;
+}
+
+DIAG_INLINE uint64_t byteShift_masked(uint64_t board, const ByteShiftMasks *masks) {
+    for (size_t step=0; step < 3; step++) {
+        const unsigned by = 4 >> step;
+        const uint64_t left = (board << by) & masks->left[step] & BYTE_SHIFT_KEEP_LEFT(by);
+        const uint64_t right = (board >> by) & masks->right[step] & BYTE_SHIFT_KEEP_RIGHT(by);
+        board = (board & ~(masks->left[step] | masks->right[step])) | left | right;
+    }
+    return board & masks->kept;
+}
+
+DIAG_INLINE uint64_t byteShift_bin(const uint64_t board, const uint64_t shifts) {
+    const ByteShiftMasks masks = byteShift_masks(shifts);
+    return byteShift_masked(board, &masks);
+}
+
+DIAG_INLINE uint64_t byteShiftVar_bin(const uint64_t board, const int8_t shifts[8]) {
+    return byteShift_bin(board, byteShifts_pack(shifts));
+}
+
+static inline void byteShiftVar_batch_bin(const uint64_t *in, uint64_t *out, size_t n, const int8_t shifts[8]) {
+    const ByteShiftMasks masks = byteShift_masks(byteShifts_pack(shifts));
+    for (size_t i=0; i < n; i++)
+        out[i] = byteShift_masked(in[i], &masks);
+}
+
+
+// ==================
+//     SSE based
+// ==================
+// Each row in the high byte of a 16-bit lane, then 'mulhi' by 2^(8 + s) leaves it shifted by 's' in the low byte,
+// to the left or the right: one multiply for both directions (the right shifts of 'diagShift_*_SSE' are the same).
+// What went past the row is masked off before 'packus'. Out of -8 to 7, the multiplier is 0.
+#ifdef DIAG_X86
+#define BYTE_SHIFT_POWER(s) ((uint16_t)(((s) >= -8 && (s) <= 7)? 1u << (8 + (s)) : 0))
+
+DIAG_INLINE uint64_t byteShift_mul(const uint64_t board, const __m128i powers) {
+    __m128i interleaved = _mm_unpacklo_epi8(_mm_setzero_si128(), _mm_cvtsi64_si128(board));
+    __m128i shifted = _mm_and_si128(_mm_mulhi_epu16(interleaved, powers), _mm_set1_epi16(UINT8_MAX));
+    return _mm_cvtsi128_si64(_mm_packus_epi16(shifted, shifted));
+}
+
+DIAG_INLINE __m128i byteShift_mul_x2(const __m128i boards, const __m128i powers) {
+    __m128i interLo = _mm_unpacklo_epi8(_mm_setzero_si128(), boards);
+    __m128i interHi = _mm_unpackhi_epi8(_mm_setzero_si128(), boards);
+
+    __m128i shiftedLo = _mm_and_si128(_mm_mulhi_epu16(interLo, powers), _mm_set1_epi16(UINT8_MAX));
+    __m128i shiftedHi = _mm_and_si128(_mm_mulhi_epu16(interHi, powers), _mm_set1_epi16(UINT8_MAX));
+    return _mm_packus_epi16(shiftedLo, shiftedHi);
+}
+
+// SSE2 has no per-lane shift to make 2^(8 + s) with, so the multipliers go through memory
+DIAG_INLINE __m128i byteShift_powers(const int8_t shifts[8]) {
+    uint16_t powers[8];
+    for (size_t r=0; r < 8; r++)
+        powers[r] = BYTE_SHIFT_POWER(shifts[r]);
+    return _mm_loadu_si128((const __m128i*)powers);
+}
+
+DIAG_INLINE uint64_t byteShiftVar_sse(const uint64_t board, const int8_t shifts[8]) {
+    return byteShift_mul(board, byteShift_powers(shifts));
+}
+
+// A board known at compile time takes the '_bin' version instead, which folds
+DIAG_INLINE uint64_t byteShift_const(const uint64_t board, const uint64_t shifts, const __m128i powers) {
+    if (DIAG_IS_CONSTANT(board)) return byteShift_bin(board, shifts);
+    return byteShift_mul(board, powers);
+}
+
+#define BYTE_SHIFT_POWERS(s0, s1, s2, s3, s4, s5, s6, s7) _mm_set_epi16( \
+    (short)BYTE_SHIFT_POWER(s7), (short)BYTE_SHIFT_POWER(s6), (short)BYTE_SHIFT_POWER(s5), (short)BYTE_SHIFT_POWER(s4), \
+    (short)BYTE_SHIFT_POWER(s3), (short)BYTE_SHIFT_POWER(s2), (short)BYTE_SHIFT_POWER(s1), (short)BYTE_SHIFT_POWER(s0))
+
+// 2 boards per iteration, the odd one out on its own
+static inline void byteShift_batch_sse(const uint64_t *in, uint64_t *out, size_t n, const __m128i powers) {
+    size_t i = 0;
+    for (; i + 2 <= n; i += 2)
+        _mm_storeu_si128((__m128i*)(out + i), byteShift_mul_x2(_mm_loadu_si128((const __m128i*)(in + i)), powers));
+
+    for (; i < n; i++)
+        out[i] = byteShift_mul(in[i], powers);
+}
+
+static inline void byteShiftVar_batch_sse(const uint64_t *in, uint64_t *out, size_t n, const int8_t shifts[8]) {
+    byteShift_batch_sse(in, out, n, byteShift_powers(shifts));
+}
+#endif
+
+
+// ==================
+//       SSSE3
+// ==================
+// 'pshufb' looks both bytes of each multiplier up from '8 + s' (0 to 15). Adding 0x70 with unsigned saturation keeps
+// those low 4 bits & sets the top bit of anything else, which 'pshufb' turns into a 0 multiplier
+#ifdef COMPILE_SSSE3
+static inline TARGET_SSSE3 __m128i byteShift_powers_ssse3(const int8_t shifts[8]) {
+    const __m128i lowBytes = _mm_setr_epi8(1, 2, 4, 8, 16, 32, 64, -128, 0, 0, 0, 0, 0, 0, 0, 0);
+    const __m128i highBytes = _mm_setr_epi8(0, 0, 0, 0, 0, 0, 0, 0, 1, 2, 4, 8, 16, 32, 64, -128);
+
+    __m128i index = _mm_add_epi8(_mm_loadl_epi64((const __m128i*)shifts), _mm_set1_epi8(8));
+    index = _mm_adds_epu8(index, _mm_set1_epi8(0x70));
+    return _mm_unpacklo_epi8(_mm_shuffle_epi8(lowBytes, index), _mm_shuffle_epi8(highBytes, index));
+}
+
+static inline TARGET_SSSE3 uint64_t byteShiftVar_ssse3(const uint64_t board, const int8_t shifts[8]) {
+    return byteShift_mul(board, byteShift_powers_ssse3(shifts));
+}
+#endif
+
+
+// ==================
+//     AVX2 & 512
+// ==================
+// Per-lane shifts: each row in bits 8 to 15 of its lane, shifted right by '8 - s' to end up shifted by 's' in the low byte.
+// Counts past the lane width give 0, so rows shifted off the board (& negative counts, as unsigned) need nothing more.
+// AVX2 only has 32 & 64-bit lanes ('vpsrlvd'), AVX-512 BW shifts 16-bit ones ('vpsrlvw', the right form of 'vpsllvw')
+#ifdef COMPILE_AVX2
+static inline TARGET_AVX2 uint64_t byteShiftVar_avx2(const uint64_t board, const int8_t shifts[8]) {
+    __m256i rows = _mm256_slli_epi32(_mm256_cvtepu8_epi32(_mm_cvtsi64_si128(board)), 8);
+    __m256i counts = _mm256_sub_epi32(_mm256_set1_epi32(8), _mm256_cvtepi8_epi32(_mm_loadl_epi64((const __m128i*)shifts)));
+    __m256i shifted = _mm256_and_si256(_mm256_srlv_epi32(rows, counts), _mm256_set1_epi32(UINT8_MAX));
+
+    // 'packus' works within 128-bit lanes: rows 0 to 3 end in the low dword of one, 4 to 7 of the other
+    __m128i packed = _mm_packus_epi32(_mm256_castsi256_si128(shifted), _mm256_extracti128_si256(shifted, 1));
+    return _mm_cvtsi128_si64(_mm_packus_epi16(packed, packed));
+}
+
+// 4 boards per iteration, the remainder is passed to the SSE version
+static inline TARGET_AVX2 void byteShiftVar_batch_avx2(const uint64_t *in, uint64_t *out, size_t n, const int8_t shifts[8]) {
+    const __m128i powers = byteShift_powers(shifts);
+    const __m256i powers_256 = _mm256_broadcastsi128_si256(powers);
+
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m256i boards = _mm256_loadu_si256((const __m256i*)(in + i));
+        __m256i interLo = _mm256_unpacklo_epi8(_mm256_setzero_si256(), boards);
+        __m256i interHi = _mm256_unpackhi_epi8(_mm256_setzero_si256(), boards);
+
+        __m256i shiftedLo = _mm256_and_si256(_mm256_mulhi_epu16(interLo, powers_256), _mm256_set1_epi16(UINT8_MAX));
+        __m256i shiftedHi = _mm256_and_si256(_mm256_mulhi_epu16(interHi, powers_256), _mm256_set1_epi16(UINT8_MAX));
+        _mm256_storeu_si256((__m256i*)(out + i), _mm256_packus_epi16(shiftedLo, shiftedHi));
+    }
+
+    byteShift_batch_sse(in + i, out + i, n - i, powers);
+}
+#endif
+
+#ifdef COMPILE_AVX512
+static inline TARGET_AVX512 uint64_t byteShift_srlv(const uint64_t board, const __m128i shifts) {
+    __m128i rows = _mm_unpacklo_epi8(_mm_setzero_si128(), _mm_cvtsi64_si128(board));
+    __m128i counts = _mm_sub_epi16(_mm_set1_epi16(8), _mm_cvtepi8_epi16(shifts));
+    return _mm_cvtsi128_si64(_mm_cvtepi16_epi8(_mm_srlv_epi16(rows, counts)));   // 'vpmovwb' drops the high bytes
+}
+
+static inline TARGET_AVX512 uint64_t byteShiftVar_avx512(const uint64_t board, const int8_t shifts[8]) {
+    return byteShift_srlv(board, _mm_loadl_epi64((const __m128i*)shifts));
+}
+
+// Known shifts fold into the counts, a known board into the '_bin' version
+static inline TARGET_AVX512 uint64_t byteShift_const_avx512(const uint64_t board, const uint64_t shifts) {
+    if (DIAG_IS_CONSTANT(board)) return byteShift_bin(board, shifts);
+    return byteShift_srlv(board, _mm_cvtsi64_si128((long long)shifts));
+}
+
+// Count of each 16-bit lane for its low (even) or high (odd) row
+static inline uint64_t byteShift_counts(const int8_t shifts[8], const size_t odd) {
+    uint64_t counts = 0;
+    for (size_t lane=0; lane < 4; lane++)
+        counts |= (uint64_t)(uint16_t)(8 - shifts[2*lane + odd]) << 16*lane;
+    return counts;
+}
+
+// 8 boards per iteration without widening: the even rows are moved up to the high byte, the odd rows are there already
+// and go back after their shift. The remainder is passed to the SSE version
+static inline TARGET_AVX512 void byteShiftVar_batch_avx512(const uint64_t *in, uint64_t *out, size_t n, const int8_t shifts[8]) {
+    const __m512i evenCounts = _mm512_set1_epi64((long long)byteShift_counts(shifts, 0));
+    const __m512i oddCounts = _mm512_set1_epi64((long long)byteShift_counts(shifts, 1));
+
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m512i boards = _mm512_loadu_si512(in + i);
+        __m512i even = _mm512_srlv_epi16(_mm512_slli_epi16(boards, 8), evenCounts);
+        __m512i odd = _mm512_srlv_epi16(_mm512_and_si512(boards, _mm512_set1_epi16((short)0xFF00)), oddCounts);
+        _mm512_storeu_si512(out + i, _mm512_or_si512(_mm512_and_si512(even, _mm512_set1_epi16(UINT8_MAX)), _mm512_slli_epi16(odd, 8)));
+    }
+
+    byteShiftVar_batch_sse(in + i, out + i, n - i, shifts);
+}
+#endif
+
+
+// SSSE3 looks the multipliers up instead of SSE2's scalar loop, so it is taken with AVX2 too (only the batch widens)
+#if defined(DIAG_PORTABLE)
+    #define byteShiftVar        byteShiftVar_bin
+    #define byteShiftVar_batch  byteShiftVar_batch_bin
+#else
+    #if defined(CPU_HAS_AVX512)
+        #define byteShiftVar    byteShiftVar_avx512
+    #elif defined(CPU_HAS_SSSE3) || defined(CPU_HAS_AVX2)
+        #define byteShiftVar    byteShiftVar_ssse3
+    #else
+        #define byteShiftVar    byteShiftVar_sse
+    #endif
+
+    #if defined(CPU_HAS_AVX512)
+        #define byteShiftVar_batch  byteShiftVar_batch_avx512
+    #elif defined(CPU_HAS_AVX2)
+        #define byteShiftVar_batch  byteShiftVar_batch_avx2
+    #else
+        #define byteShiftVar_batch  byteShiftVar_batch_sse
+    #endif
+#endif
+
+#if defined(DIAG_PORTABLE)
+    #define byteShiftConst(board, s0, s1, s2, s3, s4, s5, s6, s7) \
+        byteShift_bin(board, BYTE_SHIFTS(s0, s1, s2, s3, s4, s5, s6, s7))
+#elif defined(CPU_HAS_AVX512)
+    #define byteShiftConst(board, s0, s1, s2, s3, s4, s5, s6, s7) \
+        byteShift_const_avx512(board, BYTE_SHIFTS(s0, s1, s2, s3, s4, s5, s6, s7))
+#else
+    #define byteShiftConst(board, s0, s1, s2, s3, s4, s5, s6, s7) \
+        byteShift_const(board, BYTE_SHIFTS(s0, s1, s2, s3, s4, s5, s6, s7), BYTE_SHIFT_POWERS(s0, s1, s2, s3, s4, s5, s6, s7))
+#endif
+
+#endif
@@ -0,0 +1,148 @@
+#ifndef CPU_FEATURES_H
+#define CPU_FEATURES_H
+
+#include <stdint.h>
+
+// Which instruction set extensions can be used, and how.
+//
+// CPU_HAS_BMI2, CPU_HAS_AVX2, CPU_HAS_AVX512, CPU_HAS_GFNI: the target CPU is known to support them at compile time,
+// so the default functions (e.g. 'diagShift_bl_batch') use them directly: each header's defaults are the widest method
+// known to be supported at compile time ('dispatch.h' picks at runtime instead). CPU_HAS_AVX512 is F, BW & VL (every AVX-512 CPU
+// with BW has VL), CPU_HAS_VBMI & CPU_HAS_BITALG (Ice Lake & Zen 4 onwards) are on top of it. CPU_HAS_SSSE3 is implied by
+// CPU_HAS_AVX2 (every x86-64 CPU since Core 2 & Bulldozer has it).
+//
+// DIAG_RUNTIME_DISPATCH: every variant is compiled (using per function target attributes), whatever the
+// '-m' flags are, so 'dispatch.h' can pick between them at runtime. Only GCC/Clang support these attributes.
+//
+// DIAG_IS_CONSTANT(x): 'x' is known at compile time (after inlining). The intrinsic kernels then take their portable
+// version instead, which the compiler can fold into a constant: the intrinsics are opaque to it. Always 0 without GCC/Clang
+// (and Clang decides before inlining, so only literal arguments count there).
+//
+// DIAG_X86: SSE2 is available (always on x86-64), so the SSE, SAD & other intrinsic methods are compiled.
+// Without it only the portable ones are: "binary", multiplication, and the vector extension ('_vec') ones.
+//
+// DIAG_PORTABLE: the defaults (e.g. 'diagShift_bl_batch' & 'diagBitboard.h') use the '_vec' methods, even on x86,
+// so they can be tested & measured against the SSE ones. Always defined without DIAG_X86.
+//
+// Everything is defined in the headers, 'static inline' so any number of translation units can include them.
+// DIAG_INLINE: the single board kernels are a few instructions, less than the cost of a call, so they are always inlined.
+// The methods with a 'TARGET_*' attribute are only 'static inline': they can't be inlined into a caller without that target
+// (GCC refuses to compile an always_inline one), and are inlined as usual when the caller has it.
+
+#if defined(__GNUC__) || defined(__clang__)
+    #define TARGET_BMI2     __attribute__((target("bmi2")))
+    #define TARGET_PCLMUL   __attribute__((target("pclmul")))
+    #define TARGET_SSSE3    __attribute__((target("ssse3")))
+    #define TARGET_AVX2     __attribute__((target("avx2")))
+    #define TARGET_AVX512   __attribute__((target("avx512f,avx512bw,avx512vl")))
+    // 'vpmultishiftqb' & 'vpshufbitqmb', used at every width
+    #define TARGET_VBMI     __attribute__((target("avx512f,avx512bw,avx512vl,avx512vbmi")))
+    #define TARGET_BITALG   __attribute__((target("avx512f,avx512bw,avx512vl,avx512bitalg")))
+    // 'gf2p8affine' at each width, the 128-bit forms also use SSE4.1 blends & SSSE3 shuffles
+    #define TARGET_GFNI         __attribute__((target("gfni,sse4.1")))
+    #define TARGET_GFNI_AVX2    __attribute__((target("gfni,avx2")))
+    #define TARGET_GFNI_AVX512  __attribute__((target("gfni,avx512f,avx512bw,avx512vl")))
+
+    #define DIAG_IS_CONSTANT(x) __builtin_constant_p(x)
+    #define DIAG_INLINE         static inline __attribute__((always_inline))
+#else
+    #define TARGET_BMI2
+    #define TARGET_PCLMUL
+    #define TARGET_SSSE3
+    #define TARGET_AVX2
+    #define TARGET_AVX512
+    #define TARGET_VBMI
+    #define TARGET_BITALG
+    #define TARGET_GFNI
+    #define TARGET_GFNI_AVX2
+    #define TARGET_GFNI_AVX512
+
+    #define DIAG_IS_CONSTANT(x) 0
+    #define DIAG_INLINE         static inline
+
+    #ifdef DIAG_RUNTIME_DISPATCH
+        #error "Runtime dispatch requires GCC or Clang target attributes"
+    #endif
+#endif
+
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    #define DIAG_X86
+#else
+    #define DIAG_PORTABLE
+
+    #ifdef DIAG_RUNTIME_DISPATCH
+        #error "Runtime dispatch is only between x86 extensions"
+    #endif
+#endif
+
+// Any number of boards per vector (8 bytes each), the compiler splits or pairs them to its registers.
+// Only elementwise operations on constants broadcast from a 'uint64_t', so the byte order doesn't matter.
+#if defined(__GNUC__) || defined(__clang__)
+    #define COMPILE_VECTOR
+
+    // The widest registers the target has (16 bytes for SSE2 & NEON)
+    #ifndef DIAG_VECTOR_BYTES
+        #if defined(__AVX512BW__)
+            #define DIAG_VECTOR_BYTES 64
+        #elif defined(__AVX2__)
+            #define DIAG_VECTOR_BYTES 32
+        #else
+            #define DIAG_VECTOR_BYTES 16
+        #endif
+    #endif
+    #define DIAG_VECTOR_BOARDS (DIAG_VECTOR_BYTES / 8)
+
+    typedef uint64_t diagVec_u64 __attribute__((vector_size(DIAG_VECTOR_BYTES)));
+    typedef uint16_t diagVec_u16 __attribute__((vector_size(DIAG_VECTOR_BYTES)));
+    typedef uint8_t  diagVec_u8  __attribute__((vector_size(DIAG_VECTOR_BYTES)));
+    // A byte per board, for the extracts' output & the deposits' input ('__builtin_convertvector' to & from 'diagVec_u64')
+    typedef uint8_t  diagVec_bytes __attribute__((vector_size(DIAG_VECTOR_BOARDS)));
+
+    // Every lane set to 'x'
+    #define DIAG_VEC(x) ((diagVec_u64){0} + (uint64_t)(x))
+#elif !defined(DIAG_X86)
+    #error "Needs SSE2, or GCC/Clang vector extensions"
+#endif
+
+
+#if defined(DIAG_X86) && (defined(CPU_HAS_BMI2) || defined(DIAG_RUNTIME_DISPATCH))
+    #define COMPILE_BMI2
+#endif
+
+#if defined(DIAG_X86) && (defined(CPU_HAS_SSSE3) || defined(CPU_HAS_AVX2) || defined(DIAG_RUNTIME_DISPATCH))
+    #define COMPILE_SSSE3
+#endif
+
+#if defined(DIAG_X86) && (defined(CPU_HAS_AVX2) || defined(DIAG_RUNTIME_DISPATCH))
+    #define COMPILE_AVX2
+#endif
+
+#if defined(DIAG_X86) && (defined(CPU_HAS_AVX512) || defined(DIAG_RUNTIME_DISPATCH))
+    #define COMPILE_AVX512
+#endif
+
+#if defined(DIAG_X86) && (defined(CPU_HAS_VBMI) || defined(DIAG_RUNTIME_DISPATCH))
+    #define COMPILE_VBMI
+#endif
+
+#if defined(DIAG_X86) && (defined(CPU_HAS_BITALG) || defined(DIAG_RUNTIME_DISPATCH))
+    #define COMPILE_BITALG
+#endif
+
+#if defined(DIAG_X86) && (defined(CPU_HAS_GFNI) || defined(DIAG_RUNTIME_DISPATCH))
+    #define COMPILE_GFNI
+#endif
+
+
+// 'gf2p8affine(x, A)' multiplies every byte of 'x' by the 8x8 bit matrix in the same 64-bit lane of 'A':
+// output bit 'i' is the parity of "A.byte[7-i] & x". So a matrix that maps output bit 'i' to input bit 'i'
+// has row 'i' (byte 7-i) set to '1 << i', and each whole byte shift of it shifts every 'x' byte by a bit.
+#define GF2P8_IDENTITY  0x0102040810204080ULL
+#define GF2P8_MIRROR    0x8040201008040201ULL // Reverses the bits of each byte
+#define GF2P8_SHL(n)    (GF2P8_IDENTITY >> 8*(n))
+#define GF2P8_SHR(n)    (GF2P8_IDENTITY << 8*(n))
+// As 'x' instead: byte 'j' = '1 << j', so output byte 'j' gathers bit 'j' of every matrix byte (in reverse order)
+#define GF2P8_SELECT_COLUMN 0x8040201008040201ULL
+
+#endif
@@ -0,0 +1,4 @@
+// The 'diagbitboard' static library: the 'diag_' API of 'diagBitboard.h' as ordinary (out-of-line) functions.
+// Callers define DIAG_LIBRARY and link it, see 'CMakeLists.txt'.
+#define DIAG_LIBRARY_BUILD
+#include "diagBitboard.h"
@@ -0,0 +1,170 @@
+#ifndef DIAG_BITBOARD_H
+#define DIAG_BITBOARD_H
+
+#include <stdint.h>
+#include <stddef.h>     // size_t
+
+// Every operation behind one prefixed API, the method picked at compile time from the CPU_HAS_* flags
+// (the same choices 'dispatch.h' makes at runtime): 'diag_shift_bl', 'diag_extract_back', 'diag_toDiag_fwd',
+// 'diag_transpose', 'diag_bishopAttacks' ..., and the batched 'diag_*_batch'.
+//
+// Header only by default: every function is 'DIAG_INLINE', so it costs the same as using the method directly.
+// DIAG_LIBRARY: only the declarations, link the 'diagbitboard' static library ('diagBitboard.c') instead.
+// Every call is then out-of-line, unless the library & the caller are built with link time optimisation (CMake's DIAG_LTO).
+
+#if defined(DIAG_LIBRARY) && !defined(DIAG_LIBRARY_BUILD)
+    #define DIAG_API(signature, ...) DIAG_UNWRAP signature;
+#else
+    #include "cpuFeatures.h"
+    #include "diagShift.h"
+    #include "diagToHorizontal.h"
+    #include "horizontalTo64.h"
+    #include "transpose.h"
+    #include "slidingAttacks.h"
+    #include "symmetry.h"
+    #include "diagPopcount.h"
+    #include "rotate45.h"
+    #include "byteShift.h"
+    #include "boolMatrix.h"
+
+    #ifdef DIAG_LIBRARY_BUILD
+        #define DIAG_API(signature, ...) DIAG_UNWRAP signature __VA_ARGS__
+    #else
+        #define DIAG_API(signature, ...) DIAG_INLINE DIAG_UNWRAP signature __VA_ARGS__
+    #endif
+
+    // pext/pdep are a single instruction, otherwise the SAD & SSE versions are the fastest.
+    // DIAG_PORTABLE (and any target but x86) takes the vector extension versions
+    #if defined(DIAG_PORTABLE)
+        #define DIAG_EXTRACT_BACK   diagToHorizontal_back_vec
+        #define DIAG_EXTRACT_FWD    diagToHorizontal_fwd_vec
+        #define DIAG_TO_DIAG_FWD    toDiag_fwd_vec
+        #define DIAG_TO_VERTICAL    toVertical_vec
+    #elif defined(CPU_HAS_BMI2)
+        #define DIAG_EXTRACT_BACK   diagToHorizontal_back_pext
+        #define DIAG_EXTRACT_FWD    diagToHorizontal_fwd_pext
+        #define DIAG_TO_DIAG_FWD    toDiagonal_fwd_pdep
+        #define DIAG_TO_VERTICAL    toVertical_pdep
+    #else
+        #define DIAG_EXTRACT_BACK   diagToHorizontal_back_SAD
+        #define DIAG_EXTRACT_FWD    diagToHorizontal_fwd_SAD
+        #define DIAG_TO_DIAG_FWD    toDiag_fwd_sse
+        #define DIAG_TO_VERTICAL    toVertical_sse
+    #endif
+
+    // 'vpmultishiftqb' shifts every row in one instruction, and the AVX-512 masked move deposits (\) with less
+    // port pressure than the broadcast (the BITALG extracts lose to pext & the SAD, so only the batches use them)
+    #if defined(DIAG_PORTABLE)
+        #define DIAG_SHIFT(direction) diagShift_##direction##_vec
+        #define DIAG_TO_DIAG_BACK   toDiag_back_vec
+    #else
+        #if defined(CPU_HAS_VBMI)
+            #define DIAG_SHIFT(direction) diagShift_##direction##_vbmi
+        #else
+            #define DIAG_SHIFT(direction) diagShift_##direction##_SSE
+        #endif
+
+        #if defined(CPU_HAS_AVX512)
+            #define DIAG_TO_DIAG_BACK   toDiag_back_avx512
+        #else
+            #define DIAG_TO_DIAG_BACK   toDiag_back_sse
+        #endif
+    #endif
+
+    #if defined(DIAG_PORTABLE)
+        #define DIAG_TRANSPOSE      diagTranspose_vec
+    #elif defined(CPU_HAS_GFNI)
+        #define DIAG_TRANSPOSE      diagTranspose_gfni
+    #elif defined(CPU_HAS_AVX512)
+        #define DIAG_TRANSPOSE      diagTranspose_avx512
+    #elif defined(CPU_HAS_AVX2)
+        #define DIAG_TRANSPOSE      diagTranspose_avx2
+    #else
+        #define DIAG_TRANSPOSE      diagTranspose_sse
+    #endif
+#endif
+
+// The signature is in brackets, as its parameters have commas
+#define DIAG_UNWRAP(...) __VA_ARGS__
+
+
+// ==================
+//    Single board
+// ==================
+// Shifts: bottom/top to the left/right (\ -> |, / -> |, / -> |, \ -> |)
+DIAG_API((uint64_t diag_shift_bl(const uint64_t board)), { return DIAG_SHIFT(bl)(board); })
+DIAG_API((uint64_t diag_shift_tl(const uint64_t board)), { return DIAG_SHIFT(tl)(board); })
+DIAG_API((uint64_t diag_shift_br(const uint64_t board)), { return DIAG_SHIFT(br)(board); })
+DIAG_API((uint64_t diag_shift_tr(const uint64_t board)), { return DIAG_SHIFT(tr)(board); })
+
+// Main diagonals to a byte (\ -> -, / -> -) & back (- -> \, - -> /), rank to the first file (- -> |)
+DIAG_API((uint8_t diag_extract_back(const uint64_t board)), { return DIAG_EXTRACT_BACK(board); })
+DIAG_API((uint8_t diag_extract_fwd(const uint64_t board)), { return DIAG_EXTRACT_FWD(board); })
+DIAG_API((uint64_t diag_toDiag_back(const uint8_t input)), { return DIAG_TO_DIAG_BACK(input); })
+DIAG_API((uint64_t diag_toDiag_fwd(const uint8_t input)), { return DIAG_TO_DIAG_FWD(input); })
+DIAG_API((uint64_t diag_toVertical(const uint8_t input)), { return DIAG_TO_VERTICAL(input); })
+
+// Diagonal 'k', -7 to 7 (see 'diagToHorizontal.h')
+DIAG_API((uint8_t diag_extract_back_k(const uint64_t board, const int k)), { return diagExtract_back(board, k); })
+DIAG_API((uint8_t diag_extract_fwd_k(const uint64_t board, const int k)), { return diagExtract_fwd(board, k); })
+DIAG_API((uint64_t diag_toDiag_back_k(const uint8_t input, const int k)), { return diagDeposit_back(input, k); })
+DIAG_API((uint64_t diag_toDiag_fwd_k(const uint8_t input, const int k)), { return diagDeposit_fwd(input, k); })
+
+DIAG_API((uint64_t diag_transpose(const uint64_t board)), { return DIAG_TRANSPOSE(board); })
+
+// Row 'r' shifted left by 'shifts[r]', or right when negative (see 'byteShift.h')
+DIAG_API((uint64_t diag_byteShift(const uint64_t board, const int8_t shifts[8])), { return byteShiftVar(board, shifts); })
+
+// Boards as 8 node adjacency matrices: boolean product & transitive closure, then 64 nodes as 64 tiles (see 'boolMatrix.h')
+DIAG_API((uint64_t diag_boolMatMul(const uint64_t a, const uint64_t b)), { return boolMatMul(a, b); })
+DIAG_API((uint64_t diag_boolClosure(const uint64_t reach)), { return boolClosure(reach); })
+DIAG_API((void diag_boolMatMul64(const uint64_t *a, const uint64_t *b, uint64_t *product)), { boolMatMul64(a, b, product); })
+DIAG_API((void diag_boolClosure64(uint64_t *reach)), { boolClosure64(reach); })
+
+// Pseudo-rotations by 45 degrees & their inverses, then diagonal 'k' read from them (see 'rotate45.h')
+DIAG_API((uint64_t diag_rotate45_clockwise(const uint64_t board)), { return diagRotate45_clockwise(board); })
+DIAG_API((uint64_t diag_rotate45_antiClock(const uint64_t board)), { return diagRotate45_antiClock(board); })
+DIAG_API((uint64_t diag_unrotate45_clockwise(const uint64_t rotated)), { return diagUnrotate45_clockwise(rotated); })
+DIAG_API((uint64_t diag_unrotate45_antiClock(const uint64_t rotated)), { return diagUnrotate45_antiClock(rotated); })
+DIAG_API((uint8_t diag_rotated45_back(const uint64_t clockwise, const int k)), { return rotated45_back(clockwise, k); })
+DIAG_API((uint8_t diag_rotated45_fwd(const uint64_t antiClock, const int k)), { return rotated45_fwd(antiClock, k); })
+
+// The 8 rotations & reflections (see 'symmetry.h'), the smallest of them, and the canonical planes of a position
+DIAG_API((void diag_symmetries(const uint64_t board, uint64_t images[8])), { diagSymmetries(board, images); })
+DIAG_API((uint64_t diag_canonical(const uint64_t board)), { return diagCanonical(board); })
+DIAG_API((unsigned diag_canonicalPlanes(const uint64_t *planes, size_t count, uint64_t *out)), { return diagCanonicalPlanes(planes, count, out); })
+
+// Set squares on each diagonal, 'out[k + 7]' for diagonal 'k' (see 'diagPopcount.h')
+DIAG_API((void diag_popcounts_back(const uint64_t board, uint8_t out[15])), { diagPopcounts_back(board, out); })
+DIAG_API((void diag_popcounts_fwd(const uint64_t board, uint8_t out[15])), { diagPopcounts_fwd(board, out); })
+
+DIAG_API((uint64_t diag_bishopAttacks(const unsigned square, const uint64_t occupied)), { return bishopAttacks(square, occupied); })
+DIAG_API((uint64_t diag_rookAttacks(const unsigned square, const uint64_t occupied)), { return rookAttacks(square, occupied); })
+DIAG_API((uint64_t diag_queenAttacks(const unsigned square, const uint64_t occupied)), { return queenAttacks(square, occupied); })
+// Every (\ & /) attack of all the 'sliders' together, blocked by anything but the 'empty' squares
+DIAG_API((uint64_t diag_bishopAttacksSetwise(const uint64_t sliders, const uint64_t empty)), { return diagonalAttacksSetwise(sliders, empty); })
+
+
+// ==================
+//      Batched
+// ==================
+DIAG_API((void diag_shift_bl_batch(const uint64_t *in, uint64_t *out, size_t n)), { diagShift_bl_batch(in, out, n); })
+DIAG_API((void diag_shift_tl_batch(const uint64_t *in, uint64_t *out, size_t n)), { diagShift_tl_batch(in, out, n); })
+DIAG_API((void diag_shift_br_batch(const uint64_t *in, uint64_t *out, size_t n)), { diagShift_br_batch(in, out, n); })
+DIAG_API((void diag_shift_tr_batch(const uint64_t *in, uint64_t *out, size_t n)), { diagShift_tr_batch(in, out, n); })
+DIAG_API((void diag_extract_back_batch(const uint64_t *in, uint8_t *out, size_t n)), { diagToHorizontal_back_batch(in, out, n); })
+DIAG_API((void diag_extract_fwd_batch(const uint64_t *in, uint8_t *out, size_t n)), { diagToHorizontal_fwd_batch(in, out, n); })
+DIAG_API((void diag_toDiag_back_batch(const uint8_t *in, uint64_t *out, size_t n)), { toDiag_back_batch(in, out, n); })
+DIAG_API((void diag_toDiag_fwd_batch(const uint8_t *in, uint64_t *out, size_t n)), { toDiag_fwd_batch(in, out, n); })
+DIAG_API((void diag_toVertical_batch(const uint8_t *in, uint64_t *out, size_t n)), { toVertical_batch(in, out, n); })
+DIAG_API((void diag_transpose_batch(const uint64_t *in, uint64_t *out, size_t n)), { diagTranspose_batch(in, out, n); })
+DIAG_API((void diag_byteShift_batch(const uint64_t *in, uint64_t *out, size_t n, const int8_t shifts[8])), { byteShiftVar_batch(in, out, n, shifts); })
+DIAG_API((void diag_rotate45_clockwise_batch(const uint64_t *in, uint64_t *out, size_t n)), { diagRotate45_clockwise_batch(in, out, n); })
+DIAG_API((void diag_rotate45_antiClock_batch(const uint64_t *in, uint64_t *out, size_t n)), { diagRotate45_antiClock_batch(in, out, n); })
+DIAG_API((void diag_unrotate45_clockwise_batch(const uint64_t *in, uint64_t *out, size_t n)), { diagUnrotate45_clockwise_batch(in, out, n); })
+DIAG_API((void diag_unrotate45_antiClock_batch(const uint64_t *in, uint64_t *out, size_t n)), { diagUnrotate45_antiClock_batch(in, out, n); })
+DIAG_API((void diag_symmetries_batch(const uint64_t *in, uint64_t *out, size_t n)), { diagSymmetries_batch(in, out, n); })
+DIAG_API((void diag_popcounts_back_batch(const uint64_t *in, uint8_t *out, size_t n)), { diagPopcounts_back_batch(in, out, n); })
+DIAG_API((void diag_popcounts_fwd_batch(const uint64_t *in, uint8_t *out, size_t n)), { diagPopcounts_fwd_batch(in, out, n); })
+
+#endif
@@ -0,0 +1,337 @@
+#ifndef DIAG_POPCOUNT_H
+#define DIAG_POPCOUNT_H
+
+#include <stdint.h>
+#include <stddef.h>     // size_t
+#include <string.h>     // memcpy
+
+#include "cpuFeatures.h"
+#include "tableGen.h"
+#include "diagShift.h"  // The shifts & their multipliers
+#include "transpose.h"  // flipDiagA1H8 & its vectors
+#ifdef DIAG_X86
+#include <immintrin.h>  // SSE2, AVX2, AVX512bw, BITALG
+#endif
+
+// The number of set squares on each of the 15 diagonals (\) or anti-diagonals (/) of a board, all at once.
+// 'out[k + 7]' is diagonal 'k', the same indexing as 'backDiagonals' & 'fwdDiagonals' ('out[7]' is the main one).
+//
+// The shifts turn diagonals into columns: bottom left (\) puts diagonal 'k <= 0' in column 'k + 7', top right the ones
+// with 'k >= 0' in column 'k' (top left & bottom right for /). The transpose makes the columns rows, so a byte-wise
+// popcount counts every diagonal: bytes 0 to 7 of the first half are 'out[0..7]', of the second 'out[7..14]'.
+
+// Counts of each byte, in place
+DIAG_INLINE uint64_t popcountBytes(uint64_t x) {
+    x -= (x >> 1) & 0x5555555555555555ULL;
+    x = (x & 0x3333333333333333ULL) + ((x >> 2) & 0x3333333333333333ULL);
+    return (x + (x >> 4)) & 0x0F0F0F0F0F0F0F0FULL;
+}
+
+// Both halves to 'out' (2 overlapping stores, the main diagonal is in both). Byte 'j' is the lowest but 'j' on little endian
+DIAG_INLINE void diagPopcounts_store(const uint64_t lower, const uint64_t upper, uint8_t out[15]) {
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    for (int j=0; j < 8; j++) out[j] = (uint8_t)(lower >> 8*j);
+    for (int j=0; j < 8; j++) out[7 + j] = (uint8_t)(upper >> 8*j);
+#else
+    memcpy(out, &lower, 8);
+    memcpy(out + 7, &upper, 8);
+#endif
+}
+
+DIAG_INLINE void diagPopcounts_back_bin(const uint64_t board, uint8_t out[15]) {
+    diagPopcounts_store(popcountBytes(flipDiagA1H8(diagShift_bl_bin(board))), popcountBytes(flipDiagA1H8(diagShift_tr_bin(board))), out);
+}
+
+DIAG_INLINE void diagPopcounts_fwd_bin(const uint64_t board, uint8_t out[15]) {
+    diagPopcounts_store(popcountBytes(flipDiagA1H8(diagShift_tl_bin(board))), popcountBytes(flipDiagA1H8(diagShift_br_bin(board))), out);
+}
+
+
+// ==================
+//        SSE
+// ==================
+// Both halves in one vector: each row in the high byte of a 16-bit lane, 'mulhi' by '2^(8 + s)' shifts it left by 's',
+// by '2^(8 - s)' right. Then a single transpose & popcount for the 2 of them
+#ifdef DIAG_X86
+
+// Multipliers of rows 7 to 0: bottom left (row 'r' << '7 - r'), top left ('<< r'). The right ones are the shifts' own
+#define DIAG_POPCOUNT_BL_POWERS _mm_set_epi16(1<<8, 1<<9, 1<<10, 1<<11, 1<<12, 1<<13, 1<<14, (short)(1u<<15))
+#define DIAG_POPCOUNT_TL_POWERS _mm_set_epi16((short)(1u<<15), 1<<14, 1<<13, 1<<12, 1<<11, 1<<10, 1<<9, 1<<8)
+
+// SSE2 has no byte shift or shuffle, so the same SWAR as 'popcountBytes'
+DIAG_INLINE __m128i popcountBytes_x2(__m128i x) {
+    const __m128i k1 = _mm_set1_epi8(0x55), k2 = _mm_set1_epi8(0x33), k4 = _mm_set1_epi8(0x0F);
+    x = _mm_sub_epi8(x, _mm_and_si128(_mm_srli_epi64(x, 1), k1));
+    x = _mm_add_epi8(_mm_and_si128(x, k2), _mm_and_si128(_mm_srli_epi64(x, 2), k2));
+    return _mm_and_si128(_mm_add_epi8(x, _mm_srli_epi64(x, 4)), k4);
+}
+
+DIAG_INLINE __m128i diagPopcounts_x2(const uint64_t board, const __m128i lowerPowers, const __m128i upperPowers) {
+    const __m128i rows = _mm_unpacklo_epi8(_mm_setzero_si128(), _mm_cvtsi64_si128(board));
+    const __m128i lower = _mm_mulhi_epu16(rows, lowerPowers), upper = _mm_mulhi_epu16(rows, upperPowers);
+
+    const __m128i shifted = _mm_packus_epi16(_mm_and_si128(lower, _mm_set1_epi16(UINT8_MAX)), upper);
+    return popcountBytes_x2(flipDiagA1H8_x2(shifted));
+}
+
+DIAG_INLINE void diagPopcounts_storeLanes(const __m128i counts, uint8_t out[15]) {
+    _mm_storel_epi64((__m128i*)out, counts);
+    _mm_storel_epi64((__m128i*)(out + 7), _mm_unpackhi_epi64(counts, counts));
+}
+
+DIAG_INLINE void diagPopcounts_back_sse(const uint64_t board, uint8_t out[15]) {
+    diagPopcounts_storeLanes(diagPopcounts_x2(board, DIAG_POPCOUNT_BL_POWERS, DIAG_SHIFT_TR_POWERS), out);
+}
+
+DIAG_INLINE void diagPopcounts_fwd_sse(const uint64_t board, uint8_t out[15]) {
+    diagPopcounts_storeLanes(diagPopcounts_x2(board, DIAG_POPCOUNT_TL_POWERS, DIAG_SHIFT_BR_POWERS), out);
+}
+#endif
+
+
+// ==================
+//   AVX-512 BITALG
+// ==================
+// No shift or transpose: 'vpshufbitqmb' gathers the squares of a diagonal (one per row, a qword of square indices)
+// into a byte of the mask, 8 diagonals per instruction. The missing rows of the shorter ones are masked out,
+// then 'vpopcntb' counts the 2 masks, and a masked store writes the 15 bytes.
+#define DIAG_POPCOUNT_SQUARE(i, square) ((uint64_t)((square) & 63) << 8*(i))
+
+// Row 'i' of diagonal 'd' ('k = d - 7') is column 'i + k' (\) or '7 + k - i' (/)
+#define DIAG_POPCOUNT_BACK_SQUARES(d, unused) ( \
+    DIAG_POPCOUNT_SQUARE(0, (d) - 7) | DIAG_POPCOUNT_SQUARE(1, 9 + (d) - 7) | DIAG_POPCOUNT_SQUARE(2, 18 + (d) - 7) | \
+    DIAG_POPCOUNT_SQUARE(3, 27 + (d) - 7) | DIAG_POPCOUNT_SQUARE(4, 36 + (d) - 7) | DIAG_POPCOUNT_SQUARE(5, 45 + (d) - 7) | \
+    DIAG_POPCOUNT_SQUARE(6, 54 + (d) - 7) | DIAG_POPCOUNT_SQUARE(7, 63 + (d) - 7))
+#define DIAG_POPCOUNT_FWD_SQUARES(d, unused) ( \
+    DIAG_POPCOUNT_SQUARE(0, (d)) | DIAG_POPCOUNT_SQUARE(1, 7 + (d)) | DIAG_POPCOUNT_SQUARE(2, 14 + (d)) | \
+    DIAG_POPCOUNT_SQUARE(3, 21 + (d)) | DIAG_POPCOUNT_SQUARE(4, 28 + (d)) | DIAG_POPCOUNT_SQUARE(5, 35 + (d)) | \
+    DIAG_POPCOUNT_SQUARE(6, 42 + (d)) | DIAG_POPCOUNT_SQUARE(7, 49 + (d)))
+
+// The rows diagonal 'd' is on, none for the 16th
+#define DIAG_POPCOUNT_BACK_ROWS(d, unused) ((d) > 14 ? 0 : (d) >= 7 ? 0xFF >> ((d) - 7) : (0xFF << (7 - (d))) & 0xFF)
+#define DIAG_POPCOUNT_FWD_ROWS(d, unused)  ((d) > 14 ? 0 : (d) >= 7 ? (0xFF << ((d) - 7)) & 0xFF : 0xFF >> (7 - (d)))
+
+static const uint64_t diagPopcounts_backSquares[16] = { TABLE_16(DIAG_POPCOUNT_BACK_SQUARES, 0) };
+static const uint64_t diagPopcounts_fwdSquares[16] = { TABLE_16(DIAG_POPCOUNT_FWD_SQUARES, 0) };
+static const uint8_t diagPopcounts_backRows[16] = { TABLE_16(DIAG_POPCOUNT_BACK_ROWS, 0) };
+static const uint8_t diagPopcounts_fwdRows[16] = { TABLE_16(DIAG_POPCOUNT_FWD_ROWS, 0) };
+
+#ifdef COMPILE_BITALG
+static inline TARGET_BITALG void diagPopcounts_bitshuffle(const uint64_t board, const uint64_t squares[16], const uint8_t rows[16], uint8_t out[15]) {
+    uint64_t lowerRows, upperRows;
+    memcpy(&lowerRows, rows, 8);
+    memcpy(&upperRows, rows + 8, 8);
+
+    const __m512i boards = _mm512_set1_epi64((long long)board);
+    const __mmask64 lower = _mm512_mask_bitshuffle_epi64_mask(_cvtu64_mask64(lowerRows), boards, _mm512_loadu_si512(squares));
+    const __mmask64 upper = _mm512_mask_bitshuffle_epi64_mask(_cvtu64_mask64(upperRows), boards, _mm512_loadu_si512(squares + 8));
+
+    const __m128i counts = _mm_popcnt_epi8(_mm_set_epi64x((long long)_cvtmask64_u64(upper), (long long)_cvtmask64_u64(lower)));
+    _mm_mask_storeu_epi8(out, 0x7FFF, counts);
+}
+
+static inline TARGET_BITALG void diagPopcounts_back_bitalg(const uint64_t board, uint8_t out[15]) {
+    diagPopcounts_bitshuffle(board, diagPopcounts_backSquares, diagPopcounts_backRows, out);
+}
+
+static inline TARGET_BITALG void diagPopcounts_fwd_bitalg(const uint64_t board, uint8_t out[15]) {
+    diagPopcounts_bitshuffle(board, diagPopcounts_fwdSquares, diagPopcounts_fwdRows, out);
+}
+#endif
+
+
+
+// ==================
+//      Batched
+// ==================
+// 'n' boards in, 15 counts each out: diagonal 'k' of 'in[i]' is 'out[15*i + k + 7]'.
+// Every lane is its own board: both halves are shifted with the batched shifts, then transposed & counted.
+
+static inline void diagPopcounts_back_batch_bin(const uint64_t *in, uint8_t *out, size_t n) {
+    for (size_t i=0; i < n; i++)
+        diagPopcounts_back_bin(in[i], out + 15*i);
+}
+
+static inline void diagPopcounts_fwd_batch_bin(const uint64_t *in, uint8_t *out, size_t n) {
+    for (size_t i=0; i < n; i++)
+        diagPopcounts_fwd_bin(in[i], out + 15*i);
+}
+
+// The counts of each board in its lanes of the 2 halves
+DIAG_INLINE void diagPopcounts_storeBoards(const uint64_t *lower, const uint64_t *upper, const size_t boards, uint8_t *out) {
+    for (size_t b=0; b < boards; b++)
+        diagPopcounts_store(lower[b], upper[b], out + 15*b);
+}
+
+#ifdef DIAG_X86
+// 2 boards per iteration, the odd one out in the low lane of its own vector
+static inline void diagPopcounts_batch_sse(const uint64_t *in, uint8_t *out, size_t n, const __m128i leftPowers, const __m128i rightPowers) {
+    uint64_t lower[2], upper[2];
+    size_t i = 0;
+    for (; i < n; i += 2) {
+        const size_t boards = (i + 2 <= n)? 2 : 1;
+        const __m128i toCount = (boards == 2)? _mm_loadu_si128((const __m128i*)(in + i)) : _mm_cvtsi64_si128(in[i]);
+
+        _mm_storeu_si128((__m128i*)lower, popcountBytes_x2(flipDiagA1H8_x2(diagShift_left_x2(toCount, leftPowers))));
+        _mm_storeu_si128((__m128i*)upper, popcountBytes_x2(flipDiagA1H8_x2(diagShift_right_x2(toCount, rightPowers))));
+        diagPopcounts_storeBoards(lower, upper, boards, out + 15*i);
+    }
+}
+
+static inline void diagPopcounts_back_batch_sse(const uint64_t *in, uint8_t *out, size_t n) {
+    diagPopcounts_batch_sse(in, out, n, DIAG_SHIFT_BL_POWERS, DIAG_SHIFT_TR_POWERS);
+}
+
+static inline void diagPopcounts_fwd_batch_sse(const uint64_t *in, uint8_t *out, size_t n) {
+    diagPopcounts_batch_sse(in, out, n, DIAG_SHIFT_TL_POWERS, DIAG_SHIFT_BR_POWERS);
+}
+#endif
+
+// 'pshufb' looks up the count of each nibble
+#define DIAG_NIBBLE_POPCOUNTS _mm_setr_epi8(0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4)
+
+#ifdef COMPILE_AVX2
+static inline TARGET_AVX2 __m256i popcountBytes_x4(const __m256i x) {
+    const __m256i counts = _mm256_broadcastsi128_si256(DIAG_NIBBLE_POPCOUNTS), nibble = _mm256_set1_epi8(0x0F);
+    const __m256i low = _mm256_and_si256(x, nibble), high = _mm256_and_si256(_mm256_srli_epi16(x, 4), nibble);
+    return _mm256_add_epi8(_mm256_shuffle_epi8(counts, low), _mm256_shuffle_epi8(counts, high));
+}
+
+// 4 boards per iteration, the remainder is passed to the SSE version
+static inline TARGET_AVX2 void diagPopcounts_batch_avx2(const uint64_t *in, uint8_t *out, size_t n, const __m128i leftPowers, const __m128i rightPowers) {
+    const __m256i leftPowers_256 = _mm256_broadcastsi128_si256(leftPowers), rightPowers_256 = _mm256_broadcastsi128_si256(rightPowers);
+
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        const __m256i boards = _mm256_loadu_si256((const __m256i*)(in + i));
+        uint64_t lower[4], upper[4];
+        _mm256_storeu_si256((__m256i*)lower, popcountBytes_x4(flipDiagA1H8_x4(diagShift_left_x4(boards, leftPowers_256))));
+        _mm256_storeu_si256((__m256i*)upper, popcountBytes_x4(flipDiagA1H8_x4(diagShift_right_x4(boards, rightPowers_256))));
+        diagPopcounts_storeBoards(lower, upper, 4, out + 15*i);
+    }
+
+    diagPopcounts_batch_sse(in + i, out + 15*i, n - i, leftPowers, rightPowers);
+}
+
+static inline TARGET_AVX2 void diagPopcounts_back_batch_avx2(const uint64_t *in, uint8_t *out, size_t n) {
+    diagPopcounts_batch_avx2(in, out, n, DIAG_SHIFT_BL_POWERS, DIAG_SHIFT_TR_POWERS);
+}
+
+static inline TARGET_AVX2 void diagPopcounts_fwd_batch_avx2(const uint64_t *in, uint8_t *out, size_t n) {
+    diagPopcounts_batch_avx2(in, out, n, DIAG_SHIFT_TL_POWERS, DIAG_SHIFT_BR_POWERS);
+}
+#endif
+
+#ifdef COMPILE_AVX512
+static inline TARGET_AVX512 __m512i popcountBytes_x8(const __m512i x) {
+    const __m512i counts = _mm512_broadcast_i32x4(DIAG_NIBBLE_POPCOUNTS), nibble = _mm512_set1_epi8(0x0F);
+    const __m512i low = _mm512_and_si512(x, nibble), high = _mm512_and_si512(_mm512_srli_epi16(x, 4), nibble);
+    return _mm512_add_epi8(_mm512_shuffle_epi8(counts, low), _mm512_shuffle_epi8(counts, high));
+}
+
+// 8 boards per iteration, the remainder is passed to the SSE version
+static inline TARGET_AVX512 void diagPopcounts_batch_avx512(const uint64_t *in, uint8_t *out, size_t n, const __m128i leftPowers, const __m128i rightPowers) {
+    const __m512i leftPowers_512 = _mm512_broadcast_i32x4(leftPowers), rightPowers_512 = _mm512_broadcast_i32x4(rightPowers);
+
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        const __m512i boards = _mm512_loadu_si512(in + i);
+        uint64_t lower[8], upper[8];
+        _mm512_storeu_si512(lower, popcountBytes_x8(flipDiagA1H8_x8(diagShift_left_x8(boards, leftPowers_512))));
+        _mm512_storeu_si512(upper, popcountBytes_x8(flipDiagA1H8_x8(diagShift_right_x8(boards, rightPowers_512))));
+        diagPopcounts_storeBoards(lower, upper, 8, out + 15*i);
+    }
+
+    diagPopcounts_batch_sse(in + i, out + 15*i, n - i, leftPowers, rightPowers);
+}
+
+static inline TARGET_AVX512 void diagPopcounts_back_batch_avx512(const uint64_t *in, uint8_t *out, size_t n) {
+    diagPopcounts_batch_avx512(in, out, n, DIAG_SHIFT_BL_POWERS, DIAG_SHIFT_TR_POWERS);
+}
+
+static inline TARGET_AVX512 void diagPopcounts_fwd_batch_avx512(const uint64_t *in, uint8_t *out, size_t n) {
+    diagPopcounts_batch_avx512(in, out, n, DIAG_SHIFT_TL_POWERS, DIAG_SHIFT_BR_POWERS);
+}
+#endif
+
+// One board at a time, 'vpshufbitqmb' already counts a whole board per 2 instructions
+#ifdef COMPILE_BITALG
+static inline TARGET_BITALG void diagPopcounts_back_batch_bitalg(const uint64_t *in, uint8_t *out, size_t n) {
+    for (size_t i=0; i < n; i++)
+        diagPopcounts_back_bitalg(in[i], out + 15*i);
+}
+
+static inline TARGET_BITALG void diagPopcounts_fwd_batch_bitalg(const uint64_t *in, uint8_t *out, size_t n) {
+    for (size_t i=0; i < n; i++)
+        diagPopcounts_fwd_bitalg(in[i], out + 15*i);
+}
+#endif
+
+// The same shifts, transpose & SWAR on GCC/Clang vectors of boards
+#ifdef COMPILE_VECTOR
+DIAG_INLINE diagVec_u64 popcountBytes_vec(diagVec_u64 x) {
+    x -= (x >> 1) & 0x5555555555555555ULL;
+    x = (x & 0x3333333333333333ULL) + ((x >> 2) & 0x3333333333333333ULL);
+    return (x + (x >> 4)) & 0x0F0F0F0F0F0F0F0FULL;
+}
+
+static inline void diagPopcounts_batch_vec(const uint64_t *in, uint8_t *out, size_t n, const uint64_t leftLow, const uint64_t leftHigh,
+                                           const uint64_t rightLow, const uint64_t rightHigh) {
+    size_t i = 0;
+    for (; i + DIAG_VECTOR_BOARDS <= n; i += DIAG_VECTOR_BOARDS) {
+        diagVec_u64 boards;
+        memcpy(&boards, in + i, sizeof(boards));
+        const diagVec_u64 lower = popcountBytes_vec(flipDiagA1H8_vec(diagShift_left_vec(boards, leftLow, leftHigh)));
+        const diagVec_u64 upper = popcountBytes_vec(flipDiagA1H8_vec(diagShift_right_vec(boards, rightLow, rightHigh)));
+
+        for (size_t b=0; b < DIAG_VECTOR_BOARDS; b++)
+            diagPopcounts_store(lower[b], upper[b], out + 15*(i + b));
+    }
+
+    for (; i < n; i++) {
+        const diagVec_u64 board = DIAG_VEC(in[i]);
+        diagPopcounts_store(popcountBytes(flipDiagA1H8(diagShift_left_vec(board, leftLow, leftHigh)[0])),
+                            popcountBytes(flipDiagA1H8(diagShift_right_vec(board, rightLow, rightHigh)[0])), out + 15*i);
+    }
+}
+
+static inline void diagPopcounts_back_batch_vec(const uint64_t *in, uint8_t *out, size_t n) {
+    diagPopcounts_batch_vec(in, out, n, DIAG_VEC_BL_POWERS, DIAG_VEC_TR_POWERS);
+}
+
+static inline void diagPopcounts_fwd_batch_vec(const uint64_t *in, uint8_t *out, size_t n) {
+    diagPopcounts_batch_vec(in, out, n, DIAG_VEC_TL_POWERS, DIAG_VEC_BR_POWERS);
+}
+#endif
+
+
+// The fastest known to be supported at compile time: a single board takes 'vpshufbitqmb', or the SSE version
+// (the scalar one only without x86). The batches are bound by the 2 stores per board from AVX2 on
+#if defined(DIAG_PORTABLE)
+    #define diagPopcounts_back      diagPopcounts_back_bin
+    #define diagPopcounts_fwd       diagPopcounts_fwd_bin
+    #define diagPopcounts_back_batch diagPopcounts_back_batch_vec
+    #define diagPopcounts_fwd_batch  diagPopcounts_fwd_batch_vec
+#elif defined(CPU_HAS_BITALG)
+    #define diagPopcounts_back      diagPopcounts_back_bitalg
+    #define diagPopcounts_fwd       diagPopcounts_fwd_bitalg
+    #define diagPopcounts_back_batch diagPopcounts_back_batch_bitalg
+    #define diagPopcounts_fwd_batch  diagPopcounts_fwd_batch_bitalg
+#elif defined(CPU_HAS_AVX512)
+    #define diagPopcounts_back      diagPopcounts_back_sse
+    #define diagPopcounts_fwd       diagPopcounts_fwd_sse
+    #define diagPopcounts_back_batch diagPopcounts_back_batch_avx512
+    #define diagPopcounts_fwd_batch  diagPopcounts_fwd_batch_avx512
+#elif defined(CPU_HAS_AVX2)
+    #define diagPopcounts_back      diagPopcounts_back_sse
+    #define diagPopcounts_fwd       diagPopcounts_fwd_sse
+    #define diagPopcounts_back_batch diagPopcounts_back_batch_avx2
+    #define diagPopcounts_fwd_batch  diagPopcounts_fwd_batch_avx2
+#else
+    #define diagPopcounts_back      diagPopcounts_back_sse
+    #define diagPopcounts_fwd       diagPopcounts_fwd_sse
+    #define diagPopcounts_back_batch diagPopcounts_back_batch_sse
+    #define diagPopcounts_fwd_batch  diagPopcounts_fwd_batch_sse
+#endif
+
+#endif
@@ -0,0 +1,259 @@
+#ifndef DIAG_REGISTER_H
+#define DIAG_REGISTER_H
+
+#include <stdint.h>
+#include <stddef.h>     // size_t
+
+#include "cpuFeatures.h"
+#include "diagShift.h"          // The multipliers & 'diagShift_left_x2' ...
+#include "diagToHorizontal.h"
+#include "horizontalTo64.h"     // ROW_BIT_MASK
+#include "transpose.h"          // 'flipDiagA1H8_x2' ...
+#ifdef DIAG_X86
+#include <immintrin.h>  // SSE2, AVX2
+#endif
+
+// The kernels with the boards in vector registers, in & out: every 64-bit lane of a '__m128i' ('_v', SSE2) or a
+// '__m256i' ('_v256', AVX2) is a board. The single board kernels move their board from & to a general purpose register
+// ('movq' & 'movemask', a few cycles each way), which a chain of them pays between every step. These don't, so a chain
+// of them is a single sequence of vector instructions.
+// The extracts leave their row in the low byte of the lane, the rest 0. That is where the deposits take it from, so an
+// extract's result is the input of a deposit as it is (the rest of the lane must be 0 for the deposits).
+//
+// 'DIAG_PIPELINE(name, stage, ...)' chains them (up to 6 stages, without the '_v'), and only moves the board at both ends:
+//     DIAG_PIPELINE(diagToFile, diagToHorizontal_back, toVertical)
+// defines 'diagToFile(board)' (a 'uint64_t', or the row zero extended when the last stage is an extract),
+// 'diagToFile_v(boards)', 'diagToFile_v256(boards)' and 'diagToFile_batch(in, out, n)'.
+#ifdef DIAG_X86
+
+#define DIAG_BACK_DIAGONAL  0x8040201008040201ULL
+#define DIAG_FWD_DIAGONAL   0x0102040810204080ULL
+
+// ==================
+//       Shifts
+// ==================
+// The multiplies of 'diagShift_left_x2' & 'diagShift_right_x2', or 'vpmultishiftqb' with VBMI (see 'diagShift_multishift')
+#if defined(CPU_HAS_VBMI)
+DIAG_INLINE __m128i diagShift_multishift_v(const __m128i boards, const uint64_t control, const uint64_t keep) {
+    return _mm_and_si128(_mm_multishift_epi64_epi8(_mm_set1_epi64x((long long)control), boards), _mm_set1_epi64x((long long)keep));
+}
+    #define DIAG_SHIFT_LEFT_V(boards, powers, multishift)   diagShift_multishift_v(boards, multishift)
+    #define DIAG_SHIFT_RIGHT_V(boards, powers, multishift)  diagShift_multishift_v(boards, multishift)
+#else
+    #define DIAG_SHIFT_LEFT_V(boards, powers, multishift)   diagShift_left_x2(boards, powers)
+    #define DIAG_SHIFT_RIGHT_V(boards, powers, multishift)  diagShift_right_x2(boards, powers)
+#endif
+
+// Bottom to the left (\ -> |)
+DIAG_INLINE __m128i diagShift_bl_v(const __m128i boards) {
+    return DIAG_SHIFT_LEFT_V(boards, DIAG_SHIFT_BL_POWERS, DIAG_SHIFT_BL_MULTISHIFT);
+}
+
+// Top to the left (/ -> |)
+DIAG_INLINE __m128i diagShift_tl_v(const __m128i boards) {
+    return DIAG_SHIFT_LEFT_V(boards, DIAG_SHIFT_TL_POWERS, DIAG_SHIFT_TL_MULTISHIFT);
+}
+
+// Bottom to the right (/ -> |)
+DIAG_INLINE __m128i diagShift_br_v(const __m128i boards) {
+    return DIAG_SHIFT_RIGHT_V(boards, DIAG_SHIFT_BR_POWERS, DIAG_SHIFT_BR_MULTISHIFT);
+}
+
+// Top to the right (\ -> |)
+DIAG_INLINE __m128i diagShift_tr_v(const __m128i boards) {
+    return DIAG_SHIFT_RIGHT_V(boards, DIAG_SHIFT_TR_POWERS, DIAG_SHIFT_TR_MULTISHIFT);
+}
+
+
+// ==================
+//     Transpose
+// ==================
+// The 3 delta swaps are ~15 cycles in a row, a single 'gf2p8affine' with GFNI
+DIAG_INLINE __m128i diagTranspose_v(const __m128i boards) {
+#if defined(CPU_HAS_GFNI)
+    return diagTranspose_gfni_x2(boards);
+#else
+    return flipDiagA1H8_x2(boards);
+#endif
+}
+
+
+// ==================
+//      Extracts
+// ==================
+// The SAD of each lane ors its diagonal's bits together, as in 'diagToHorizontal_back_SAD'.
+// Anti-clockwise (\ -> -)
+DIAG_INLINE __m128i diagToHorizontal_back_v(const __m128i boards) {
+    return _mm_sad_epu8(_mm_and_si128(boards, _mm_set1_epi64x(DIAG_BACK_DIAGONAL)), _mm_setzero_si128());
+}
+
+// Clockwise (/ -> -): row 'i' holds bit 'i' of the result, so each row is replaced by its bit of 'ROW_BIT_MASK' first
+// (instead of reversing the sum)
+DIAG_INLINE __m128i diagToHorizontal_fwd_v(const __m128i boards) {
+    const __m128i empty = _mm_cmpeq_epi8(_mm_and_si128(boards, _mm_set1_epi64x(DIAG_FWD_DIAGONAL)), _mm_setzero_si128());
+    return _mm_sad_epu8(_mm_andnot_si128(empty, _mm_set1_epi64x(ROW_BIT_MASK)), _mm_setzero_si128());
+}
+
+
+// ==================
+//      Deposits
+// ==================
+// The low byte of each lane to all 8 of its rows: the 2 bytes of word 0 (byte 1 is 0), then 'pshuflw' & 'pshufhw'
+DIAG_INLINE __m128i diagBroadcastRows_v(const __m128i rows) {
+    const __m128i doubled = _mm_or_si128(rows, _mm_slli_epi16(rows, 8));
+    return _mm_shufflehi_epi16(_mm_shufflelo_epi16(doubled, 0), 0);
+}
+
+// Every row to 0xFF when its bit of the input is set, 0 otherwise
+DIAG_INLINE __m128i diagRowsToBytes_v(const __m128i rows) {
+    const __m128i rowBits = _mm_set1_epi64x(ROW_BIT_MASK);
+    return _mm_cmpeq_epi8(_mm_and_si128(diagBroadcastRows_v(rows), rowBits), rowBits);
+}
+
+// Clockwise (- -> \)
+DIAG_INLINE __m128i toDiag_back_v(const __m128i rows) {
+    return _mm_and_si128(diagBroadcastRows_v(rows), _mm_set1_epi64x(DIAG_BACK_DIAGONAL));
+}
+
+// Anti-clockwise (- -> /), bit 'i' to row 'i'
+DIAG_INLINE __m128i toDiag_fwd_v(const __m128i rows) {
+    return _mm_and_si128(diagRowsToBytes_v(rows), _mm_set1_epi64x(DIAG_FWD_DIAGONAL));
+}
+
+// Anti-clockwise (- -> |)
+DIAG_INLINE __m128i toVertical_v(const __m128i rows) {
+    return _mm_and_si128(diagRowsToBytes_v(rows), _mm_set1_epi8(1));
+}
+
+
+
+// ==================
+//       AVX2
+// ==================
+// The same on 4 boards. 'pshufb' broadcasts the rows in 1 instruction
+#ifdef COMPILE_AVX2
+#if defined(CPU_HAS_VBMI)
+static inline TARGET_AVX2 __m256i diagShift_multishift_v256(const __m256i boards, const uint64_t control, const uint64_t keep) {
+    return _mm256_and_si256(_mm256_multishift_epi64_epi8(_mm256_set1_epi64x((long long)control), boards), _mm256_set1_epi64x((long long)keep));
+}
+    #define DIAG_SHIFT_LEFT_V256(boards, powers, multishift)    diagShift_multishift_v256(boards, multishift)
+    #define DIAG_SHIFT_RIGHT_V256(boards, powers, multishift)   diagShift_multishift_v256(boards, multishift)
+#else
+    #define DIAG_SHIFT_LEFT_V256(boards, powers, multishift)    diagShift_left_x4(boards, _mm256_broadcastsi128_si256(powers))
+    #define DIAG_SHIFT_RIGHT_V256(boards, powers, multishift)   diagShift_right_x4(boards, _mm256_broadcastsi128_si256(powers))
+#endif
+
+static inline TARGET_AVX2 __m256i diagShift_bl_v256(const __m256i boards) {
+    return DIAG_SHIFT_LEFT_V256(boards, DIAG_SHIFT_BL_POWERS, DIAG_SHIFT_BL_MULTISHIFT);
+}
+static inline TARGET_AVX2 __m256i diagShift_tl_v256(const __m256i boards) {
+    return DIAG_SHIFT_LEFT_V256(boards, DIAG_SHIFT_TL_POWERS, DIAG_SHIFT_TL_MULTISHIFT);
+}
+static inline TARGET_AVX2 __m256i diagShift_br_v256(const __m256i boards) {
+    return DIAG_SHIFT_RIGHT_V256(boards, DIAG_SHIFT_BR_POWERS, DIAG_SHIFT_BR_MULTISHIFT);
+}
+static inline TARGET_AVX2 __m256i diagShift_tr_v256(const __m256i boards) {
+    return DIAG_SHIFT_RIGHT_V256(boards, DIAG_SHIFT_TR_POWERS, DIAG_SHIFT_TR_MULTISHIFT);
+}
+
+static inline TARGET_AVX2 __m256i diagTranspose_v256(const __m256i boards) {
+#if defined(CPU_HAS_GFNI)
+    return diagTranspose_gfni_x4(boards);
+#else
+    return flipDiagA1H8_x4(boards);
+#endif
+}
+
+static inline TARGET_AVX2 __m256i diagToHorizontal_back_v256(const __m256i boards) {
+    return _mm256_sad_epu8(_mm256_and_si256(boards, _mm256_set1_epi64x(DIAG_BACK_DIAGONAL)), _mm256_setzero_si256());
+}
+
+static inline TARGET_AVX2 __m256i diagToHorizontal_fwd_v256(const __m256i boards) {
+    const __m256i empty = _mm256_cmpeq_epi8(_mm256_and_si256(boards, _mm256_set1_epi64x(DIAG_FWD_DIAGONAL)), _mm256_setzero_si256());
+    return _mm256_sad_epu8(_mm256_andnot_si256(empty, _mm256_set1_epi64x(ROW_BIT_MASK)), _mm256_setzero_si256());
+}
+
+static inline TARGET_AVX2 __m256i diagBroadcastRows_v256(const __m256i rows) {
+    return _mm256_shuffle_epi8(rows, _mm256_set_epi64x(0x0808080808080808LL, 0, 0x0808080808080808LL, 0));
+}
+
+static inline TARGET_AVX2 __m256i diagRowsToBytes_v256(const __m256i rows) {
+    const __m256i rowBits = _mm256_set1_epi64x(ROW_BIT_MASK);
+    return _mm256_cmpeq_epi8(_mm256_and_si256(diagBroadcastRows_v256(rows), rowBits), rowBits);
+}
+
+static inline TARGET_AVX2 __m256i toDiag_back_v256(const __m256i rows) {
+    return _mm256_and_si256(diagBroadcastRows_v256(rows), _mm256_set1_epi64x(DIAG_BACK_DIAGONAL));
+}
+
+static inline TARGET_AVX2 __m256i toDiag_fwd_v256(const __m256i rows) {
+    return _mm256_and_si256(diagRowsToBytes_v256(rows), _mm256_set1_epi64x(DIAG_FWD_DIAGONAL));
+}
+
+static inline TARGET_AVX2 __m256i toVertical_v256(const __m256i rows) {
+    return _mm256_and_si256(diagRowsToBytes_v256(rows), _mm256_set1_epi8(1));
+}
+#endif
+
+
+
+// ==================
+//     Pipelines
+// ==================
+// 'DIAG_STAGES(x, _v, f, g)' is 'g_v(f_v(x))'
+#define DIAG_STAGES_1(x, suffix, f)         f##suffix(x)
+#define DIAG_STAGES_2(x, suffix, f, ...)    DIAG_STAGES_1(f##suffix(x), suffix, __VA_ARGS__)
+#define DIAG_STAGES_3(x, suffix, f, ...)    DIAG_STAGES_2(f##suffix(x), suffix, __VA_ARGS__)
+#define DIAG_STAGES_4(x, suffix, f, ...)    DIAG_STAGES_3(f##suffix(x), suffix, __VA_ARGS__)
+#define DIAG_STAGES_5(x, suffix, f, ...)    DIAG_STAGES_4(f##suffix(x), suffix, __VA_ARGS__)
+#define DIAG_STAGES_6(x, suffix, f, ...)    DIAG_STAGES_5(f##suffix(x), suffix, __VA_ARGS__)
+#define DIAG_STAGES_COUNT(_1, _2, _3, _4, _5, _6, count, ...) count
+#define DIAG_STAGES_N(count, ...)           DIAG_STAGES_##count(__VA_ARGS__)
+#define DIAG_STAGES_N_(count, ...)          DIAG_STAGES_N(count, __VA_ARGS__)
+#define DIAG_STAGES(x, suffix, ...) \
+    DIAG_STAGES_N_(DIAG_STAGES_COUNT(__VA_ARGS__, 6, 5, 4, 3, 2, 1, 0), x, suffix, __VA_ARGS__)
+
+#ifdef COMPILE_AVX2
+#define DIAG_PIPELINE_AVX2(name, ...) \
+    static inline TARGET_AVX2 __m256i name##_v256(const __m256i boards) { return DIAG_STAGES(boards, _v256, __VA_ARGS__); } \
+    \
+    static inline TARGET_AVX2 void name##_batch_avx2(const uint64_t *in, uint64_t *out, size_t n) { \
+        size_t i = 0; \
+        for (; i + 4 <= n; i += 4) \
+            _mm256_storeu_si256((__m256i*)(out + i), name##_v256(_mm256_loadu_si256((const __m256i*)(in + i)))); \
+        name##_batch_sse(in + i, out + i, n - i); \
+    }
+#else
+#define DIAG_PIPELINE_AVX2(name, ...)
+#endif
+
+// The pipelines stop at AVX2
+#if defined(CPU_HAS_AVX2)
+    #define DIAG_PIPELINE_BATCH(name) name##_batch_avx2
+#else
+    #define DIAG_PIPELINE_BATCH(name) name##_batch_sse
+#endif
+
+#define DIAG_PIPELINE(name, ...) \
+    DIAG_INLINE __m128i name##_v(const __m128i boards) { return DIAG_STAGES(boards, _v, __VA_ARGS__); } \
+    \
+    DIAG_INLINE uint64_t name(const uint64_t board) { \
+        return (uint64_t)_mm_cvtsi128_si64(name##_v(_mm_cvtsi64_si128((long long)board))); \
+    } \
+    \
+    /* 2 boards per iteration, the odd one out on its own */ \
+    static inline void name##_batch_sse(const uint64_t *in, uint64_t *out, size_t n) { \
+        size_t i = 0; \
+        for (; i + 2 <= n; i += 2) \
+            _mm_storeu_si128((__m128i*)(out + i), name##_v(_mm_loadu_si128((const __m128i*)(in + i)))); \
+        if (i < n) \
+            out[i] = name(in[i]); \
+    } \
+    \
+    DIAG_PIPELINE_AVX2(name, __VA_ARGS__) \
+    \
+    static inline void name##_batch(const uint64_t *in, uint64_t *out, size_t n) { DIAG_PIPELINE_BATCH(name)(in, out, n); }
+
+#endif
+
+#endif
@@ -2,16 +2,24 @@
 #define DIAG_SHIFT_H
 
 #include <stdint.h>
+#include <stddef.h>     // size_t
 #include <limits.h>     // For masking
-#include <emmintrin.h>  // SIMD (SSE2)
+#include <string.h>     // memcpy
 
-#define hex2d_as_u64(r7, r6, r5, r4, r3, r2, r1, r0) (0x ## r7 ## r6 ## r5 ## r4 ## r3 ## r2 ## r1 ## r0 ## ULL)
+#include "cpuFeatures.h"
+#include "tableGen.h"     // hex2d_as_u64
+#ifdef DIAG_X86
+#include <emmintrin.h>  // SIMD (SSE2)
+#endif
+#if defined(COMPILE_AVX2) || defined(COMPILE_AVX512) || defined(COMPILE_GFNI) || defined(COMPILE_VBMI)
+#include <immintrin.h>  // AVX2, AVX512bw, GFNI (batched), VBMI
+#endif
 
 // ==================
 //       Linear
 // ==================
 // Bottom to the left (\ -> |)
-uint64_t diagShift_bl_lin(uint64_t toShift) {
+DIAG_INLINE uint64_t diagShift_bl_lin(uint64_t toShift) {
     union {uint64_t full; uint8_t byte[8];} inp;
     inp.full = toShift;
 
@@ -37,7 +45,7 @@ uint64_t diagShift_bl_lin(uint64_t toShift) {
 	ABCDEFGH    EFGH---- |  GH0000-- |  H000000- |
 */
 // Bottom to the left (\ -> |)
-uint64_t diagShift_bl_bin(const uint64_t toShift) {
+DIAG_INLINE uint64_t diagShift_bl_bin(const uint64_t toShift) {
     uint64_t result, keptSame, changed;
 
     keptSame = toShift &        hex2d_as_u64(FF, FF, FF, FF, 00, 00, 00, 00);
@@ -56,7 +64,7 @@ uint64_t diagShift_bl_bin(const uint64_t toShift) {
 }
 
 // Top to the left (/ -> |)
-uint64_t diagShift_tl_bin(const uint64_t toShift) {
+DIAG_INLINE uint64_t diagShift_tl_bin(const uint64_t toShift) {
     uint64_t result, keptSame, changed;
 
     keptSame = toShift &        hex2d_as_u64(00, 00, 00, 00, FF, FF, FF, FF);
@@ -76,7 +84,7 @@ uint64_t diagShift_tl_bin(const uint64_t toShift) {
 
 
 // Bottom to the right (/ -> |)
-uint64_t diagShift_br_bin(const uint64_t toShift) {
+DIAG_INLINE uint64_t diagShift_br_bin(const uint64_t toShift) {
     uint64_t result, keptSame, changed;
 
     keptSame = toShift &        hex2d_as_u64(FF, FF, FF, FF, 00, 00, 00, 00);
@@ -95,7 +103,7 @@ uint64_t diagShift_br_bin(const uint64_t toShift) {
 }
 
 // Top to the right (\ -> |)
-uint64_t diagShift_tr_bin(const uint64_t toShift) {
+DIAG_INLINE uint64_t diagShift_tr_bin(const uint64_t toShift) {
     uint64_t result, keptSame, changed;
 
     keptSame = toShift &        hex2d_as_u64(00, 00, 00, 00, FF, FF, FF, FF);
@@ -117,8 +125,13 @@ uint64_t diagShift_tr_bin(const uint64_t toShift) {
 // ==================
 //     SSE based
 // ==================
+// A board known at compile time takes the '_bin' version instead, which folds (same for the GFNI ones)
+#ifdef DIAG_X86
+
 // Bottom to the left (\ -> |)
-uint64_t diagShift_bl_SSE(const uint64_t toShift) {
+DIAG_INLINE uint64_t diagShift_bl_SSE(const uint64_t toShift) {
+    if (DIAG_IS_CONSTANT(toShift)) return diagShift_bl_bin(toShift);
+
     __m128i toShift_inLo = _mm_cvtsi64_si128(toShift);
 
     // [B,A] => [0,B,0,A]
@@ -134,7 +147,9 @@ uint64_t diagShift_bl_SSE(const uint64_t toShift) {
 }
 
 // Top to the left: / -> |
-uint64_t diagShift_tl_SSE(const uint64_t toShift) {
+DIAG_INLINE uint64_t diagShift_tl_SSE(const uint64_t toShift) {
+    if (DIAG_IS_CONSTANT(toShift)) return diagShift_tl_bin(toShift);
+
     __m128i toShift_inLo = _mm_cvtsi64_si128(toShift);
 
     // [B,A] => [0,B,0,A]
@@ -150,7 +165,9 @@ uint64_t diagShift_tl_SSE(const uint64_t toShift) {
 }
 
 // Bottom to the right: / -> |
-uint64_t diagShift_br_SSE(const uint64_t toShift) {
+DIAG_INLINE uint64_t diagShift_br_SSE(const uint64_t toShift) {
+    if (DIAG_IS_CONSTANT(toShift)) return diagShift_br_bin(toShift);
+
     __m128i toShift_inLo = _mm_cvtsi64_si128(toShift);
 
     // [B,A] => [B,0,A,0]
@@ -165,7 +182,9 @@ uint64_t diagShift_br_SSE(const uint64_t toShift) {
 }
 
 // Top to the right: \ -> |
-uint64_t diagShift_tr_SSE(const uint64_t toShift) {
+DIAG_INLINE uint64_t diagShift_tr_SSE(const uint64_t toShift) {
+    if (DIAG_IS_CONSTANT(toShift)) return diagShift_tr_bin(toShift);
+
     __m128i toShift_inLo = _mm_cvtsi64_si128(toShift);
 
     // [B,A] => [B,0,A,0]
@@ -178,6 +197,526 @@ uint64_t diagShift_tr_SSE(const uint64_t toShift) {
 
     return _mm_cvtsi128_si64(unInterleaved);
 }
+#endif
+
+
+// Diagonal 'k' is the main one moved down (\) or up (/) by 'k' rows, the rows moved off the board are dropped
+#define BACK_DIAGONAL(k)    (((k) >= 0)? 0x8040201008040201ULL >> (8*(k) & 63) : 0x8040201008040201ULL << (-8*(k) & 63))
+#define FWD_DIAGONAL(k)     (((k) >= 0)? 0x0102040810204080ULL << (8*(k) & 63) : 0x0102040810204080ULL >> (-8*(k) & 63))
+
+// Every diagonal (for 'diagExtract_*' & 'diagDeposit_*'), indexed by 'k + 7' where 'k' is 'column - row' (\) or 'column + row - 7' (/). The main ones are 'k = 0'
+static const uint64_t backDiagonals[15] = {
+    BACK_DIAGONAL(-7), BACK_DIAGONAL(-6), BACK_DIAGONAL(-5), BACK_DIAGONAL(-4), BACK_DIAGONAL(-3), BACK_DIAGONAL(-2), BACK_DIAGONAL(-1),
+    BACK_DIAGONAL(0), BACK_DIAGONAL(1), BACK_DIAGONAL(2), BACK_DIAGONAL(3), BACK_DIAGONAL(4), BACK_DIAGONAL(5), BACK_DIAGONAL(6), BACK_DIAGONAL(7)
+};
+static const uint64_t fwdDiagonals[15] = {
+    FWD_DIAGONAL(-7), FWD_DIAGONAL(-6), FWD_DIAGONAL(-5), FWD_DIAGONAL(-4), FWD_DIAGONAL(-3), FWD_DIAGONAL(-2), FWD_DIAGONAL(-1),
+    FWD_DIAGONAL(0), FWD_DIAGONAL(1), FWD_DIAGONAL(2), FWD_DIAGONAL(3), FWD_DIAGONAL(4), FWD_DIAGONAL(5), FWD_DIAGONAL(6), FWD_DIAGONAL(7)
+};
+
+
+
+// ==================
+//      Batched
+// ==================
+// Same unpack/multiply/pack as the SSE versions, but every 64-bit lane holds its own board.
+// 'unpack' and 'packus' work within 128-bit lanes, so the board order is kept at every width.
+#ifdef DIAG_X86
+
+// 16-bit multipliers for each row, byte 'i' is shifted by log2 of element 'i'
+#define DIAG_SHIFT_BL_POWERS _mm_set_epi16(1<<0, 1<<1, 1<<2, 1<<3, 1<<4, 1<<5, 1<<6, 1<<7)
+#define DIAG_SHIFT_TL_POWERS _mm_set_epi16(1<<7, 1<<6, 1<<5, 1<<4, 1<<3, 1<<2, 1<<1, 1<<0)
+// Shift right by '8 - log2'
+#define DIAG_SHIFT_BR_POWERS _mm_set_epi16(1<<8, 1<<7, 1<<6, 1<<5, 1<<4, 1<<3, 1<<2, 1<<1)
+#define DIAG_SHIFT_TR_POWERS _mm_set_epi16(1<<1, 1<<2, 1<<3, 1<<4, 1<<5, 1<<6, 1<<7, 1<<8)
+
+// Each byte is shifted left by log2 of its 16-bit multiplier, the low board by 'powersLo' & the high one by 'powersHi'
+DIAG_INLINE __m128i diagShift_left_x2_lanes(const __m128i boards, const __m128i powersLo, const __m128i powersHi) {
+    __m128i interLo = _mm_unpacklo_epi8(boards, _mm_setzero_si128());
+    __m128i interHi = _mm_unpackhi_epi8(boards, _mm_setzero_si128());
+
+    __m128i shiftedLo = _mm_and_si128(_mm_mullo_epi16(interLo, powersLo), _mm_set1_epi16(UINT8_MAX));
+    __m128i shiftedHi = _mm_and_si128(_mm_mullo_epi16(interHi, powersHi), _mm_set1_epi16(UINT8_MAX));
+    return _mm_packus_epi16(shiftedLo, shiftedHi);
+}
+
+// Each byte is shifted right by 8 - log2 of its 16-bit multiplier
+DIAG_INLINE __m128i diagShift_right_x2_lanes(const __m128i boards, const __m128i powersLo, const __m128i powersHi) {
+    __m128i interLo = _mm_unpacklo_epi8(_mm_setzero_si128(), boards);
+    __m128i interHi = _mm_unpackhi_epi8(_mm_setzero_si128(), boards);
+
+    // Results are always < 256, so 'packus' never saturates
+    return _mm_packus_epi16(_mm_mulhi_epu16(interLo, powersLo), _mm_mulhi_epu16(interHi, powersHi));
+}
+
+DIAG_INLINE __m128i diagShift_left_x2(const __m128i boards, const __m128i powersOfTwo) {
+    return diagShift_left_x2_lanes(boards, powersOfTwo, powersOfTwo);
+}
+
+DIAG_INLINE __m128i diagShift_right_x2(const __m128i boards, const __m128i powersOfTwo) {
+    return diagShift_right_x2_lanes(boards, powersOfTwo, powersOfTwo);
+}
+
+// 2 boards per iteration, the odd one out goes through the single board path
+static inline void diagShift_batch_left_sse(const uint64_t *in, uint64_t *out, size_t n, const __m128i powersOfTwo) {
+    size_t i = 0;
+    for (; i + 2 <= n; i += 2)
+        _mm_storeu_si128((__m128i*)(out + i), diagShift_left_x2(_mm_loadu_si128((const __m128i*)(in + i)), powersOfTwo));
+
+    for (; i < n; i++)
+        out[i] = _mm_cvtsi128_si64(diagShift_left_x2(_mm_cvtsi64_si128(in[i]), powersOfTwo));
+}
+
+static inline void diagShift_batch_right_sse(const uint64_t *in, uint64_t *out, size_t n, const __m128i powersOfTwo) {
+    size_t i = 0;
+    for (; i + 2 <= n; i += 2)
+        _mm_storeu_si128((__m128i*)(out + i), diagShift_right_x2(_mm_loadu_si128((const __m128i*)(in + i)), powersOfTwo));
+
+    for (; i < n; i++)
+        out[i] = _mm_cvtsi128_si64(diagShift_right_x2(_mm_cvtsi64_si128(in[i]), powersOfTwo));
+}
+
+
+#ifdef COMPILE_AVX2
+static inline TARGET_AVX2 __m256i diagShift_left_x4(const __m256i boards, const __m256i powersOfTwo) {
+    __m256i interLo = _mm256_unpacklo_epi8(boards, _mm256_setzero_si256());
+    __m256i interHi = _mm256_unpackhi_epi8(boards, _mm256_setzero_si256());
+
+    __m256i shiftedLo = _mm256_and_si256(_mm256_mullo_epi16(interLo, powersOfTwo), _mm256_set1_epi16(UINT8_MAX));
+    __m256i shiftedHi = _mm256_and_si256(_mm256_mullo_epi16(interHi, powersOfTwo), _mm256_set1_epi16(UINT8_MAX));
+    return _mm256_packus_epi16(shiftedLo, shiftedHi);
+}
+
+static inline TARGET_AVX2 __m256i diagShift_right_x4(const __m256i boards, const __m256i powersOfTwo) {
+    __m256i interLo = _mm256_unpacklo_epi8(_mm256_setzero_si256(), boards);
+    __m256i interHi = _mm256_unpackhi_epi8(_mm256_setzero_si256(), boards);
+
+    return _mm256_packus_epi16(_mm256_mulhi_epu16(interLo, powersOfTwo), _mm256_mulhi_epu16(interHi, powersOfTwo));
+}
+
+// 4 boards per iteration, the remainder is passed to the SSE version
+static inline TARGET_AVX2 void diagShift_batch_left_avx2(const uint64_t *in, uint64_t *out, size_t n, const __m128i powersOfTwo) {
+    const __m256i powersOfTwo_256 = _mm256_broadcastsi128_si256(powersOfTwo);
+
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4)
+        _mm256_storeu_si256((__m256i*)(out + i), diagShift_left_x4(_mm256_loadu_si256((const __m256i*)(in + i)), powersOfTwo_256));
+
+    diagShift_batch_left_sse(in + i, out + i, n - i, powersOfTwo);
+}
+
+static inline TARGET_AVX2 void diagShift_batch_right_avx2(const uint64_t *in, uint64_t *out, size_t n, const __m128i powersOfTwo) {
+    const __m256i powersOfTwo_256 = _mm256_broadcastsi128_si256(powersOfTwo);
+
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4)
+        _mm256_storeu_si256((__m256i*)(out + i), diagShift_right_x4(_mm256_loadu_si256((const __m256i*)(in + i)), powersOfTwo_256));
+
+    diagShift_batch_right_sse(in + i, out + i, n - i, powersOfTwo);
+}
+#endif
+
+
+#ifdef COMPILE_AVX512 // avx512bw
+static inline TARGET_AVX512 __m512i diagShift_left_x8(const __m512i boards, const __m512i powersOfTwo) {
+    __m512i interLo = _mm512_unpacklo_epi8(boards, _mm512_setzero_si512());
+    __m512i interHi = _mm512_unpackhi_epi8(boards, _mm512_setzero_si512());
+
+    __m512i shiftedLo = _mm512_and_si512(_mm512_mullo_epi16(interLo, powersOfTwo), _mm512_set1_epi16(UINT8_MAX));
+    __m512i shiftedHi = _mm512_and_si512(_mm512_mullo_epi16(interHi, powersOfTwo), _mm512_set1_epi16(UINT8_MAX));
+    return _mm512_packus_epi16(shiftedLo, shiftedHi);
+}
+
+static inline TARGET_AVX512 __m512i diagShift_right_x8(const __m512i boards, const __m512i powersOfTwo) {
+    __m512i interLo = _mm512_unpacklo_epi8(_mm512_setzero_si512(), boards);
+    __m512i interHi = _mm512_unpackhi_epi8(_mm512_setzero_si512(), boards);
+
+    return _mm512_packus_epi16(_mm512_mulhi_epu16(interLo, powersOfTwo), _mm512_mulhi_epu16(interHi, powersOfTwo));
+}
+
+// 8 boards per iteration, the remainder is passed to the SSE version
+static inline TARGET_AVX512 void diagShift_batch_left_avx512(const uint64_t *in, uint64_t *out, size_t n, const __m128i powersOfTwo) {
+    const __m512i powersOfTwo_512 = _mm512_broadcast_i32x4(powersOfTwo);
+
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8)
+        _mm512_storeu_si512(out + i, diagShift_left_x8(_mm512_loadu_si512(in + i), powersOfTwo_512));
+
+    diagShift_batch_left_sse(in + i, out + i, n - i, powersOfTwo);
+}
+
+static inline TARGET_AVX512 void diagShift_batch_right_avx512(const uint64_t *in, uint64_t *out, size_t n, const __m128i powersOfTwo) {
+    const __m512i powersOfTwo_512 = _mm512_broadcast_i32x4(powersOfTwo);
+
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8)
+        _mm512_storeu_si512(out + i, diagShift_right_x8(_mm512_loadu_si512(in + i), powersOfTwo_512));
+
+    diagShift_batch_right_sse(in + i, out + i, n - i, powersOfTwo);
+}
+#endif
+#endif
+
+
+// ==================
+//       GFNI
+// ==================
+// "Binary" method, but 'gf2p8affine' shifts every byte on its own, so nothing spills into the next row
+// and only the rows that take the shifted byte need masking (same rows as the '_bin' versions).
+#ifdef COMPILE_GFNI
+// Rows that take the shift by 4, 2 then 1
+#define DIAG_SHIFT_BL_STEPS hex2d_as_u64(00, 00, 00, 00, FF, FF, FF, FF), hex2d_as_u64(00, 00, FF, FF, 00, 00, FF, FF), hex2d_as_u64(00, FF, 00, FF, 00, FF, 00, FF)
+#define DIAG_SHIFT_TL_STEPS hex2d_as_u64(FF, FF, FF, FF, 00, 00, 00, 00), hex2d_as_u64(FF, FF, 00, 00, FF, FF, 00, 00), hex2d_as_u64(FF, 00, FF, 00, FF, 00, FF, 00)
+
+static inline TARGET_GFNI __m128i diagShift_gfni_x2(__m128i boards, const uint64_t rows4, const uint64_t rows2, const uint64_t rows1, const int right) {
+    const __m128i by4 = _mm_set1_epi64x(right? GF2P8_SHR(4) : GF2P8_SHL(4));
+    const __m128i by2 = _mm_set1_epi64x(right? GF2P8_SHR(2) : GF2P8_SHL(2));
+    const __m128i by1 = _mm_set1_epi64x(right? GF2P8_SHR(1) : GF2P8_SHL(1));
+
+    boards = _mm_blendv_epi8(boards, _mm_gf2p8affine_epi64_epi8(boards, by4, 0), _mm_set1_epi64x(rows4));
+    boards = _mm_blendv_epi8(boards, _mm_gf2p8affine_epi64_epi8(boards, by2, 0), _mm_set1_epi64x(rows2));
+    boards = _mm_blendv_epi8(boards, _mm_gf2p8affine_epi64_epi8(boards, by1, 0), _mm_set1_epi64x(rows1));
+    return boards;
+}
+
+// Bottom to the left (\ -> |)
+static inline TARGET_GFNI uint64_t diagShift_bl_gfni(const uint64_t toShift) {
+    if (DIAG_IS_CONSTANT(toShift)) return diagShift_bl_bin(toShift);
+    return _mm_cvtsi128_si64(diagShift_gfni_x2(_mm_cvtsi64_si128(toShift), DIAG_SHIFT_BL_STEPS, 0));
+}
+
+// Top to the left (/ -> |)
+static inline TARGET_GFNI uint64_t diagShift_tl_gfni(const uint64_t toShift) {
+    if (DIAG_IS_CONSTANT(toShift)) return diagShift_tl_bin(toShift);
+    return _mm_cvtsi128_si64(diagShift_gfni_x2(_mm_cvtsi64_si128(toShift), DIAG_SHIFT_TL_STEPS, 0));
+}
+
+// Bottom to the right (/ -> |)
+static inline TARGET_GFNI uint64_t diagShift_br_gfni(const uint64_t toShift) {
+    if (DIAG_IS_CONSTANT(toShift)) return diagShift_br_bin(toShift);
+    return _mm_cvtsi128_si64(diagShift_gfni_x2(_mm_cvtsi64_si128(toShift), DIAG_SHIFT_BL_STEPS, 1));
+}
+
+// Top to the right (\ -> |)
+static inline TARGET_GFNI uint64_t diagShift_tr_gfni(const uint64_t toShift) {
+    if (DIAG_IS_CONSTANT(toShift)) return diagShift_tr_bin(toShift);
+    return _mm_cvtsi128_si64(diagShift_gfni_x2(_mm_cvtsi64_si128(toShift), DIAG_SHIFT_TL_STEPS, 1));
+}
+
+
+// The batch loops take the same multipliers as the other widths (so 'dispatch.h' can swap them in),
+// the rows of each step are worked out from them once per call
+static inline uint64_t diagShift_gfniStepRows(const __m128i powersOfTwo, const int right, const unsigned step) {
+    uint16_t powers[8];
+    _mm_storeu_si128((__m128i*)powers, powersOfTwo);
+
+    uint64_t rows = 0;
+    for (size_t i = 0; i < 8; i++) {
+        const unsigned log2 = (unsigned)__builtin_ctz(powers[i]);
+        if ((right? 8 - log2 : log2) & step)
+            rows |= (uint64_t)UINT8_MAX << 8*i;
+    }
+    return rows;
+}
+
+static inline TARGET_GFNI void diagShift_batch_gfni(const uint64_t *in, uint64_t *out, size_t n, const __m128i powersOfTwo, const int right) {
+    const uint64_t rows4 = diagShift_gfniStepRows(powersOfTwo, right, 4);
+    const uint64_t rows2 = diagShift_gfniStepRows(powersOfTwo, right, 2);
+    const uint64_t rows1 = diagShift_gfniStepRows(powersOfTwo, right, 1);
+
+    size_t i = 0;
+    for (; i + 2 <= n; i += 2)
+        _mm_storeu_si128((__m128i*)(out + i), diagShift_gfni_x2(_mm_loadu_si128((const __m128i*)(in + i)), rows4, rows2, rows1, right));
+
+    for (; i < n; i++)
+        out[i] = _mm_cvtsi128_si64(diagShift_gfni_x2(_mm_cvtsi64_si128(in[i]), rows4, rows2, rows1, right));
+}
+
+static inline TARGET_GFNI void diagShift_batch_left_gfni(const uint64_t *in, uint64_t *out, size_t n, const __m128i powersOfTwo) {
+    diagShift_batch_gfni(in, out, n, powersOfTwo, 0);
+}
+
+static inline TARGET_GFNI void diagShift_batch_right_gfni(const uint64_t *in, uint64_t *out, size_t n, const __m128i powersOfTwo) {
+    diagShift_batch_gfni(in, out, n, powersOfTwo, 1);
+}
+#endif
+
+#if defined(COMPILE_GFNI) && defined(COMPILE_AVX2)
+static inline TARGET_GFNI_AVX2 __m256i diagShift_gfni_x4(__m256i boards, const uint64_t rows4, const uint64_t rows2, const uint64_t rows1, const int right) {
+    const __m256i by4 = _mm256_set1_epi64x(right? GF2P8_SHR(4) : GF2P8_SHL(4));
+    const __m256i by2 = _mm256_set1_epi64x(right? GF2P8_SHR(2) : GF2P8_SHL(2));
+    const __m256i by1 = _mm256_set1_epi64x(right? GF2P8_SHR(1) : GF2P8_SHL(1));
+
+    boards = _mm256_blendv_epi8(boards, _mm256_gf2p8affine_epi64_epi8(boards, by4, 0), _mm256_set1_epi64x(rows4));
+    boards = _mm256_blendv_epi8(boards, _mm256_gf2p8affine_epi64_epi8(boards, by2, 0), _mm256_set1_epi64x(rows2));
+    boards = _mm256_blendv_epi8(boards, _mm256_gf2p8affine_epi64_epi8(boards, by1, 0), _mm256_set1_epi64x(rows1));
+    return boards;
+}
+
+static inline TARGET_GFNI_AVX2 void diagShift_batch_gfni_avx2(const uint64_t *in, uint64_t *out, size_t n, const __m128i powersOfTwo, const int right) {
+    const uint64_t rows4 = diagShift_gfniStepRows(powersOfTwo, right, 4);
+    const uint64_t rows2 = diagShift_gfniStepRows(powersOfTwo, right, 2);
+    const uint64_t rows1 = diagShift_gfniStepRows(powersOfTwo, right, 1);
+
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4)
+        _mm256_storeu_si256((__m256i*)(out + i), diagShift_gfni_x4(_mm256_loadu_si256((const __m256i*)(in + i)), rows4, rows2, rows1, right));
+
+    diagShift_batch_gfni(in + i, out + i, n - i, powersOfTwo, right);
+}
+
+static inline TARGET_GFNI_AVX2 void diagShift_batch_left_gfni_avx2(const uint64_t *in, uint64_t *out, size_t n, const __m128i powersOfTwo) {
+    diagShift_batch_gfni_avx2(in, out, n, powersOfTwo, 0);
+}
+
+static inline TARGET_GFNI_AVX2 void diagShift_batch_right_gfni_avx2(const uint64_t *in, uint64_t *out, size_t n, const __m128i powersOfTwo) {
+    diagShift_batch_gfni_avx2(in, out, n, powersOfTwo, 1);
+}
+#endif
+
+#if defined(COMPILE_GFNI) && defined(COMPILE_AVX512)
+// Masked 'gf2p8affine' does the blend itself: 3 instructions for 8 boards
+static inline TARGET_GFNI_AVX512 __m512i diagShift_gfni_x8(__m512i boards, const __mmask64 rows4, const __mmask64 rows2, const __mmask64 rows1, const int right) {
+    const __m512i by4 = _mm512_set1_epi64(right? GF2P8_SHR(4) : GF2P8_SHL(4));
+    const __m512i by2 = _mm512_set1_epi64(right? GF2P8_SHR(2) : GF2P8_SHL(2));
+    const __m512i by1 = _mm512_set1_epi64(right? GF2P8_SHR(1) : GF2P8_SHL(1));
+
+    boards = _mm512_mask_gf2p8affine_epi64_epi8(boards, rows4, boards, by4, 0);
+    boards = _mm512_mask_gf2p8affine_epi64_epi8(boards, rows2, boards, by2, 0);
+    boards = _mm512_mask_gf2p8affine_epi64_epi8(boards, rows1, boards, by1, 0);
+    return boards;
+}
+
+static inline TARGET_GFNI_AVX512 void diagShift_batch_gfni_avx512(const uint64_t *in, uint64_t *out, size_t n, const __m128i powersOfTwo, const int right) {
+    const __mmask64 rows4 = _mm512_movepi8_mask(_mm512_set1_epi64(diagShift_gfniStepRows(powersOfTwo, right, 4)));
+    const __mmask64 rows2 = _mm512_movepi8_mask(_mm512_set1_epi64(diagShift_gfniStepRows(powersOfTwo, right, 2)));
+    const __mmask64 rows1 = _mm512_movepi8_mask(_mm512_set1_epi64(diagShift_gfniStepRows(powersOfTwo, right, 1)));
+
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8)
+        _mm512_storeu_si512(out + i, diagShift_gfni_x8(_mm512_loadu_si512(in + i), rows4, rows2, rows1, right));
+
+    diagShift_batch_gfni(in + i, out + i, n - i, powersOfTwo, right);
+}
+
+static inline TARGET_GFNI_AVX512 void diagShift_batch_left_gfni_avx512(const uint64_t *in, uint64_t *out, size_t n, const __m128i powersOfTwo) {
+    diagShift_batch_gfni_avx512(in, out, n, powersOfTwo, 0);
+}
+
+static inline TARGET_GFNI_AVX512 void diagShift_batch_right_gfni_avx512(const uint64_t *in, uint64_t *out, size_t n, const __m128i powersOfTwo) {
+    diagShift_batch_gfni_avx512(in, out, n, powersOfTwo, 1);
+}
+#endif
+
+
+// ==================
+//    AVX-512 VBMI
+// ==================
+// 'vpmultishiftqb': output byte 'i' is the 8 bits of its qword starting at bit 'control.byte[i]' (wrapping around).
+// Row 'i' shifted left by 's' starts at bit '8i - s', right by 's' at '8i + s': every row is shifted by its own amount
+// in one instruction (no 16-bit widening), then the bits that came from the neighbouring rows are masked out.
+#ifdef COMPILE_VBMI
+// Bit offsets (low byte is row 0) & what's kept of each row
+#define DIAG_SHIFT_BL_MULTISHIFT 0x382F261D140B0239ULL, hex2d_as_u64(FF, FE, FC, F8, F0, E0, C0, 80)
+#define DIAG_SHIFT_TL_MULTISHIFT 0x312A231C150E0700ULL, hex2d_as_u64(80, C0, E0, F0, F8, FC, FE, FF)
+#define DIAG_SHIFT_BR_MULTISHIFT 0x38312A231C150E07ULL, hex2d_as_u64(FF, 7F, 3F, 1F, 0F, 07, 03, 01)
+#define DIAG_SHIFT_TR_MULTISHIFT 0x3F362D241B120900ULL, hex2d_as_u64(01, 03, 07, 0F, 1F, 3F, 7F, FF)
+
+static inline TARGET_VBMI uint64_t diagShift_multishift(const uint64_t toShift, const uint64_t control, const uint64_t keep) {
+    __m128i shifted = _mm_multishift_epi64_epi8(_mm_cvtsi64_si128((long long)control), _mm_cvtsi64_si128((long long)toShift));
+    return (uint64_t)_mm_cvtsi128_si64(shifted) & keep;
+}
+
+// Bottom to the left (\ -> |)
+static inline TARGET_VBMI uint64_t diagShift_bl_vbmi(const uint64_t toShift) {
+    if (DIAG_IS_CONSTANT(toShift)) return diagShift_bl_bin(toShift);
+    return diagShift_multishift(toShift, DIAG_SHIFT_BL_MULTISHIFT);
+}
+
+// Top to the left (/ -> |)
+static inline TARGET_VBMI uint64_t diagShift_tl_vbmi(const uint64_t toShift) {
+    if (DIAG_IS_CONSTANT(toShift)) return diagShift_tl_bin(toShift);
+    return diagShift_multishift(toShift, DIAG_SHIFT_TL_MULTISHIFT);
+}
+
+// Bottom to the right (/ -> |)
+static inline TARGET_VBMI uint64_t diagShift_br_vbmi(const uint64_t toShift) {
+    if (DIAG_IS_CONSTANT(toShift)) return diagShift_br_bin(toShift);
+    return diagShift_multishift(toShift, DIAG_SHIFT_BR_MULTISHIFT);
+}
+
+// Top to the right (\ -> |)
+static inline TARGET_VBMI uint64_t diagShift_tr_vbmi(const uint64_t toShift) {
+    if (DIAG_IS_CONSTANT(toShift)) return diagShift_tr_bin(toShift);
+    return diagShift_multishift(toShift, DIAG_SHIFT_TR_MULTISHIFT);
+}
+
+
+// The batch loops take the same multipliers as the other widths, the offsets & masks are worked out from them once per call
+static inline void diagShift_multishiftControl(const __m128i powersOfTwo, const int right, uint64_t *control, uint64_t *keep) {
+    uint16_t powers[8];
+    _mm_storeu_si128((__m128i*)powers, powersOfTwo);
+
+    *control = *keep = 0;
+    for (size_t i = 0; i < 8; i++) {
+        const unsigned log2 = (unsigned)__builtin_ctz(powers[i]);
+        const unsigned amount = right? 8 - log2 : log2;
+        *control |= (uint64_t)((right? 8*i + amount : 8*i - amount) & 63) << 8*i;
+        *keep |= (uint64_t)(uint8_t)(right? UINT8_MAX >> amount : UINT8_MAX << amount) << 8*i;
+    }
+}
+
+// 8 boards per iteration (2 instructions), the remainder through the 128-bit form
+static inline TARGET_VBMI void diagShift_batch_vbmi(const uint64_t *in, uint64_t *out, size_t n, const __m128i powersOfTwo, const int right) {
+    uint64_t control, keep;
+    diagShift_multishiftControl(powersOfTwo, right, &control, &keep);
+    const __m512i control_512 = _mm512_set1_epi64((long long)control), keep_512 = _mm512_set1_epi64((long long)keep);
+
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m512i shifted = _mm512_multishift_epi64_epi8(control_512, _mm512_loadu_si512(in + i));
+        _mm512_storeu_si512(out + i, _mm512_and_si512(shifted, keep_512));
+    }
+
+    for (; i < n; i++)
+        out[i] = diagShift_multishift(in[i], control, keep);
+}
+
+static inline TARGET_VBMI void diagShift_batch_left_vbmi(const uint64_t *in, uint64_t *out, size_t n, const __m128i powersOfTwo) {
+    diagShift_batch_vbmi(in, out, n, powersOfTwo, 0);
+}
+
+static inline TARGET_VBMI void diagShift_batch_right_vbmi(const uint64_t *in, uint64_t *out, size_t n, const __m128i powersOfTwo) {
+    diagShift_batch_vbmi(in, out, n, powersOfTwo, 1);
+}
+#endif
+
+
+// ==================
+//  Vector extensions
+// ==================
+// Same multiplies as the SSE versions, written with GCC/Clang vectors so they compile for any target ('diagVec_u64').
+// Each 16-bit lane is 2 rows: the low byte is masked before & after its multiply, the high byte's
+// bits past the lane are just dropped. Right by 'n' is the high byte of a multiply by '2^(8 - n)' (like 'mulhi').
+#ifdef COMPILE_VECTOR
+// 16-bit multipliers of the low bytes (rows 0, 2, 4, 6) or the high bytes (rows 1, 3, 5, 7)
+#define DIAG_VEC_POWERS(r0, r2, r4, r6) ((uint64_t)(r0) | (uint64_t)(r2) << 16 | (uint64_t)(r4) << 32 | (uint64_t)(r6) << 48)
+#define DIAG_VEC_BL_POWERS DIAG_VEC_POWERS(1<<7, 1<<5, 1<<3, 1<<1), DIAG_VEC_POWERS(1<<6, 1<<4, 1<<2, 1<<0)
+#define DIAG_VEC_TL_POWERS DIAG_VEC_POWERS(1<<0, 1<<2, 1<<4, 1<<6), DIAG_VEC_POWERS(1<<1, 1<<3, 1<<5, 1<<7)
+#define DIAG_VEC_BR_POWERS DIAG_VEC_POWERS(1<<1, 1<<3, 1<<5, 1<<7), DIAG_VEC_POWERS(1<<2, 1<<4, 1<<6, 1<<8)
+#define DIAG_VEC_TR_POWERS DIAG_VEC_POWERS(1<<8, 1<<6, 1<<4, 1<<2), DIAG_VEC_POWERS(1<<7, 1<<5, 1<<3, 1<<1)
+
+DIAG_INLINE diagVec_u64 diagShift_left_vec(const diagVec_u64 boards, const uint64_t lowPowers, const uint64_t highPowers) {
+    const diagVec_u16 rows = (diagVec_u16)boards;
+    const diagVec_u16 low = ((rows & 0x00FF) * (diagVec_u16)DIAG_VEC(lowPowers)) & 0x00FF;
+    const diagVec_u16 high = (rows & 0xFF00) * (diagVec_u16)DIAG_VEC(highPowers);
+    return (diagVec_u64)(low | high);
+}
+
+DIAG_INLINE diagVec_u64 diagShift_right_vec(const diagVec_u64 boards, const uint64_t lowPowers, const uint64_t highPowers) {
+    const diagVec_u16 rows = (diagVec_u16)boards;
+    const diagVec_u16 low = ((rows & 0x00FF) * (diagVec_u16)DIAG_VEC(lowPowers)) >> 8;
+    const diagVec_u16 high = ((rows >> 8) * (diagVec_u16)DIAG_VEC(highPowers)) & 0xFF00;
+    return (diagVec_u64)(low | high);
+}
+
+// Bottom to the left (\ -> |)
+DIAG_INLINE uint64_t diagShift_bl_vec(const uint64_t toShift) {
+    return diagShift_left_vec((diagVec_u64){toShift}, DIAG_VEC_BL_POWERS)[0];
+}
+
+// Top to the left (/ -> |)
+DIAG_INLINE uint64_t diagShift_tl_vec(const uint64_t toShift) {
+    return diagShift_left_vec((diagVec_u64){toShift}, DIAG_VEC_TL_POWERS)[0];
+}
+
+// Bottom to the right (/ -> |)
+DIAG_INLINE uint64_t diagShift_br_vec(const uint64_t toShift) {
+    return diagShift_right_vec((diagVec_u64){toShift}, DIAG_VEC_BR_POWERS)[0];
+}
+
+// Top to the right (\ -> |)
+DIAG_INLINE uint64_t diagShift_tr_vec(const uint64_t toShift) {
+    return diagShift_right_vec((diagVec_u64){toShift}, DIAG_VEC_TR_POWERS)[0];
+}
+
+// 'DIAG_VECTOR_BOARDS' per iteration, the rest one at a time
+static inline void diagShift_batch_vec(const uint64_t *in, uint64_t *out, size_t n, const uint64_t lowPowers, const uint64_t highPowers, const int right) {
+    size_t i = 0;
+    for (; i + DIAG_VECTOR_BOARDS <= n; i += DIAG_VECTOR_BOARDS) {
+        diagVec_u64 boards;
+        memcpy(&boards, in + i, sizeof(boards));
+        boards = right? diagShift_right_vec(boards, lowPowers, highPowers) : diagShift_left_vec(boards, lowPowers, highPowers);
+        memcpy(out + i, &boards, sizeof(boards));
+    }
+
+    for (; i < n; i++) {
+        const diagVec_u64 board = {in[i]};
+        out[i] = (right? diagShift_right_vec(board, lowPowers, highPowers) : diagShift_left_vec(board, lowPowers, highPowers))[0];
+    }
+}
+
+static inline void diagShift_bl_batch_vec(const uint64_t *in, uint64_t *out, size_t n) {
+    diagShift_batch_vec(in, out, n, DIAG_VEC_BL_POWERS, 0);
+}
+
+static inline void diagShift_tl_batch_vec(const uint64_t *in, uint64_t *out, size_t n) {
+    diagShift_batch_vec(in, out, n, DIAG_VEC_TL_POWERS, 0);
+}
+
+static inline void diagShift_br_batch_vec(const uint64_t *in, uint64_t *out, size_t n) {
+    diagShift_batch_vec(in, out, n, DIAG_VEC_BR_POWERS, 1);
+}
+
+static inline void diagShift_tr_batch_vec(const uint64_t *in, uint64_t *out, size_t n) {
+    diagShift_batch_vec(in, out, n, DIAG_VEC_TR_POWERS, 1);
+}
+#endif
+
+
+#ifdef DIAG_PORTABLE
+    #define diagShift_bl_batch diagShift_bl_batch_vec
+    #define diagShift_tl_batch diagShift_tl_batch_vec
+    #define diagShift_br_batch diagShift_br_batch_vec
+    #define diagShift_tr_batch diagShift_tr_batch_vec
+#else
+#if defined(CPU_HAS_VBMI)
+    #define diagShift_batch_left  diagShift_batch_left_vbmi
+    #define diagShift_batch_right diagShift_batch_right_vbmi
+#elif defined(CPU_HAS_GFNI) && defined(CPU_HAS_AVX512)
+    #define diagShift_batch_left  diagShift_batch_left_gfni_avx512
+    #define diagShift_batch_right diagShift_batch_right_gfni_avx512
+#elif defined(CPU_HAS_AVX512)
+    #define diagShift_batch_left  diagShift_batch_left_avx512
+    #define diagShift_batch_right diagShift_batch_right_avx512
+#elif defined(CPU_HAS_AVX2)
+    #define diagShift_batch_left  diagShift_batch_left_avx2
+    #define diagShift_batch_right diagShift_batch_right_avx2
+#else
+    #define diagShift_batch_left  diagShift_batch_left_sse
+    #define diagShift_batch_right diagShift_batch_right_sse
+#endif
+
+// Bottom to the left (\ -> |)
+static inline void diagShift_bl_batch(const uint64_t *in, uint64_t *out, size_t n) {
+    diagShift_batch_left(in, out, n, DIAG_SHIFT_BL_POWERS);
+}
+
+// Top to the left (/ -> |)
+static inline void diagShift_tl_batch(const uint64_t *in, uint64_t *out, size_t n) {
+    diagShift_batch_left(in, out, n, DIAG_SHIFT_TL_POWERS);
+}
+
+// Bottom to the right (/ -> |)
+static inline void diagShift_br_batch(const uint64_t *in, uint64_t *out, size_t n) {
+    diagShift_batch_right(in, out, n, DIAG_SHIFT_BR_POWERS);
+}
+
+// Top to the right (\ -> |)
+static inline void diagShift_tr_batch(const uint64_t *in, uint64_t *out, size_t n) {
+    diagShift_batch_right(in, out, n, DIAG_SHIFT_TR_POWERS);
+}
+#endif
 
 
 #endif
\ No newline at end of file
@@ -3,26 +3,52 @@
 
 #include <stdint.h>
 #include <limits.h>     // For masking
-#include <immintrin.h> // Pext & SSE2
+#include <stddef.h>     // size_t
+#include <string.h>     // memcpy
+
+#include "cpuFeatures.h"
+#include "diagShift.h"  // Batched shift kernels
+#include "tableGen.h"
+#ifdef DIAG_X86
+#include <immintrin.h> // Pext, SSE2, GFNI & BITALG
+#endif
+
+static const uint8_t reverseBitsLUT[256] = { TABLE_256(REVERSE_BYTE, 0) };
 
-#define hex2d_as_u64(r7, r6, r5, r4, r3, r2, r1, r0) (0x ## r7 ## r6 ## r5 ## r4 ## r3 ## r2 ## r1 ## r0 ## ULL)
 
+// The multiply adds every row into the top byte (1 bit per column so no carries).
+// No intrinsics, so the other versions use these when the board is known at compile time
+// Anti-clockwise (\ -> -)
+DIAG_INLINE uint8_t diagToHorizontal_back_mul(const uint64_t toShift) {
+    return ((toShift & 0x8040201008040201ULL) * 0x0101010101010101ULL) >> 56;
+}
 
-#ifdef CPU_HAS_BMI2
+// Clockwise (/ -> -), the multiply packs by column so it's reversed
+DIAG_INLINE uint8_t diagToHorizontal_fwd_mul(const uint64_t toShift) {
+    return reverseBitsLUT[((toShift & 0x0102040810204080ULL) * 0x0101010101010101ULL) >> 56];
+}
+
+
+#ifdef COMPILE_BMI2
 // Faster when returning a u8 (pext only?)
 // Anti-clockwise (\ -> -)
-uint8_t diagToHorizontal_back_pext(const uint64_t toShift) {
+static inline TARGET_BMI2 uint8_t diagToHorizontal_back_pext(const uint64_t toShift) {
+    if (DIAG_IS_CONSTANT(toShift)) return diagToHorizontal_back_mul(toShift);
     return _pext_u64(toShift, hex2d_as_u64(80, 40, 20, 10, 08, 04, 02, 01));
 }
 
 // Clockwise (/ -> -)
-uint8_t diagToHorizontal_fwd_pext(const uint64_t toShift) {
+static inline TARGET_BMI2 uint8_t diagToHorizontal_fwd_pext(const uint64_t toShift) {
+    if (DIAG_IS_CONSTANT(toShift)) return diagToHorizontal_fwd_mul(toShift);
     return _pext_u64(toShift, hex2d_as_u64(01, 02, 04, 08, 10, 20, 40, 80));
 }
 #endif
 
+#ifdef DIAG_X86
 // Anti-clockwise (\ -> -)
-uint64_t diagToHorizontal_back_SSE(const uint64_t toShift) {
+DIAG_INLINE uint64_t diagToHorizontal_back_SSE(const uint64_t toShift) {
+    if (DIAG_IS_CONSTANT(toShift)) return diagToHorizontal_back_mul(toShift);
+
     __m128i toShift_inLo = _mm_cvtsi64_si128(toShift);
 
     // [B,A] => [0,B,0,A]
@@ -38,7 +64,9 @@ uint64_t diagToHorizontal_back_SSE(const uint64_t toShift) {
 }
 
 // Anti-clockwise (\ -> -)
-uint64_t diagToHorizontal_back_SAD(const uint64_t toShift) {
+DIAG_INLINE uint64_t diagToHorizontal_back_SAD(const uint64_t toShift) {
+    if (DIAG_IS_CONSTANT(toShift)) return diagToHorizontal_back_mul(toShift);
+
     __m128i toShift_inLo = _mm_cvtsi64_si128(toShift);
 
     // Mask the diagonal bits in each row
@@ -54,7 +82,9 @@ uint64_t diagToHorizontal_back_SAD(const uint64_t toShift) {
 
 
 // Clockwise (/ -> -)
-uint64_t diagToHorizontal_fwd_SSE(const uint64_t toShift) {
+DIAG_INLINE uint64_t diagToHorizontal_fwd_SSE(const uint64_t toShift) {
+    if (DIAG_IS_CONSTANT(toShift)) return diagToHorizontal_fwd_mul(toShift);
+
     __m128i toShift_inLo = _mm_cvtsi64_si128(toShift);
 
     // [B,A] => [0,B,0,A]
@@ -70,7 +100,9 @@ uint64_t diagToHorizontal_fwd_SSE(const uint64_t toShift) {
 }
 
 // Anti-clockwise (/ -> -) !!REVERSED ORDER!!
-uint64_t diagToHorizontal_fwd_SAD_ANTI(const uint64_t toShift) {
+DIAG_INLINE uint64_t diagToHorizontal_fwd_SAD_ANTI(const uint64_t toShift) {
+    if (DIAG_IS_CONSTANT(toShift)) return reverseBitsLUT[diagToHorizontal_fwd_mul(toShift)];
+
     __m128i toShift_inLo = _mm_cvtsi64_si128(toShift);
 
     // Mask the diagonal bits in each row
@@ -82,26 +114,10 @@ uint64_t diagToHorizontal_fwd_SAD_ANTI(const uint64_t toShift) {
     return _mm_cvtsi128_si64(resultInLo);
 }
 
-static const uint8_t reverseBitsLUT[] = {
-  0x00, 0x80, 0x40, 0xC0, 0x20, 0xA0, 0x60, 0xE0, 0x10, 0x90, 0x50, 0xD0, 0x30, 0xB0, 0x70, 0xF0, 
-  0x08, 0x88, 0x48, 0xC8, 0x28, 0xA8, 0x68, 0xE8, 0x18, 0x98, 0x58, 0xD8, 0x38, 0xB8, 0x78, 0xF8, 
-  0x04, 0x84, 0x44, 0xC4, 0x24, 0xA4, 0x64, 0xE4, 0x14, 0x94, 0x54, 0xD4, 0x34, 0xB4, 0x74, 0xF4, 
-  0x0C, 0x8C, 0x4C, 0xCC, 0x2C, 0xAC, 0x6C, 0xEC, 0x1C, 0x9C, 0x5C, 0xDC, 0x3C, 0xBC, 0x7C, 0xFC, 
-  0x02, 0x82, 0x42, 0xC2, 0x22, 0xA2, 0x62, 0xE2, 0x12, 0x92, 0x52, 0xD2, 0x32, 0xB2, 0x72, 0xF2, 
-  0x0A, 0x8A, 0x4A, 0xCA, 0x2A, 0xAA, 0x6A, 0xEA, 0x1A, 0x9A, 0x5A, 0xDA, 0x3A, 0xBA, 0x7A, 0xFA,
-  0x06, 0x86, 0x46, 0xC6, 0x26, 0xA6, 0x66, 0xE6, 0x16, 0x96, 0x56, 0xD6, 0x36, 0xB6, 0x76, 0xF6, 
-  0x0E, 0x8E, 0x4E, 0xCE, 0x2E, 0xAE, 0x6E, 0xEE, 0x1E, 0x9E, 0x5E, 0xDE, 0x3E, 0xBE, 0x7E, 0xFE,
-  0x01, 0x81, 0x41, 0xC1, 0x21, 0xA1, 0x61, 0xE1, 0x11, 0x91, 0x51, 0xD1, 0x31, 0xB1, 0x71, 0xF1,
-  0x09, 0x89, 0x49, 0xC9, 0x29, 0xA9, 0x69, 0xE9, 0x19, 0x99, 0x59, 0xD9, 0x39, 0xB9, 0x79, 0xF9, 
-  0x05, 0x85, 0x45, 0xC5, 0x25, 0xA5, 0x65, 0xE5, 0x15, 0x95, 0x55, 0xD5, 0x35, 0xB5, 0x75, 0xF5,
-  0x0D, 0x8D, 0x4D, 0xCD, 0x2D, 0xAD, 0x6D, 0xED, 0x1D, 0x9D, 0x5D, 0xDD, 0x3D, 0xBD, 0x7D, 0xFD,
-  0x03, 0x83, 0x43, 0xC3, 0x23, 0xA3, 0x63, 0xE3, 0x13, 0x93, 0x53, 0xD3, 0x33, 0xB3, 0x73, 0xF3, 
-  0x0B, 0x8B, 0x4B, 0xCB, 0x2B, 0xAB, 0x6B, 0xEB, 0x1B, 0x9B, 0x5B, 0xDB, 0x3B, 0xBB, 0x7B, 0xFB,
-  0x07, 0x87, 0x47, 0xC7, 0x27, 0xA7, 0x67, 0xE7, 0x17, 0x97, 0x57, 0xD7, 0x37, 0xB7, 0x77, 0xF7, 
-  0x0F, 0x8F, 0x4F, 0xCF, 0x2F, 0xAF, 0x6F, 0xEF, 0x1F, 0x9F, 0x5F, 0xDF, 0x3F, 0xBF, 0x7F, 0xFF
-};
 // Clockwise (/ -> -)
-uint64_t diagToHorizontal_fwd_SAD(const uint64_t toShift) {
+DIAG_INLINE uint64_t diagToHorizontal_fwd_SAD(const uint64_t toShift) {
+    if (DIAG_IS_CONSTANT(toShift)) return diagToHorizontal_fwd_mul(toShift);
+
     __m128i toShift_inLo = _mm_cvtsi64_si128(toShift);
 
     // Mask the diagonal bits in each row
@@ -112,5 +128,340 @@ uint64_t diagToHorizontal_fwd_SAD(const uint64_t toShift) {
     __m128i resultInLo = _mm_sad_epu8(diagBitsOnly, _mm_setzero_si128());
     return reverseBitsLUT[_mm_cvtsi128_si64(resultInLo)];
 }
+#endif
+
+
+
+// ==================
+//    Any diagonal
+// ==================
+// 'k' is the diagonal's offset from the main one in columns, -7 to 7 ('column - row' for (\), 'column + row - 7' for (/)).
+// Bit 'i' is the square in column 'i' (\) or column '7 - i' (/), same as the main diagonal, and bits off the board are 0.
+//
+// A diagonal has a single square per column, so the SAD & the multiply don't care which rows it is on: only the mask changes.
+// 'pext' packs from bit 0 instead, so it's shifted up to the diagonal's first square. Nothing branches on 'k'.
+
+// Same as the main diagonals, the multiply adds every row into the top byte
+// Anti-clockwise (\ -> -)
+DIAG_INLINE uint8_t diagExtract_back_mul(const uint64_t board, const int k) {
+    return ((board & backDiagonals[k + 7]) * 0x0101010101010101ULL) >> 56;
+}
+
+// Clockwise (/ -> -)
+DIAG_INLINE uint8_t diagExtract_fwd_mul(const uint64_t board, const int k) {
+    return reverseBitsLUT[((board & fwdDiagonals[k + 7]) * 0x0101010101010101ULL) >> 56];
+}
+
+// The SAD is the same sum
+#ifdef DIAG_X86
+// Anti-clockwise (\ -> -)
+DIAG_INLINE uint8_t diagExtract_back_SAD(const uint64_t board, const int k) {
+    if (DIAG_IS_CONSTANT(board) && DIAG_IS_CONSTANT(k)) return diagExtract_back_mul(board, k);
+    __m128i diagBitsOnly = _mm_cvtsi64_si128(board & backDiagonals[k + 7]);
+    return _mm_cvtsi128_si32(_mm_sad_epu8(diagBitsOnly, _mm_setzero_si128()));
+}
+
+// Clockwise (/ -> -)
+DIAG_INLINE uint8_t diagExtract_fwd_SAD(const uint64_t board, const int k) {
+    if (DIAG_IS_CONSTANT(board) && DIAG_IS_CONSTANT(k)) return diagExtract_fwd_mul(board, k);
+    __m128i diagBitsOnly = _mm_cvtsi64_si128(board & fwdDiagonals[k + 7]);
+    return reverseBitsLUT[_mm_cvtsi128_si32(_mm_sad_epu8(diagBitsOnly, _mm_setzero_si128()))];
+}
+#endif
+
+#ifdef COMPILE_BMI2
+// Packed from the lowest square, which is column 'k' when the diagonal starts on the bottom row (k > 0)
+static inline TARGET_BMI2 uint8_t diagExtract_back_pext(const uint64_t board, const int k) {
+    if (DIAG_IS_CONSTANT(board) && DIAG_IS_CONSTANT(k)) return diagExtract_back_mul(board, k);
+    return _pext_u64(board, backDiagonals[k + 7]) << (k & -(k > 0));
+}
+
+// Lowest square is column '7 + k' when on the bottom row (k < 0), so bit '-k'
+static inline TARGET_BMI2 uint8_t diagExtract_fwd_pext(const uint64_t board, const int k) {
+    if (DIAG_IS_CONSTANT(board) && DIAG_IS_CONSTANT(k)) return diagExtract_fwd_mul(board, k);
+    return _pext_u64(board, fwdDiagonals[k + 7]) << (-k & -(k < 0));
+}
+#endif
+
+// The multiplies are as fast or faster than 'pext' here, which needs the extra shift
+#define diagExtract_back diagExtract_back_mul
+#define diagExtract_fwd  diagExtract_fwd_mul
+
+
+
+// ==================
+//      Batched
+// ==================
+// Same as the SSE method: diagonal shift to the left, then grab the MSB of each byte.
+// Every board is a 64-bit lane, so the movemask is already the packed output bytes.
+#ifdef DIAG_X86
+
+static inline void diagToHorizontal_batch_sse(const uint64_t *in, uint8_t *out, size_t n, const __m128i powersOfTwo) {
+    size_t i = 0;
+    for (; i + 2 <= n; i += 2) {
+        __m128i shifted = diagShift_left_x2(_mm_loadu_si128((const __m128i*)(in + i)), powersOfTwo);
+        uint16_t horizontal = _mm_movemask_epi8(shifted);
+        memcpy(out + i, &horizontal, sizeof(horizontal));
+    }
+
+    for (; i < n; i++)
+        out[i] = _mm_movemask_epi8(diagShift_left_x2(_mm_cvtsi64_si128(in[i]), powersOfTwo));
+}
+
+#ifdef COMPILE_AVX2
+static inline TARGET_AVX2 void diagToHorizontal_batch_avx2(const uint64_t *in, uint8_t *out, size_t n, const __m128i powersOfTwo) {
+    const __m256i powersOfTwo_256 = _mm256_broadcastsi128_si256(powersOfTwo);
+
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m256i shifted = diagShift_left_x4(_mm256_loadu_si256((const __m256i*)(in + i)), powersOfTwo_256);
+        uint32_t horizontal = _mm256_movemask_epi8(shifted);
+        memcpy(out + i, &horizontal, sizeof(horizontal));
+    }
+
+    diagToHorizontal_batch_sse(in + i, out + i, n - i, powersOfTwo);
+}
+#endif
+
+#ifdef COMPILE_AVX512 // avx512bw
+static inline TARGET_AVX512 void diagToHorizontal_batch_avx512(const uint64_t *in, uint8_t *out, size_t n, const __m128i powersOfTwo) {
+    const __m512i powersOfTwo_512 = _mm512_broadcast_i32x4(powersOfTwo);
+
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m512i shifted = diagShift_left_x8(_mm512_loadu_si512(in + i), powersOfTwo_512);
+        uint64_t horizontal = _mm512_movepi8_mask(shifted);
+        memcpy(out + i, &horizontal, sizeof(horizontal));
+    }
+
+    diagToHorizontal_batch_sse(in + i, out + i, n - i, powersOfTwo);
+}
+#endif
+#endif
+
+
+// ==================
+//       GFNI
+// ==================
+// With the board (rows reversed) as the matrix, output bit 'i' is the parity of "row 'i' & x".
+// Masked to the diagonal, each row has at most 1 bit left, so 'x = 0xFF' reads them all out as one byte.
+#ifdef COMPILE_GFNI
+static inline TARGET_GFNI uint8_t diagToHorizontal_gfni(const uint64_t toShift, const uint64_t diagonalMask) {
+    __m128i reversedRows = _mm_cvtsi64_si128((long long)_bswap64((long long)(toShift & diagonalMask)));
+    return (uint8_t)_mm_cvtsi128_si32(_mm_gf2p8affine_epi64_epi8(_mm_cvtsi32_si128(UINT8_MAX), reversedRows, 0));
+}
+
+// Anti-clockwise (\ -> -)
+static inline TARGET_GFNI uint8_t diagToHorizontal_back_gfni(const uint64_t toShift) {
+    if (DIAG_IS_CONSTANT(toShift)) return diagToHorizontal_back_mul(toShift);
+    return diagToHorizontal_gfni(toShift, hex2d_as_u64(80, 40, 20, 10, 08, 04, 02, 01));
+}
+
+// Clockwise (/ -> -)
+static inline TARGET_GFNI uint8_t diagToHorizontal_fwd_gfni(const uint64_t toShift) {
+    if (DIAG_IS_CONSTANT(toShift)) return diagToHorizontal_fwd_mul(toShift);
+    return diagToHorizontal_gfni(toShift, hex2d_as_u64(01, 02, 04, 08, 10, 20, 40, 80));
+}
+
+
+// The batch loops take the same multipliers as the other widths: row 'i' keeps the bit they shift onto the MSB
+static inline uint64_t diagToHorizontal_gfniMask(const __m128i powersOfTwo) {
+    uint16_t powers[8];
+    _mm_storeu_si128((__m128i*)powers, powersOfTwo);
+
+    uint64_t diagonalMask = 0;
+    for (size_t i = 0; i < 8; i++)
+        diagonalMask |= (uint64_t)(0x80 >> __builtin_ctz(powers[i])) << 8*i;
+    return diagonalMask;
+}
+
+// Board 'q' only reads out into byte 'q' of its lane, so OR-ing the lanes together packs the output bytes
+static inline TARGET_GFNI void diagToHorizontal_batch_gfni(const uint64_t *in, uint8_t *out, size_t n, const __m128i powersOfTwo) {
+    const __m128i diagonalMask = _mm_set1_epi64x(diagToHorizontal_gfniMask(powersOfTwo));
+    const __m128i reverseRows = _mm_set_epi8(8, 9, 10, 11, 12, 13, 14, 15, 0, 1, 2, 3, 4, 5, 6, 7);
+    const __m128i readOut = _mm_set_epi64x(0xFF00, 0x00FF);
+
+    size_t i = 0;
+    for (; i + 2 <= n; i += 2) {
+        __m128i diagBitsOnly = _mm_and_si128(_mm_loadu_si128((const __m128i*)(in + i)), diagonalMask);
+        __m128i horizontal = _mm_gf2p8affine_epi64_epi8(readOut, _mm_shuffle_epi8(diagBitsOnly, reverseRows), 0);
+
+        uint16_t packed = (uint16_t)_mm_cvtsi128_si32(_mm_or_si128(horizontal, _mm_unpackhi_epi64(horizontal, horizontal)));
+        memcpy(out + i, &packed, sizeof(packed));
+    }
+
+    const uint64_t scalarMask = diagToHorizontal_gfniMask(powersOfTwo);
+    for (; i < n; i++)
+        out[i] = diagToHorizontal_gfni(in[i], scalarMask);
+}
+#endif
+
+#if defined(COMPILE_GFNI) && defined(COMPILE_AVX2)
+static inline TARGET_GFNI_AVX2 void diagToHorizontal_batch_gfni_avx2(const uint64_t *in, uint8_t *out, size_t n, const __m128i powersOfTwo) {
+    const __m256i diagonalMask = _mm256_set1_epi64x(diagToHorizontal_gfniMask(powersOfTwo));
+    const __m256i reverseRows = _mm256_broadcastsi128_si256(_mm_set_epi8(8, 9, 10, 11, 12, 13, 14, 15, 0, 1, 2, 3, 4, 5, 6, 7));
+    const __m256i readOut = _mm256_set_epi64x(0xFF000000, 0x00FF0000, 0x0000FF00, 0x000000FF);
+
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m256i diagBitsOnly = _mm256_and_si256(_mm256_loadu_si256((const __m256i*)(in + i)), diagonalMask);
+        __m256i horizontal = _mm256_gf2p8affine_epi64_epi8(readOut, _mm256_shuffle_epi8(diagBitsOnly, reverseRows), 0);
+
+        __m128i halves = _mm_or_si128(_mm256_castsi256_si128(horizontal), _mm256_extracti128_si256(horizontal, 1));
+        uint32_t packed = (uint32_t)_mm_cvtsi128_si32(_mm_or_si128(halves, _mm_unpackhi_epi64(halves, halves)));
+        memcpy(out + i, &packed, sizeof(packed));
+    }
+
+    diagToHorizontal_batch_gfni(in + i, out + i, n - i, powersOfTwo);
+}
+#endif
+
+#if defined(COMPILE_GFNI) && defined(COMPILE_AVX512)
+// Every byte of a lane holds the output, 'vpmovqb' packs the low ones
+static inline TARGET_GFNI_AVX512 void diagToHorizontal_batch_gfni_avx512(const uint64_t *in, uint8_t *out, size_t n, const __m128i powersOfTwo) {
+    const __m512i diagonalMask = _mm512_set1_epi64(diagToHorizontal_gfniMask(powersOfTwo));
+    const __m512i reverseRows = _mm512_broadcast_i32x4(_mm_set_epi8(8, 9, 10, 11, 12, 13, 14, 15, 0, 1, 2, 3, 4, 5, 6, 7));
+
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m512i diagBitsOnly = _mm512_and_si512(_mm512_loadu_si512(in + i), diagonalMask);
+        __m512i horizontal = _mm512_gf2p8affine_epi64_epi8(_mm512_set1_epi8(-1), _mm512_shuffle_epi8(diagBitsOnly, reverseRows), 0);
+        _mm_storel_epi64((__m128i*)(out + i), _mm512_cvtepi64_epi8(horizontal));
+    }
+
+    diagToHorizontal_batch_gfni(in + i, out + i, n - i, powersOfTwo);
+}
+#endif
+
+
+// ==================
+//   AVX-512 BITALG
+// ==================
+// 'vpshufbitqmb': mask bit 'i' of each qword is the board's bit at 'control.byte[i]', so bit 'i' is read straight from row 'i'.
+// No masking or packing: the 8 bits of each board are already its output byte (and 8 boards are the 64-bit mask).
+#ifdef COMPILE_BITALG
+// Square of each row's diagonal bit (low byte is row 0)
+#define DIAG_EXTRACT_BACK_BITSHUFFLE 0x3F362D241B120900ULL
+#define DIAG_EXTRACT_FWD_BITSHUFFLE  0x38312A231C150E07ULL
+
+static inline TARGET_BITALG uint8_t diagToHorizontal_bitshuffle(const uint64_t toShift, const uint64_t control) {
+    return (uint8_t)_mm_bitshuffle_epi64_mask(_mm_cvtsi64_si128((long long)toShift), _mm_cvtsi64_si128((long long)control));
+}
+
+// Anti-clockwise (\ -> -)
+static inline TARGET_BITALG uint8_t diagToHorizontal_back_bitalg(const uint64_t toShift) {
+    if (DIAG_IS_CONSTANT(toShift)) return diagToHorizontal_back_mul(toShift);
+    return diagToHorizontal_bitshuffle(toShift, DIAG_EXTRACT_BACK_BITSHUFFLE);
+}
+
+// Clockwise (/ -> -)
+static inline TARGET_BITALG uint8_t diagToHorizontal_fwd_bitalg(const uint64_t toShift) {
+    if (DIAG_IS_CONSTANT(toShift)) return diagToHorizontal_fwd_mul(toShift);
+    return diagToHorizontal_bitshuffle(toShift, DIAG_EXTRACT_FWD_BITSHUFFLE);
+}
+
+
+// The batch loops take the same multipliers as the other widths: row 'i' reads the bit they shift onto the MSB
+static inline uint64_t diagToHorizontal_bitshuffleControl(const __m128i powersOfTwo) {
+    uint16_t powers[8];
+    _mm_storeu_si128((__m128i*)powers, powersOfTwo);
+
+    uint64_t control = 0;
+    for (size_t i = 0; i < 8; i++)
+        control |= (uint64_t)(8*i + 7 - __builtin_ctz(powers[i])) << 8*i;
+    return control;
+}
+
+static inline TARGET_BITALG void diagToHorizontal_batch_bitalg(const uint64_t *in, uint8_t *out, size_t n, const __m128i powersOfTwo) {
+    const uint64_t control = diagToHorizontal_bitshuffleControl(powersOfTwo);
+    const __m512i control_512 = _mm512_set1_epi64((long long)control);
+
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        uint64_t horizontal = _cvtmask64_u64(_mm512_bitshuffle_epi64_mask(_mm512_loadu_si512(in + i), control_512));
+        memcpy(out + i, &horizontal, sizeof(horizontal));
+    }
+
+    for (; i < n; i++)
+        out[i] = diagToHorizontal_bitshuffle(in[i], control);
+}
+#endif
+
+
+// ==================
+//  Vector extensions
+// ==================
+// Masked to the diagonal, then every row is OR-ed into the low byte (the SAD's sum).
+// For (/) a compare first sets each row that has its bit to 0xFF, which is masked to bit 'row' (same order as the SSE versions).
+#ifdef COMPILE_VECTOR
+DIAG_INLINE diagVec_u64 diagToHorizontal_vec(diagVec_u64 boards, const int fwd) {
+    if (fwd)
+        boards = (diagVec_u64)((diagVec_u8)(boards & 0x0102040810204080ULL) != 0) & 0x8040201008040201ULL;
+    else
+        boards &= 0x8040201008040201ULL;
+
+    boards |= boards >> 32;
+    boards |= boards >> 16;
+    boards |= boards >> 8;
+    return boards & UINT8_MAX;
+}
+
+// Anti-clockwise (\ -> -)
+DIAG_INLINE uint8_t diagToHorizontal_back_vec(const uint64_t toShift) {
+    return diagToHorizontal_vec((diagVec_u64){toShift}, 0)[0];
+}
+
+// Clockwise (/ -> -)
+DIAG_INLINE uint8_t diagToHorizontal_fwd_vec(const uint64_t toShift) {
+    return diagToHorizontal_vec((diagVec_u64){toShift}, 1)[0];
+}
+
+static inline void diagToHorizontal_batch_vec(const uint64_t *in, uint8_t *out, size_t n, const int fwd) {
+    size_t i = 0;
+    for (; i + DIAG_VECTOR_BOARDS <= n; i += DIAG_VECTOR_BOARDS) {
+        diagVec_u64 boards;
+        memcpy(&boards, in + i, sizeof(boards));
+        const diagVec_bytes horizontal = __builtin_convertvector(diagToHorizontal_vec(boards, fwd), diagVec_bytes);
+        memcpy(out + i, &horizontal, sizeof(horizontal));
+    }
+
+    for (; i < n; i++)
+        out[i] = (uint8_t)diagToHorizontal_vec((diagVec_u64){in[i]}, fwd)[0];
+}
+
+static inline void diagToHorizontal_back_batch_vec(const uint64_t *in, uint8_t *out, size_t n) {
+    diagToHorizontal_batch_vec(in, out, n, 0);
+}
+
+static inline void diagToHorizontal_fwd_batch_vec(const uint64_t *in, uint8_t *out, size_t n) {
+    diagToHorizontal_batch_vec(in, out, n, 1);
+}
+#endif
+
+
+#ifdef DIAG_PORTABLE
+    #define diagToHorizontal_back_batch diagToHorizontal_back_batch_vec
+    #define diagToHorizontal_fwd_batch  diagToHorizontal_fwd_batch_vec
+#else
+#if defined(CPU_HAS_BITALG)
+    #define diagToHorizontal_batch diagToHorizontal_batch_bitalg
+#elif defined(CPU_HAS_AVX512)
+    #define diagToHorizontal_batch diagToHorizontal_batch_avx512
+#elif defined(CPU_HAS_AVX2)
+    #define diagToHorizontal_batch diagToHorizontal_batch_avx2
+#else
+    #define diagToHorizontal_batch diagToHorizontal_batch_sse
+#endif
+
+// Anti-clockwise (\ -> -)
+static inline void diagToHorizontal_back_batch(const uint64_t *in, uint8_t *out, size_t n) {
+    diagToHorizontal_batch(in, out, n, DIAG_SHIFT_BL_POWERS);
+}
+
+// Clockwise (/ -> -)
+static inline void diagToHorizontal_fwd_batch(const uint64_t *in, uint8_t *out, size_t n) {
+    diagToHorizontal_batch(in, out, n, DIAG_SHIFT_TL_POWERS);
+}
+#endif
 
 #endif
\ No newline at end of file
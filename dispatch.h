@@ -0,0 +1,237 @@
+#ifndef DISPATCH_H
+#define DISPATCH_H
+
+// Binds each operation to the fastest method the running CPU supports, checked once at startup.
+// Every variant must be compiled for this, so include it before the other headers
+// (or define DIAG_RUNTIME_DISPATCH for the whole build).
+#ifndef DIAG_RUNTIME_DISPATCH
+    #ifdef CPU_FEATURES_H
+        #error "Include dispatch.h before the other headers, or define DIAG_RUNTIME_DISPATCH"
+    #endif
+    #define DIAG_RUNTIME_DISPATCH
+#endif
+
+#include <stdint.h>
+#include <stddef.h>     // size_t
+#include <cpuid.h>      // Vendor & family
+
+#include "cpuFeatures.h"
+#include "diagShift.h"
+#include "diagToHorizontal.h"
+#include "horizontalTo64.h"
+#include "transpose.h"
+
+
+enum DiagCpuFeature {
+    DIAG_CPU_BMI2   = 1 << 0, // Only when pext/pdep are fast, see 'diagOps_hasSlowPdep'
+    DIAG_CPU_AVX2   = 1 << 1,
+    DIAG_CPU_AVX512 = 1 << 2, // F, BW & VL
+    DIAG_CPU_GFNI   = 1 << 3,
+    DIAG_CPU_VBMI   = 1 << 4, // Only with DIAG_CPU_AVX512
+    DIAG_CPU_BITALG = 1 << 5, // Same
+};
+
+typedef struct {
+    uint64_t (*shift_bl)(uint64_t);
+    uint64_t (*shift_tl)(uint64_t);
+    uint64_t (*shift_br)(uint64_t);
+    uint64_t (*shift_tr)(uint64_t);
+    uint8_t  (*extract_back)(uint64_t);
+    uint8_t  (*extract_fwd)(uint64_t);
+    uint64_t (*toDiag_back)(uint8_t);
+    uint64_t (*toDiag_fwd)(uint8_t);
+    uint64_t (*toVertical)(uint8_t);
+    uint64_t (*transpose)(uint64_t);
+
+    // Widest batch loop, the per operation constants are passed in by the 'diagOps_*_batch' functions
+    void (*batch_left)(const uint64_t*, uint64_t*, size_t, __m128i);
+    void (*batch_right)(const uint64_t*, uint64_t*, size_t, __m128i);
+    void (*batch_extract)(const uint64_t*, uint8_t*, size_t, __m128i);
+    void (*batch_toBytes)(const uint8_t*, uint64_t*, size_t, uint64_t, int);
+    void (*batch_transpose)(const uint64_t*, uint64_t*, size_t);
+
+    unsigned features;
+} DiagOps;
+
+
+// The SAD methods return a u64
+static uint8_t diagOps_extract_back_SAD(uint64_t board) { return diagToHorizontal_back_SAD(board); }
+static uint8_t diagOps_extract_fwd_SAD(uint64_t board) { return diagToHorizontal_fwd_SAD(board); }
+
+// SSE2 is part of x86-64, so calls made before the constructor runs are still valid
+static DiagOps diagOps = {
+    diagShift_bl_SSE, diagShift_tl_SSE, diagShift_br_SSE, diagShift_tr_SSE,
+    diagOps_extract_back_SAD, diagOps_extract_fwd_SAD,
+    toDiag_back_sse, toDiag_fwd_sse, toVertical_sse,
+    diagTranspose_sse,
+
+    diagShift_batch_left_sse, diagShift_batch_right_sse,
+    diagToHorizontal_batch_sse, toBytes_batch_sse, diagTranspose_batch_sse,
+    0
+};
+
+
+// Zen 1/2 (and Hygon, which is based on Zen 1) and earlier AMD CPUs microcode pext/pdep,
+// taking hundreds of cycles depending on the mask. Fixed in Zen 3 (family 0x19).
+static int diagOps_hasSlowPdep(void) {
+    unsigned int maxLeaf, vendor[3], signature, unused;
+    if (!__get_cpuid(0, &maxLeaf, &vendor[0], &vendor[2], &vendor[1]) || maxLeaf < 1)
+        return 0;
+
+    // "AuthenticAMD" & "HygonGenuine" (ebx only)
+    const int isAMD = vendor[0] == 0x68747541 && vendor[1] == 0x69746E65 && vendor[2] == 0x444D4163;
+    const int isHygon = vendor[0] == 0x6F677948;
+    if (!isAMD && !isHygon)
+        return 0;
+
+    if (!__get_cpuid(1, &signature, &unused, &unused, &unused))
+        return 0;
+    unsigned int family = (signature >> 8) & 0xF;
+    if (family == 0xF)
+        family += (signature >> 20) & 0xFF;
+
+    return family < 0x19;
+}
+
+static unsigned diagOps_detect(void) {
+    __builtin_cpu_init(); // Required when called from a constructor
+    unsigned features = 0;
+
+    if (__builtin_cpu_supports("bmi2") && !diagOps_hasSlowPdep())
+        features |= DIAG_CPU_BMI2;
+    if (__builtin_cpu_supports("avx2"))
+        features |= DIAG_CPU_AVX2;
+    if (__builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw") && __builtin_cpu_supports("avx512vl"))
+        features |= DIAG_CPU_AVX512;
+    if (__builtin_cpu_supports("gfni"))
+        features |= DIAG_CPU_GFNI;
+    if ((features & DIAG_CPU_AVX512) && __builtin_cpu_supports("avx512vbmi"))
+        features |= DIAG_CPU_VBMI;
+    if ((features & DIAG_CPU_AVX512) && __builtin_cpu_supports("avx512bitalg"))
+        features |= DIAG_CPU_BITALG;
+
+    return features;
+}
+
+// Can also be used to force a subset of the features, e.g. to compare the methods
+static void diagOps_bind(const unsigned features) {
+    diagOps.features = features;
+
+    // pext/pdep: single instruction, ~3 cycle latency and no trip to the vector registers
+    diagOps.extract_back = (features & DIAG_CPU_BMI2)? diagToHorizontal_back_pext : diagOps_extract_back_SAD;
+    diagOps.extract_fwd =  (features & DIAG_CPU_BMI2)? diagToHorizontal_fwd_pext  : diagOps_extract_fwd_SAD;
+    diagOps.toDiag_fwd =   (features & DIAG_CPU_BMI2)? toDiagonal_fwd_pdep : toDiag_fwd_sse;
+    diagOps.toVertical =   (features & DIAG_CPU_BMI2)? toVertical_pdep     : toVertical_sse;
+    diagOps.toDiag_back =  (features & DIAG_CPU_AVX512)? toDiag_back_avx512 : toDiag_back_sse;
+
+    diagOps.shift_bl = diagShift_bl_SSE;
+    diagOps.shift_tl = diagShift_tl_SSE;
+    diagOps.shift_br = diagShift_br_SSE;
+    diagOps.shift_tr = diagShift_tr_SSE;
+
+    diagOps.transpose = diagTranspose_sse;
+    diagOps.batch_left = diagShift_batch_left_sse;
+    diagOps.batch_right = diagShift_batch_right_sse;
+    diagOps.batch_extract = diagToHorizontal_batch_sse;
+    diagOps.batch_toBytes = toBytes_batch_sse;
+    diagOps.batch_transpose = diagTranspose_batch_sse;
+
+    if (features & DIAG_CPU_AVX2) {
+        diagOps.transpose = diagTranspose_avx2;
+        diagOps.batch_left = diagShift_batch_left_avx2;
+        diagOps.batch_right = diagShift_batch_right_avx2;
+        diagOps.batch_extract = diagToHorizontal_batch_avx2;
+        diagOps.batch_toBytes = toBytes_batch_avx2;
+        diagOps.batch_transpose = diagTranspose_batch_avx2;
+    }
+
+    if (features & DIAG_CPU_AVX512) {
+        diagOps.transpose = diagTranspose_avx512;
+        diagOps.batch_left = diagShift_batch_left_avx512;
+        diagOps.batch_right = diagShift_batch_right_avx512;
+        diagOps.batch_extract = diagToHorizontal_batch_avx512;
+        diagOps.batch_toBytes = toBytes_batch_avx512;
+        diagOps.batch_transpose = diagTranspose_batch_avx512;
+    }
+
+    // 'gf2p8affine' only wins for the transpose & the masked (AVX-512) shift, plus the AVX2 deposits.
+    // The blend based shifts & the extracts are slower than the multiply/movemask versions.
+    if (features & DIAG_CPU_GFNI) {
+        diagOps.transpose = diagTranspose_gfni;
+        diagOps.batch_transpose = diagTranspose_batch_gfni;
+
+        if (features & DIAG_CPU_AVX2) {
+            diagOps.batch_toBytes = toBytes_batch_gfni_avx2;
+            diagOps.batch_transpose = diagTranspose_batch_gfni_avx2;
+        }
+        if (features & DIAG_CPU_AVX512) {
+            diagOps.batch_left = diagShift_batch_left_gfni_avx512;
+            diagOps.batch_right = diagShift_batch_right_gfni_avx512;
+            diagOps.batch_toBytes = toBytes_batch_avx512;
+            diagOps.batch_transpose = diagTranspose_batch_gfni_avx512;
+        }
+    }
+
+    // 'vpmultishiftqb' shifts every row of 8 boards in 1 instruction (+ a mask), 'vpshufbitqmb' extracts them straight
+    // into a mask. The single board extracts stay on pext/SAD, which have the lower latency
+    if (features & DIAG_CPU_VBMI) {
+        diagOps.shift_bl = diagShift_bl_vbmi;
+        diagOps.shift_tl = diagShift_tl_vbmi;
+        diagOps.shift_br = diagShift_br_vbmi;
+        diagOps.shift_tr = diagShift_tr_vbmi;
+        diagOps.batch_left = diagShift_batch_left_vbmi;
+        diagOps.batch_right = diagShift_batch_right_vbmi;
+    }
+    if (features & DIAG_CPU_BITALG)
+        diagOps.batch_extract = diagToHorizontal_batch_bitalg;
+}
+
+__attribute__((constructor)) static void diagOps_init(void) {
+    diagOps_bind(diagOps_detect());
+}
+
+
+// =====================
+//  Batched entry points
+// =====================
+static inline void diagOps_shift_bl_batch(const uint64_t *in, uint64_t *out, size_t n) {
+    diagOps.batch_left(in, out, n, DIAG_SHIFT_BL_POWERS);
+}
+
+static inline void diagOps_shift_tl_batch(const uint64_t *in, uint64_t *out, size_t n) {
+    diagOps.batch_left(in, out, n, DIAG_SHIFT_TL_POWERS);
+}
+
+static inline void diagOps_shift_br_batch(const uint64_t *in, uint64_t *out, size_t n) {
+    diagOps.batch_right(in, out, n, DIAG_SHIFT_BR_POWERS);
+}
+
+static inline void diagOps_shift_tr_batch(const uint64_t *in, uint64_t *out, size_t n) {
+    diagOps.batch_right(in, out, n, DIAG_SHIFT_TR_POWERS);
+}
+
+static inline void diagOps_extract_back_batch(const uint64_t *in, uint8_t *out, size_t n) {
+    diagOps.batch_extract(in, out, n, DIAG_SHIFT_BL_POWERS);
+}
+
+static inline void diagOps_extract_fwd_batch(const uint64_t *in, uint8_t *out, size_t n) {
+    diagOps.batch_extract(in, out, n, DIAG_SHIFT_TL_POWERS);
+}
+
+static inline void diagOps_toDiag_back_batch(const uint8_t *in, uint64_t *out, size_t n) {
+    diagOps.batch_toBytes(in, out, n, 0x8040201008040201ULL, 0);
+}
+
+static inline void diagOps_toDiag_fwd_batch(const uint8_t *in, uint64_t *out, size_t n) {
+    diagOps.batch_toBytes(in, out, n, 0x0102040810204080ULL, 1);
+}
+
+static inline void diagOps_toVertical_batch(const uint8_t *in, uint64_t *out, size_t n) {
+    diagOps.batch_toBytes(in, out, n, 0x0101010101010101ULL, 1);
+}
+
+static inline void diagOps_transpose_batch(const uint64_t *in, uint64_t *out, size_t n) {
+    diagOps.batch_transpose(in, out, n);
+}
+
+#endif
@@ -3,20 +3,30 @@
 
 #include <stdint.h>
 #include <limits.h>     // For masking
-#include <immintrin.h> // SSE2 & clMul
-
-#define hex2d_as_u64(r7, r6, r5, r4, r3, r2, r1, r0) (0x ## r7 ## r6 ## r5 ## r4 ## r3 ## r2 ## r1 ## r0 ## ULL)
+#include <stddef.h>     // size_t
+#include <string.h>     // memcpy
+
+#include "cpuFeatures.h"
+#include "diagShift.h"  // The diagonal masks
+#include "tableGen.h"   // hex2d_as_u64
+#ifdef DIAG_X86
+#include <immintrin.h> // SSE2, clMul & GFNI
+#endif
 
+// The '_mul' versions have no intrinsics, the others use them when the input is known at compile time (see 'DIAG_IS_CONSTANT')
 
 // Clockwise (- -> \)
-uint64_t toDiag_back_mul(const uint8_t input) {
+DIAG_INLINE uint64_t toDiag_back_mul(const uint8_t input) {
     uint64_t broadcasted = input * 0x0101010101010101ULL;
     // Keep only diagonal bits
     return broadcasted & 0x8040201008040201ULL;
 }
 
+#ifdef DIAG_X86
 // Clockwise (- -> \)
-uint64_t toDiag_back_sse(const uint8_t input) {
+DIAG_INLINE uint64_t toDiag_back_sse(const uint8_t input) {
+    if (DIAG_IS_CONSTANT(input)) return toDiag_back_mul(input);
+
     __m128i boadcasted = _mm_set1_epi8(input);
     //return _mm_cvtsi128_si64(boadcasted) & 0x8040201008040201ULL;
 
@@ -24,10 +34,11 @@ uint64_t toDiag_back_sse(const uint8_t input) {
     __m128i result = _mm_and_si128(boadcasted, diagonalMask);
     return _mm_cvtsi128_si64(result);
 }
+#endif
 
 
 // Anti-clockwise (- -> /)
-uint64_t toDiag_fwd_mul(const uint8_t input) {
+DIAG_INLINE uint64_t toDiag_fwd_mul(const uint8_t input) {
     // 2+6th bit set for the mul, 6-wide, so no carry
     uint64_t inp_noCarry = input & 0b00111111;
     uint64_t bitsInDiag = inp_noCarry * ((1ULL<<7) + (1ULL<<13) + (1ULL<<19) + (1ULL<<25) + (1ULL<<31) + (1ULL<<37));
@@ -40,8 +51,11 @@ uint64_t toDiag_fwd_mul(const uint8_t input) {
     return bitsInDiag & 0x0102040810204080ULL;
 }
 
+#ifdef DIAG_X86
 // Anti-clockwise (- -> /)
-uint64_t toDiag_fwd_sse(const uint8_t input) {
+DIAG_INLINE uint64_t toDiag_fwd_sse(const uint8_t input) {
+    if (DIAG_IS_CONSTANT(input)) return toDiag_fwd_mul(input);
+
     // A => [A,0, A,0, A,0]
     __m128i interleaved = _mm_slli_epi16(_mm_set1_epi16(input), 8);
 
@@ -56,20 +70,76 @@ uint64_t toDiag_fwd_sse(const uint8_t input) {
     const __m128i DIAGONAL_MASK = _mm_cvtsi64_si128(0x0102040810204080ULL);
     return _mm_cvtsi128_si64(_mm_and_si128(unInterleaved, DIAGONAL_MASK));
 }
+#endif
 
-#ifdef CPU_HAS_BMI2
-uint64_t toDiagonal_fwd_pdep(const uint8_t input) {
+#ifdef COMPILE_BMI2
+static inline TARGET_BMI2 uint64_t toDiagonal_fwd_pdep(const uint8_t input) {
+    if (DIAG_IS_CONSTANT(input)) return toDiag_fwd_mul(input);
     return _pdep_u64(input, 0x0102040810204080ULL);
 }
 #endif
 
 
+// ==================
+//    Any diagonal
+// ==================
+// Inverse of 'diagExtract_*' for diagonal 'k' (-7 to 7, see 'diagToHorizontal.h').
+// Broadcast & mask only needs the diagonal's mask, which also drops the bits past the end of a short diagonal.
+
+// Reversed so bit 'c' is column 'c' (3 ops, no table)
+DIAG_INLINE uint8_t reverseByte_mul(const uint8_t input) {
+    return ((input * 0x80200802ULL) & 0x0884422110ULL) * 0x0101010101ULL >> 32;
+}
+
+// Clockwise (- -> \)
+DIAG_INLINE uint64_t diagDeposit_back_mul(const uint8_t input, const int k) {
+    return (input * 0x0101010101010101ULL) & backDiagonals[k + 7];
+}
+
+#ifdef DIAG_X86
+DIAG_INLINE uint64_t diagDeposit_back_sse(const uint8_t input, const int k) {
+    if (DIAG_IS_CONSTANT(input) && DIAG_IS_CONSTANT(k)) return diagDeposit_back_mul(input, k);
+    __m128i broadcasted = _mm_set1_epi8(input);
+    return _mm_cvtsi128_si64(broadcasted) & backDiagonals[k + 7];
+}
+#endif
+
+// Anti-clockwise (- -> /)
+DIAG_INLINE uint64_t diagDeposit_fwd_mul(const uint8_t input, const int k) {
+    return (reverseByte_mul(input) * 0x0101010101010101ULL) & fwdDiagonals[k + 7];
+}
+
+#ifdef DIAG_X86
+DIAG_INLINE uint64_t diagDeposit_fwd_sse(const uint8_t input, const int k) {
+    if (DIAG_IS_CONSTANT(input) && DIAG_IS_CONSTANT(k)) return diagDeposit_fwd_mul(input, k);
+    __m128i broadcasted = _mm_set1_epi8(reverseByte_mul(input));
+    return _mm_cvtsi128_si64(broadcasted) & fwdDiagonals[k + 7];
+}
+#endif
+
+#ifdef COMPILE_BMI2
+// Same shifts as 'diagExtract_*_pext', the other way
+static inline TARGET_BMI2 uint64_t diagDeposit_back_pdep(const uint8_t input, const int k) {
+    if (DIAG_IS_CONSTANT(input) && DIAG_IS_CONSTANT(k)) return diagDeposit_back_mul(input, k);
+    return _pdep_u64(input >> (k & -(k > 0)), backDiagonals[k + 7]);
+}
+
+static inline TARGET_BMI2 uint64_t diagDeposit_fwd_pdep(const uint8_t input, const int k) {
+    if (DIAG_IS_CONSTANT(input) && DIAG_IS_CONSTANT(k)) return diagDeposit_fwd_mul(input, k);
+    return _pdep_u64(input >> (-k & -(k < 0)), fwdDiagonals[k + 7]);
+}
+#endif
+
+#define diagDeposit_back diagDeposit_back_mul
+#define diagDeposit_fwd  diagDeposit_fwd_mul
+
+
 
 // =====================
 //  To LSB of each byte
 // =====================
 // Anti-clockwise (- -> |)
-uint64_t toVertical_mul(const uint8_t input) {
+DIAG_INLINE uint64_t toVertical_mul(const uint8_t input) {
     // 7th bit set for the mul, 7-wide, so no carry
     uint64_t inp_noCarry = input & 0b11111110;
     uint64_t bitsInDiag = inp_noCarry * ((1ULL<<0) + (1ULL<<7) + (1ULL<<14) + (1ULL<<21) + (1ULL<<28) + (1ULL<<35) + (1ULL<<42) + (1ULL<<49));
@@ -80,8 +150,11 @@ uint64_t toVertical_mul(const uint8_t input) {
     return bitsInDiag & 0x0101010101010101ULL;
 }
 
+#ifdef DIAG_X86
 // Anti-clockwise (- -> |)
-uint64_t toVertical_sse(const uint8_t input) {
+DIAG_INLINE uint64_t toVertical_sse(const uint8_t input) {
+    if (DIAG_IS_CONSTANT(input)) return toVertical_mul(input);
+
     // A => [A,0, A,0, A,0]
     __m128i interleaved = _mm_slli_epi16(_mm_set1_epi16(input), 8);
 
@@ -94,9 +167,10 @@ uint64_t toVertical_sse(const uint8_t input) {
     const __m128i VERTICAL_MASK = _mm_cvtsi64_si128(0x0101010101010101ULL);
     return _mm_cvtsi128_si64(_mm_and_si128(unInterleaved, VERTICAL_MASK));
 }
+#endif
 
 // Anti-clockwise (- -> |)
-uint64_t toVertical_bin(const uint8_t input) {
+DIAG_INLINE uint64_t toVertical_bin(const uint8_t input) {
     uint64_t keptSame, changed, result = (uint64_t)input;
 
     keptSame = result & 0b00001111;
@@ -115,9 +189,11 @@ uint64_t toVertical_bin(const uint8_t input) {
 }
 
 
-#ifdef CPU_HAS_BMI2
+#ifdef COMPILE_BMI2
 // Anti-clockwise (- -> |)
-uint64_t toVertical_clMul(const uint8_t input) {
+static inline TARGET_PCLMUL uint64_t toVertical_clMul(const uint8_t input) {
+    if (DIAG_IS_CONSTANT(input)) return toVertical_mul(input);
+
     __m128i input_vec = _mm_cvtsi32_si128(input);
     __m128i toMul = _mm_cvtsi64_si128((1ULL<<0) + (1ULL<<7) + (1ULL<<14) + (1ULL<<21) + (1ULL<<28) + (1ULL<<35) + (1ULL<<42) + (1ULL<<49));
 
@@ -126,9 +202,302 @@ uint64_t toVertical_clMul(const uint8_t input) {
 }
 
 // Anti-clockwise (- -> |)
-uint64_t toVertical_pdep(const uint8_t input) {
+static inline TARGET_BMI2 uint64_t toVertical_pdep(const uint8_t input) {
+    if (DIAG_IS_CONSTANT(input)) return toVertical_mul(input);
     return _pdep_u64(input, 0x0101010101010101ULL);
 }
 #endif
 
+
+
+// ==================
+//      Batched
+// ==================
+// Every input byte is broadcast to its own 64-bit lane, then:
+//  - Diagonal (\): masked, same as the single board methods
+//  - Diagonal (/) & vertical: row 'i' tests bit 'i', 'cmpeq' expands it to the whole byte, then masked
+#define ROW_BIT_MASK 0x8040201008040201ULL
+
+#ifdef DIAG_X86
+
+// [.., B,A] => [BBBBBBBB, AAAAAAAA]
+DIAG_INLINE __m128i broadcastBytes_x2(const uint8_t *in) {
+    __m128i inLo = _mm_cvtsi32_si128(in[0] | (in[1] << 8));
+    __m128i doubled = _mm_unpacklo_epi8(inLo, inLo);
+    __m128i quadrupled = _mm_unpacklo_epi16(doubled, doubled);
+    return _mm_unpacklo_epi32(quadrupled, quadrupled);
+}
+
+// 'maskOut' is applied after expanding, bytes that don't test their bit are zeroed
+static inline void toBytes_batch_sse(const uint8_t *in, uint64_t *out, size_t n, const uint64_t maskOut, const int expandBit) {
+    const __m128i ROW_BIT = _mm_set1_epi64x(ROW_BIT_MASK), MASK_OUT = _mm_set1_epi64x(maskOut);
+
+    size_t i = 0;
+    for (; i + 2 <= n; i += 2) {
+        __m128i broadcasted = broadcastBytes_x2(in + i);
+        if (expandBit)
+            broadcasted = _mm_cmpeq_epi8(_mm_and_si128(broadcasted, ROW_BIT), ROW_BIT);
+        _mm_storeu_si128((__m128i*)(out + i), _mm_and_si128(broadcasted, MASK_OUT));
+    }
+
+    for (; i < n; i++) {
+        uint64_t broadcasted = in[i] * 0x0101010101010101ULL;
+        if (expandBit) {
+            // Same as 'cmpeq': MSB set if the row's bit is set, then smeared to the entire byte
+            uint64_t rowBitSet = ((broadcasted & ROW_BIT_MASK) + 0x7F7F7F7F7F7F7F7FULL) & 0x8080808080808080ULL;
+            broadcasted = (rowBitSet >> 7) * UINT8_MAX;
+        }
+        out[i] = broadcasted & maskOut;
+    }
+}
+
+
+#ifdef COMPILE_AVX2
+static inline TARGET_AVX2 __m256i broadcastBytes_x4(const uint8_t *in) {
+    uint32_t inputs;
+    memcpy(&inputs, in, sizeof(inputs));
+
+    // 'shuffle_epi8' can't cross 128-bit lanes, so each lane gets a copy of every input
+    const __m256i BYTE_IDX = _mm256_setr_epi8(
+        0,0,0,0,0,0,0,0, 1,1,1,1,1,1,1,1, 2,2,2,2,2,2,2,2, 3,3,3,3,3,3,3,3
+    );
+    return _mm256_shuffle_epi8(_mm256_set1_epi32(inputs), BYTE_IDX);
+}
+
+static inline TARGET_AVX2 void toBytes_batch_avx2(const uint8_t *in, uint64_t *out, size_t n, const uint64_t maskOut, const int expandBit) {
+    const __m256i ROW_BIT = _mm256_set1_epi64x(ROW_BIT_MASK), MASK_OUT = _mm256_set1_epi64x(maskOut);
+
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m256i broadcasted = broadcastBytes_x4(in + i);
+        if (expandBit)
+            broadcasted = _mm256_cmpeq_epi8(_mm256_and_si256(broadcasted, ROW_BIT), ROW_BIT);
+        _mm256_storeu_si256((__m256i*)(out + i), _mm256_and_si256(broadcasted, MASK_OUT));
+    }
+
+    toBytes_batch_sse(in + i, out + i, n - i, maskOut, expandBit);
+}
+#endif
+
+
+#ifdef COMPILE_AVX512 // avx512bw & vl
+static inline TARGET_AVX512 __m512i broadcastBytes_x8(const uint8_t *in) {
+    uint64_t inputs;
+    memcpy(&inputs, in, sizeof(inputs));
+
+    const __m512i BYTE_IDX = _mm512_set_epi64(
+        0x0707070707070707ULL, 0x0606060606060606ULL, 0x0505050505050505ULL, 0x0404040404040404ULL,
+        0x0303030303030303ULL, 0x0202020202020202ULL, 0x0101010101010101ULL, 0x0000000000000000ULL
+    );
+    return _mm512_shuffle_epi8(_mm512_set1_epi64(inputs), BYTE_IDX);
+}
+
+// 8 input bytes are already the 64 row bits of 8 boards: as a byte mask, a masked move of 'maskOut' is the expand & mask.
+// That's also the masked broadcast when 'maskOut' only has each row's own bit (\), otherwise it takes the shuffle
+static inline TARGET_AVX512 void toBytes_batch_avx512(const uint8_t *in, uint64_t *out, size_t n, const uint64_t maskOut, const int expandBit) {
+    const __m512i MASK_OUT = _mm512_set1_epi64(maskOut);
+    const int rowBitsOnly = expandBit || (maskOut & ~ROW_BIT_MASK) == 0;
+
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m512i result;
+        if (rowBitsOnly) {
+            uint64_t rowBits;
+            memcpy(&rowBits, in + i, sizeof(rowBits));
+            result = _mm512_maskz_mov_epi8(_cvtu64_mask64(rowBits), MASK_OUT);
+        } else {
+            result = _mm512_and_si512(broadcastBytes_x8(in + i), MASK_OUT);
+        }
+        _mm512_storeu_si512(out + i, result);
+    }
+
+    toBytes_batch_sse(in + i, out + i, n - i, maskOut, expandBit);
+}
+
+
+// Single board: the input byte is the mask of the 8 rows
+static inline TARGET_AVX512 uint64_t toBytes_avx512(const uint8_t input, const uint64_t maskOut) {
+    return (uint64_t)_mm_cvtsi128_si64(_mm_maskz_mov_epi8((__mmask16)input, _mm_cvtsi64_si128((long long)maskOut)));
+}
+
+// Clockwise (- -> \)
+static inline TARGET_AVX512 uint64_t toDiag_back_avx512(const uint8_t input) {
+    if (DIAG_IS_CONSTANT(input)) return toDiag_back_mul(input);
+    return toBytes_avx512(input, 0x8040201008040201ULL);
+}
+
+// Anti-clockwise (- -> /)
+static inline TARGET_AVX512 uint64_t toDiag_fwd_avx512(const uint8_t input) {
+    if (DIAG_IS_CONSTANT(input)) return toDiag_fwd_mul(input);
+    return toBytes_avx512(input, 0x0102040810204080ULL);
+}
+
+// Anti-clockwise (- -> |)
+static inline TARGET_AVX512 uint64_t toVertical_avx512(const uint8_t input) {
+    if (DIAG_IS_CONSTANT(input)) return toVertical_mul(input);
+    return toBytes_avx512(input, 0x0101010101010101ULL);
+}
+#endif
+#endif
+
+
+// ==================
+//       GFNI
+// ==================
+// With 'x = GF2P8_SELECT_COLUMN', output byte 'j' gathers bit 'j' of every row of the matrix:
+//  - Input in the top row only: bit 'j' lands in the LSB of byte 'j' (vertical, nothing to mask)
+//  - Input in every row: bit 'j' is expanded to all of byte 'j', then masked like 'cmpeq' does
+#ifdef COMPILE_GFNI
+// Anti-clockwise (- -> /)
+static inline TARGET_GFNI uint64_t toDiag_fwd_gfni(const uint8_t input) {
+    if (DIAG_IS_CONSTANT(input)) return toDiag_fwd_mul(input);
+
+    __m128i broadcasted = _mm_cvtsi64_si128((long long)(input * 0x0101010101010101ULL));
+    __m128i expanded = _mm_gf2p8affine_epi64_epi8(_mm_cvtsi64_si128(GF2P8_SELECT_COLUMN), broadcasted, 0);
+    return _mm_cvtsi128_si64(_mm_and_si128(expanded, _mm_cvtsi64_si128(0x0102040810204080ULL)));
+}
+
+// Anti-clockwise (- -> |)
+static inline TARGET_GFNI uint64_t toVertical_gfni(const uint8_t input) {
+    if (DIAG_IS_CONSTANT(input)) return toVertical_mul(input);
+
+    __m128i inTopRow = _mm_cvtsi64_si128((long long)((uint64_t)input << 56));
+    return _mm_cvtsi128_si64(_mm_gf2p8affine_epi64_epi8(_mm_cvtsi64_si128(GF2P8_SELECT_COLUMN), inTopRow, 0));
+}
+
+
+static inline TARGET_GFNI void toBytes_batch_gfni(const uint8_t *in, uint64_t *out, size_t n, const uint64_t maskOut, const int expandBit) {
+    const __m128i SELECT_COLUMN = _mm_set1_epi64x(GF2P8_SELECT_COLUMN), MASK_OUT = _mm_set1_epi64x(maskOut);
+
+    size_t i = 0;
+    for (; i + 2 <= n; i += 2) {
+        __m128i broadcasted = broadcastBytes_x2(in + i);
+        if (expandBit)
+            broadcasted = _mm_gf2p8affine_epi64_epi8(SELECT_COLUMN, broadcasted, 0);
+        _mm_storeu_si128((__m128i*)(out + i), _mm_and_si128(broadcasted, MASK_OUT));
+    }
+
+    toBytes_batch_sse(in + i, out + i, n - i, maskOut, expandBit);
+}
+#endif
+
+#if defined(COMPILE_GFNI) && defined(COMPILE_AVX2)
+static inline TARGET_GFNI_AVX2 void toBytes_batch_gfni_avx2(const uint8_t *in, uint64_t *out, size_t n, const uint64_t maskOut, const int expandBit) {
+    const __m256i SELECT_COLUMN = _mm256_set1_epi64x(GF2P8_SELECT_COLUMN), MASK_OUT = _mm256_set1_epi64x(maskOut);
+
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m256i broadcasted = broadcastBytes_x4(in + i);
+        if (expandBit)
+            broadcasted = _mm256_gf2p8affine_epi64_epi8(SELECT_COLUMN, broadcasted, 0);
+        _mm256_storeu_si256((__m256i*)(out + i), _mm256_and_si256(broadcasted, MASK_OUT));
+    }
+
+    toBytes_batch_sse(in + i, out + i, n - i, maskOut, expandBit);
+}
+#endif
+
+#if defined(COMPILE_GFNI) && defined(COMPILE_AVX512)
+static inline TARGET_GFNI_AVX512 void toBytes_batch_gfni_avx512(const uint8_t *in, uint64_t *out, size_t n, const uint64_t maskOut, const int expandBit) {
+    const __m512i SELECT_COLUMN = _mm512_set1_epi64(GF2P8_SELECT_COLUMN), MASK_OUT = _mm512_set1_epi64(maskOut);
+
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m512i broadcasted = broadcastBytes_x8(in + i);
+        if (expandBit)
+            broadcasted = _mm512_gf2p8affine_epi64_epi8(SELECT_COLUMN, broadcasted, 0);
+        _mm512_storeu_si512(out + i, _mm512_and_si512(broadcasted, MASK_OUT));
+    }
+
+    toBytes_batch_sse(in + i, out + i, n - i, maskOut, expandBit);
+}
+#endif
+
+
+// ==================
+//  Vector extensions
+// ==================
+// Same as the batched versions: every lane is its input byte broadcast, and (/) & vertical expand the row's bit with a compare
+#ifdef COMPILE_VECTOR
+DIAG_INLINE diagVec_u64 toBytes_vec(diagVec_u64 broadcasted, const uint64_t maskOut, const int expandBit) {
+    if (expandBit)
+        broadcasted = (diagVec_u64)((diagVec_u8)(broadcasted & ROW_BIT_MASK) != 0);
+    return broadcasted & maskOut;
+}
+
+// Clockwise (- -> \)
+DIAG_INLINE uint64_t toDiag_back_vec(const uint8_t input) {
+    return toBytes_vec((diagVec_u64)((diagVec_u8){0} + input), 0x8040201008040201ULL, 0)[0];
+}
+
+// Anti-clockwise (- -> /)
+DIAG_INLINE uint64_t toDiag_fwd_vec(const uint8_t input) {
+    return toBytes_vec((diagVec_u64)((diagVec_u8){0} + input), 0x0102040810204080ULL, 1)[0];
+}
+
+// Anti-clockwise (- -> |)
+DIAG_INLINE uint64_t toVertical_vec(const uint8_t input) {
+    return toBytes_vec((diagVec_u64)((diagVec_u8){0} + input), 0x0101010101010101ULL, 1)[0];
+}
+
+// The input bytes go to the bottom of their lanes, then are copied up to the whole lane
+static inline void toBytes_batch_vec(const uint8_t *in, uint64_t *out, size_t n, const uint64_t maskOut, const int expandBit) {
+    size_t i = 0;
+    for (; i + DIAG_VECTOR_BOARDS <= n; i += DIAG_VECTOR_BOARDS) {
+        diagVec_bytes bytes;
+        memcpy(&bytes, in + i, sizeof(bytes));
+        diagVec_u64 broadcasted = __builtin_convertvector(bytes, diagVec_u64);
+        broadcasted |= broadcasted << 8;
+        broadcasted |= broadcasted << 16;
+        broadcasted |= broadcasted << 32;
+
+        broadcasted = toBytes_vec(broadcasted, maskOut, expandBit);
+        memcpy(out + i, &broadcasted, sizeof(broadcasted));
+    }
+
+    for (; i < n; i++)
+        out[i] = toBytes_vec((diagVec_u64)((diagVec_u8){0} + in[i]), maskOut, expandBit)[0];
+}
+
+static inline void toDiag_back_batch_vec(const uint8_t *in, uint64_t *out, size_t n) {
+    toBytes_batch_vec(in, out, n, 0x8040201008040201ULL, 0);
+}
+
+static inline void toDiag_fwd_batch_vec(const uint8_t *in, uint64_t *out, size_t n) {
+    toBytes_batch_vec(in, out, n, 0x0102040810204080ULL, 1);
+}
+
+static inline void toVertical_batch_vec(const uint8_t *in, uint64_t *out, size_t n) {
+    toBytes_batch_vec(in, out, n, 0x0101010101010101ULL, 1);
+}
+#endif
+
+
+#ifdef DIAG_PORTABLE
+    #define toBytes_batch toBytes_batch_vec
+#elif defined(CPU_HAS_AVX512)
+    #define toBytes_batch toBytes_batch_avx512
+#elif defined(CPU_HAS_GFNI) && defined(CPU_HAS_AVX2)
+    #define toBytes_batch toBytes_batch_gfni_avx2
+#elif defined(CPU_HAS_AVX2)
+    #define toBytes_batch toBytes_batch_avx2
+#else
+    #define toBytes_batch toBytes_batch_sse
+#endif
+
+// Clockwise (- -> \)
+static inline void toDiag_back_batch(const uint8_t *in, uint64_t *out, size_t n) {
+    toBytes_batch(in, out, n, 0x8040201008040201ULL, 0);
+}
+
+// Anti-clockwise (- -> /)
+static inline void toDiag_fwd_batch(const uint8_t *in, uint64_t *out, size_t n) {
+    toBytes_batch(in, out, n, 0x0102040810204080ULL, 1);
+}
+
+// Anti-clockwise (- -> |)
+static inline void toVertical_batch(const uint8_t *in, uint64_t *out, size_t n) {
+    toBytes_batch(in, out, n, 0x0101010101010101ULL, 1);
+}
+
 #endif
\ No newline at end of file
@@ -0,0 +1,159 @@
+#ifndef PERF_COUNTERS_H
+#define PERF_COUNTERS_H
+
+#include <stdint.h>
+#include <string.h>     // memset
+#include <errno.h>
+
+// Hardware performance counters around a measurement, from Linux' 'perf_event_open' (user space only).
+// Every counter is opened on its own into one group, so a missing one (uops on an unknown CPU, L1 misses in some VMs)
+// doesn't lose the others, and the rest are still counted over exactly the same instructions.
+// Containers, most VMs & 'perf_event_paranoid' > 2 refuse all of them: 'perfCounters_open' then returns 0 and
+// 'perfCounters_stop' reports nothing, so the caller only has its own timer.
+
+#if defined(__linux__)
+    #include <unistd.h>             // read, close, syscall
+    #include <sys/ioctl.h>
+    #include <sys/syscall.h>        // SYS_perf_event_open
+    #include <linux/perf_event.h>
+    #define PERF_COUNTERS_SUPPORTED
+#endif
+
+#if defined(__x86_64__) || defined(__i386__)
+    #include <cpuid.h>              // Vendor & family, for the uops event
+#endif
+
+
+enum PerfCounter {PERF_CYCLES, PERF_INSTRUCTIONS, PERF_UOPS, PERF_BRANCH_MISSES, PERF_L1D_MISSES, PERF_COUNTER_COUNT};
+static const char *const PERF_COUNTER_NAMES[PERF_COUNTER_COUNT] = {"cycles", "instructions", "uops", "branch-misses", "L1d-misses"};
+
+typedef struct {
+    int fd[PERF_COUNTER_COUNT];     // -1 when unavailable
+    int leader;                     // First counter that opened, -1 if none did
+    int error;                      // errno of the first refusal
+} PerfCounters;
+
+
+// There's no generic uops event: retired uops (fused) are a raw, model specific one.
+// Intel: UOPS_RETIRED.RETIRE_SLOTS/SLOTS (0xC2, umask 2) from Haswell to Sapphire Rapids. AMD Zen: retired ops (0xC1).
+// Returns 0 for the other CPUs
+static uint64_t perfCounters_uopsEvent(void) {
+#if defined(__x86_64__) || defined(__i386__)
+    unsigned int maxLeaf, vendor[3], signature, unused;
+    if (!__get_cpuid(0, &maxLeaf, &vendor[0], &vendor[2], &vendor[1]) || maxLeaf < 1)
+        return 0;
+    if (!__get_cpuid(1, &signature, &unused, &unused, &unused))
+        return 0;
+
+    unsigned int family = (signature >> 8) & 0xF;
+    if (family == 0xF)
+        family += (signature >> 20) & 0xFF;
+
+    // "GenuineIntel" & "AuthenticAMD" (ebx only)
+    if (vendor[0] == 0x756E6547 && family == 6)
+        return 0x02C2;
+    if (vendor[0] == 0x68747541 && family >= 0x17)
+        return 0xC1;
+#endif
+    return 0;
+}
+
+#ifdef PERF_COUNTERS_SUPPORTED
+static int perfCounters_openEvent(const uint32_t type, const uint64_t config, const int groupFd) {
+    struct perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = type;
+    attr.config = config;
+    attr.disabled = groupFd == -1;  // The others follow their leader
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+    return (int)syscall(SYS_perf_event_open, &attr, 0, -1, groupFd, 0);
+}
+#endif
+
+// Counts the calling thread. Returns how many of the counters are available
+static int perfCounters_open(PerfCounters *counters) {
+    int opened = 0;
+    counters->leader = -1;
+    counters->error = 0;
+    for (int c=0; c < PERF_COUNTER_COUNT; c++)
+        counters->fd[c] = -1;
+
+#ifdef PERF_COUNTERS_SUPPORTED
+    const uint64_t uops = perfCounters_uopsEvent();
+    const struct {uint32_t type; uint64_t config;} events[PERF_COUNTER_COUNT] = {
+        {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES},
+        {PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS},
+        {PERF_TYPE_RAW, uops},
+        {PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES},
+        {PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_L1D | PERF_COUNT_HW_CACHE_OP_READ << 8 | PERF_COUNT_HW_CACHE_RESULT_MISS << 16},
+    };
+
+    for (int c=0; c < PERF_COUNTER_COUNT; c++) {
+        if (c == PERF_UOPS && !uops) continue;
+
+        const int fd = perfCounters_openEvent(events[c].type, events[c].config, counters->leader);
+        if (fd < 0) {
+            if (!counters->error) counters->error = errno;
+            continue;
+        }
+        counters->fd[c] = fd;
+        if (counters->leader == -1)
+            counters->leader = fd;
+        opened++;
+    }
+#else
+    counters->error = ENOSYS;
+#endif
+    return opened;
+}
+
+static void perfCounters_close(PerfCounters *counters) {
+#ifdef PERF_COUNTERS_SUPPORTED
+    for (int c=0; c < PERF_COUNTER_COUNT; c++)
+        if (counters->fd[c] >= 0) close(counters->fd[c]);
+#endif
+    for (int c=0; c < PERF_COUNTER_COUNT; c++)
+        counters->fd[c] = -1;
+    counters->leader = -1;
+}
+
+static inline void perfCounters_start(const PerfCounters *counters) {
+#ifdef PERF_COUNTERS_SUPPORTED
+    if (counters->leader < 0) return;
+    ioctl(counters->leader, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+    ioctl(counters->leader, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+#else
+    (void)counters;
+#endif
+}
+
+// Writes the count of every available counter since 'perfCounters_start' into 'values'.
+// Returns a mask of those that were counted ('1 << PERF_CYCLES', ...): not the unavailable ones, nor a group the
+// kernel couldn't schedule. A group that only ran part of the time (sharing the counters with another process) is scaled up
+static inline unsigned perfCounters_stop(const PerfCounters *counters, uint64_t values[PERF_COUNTER_COUNT]) {
+    unsigned counted = 0;
+    memset(values, 0, PERF_COUNTER_COUNT * sizeof(uint64_t));
+
+#ifdef PERF_COUNTERS_SUPPORTED
+    if (counters->leader < 0) return 0;
+    ioctl(counters->leader, PERF_EVENT_IOC_DISABLE, PERF_IOC_FLAG_GROUP);
+
+    for (int c=0; c < PERF_COUNTER_COUNT; c++) {
+        uint64_t raw[3]; // Value, time enabled, time running
+        if (counters->fd[c] < 0 || read(counters->fd[c], raw, sizeof(raw)) != sizeof(raw) || raw[2] == 0)
+            continue;
+
+        values[c] = (raw[2] < raw[1])? (uint64_t)((double)raw[0] * raw[1] / raw[2]) : raw[0];
+        counted |= 1u << c;
+    }
+#else
+    (void)counters;
+#endif
+    return counted;
+}
+
+#endif
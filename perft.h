@@ -0,0 +1,288 @@
+#ifndef PERFT_H
+#define PERFT_H
+
+#include <stdint.h>
+#include <string.h>     // memset, strchr
+
+#include "cpuFeatures.h"
+#include "tableGen.h"
+
+// Minimal legal move generator & perft (every leaf node counted to a fixed depth), to measure the attack methods
+// as part of a search: between the move generation, the copy of the position & the check tests, instead of in a tight loop.
+// Squares are 'row * 8 + column' like the rest of the library, row 0 is white's first rank.
+//
+// The sliders are parameters: 'PERFT(name, bishopAttacks, rookAttacks, target)' defines 'perft_##name' with them.
+// The generator is inlined into it, so the attack functions are called directly (and inlined) instead of through a pointer.
+// Pseudo-legal moves are made on a copy of the position, then dropped when they leave the king attacked.
+
+enum PerftColor {PERFT_WHITE, PERFT_BLACK};
+enum PerftPieceType {PERFT_PAWN, PERFT_KNIGHT, PERFT_BISHOP, PERFT_ROOK, PERFT_QUEEN, PERFT_KING};
+enum {PERFT_NO_PIECE = 12, PERFT_NO_SQUARE = 64, PERFT_MAX_MOVES = 256};
+
+// Castling rights
+enum {PERFT_WHITE_OO = 1, PERFT_WHITE_OOO = 2, PERFT_BLACK_OO = 4, PERFT_BLACK_OOO = 8};
+
+// 'from | to << 6 | kind << 12', the promotions are 'PERFT_PROMOTION + type - PERFT_KNIGHT'
+enum {PERFT_NORMAL, PERFT_DOUBLE_PUSH, PERFT_CASTLE, PERFT_EN_PASSANT, PERFT_PROMOTION};
+typedef uint16_t PerftMove;
+
+typedef struct {
+    uint64_t pieces[12];    // 'color * 6 + type'
+    uint64_t colors[2], occupied;
+    uint8_t mailbox[64];    // Piece on each square, or PERFT_NO_PIECE
+    uint8_t side, castling, enPassant;
+} PerftPosition;
+
+typedef uint64_t (*PerftSlider)(unsigned square, uint64_t occupied);
+
+#define PERFT_FILE_A    0x0101010101010101ULL
+#define PERFT_FILE_H    0x8080808080808080ULL
+
+
+// ==================
+//       Tables
+// ==================
+// The square 'dRow' rows & 'dColumn' columns away, if it is on the board
+#define PERFT_STEP(square, dRow, dColumn) \
+    (((unsigned)(((square) >> 3) + (dRow)) < 8 && (unsigned)(((square) & 7) + (dColumn)) < 8) \
+        ? 1ULL << (((square) + 8*(dRow) + (dColumn)) & 63) : 0)
+
+#define KNIGHT_ATTACKS(square, unused) \
+    (PERFT_STEP(square, 1, 2) | PERFT_STEP(square, 2, 1) | PERFT_STEP(square, 2, -1) | PERFT_STEP(square, 1, -2) | \
+     PERFT_STEP(square, -1, -2) | PERFT_STEP(square, -2, -1) | PERFT_STEP(square, -2, 1) | PERFT_STEP(square, -1, 2))
+
+#define KING_ATTACKS(square, unused) \
+    (PERFT_STEP(square, 1, -1) | PERFT_STEP(square, 1, 0) | PERFT_STEP(square, 1, 1) | PERFT_STEP(square, 0, 1) | \
+     PERFT_STEP(square, -1, 1) | PERFT_STEP(square, -1, 0) | PERFT_STEP(square, -1, -1) | PERFT_STEP(square, 0, -1))
+
+// Castling rights kept after a move from or to the square (the kings' & rooks' starting squares)
+#define CASTLING_KEPT(square, unused) \
+    (15 & ~(((square) == 4) * (PERFT_WHITE_OO | PERFT_WHITE_OOO) | ((square) == 7) * PERFT_WHITE_OO | ((square) == 0) * PERFT_WHITE_OOO | \
+            ((square) == 60) * (PERFT_BLACK_OO | PERFT_BLACK_OOO) | ((square) == 63) * PERFT_BLACK_OO | ((square) == 56) * PERFT_BLACK_OOO))
+
+static const uint64_t knightAttacks[64] = { TABLE_64(KNIGHT_ATTACKS, 0) };
+static const uint64_t kingAttacks[64] = { TABLE_64(KING_ATTACKS, 0) };
+static const uint8_t castlingKept[64] = { TABLE_64(CASTLING_KEPT, 0) };
+
+
+// ==================
+//      Position
+// ==================
+// Squares attacked by the 'color' pawns
+DIAG_INLINE uint64_t perft_pawnAttacks(const uint64_t pawns, const int color) {
+    return (color == PERFT_WHITE)
+        ? ((pawns << 7) & ~PERFT_FILE_H) | ((pawns << 9) & ~PERFT_FILE_A)
+        : ((pawns >> 9) & ~PERFT_FILE_H) | ((pawns >> 7) & ~PERFT_FILE_A);
+}
+
+DIAG_INLINE void perft_put(PerftPosition *position, const unsigned square, const unsigned piece) {
+    position->pieces[piece] |= 1ULL << square;
+    position->colors[piece / 6] |= 1ULL << square;
+    position->mailbox[square] = piece;
+}
+
+DIAG_INLINE void perft_remove(PerftPosition *position, const unsigned square) {
+    const unsigned piece = position->mailbox[square];
+    position->pieces[piece] &= ~(1ULL << square);
+    position->colors[piece / 6] &= ~(1ULL << square);
+    position->mailbox[square] = PERFT_NO_PIECE;
+}
+
+// Pieces, side to move, castling & en passant of a FEN (the move counters are ignored). Returns 0 if it can't be read
+static inline int perft_fromFEN(PerftPosition *position, const char *fen) {
+    static const char PIECES[] = "PNBRQKpnbrqk";
+    memset(position, 0, sizeof(*position));
+    memset(position->mailbox, PERFT_NO_PIECE, sizeof(position->mailbox));
+
+    int row = 7, column = 0;
+    for (; *fen && *fen != ' '; fen++) {
+        const char *piece = strchr(PIECES, *fen);
+        if (*fen == '/') { row--; column = 0; }
+        else if (*fen >= '1' && *fen <= '8') column += *fen - '0';
+        else if (piece && *piece && row >= 0 && column < 8) perft_put(position, row*8 + column++, piece - PIECES);
+        else return 0;
+    }
+    if (*fen++ != ' ' || (*fen != 'w' && *fen != 'b')) return 0;
+    position->side = (*fen++ == 'b');
+
+    for (fen += (*fen == ' '); *fen && *fen != ' '; fen++) {
+        const char *right = strchr("KQkq", *fen);
+        if (right && *right) position->castling |= 1 << (right - "KQkq");
+    }
+
+    position->enPassant = PERFT_NO_SQUARE;
+    fen += (*fen == ' ');
+    if (fen[0] >= 'a' && fen[0] <= 'h' && fen[1] >= '1' && fen[1] <= '8')
+        position->enPassant = (fen[1] - '1') * 8 + (fen[0] - 'a');
+
+    position->occupied = position->colors[PERFT_WHITE] | position->colors[PERFT_BLACK];
+    return 1;
+}
+
+// The position after the move, on a copy
+DIAG_INLINE void perft_makeMove(const PerftPosition *position, PerftPosition *next, const PerftMove move) {
+    const unsigned from = move & 63, to = (move >> 6) & 63, kind = move >> 12;
+    const unsigned us = position->side;
+    *next = *position;
+
+    const unsigned piece = next->mailbox[from];
+    perft_remove(next, from);
+    if (next->mailbox[to] != PERFT_NO_PIECE) perft_remove(next, to);
+    perft_put(next, to, (kind >= PERFT_PROMOTION)? us*6 + PERFT_KNIGHT + kind - PERFT_PROMOTION : piece);
+
+    // The captured pawn is a row behind, 'to ^ 8' for both sides (rows 5 -> 4 & 2 -> 3).
+    // The rook of a castle moves from the corner to the other side of the king
+    if (kind == PERFT_EN_PASSANT) perft_remove(next, to ^ 8);
+    if (kind == PERFT_CASTLE) {
+        const unsigned rookFrom = (to > from)? to + 1 : to - 2, rookTo = (to > from)? to - 1 : to + 1;
+        perft_remove(next, rookFrom);
+        perft_put(next, rookTo, us*6 + PERFT_ROOK);
+    }
+
+    next->castling &= castlingKept[from] & castlingKept[to];
+    next->enPassant = (kind == PERFT_DOUBLE_PUSH)? (from + to) / 2 : PERFT_NO_SQUARE;
+    next->side = us ^ 1;
+    next->occupied = next->colors[PERFT_WHITE] | next->colors[PERFT_BLACK];
+}
+
+
+// ==================
+//   Move generation
+// ==================
+DIAG_INLINE int perft_isAttacked(const PerftPosition *position, const unsigned square, const unsigned by,
+                                 const PerftSlider bishopAttacks, const PerftSlider rookAttacks) {
+    const uint64_t *pieces = &position->pieces[by * 6];
+    const uint64_t diagonalSliders = pieces[PERFT_BISHOP] | pieces[PERFT_QUEEN];
+    const uint64_t lineSliders = pieces[PERFT_ROOK] | pieces[PERFT_QUEEN];
+
+    return (perft_pawnAttacks(1ULL << square, by ^ 1) & pieces[PERFT_PAWN])
+        || (knightAttacks[square] & pieces[PERFT_KNIGHT])
+        || (kingAttacks[square] & pieces[PERFT_KING])
+        || (diagonalSliders && (bishopAttacks(square, position->occupied) & diagonalSliders))
+        || (lineSliders && (rookAttacks(square, position->occupied) & lineSliders));
+}
+
+// A move to each square of 'targets', from 'to - offset'
+DIAG_INLINE PerftMove *perft_addPawnMoves(PerftMove *moves, uint64_t targets, const int offset, const unsigned kind) {
+    for (; targets; targets &= targets - 1) {
+        const unsigned to = __builtin_ctzll(targets);
+        *moves++ = (to - offset) | to << 6 | kind << 12;
+    }
+    return moves;
+}
+
+DIAG_INLINE PerftMove *perft_addPromotions(PerftMove *moves, uint64_t targets, const int offset) {
+    for (; targets; targets &= targets - 1) {
+        const unsigned to = __builtin_ctzll(targets);
+        for (unsigned type=PERFT_KNIGHT; type <= PERFT_QUEEN; type++)
+            *moves++ = (to - offset) | to << 6 | (PERFT_PROMOTION + type - PERFT_KNIGHT) << 12;
+    }
+    return moves;
+}
+
+DIAG_INLINE PerftMove *perft_addMoves(PerftMove *moves, const unsigned from, uint64_t targets) {
+    for (; targets; targets &= targets - 1)
+        *moves++ = from | __builtin_ctzll(targets) << 6;
+    return moves;
+}
+
+// Pseudo-legal moves (castling through an attacked square is already left out), returns the count
+DIAG_INLINE int perft_generate(const PerftPosition *position, PerftMove *moves,
+                               const PerftSlider bishopAttacks, const PerftSlider rookAttacks) {
+    const unsigned us = position->side, them = us ^ 1;
+    const uint64_t *pieces = &position->pieces[us * 6];
+    const uint64_t empty = ~position->occupied, enemies = position->colors[them], targets = ~position->colors[us];
+    PerftMove *const first = moves;
+
+    // Pawns: pushes & captures as shifts of every pawn at once, the last row promotes
+    const uint64_t pawns = pieces[PERFT_PAWN];
+    const uint64_t lastRow = (us == PERFT_WHITE)? 0xFF00000000000000ULL : 0xFFULL;
+    const uint64_t thirdRow = (us == PERFT_WHITE)? 0xFF0000ULL : 0xFF0000000000ULL;
+    const int forward = (us == PERFT_WHITE)? 8 : -8;
+    const int left = forward - 1, right = forward + 1;
+
+    const uint64_t pushes = ((us == PERFT_WHITE)? pawns << 8 : pawns >> 8) & empty;
+    const uint64_t doublePushes = ((us == PERFT_WHITE)? (pushes & thirdRow) << 8 : (pushes & thirdRow) >> 8) & empty;
+    const uint64_t leftCaptures = ((us == PERFT_WHITE)? pawns << 7 : pawns >> 9) & ~PERFT_FILE_H & enemies;
+    const uint64_t rightCaptures = ((us == PERFT_WHITE)? pawns << 9 : pawns >> 7) & ~PERFT_FILE_A & enemies;
+
+    moves = perft_addPawnMoves(moves, pushes & ~lastRow, forward, PERFT_NORMAL);
+    moves = perft_addPawnMoves(moves, doublePushes, 2*forward, PERFT_DOUBLE_PUSH);
+    moves = perft_addPawnMoves(moves, leftCaptures & ~lastRow, left, PERFT_NORMAL);
+    moves = perft_addPawnMoves(moves, rightCaptures & ~lastRow, right, PERFT_NORMAL);
+    moves = perft_addPromotions(moves, pushes & lastRow, forward);
+    moves = perft_addPromotions(moves, leftCaptures & lastRow, left);
+    moves = perft_addPromotions(moves, rightCaptures & lastRow, right);
+
+    // The pawns that could capture on the en passant square are the ones an enemy pawn there would attack
+    if (position->enPassant != PERFT_NO_SQUARE) {
+        const unsigned to = position->enPassant;
+        for (uint64_t from = perft_pawnAttacks(1ULL << to, them) & pawns; from; from &= from - 1)
+            *moves++ = __builtin_ctzll(from) | to << 6 | PERFT_EN_PASSANT << 12;
+    }
+
+    for (uint64_t knights = pieces[PERFT_KNIGHT]; knights; knights &= knights - 1) {
+        const unsigned from = __builtin_ctzll(knights);
+        moves = perft_addMoves(moves, from, knightAttacks[from] & targets);
+    }
+    for (uint64_t sliders = pieces[PERFT_BISHOP] | pieces[PERFT_QUEEN]; sliders; sliders &= sliders - 1) {
+        const unsigned from = __builtin_ctzll(sliders);
+        moves = perft_addMoves(moves, from, bishopAttacks(from, position->occupied) & targets);
+    }
+    for (uint64_t sliders = pieces[PERFT_ROOK] | pieces[PERFT_QUEEN]; sliders; sliders &= sliders - 1) {
+        const unsigned from = __builtin_ctzll(sliders);
+        moves = perft_addMoves(moves, from, rookAttacks(from, position->occupied) & targets);
+    }
+
+    const unsigned king = __builtin_ctzll(pieces[PERFT_KING]);
+    moves = perft_addMoves(moves, king, kingAttacks[king] & targets);
+
+    // The squares between the king & the rook are empty, the king isn't in check and doesn't cross an attacked square
+    // (where it lands is tested as any other move)
+    const unsigned rights = position->castling >> 2*us, home = 56 * us;
+    if ((rights & PERFT_WHITE_OO) && !(position->occupied & (0x60ULL << home))
+        && !perft_isAttacked(position, home + 4, them, bishopAttacks, rookAttacks)
+        && !perft_isAttacked(position, home + 5, them, bishopAttacks, rookAttacks))
+        *moves++ = (home + 4) | (home + 6) << 6 | PERFT_CASTLE << 12;
+    if ((rights & PERFT_WHITE_OOO) && !(position->occupied & (0x0EULL << home))
+        && !perft_isAttacked(position, home + 4, them, bishopAttacks, rookAttacks)
+        && !perft_isAttacked(position, home + 3, them, bishopAttacks, rookAttacks))
+        *moves++ = (home + 4) | (home + 2) << 6 | PERFT_CASTLE << 12;
+
+    return moves - first;
+}
+
+// Leaf nodes under 'position', 'perft' is the function itself (for the recursion)
+DIAG_INLINE uint64_t perft_count(const PerftPosition *position, const int depth, uint64_t (*perft)(const PerftPosition*, int),
+                                 const PerftSlider bishopAttacks, const PerftSlider rookAttacks) {
+    if (depth <= 0) return 1;
+
+    PerftMove moves[PERFT_MAX_MOVES];
+    const int count = perft_generate(position, moves, bishopAttacks, rookAttacks);
+    uint64_t nodes = 0;
+
+    for (int i=0; i < count; i++) {
+        PerftPosition next;
+        perft_makeMove(position, &next, moves[i]);
+
+        const unsigned king = __builtin_ctzll(next.pieces[position->side * 6 + PERFT_KING]);
+        if (perft_isAttacked(&next, king, next.side, bishopAttacks, rookAttacks)) continue;
+        nodes += (depth == 1)? 1 : perft(&next, depth - 1);
+    }
+    return nodes;
+}
+
+// The TARGET methods are only 'static inline' (e.g. 'bishopAttacks_pext'), and the move generation is too big for them
+// to be inlined on their own: 'flatten' inlines every call but the recursion, so no method pays for a call the others don't
+#if defined(__GNUC__) || defined(__clang__)
+    #define PERFT_FLATTEN __attribute__((flatten))
+#else
+    #define PERFT_FLATTEN
+#endif
+
+#define PERFT(name, bishopAttacks, rookAttacks, target) \
+    target PERFT_FLATTEN uint64_t perft_##name(const PerftPosition *position, const int depth) { \
+        return perft_count(position, depth, perft_##name, bishopAttacks, rookAttacks); \
+    }
+
+#endif
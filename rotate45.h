@@ -0,0 +1,314 @@
+#ifndef ROTATE45_H
+#define ROTATE45_H
+
+#include <stdint.h>
+#include <stddef.h>     // size_t
+#include <string.h>     // memcpy
+
+#include "cpuFeatures.h"
+#ifdef DIAG_X86
+#include <immintrin.h>  // SSE2, AVX2, AVX512f/vl
+#endif
+
+// Pseudo-rotations by 45 degrees (https://www.chessprogramming.org/Flipping_Mirroring_and_Rotating#Pseudo-Rotation_by_45_degrees):
+// column 'c' is rotated down (clockwise) or up (anti-clockwise) by 'c' rows, wrapping around the board.
+// Square (r, c) of the clockwise board is square ((r + c) & 7, c) of the board, of the anti-clockwise one ((r - c) & 7, c).
+//
+// Every (\) diagonal is then in a single row of the clockwise board, every (/) one in a row of the anti-clockwise board,
+// in the same columns as on the board: one shift & mask reads it ('rotated45_back' & 'rotated45_fwd').
+// The rest of that row is the diagonal 8 columns away, wrapped around.
+//
+// Each rotation moves the columns back where the other one moved them from, so each is the other's exact inverse.
+// With 3 delta swaps (columns 1, 3, 5, 7 by 1 row, then 2, 3, 6, 7 by 2, then 4 to 7 by 4), every step a 64-bit rotate.
+
+DIAG_INLINE uint64_t rotateRight64(const uint64_t x, const unsigned n) { return (x >> (n & 63)) | (x << (-n & 63)); }
+DIAG_INLINE uint64_t rotateLeft64(const uint64_t x, const unsigned n) { return (x << (n & 63)) | (x >> (-n & 63)); }
+
+DIAG_INLINE uint64_t diagRotate45_clockwise_bin(uint64_t board) {
+    board ^= 0xAAAAAAAAAAAAAAAAULL & (board ^ rotateRight64(board, 8));
+    board ^= 0xCCCCCCCCCCCCCCCCULL & (board ^ rotateRight64(board, 16));
+    board ^= 0xF0F0F0F0F0F0F0F0ULL & (board ^ rotateRight64(board, 32));
+    return board;
+}
+
+DIAG_INLINE uint64_t diagRotate45_antiClock_bin(uint64_t board) {
+    board ^= 0xAAAAAAAAAAAAAAAAULL & (board ^ rotateLeft64(board, 8));
+    board ^= 0xCCCCCCCCCCCCCCCCULL & (board ^ rotateLeft64(board, 16));
+    board ^= 0xF0F0F0F0F0F0F0F0ULL & (board ^ rotateLeft64(board, 32));
+    return board;
+}
+
+
+// ==================
+//  Diagonal access
+// ==================
+// Diagonal 'k' ('column - row' for \, 'column + row - 7' for /, as in 'backDiagonals' & 'fwdDiagonals') is in row
+// '-k & 7' of the clockwise board, row 'k + 7 & 7' of the anti-clockwise one, and in columns 'k' to '7 + k' of it.
+// The bytes read have bit 'c' for column 'c' (the same as 'diagExtract_back', the reverse of 'diagExtract_fwd').
+#define ROTATED45_BACK_ROW(k)   (-(k) & 7)
+#define ROTATED45_FWD_ROW(k)    (((k) + 7) & 7)
+#define ROTATED45_COLUMNS(k)    (((k) >= 0)? (0xFFULL << (k)) & 0xFF : 0xFFULL >> -(k))
+
+#define ROTATED45_BACK_MASK(k)  (ROTATED45_COLUMNS(k) << 8*ROTATED45_BACK_ROW(k))
+#define ROTATED45_FWD_MASK(k)   (ROTATED45_COLUMNS(k) << 8*ROTATED45_FWD_ROW(k))
+
+// The squares of each diagonal in the rotated boards, indexed by 'k + 7'
+static const uint64_t rotated45_backMasks[15] = {
+    ROTATED45_BACK_MASK(-7), ROTATED45_BACK_MASK(-6), ROTATED45_BACK_MASK(-5), ROTATED45_BACK_MASK(-4), ROTATED45_BACK_MASK(-3),
+    ROTATED45_BACK_MASK(-2), ROTATED45_BACK_MASK(-1), ROTATED45_BACK_MASK(0), ROTATED45_BACK_MASK(1), ROTATED45_BACK_MASK(2),
+    ROTATED45_BACK_MASK(3), ROTATED45_BACK_MASK(4), ROTATED45_BACK_MASK(5), ROTATED45_BACK_MASK(6), ROTATED45_BACK_MASK(7)
+};
+static const uint64_t rotated45_fwdMasks[15] = {
+    ROTATED45_FWD_MASK(-7), ROTATED45_FWD_MASK(-6), ROTATED45_FWD_MASK(-5), ROTATED45_FWD_MASK(-4), ROTATED45_FWD_MASK(-3),
+    ROTATED45_FWD_MASK(-2), ROTATED45_FWD_MASK(-1), ROTATED45_FWD_MASK(0), ROTATED45_FWD_MASK(1), ROTATED45_FWD_MASK(2),
+    ROTATED45_FWD_MASK(3), ROTATED45_FWD_MASK(4), ROTATED45_FWD_MASK(5), ROTATED45_FWD_MASK(6), ROTATED45_FWD_MASK(7)
+};
+
+DIAG_INLINE uint8_t rotated45_back(const uint64_t clockwise, const int k) {
+    return (uint8_t)((clockwise & rotated45_backMasks[k + 7]) >> 8*ROTATED45_BACK_ROW(k));
+}
+
+DIAG_INLINE uint8_t rotated45_fwd(const uint64_t antiClock, const int k) {
+    return (uint8_t)((antiClock & rotated45_fwdMasks[k + 7]) >> 8*ROTATED45_FWD_ROW(k));
+}
+
+// Where a square of the board is in the rotated boards, to keep them up to date a square at a time
+DIAG_INLINE unsigned rotated45_clockwiseSquare(const unsigned square) {
+    return (((square >> 3) - square) & 7) << 3 | (square & 7);
+}
+
+DIAG_INLINE unsigned rotated45_antiClockSquare(const unsigned square) {
+    return (((square >> 3) + square) & 7) << 3 | (square & 7);
+}
+
+
+// ==================
+//      AVX-512
+// ==================
+// 'vprorq' rotates in one instruction, and 'vpternlogq' takes the rotated bits for the masked columns: 2 per step
+#ifdef COMPILE_AVX512
+#define ROTATE45_SELECT 0xAC // mask ? rotated : board
+
+static inline TARGET_AVX512 __m128i diagRotate45_avx512_x2(__m128i boards, const int clockwise) {
+    const __m128i k1 = _mm_set1_epi8((char)0xAA), k2 = _mm_set1_epi8((char)0xCC), k4 = _mm_set1_epi8((char)0xF0);
+    boards = _mm_ternarylogic_epi64(k1, boards, clockwise? _mm_ror_epi64(boards, 8) : _mm_rol_epi64(boards, 8), ROTATE45_SELECT);
+    boards = _mm_ternarylogic_epi64(k2, boards, clockwise? _mm_ror_epi64(boards, 16) : _mm_rol_epi64(boards, 16), ROTATE45_SELECT);
+    return _mm_ternarylogic_epi64(k4, boards, _mm_ror_epi64(boards, 32), ROTATE45_SELECT);
+}
+
+static inline TARGET_AVX512 uint64_t diagRotate45_clockwise_avx512(const uint64_t board) {
+    if (DIAG_IS_CONSTANT(board)) return diagRotate45_clockwise_bin(board);
+    return (uint64_t)_mm_cvtsi128_si64(diagRotate45_avx512_x2(_mm_cvtsi64_si128((long long)board), 1));
+}
+
+static inline TARGET_AVX512 uint64_t diagRotate45_antiClock_avx512(const uint64_t board) {
+    if (DIAG_IS_CONSTANT(board)) return diagRotate45_antiClock_bin(board);
+    return (uint64_t)_mm_cvtsi128_si64(diagRotate45_avx512_x2(_mm_cvtsi64_si128((long long)board), 0));
+}
+#endif
+
+
+
+// ==================
+//      Batched
+// ==================
+// Every lane is its own board, the same 3 delta swaps. The row rotates are whole bytes, so they are shuffles:
+// SSE2 shifts for 8 bits & shuffles the 16-bit words for 16, 'pshufb' from AVX2 on, 'vprorq' for AVX-512.
+static inline void diagRotate45_batchFrom(const uint64_t *in, uint64_t *out, size_t i, const size_t n, const int clockwise) {
+    for (; i < n; i++)
+        out[i] = clockwise? diagRotate45_clockwise_bin(in[i]) : diagRotate45_antiClock_bin(in[i]);
+}
+
+static inline void diagRotate45_clockwise_batch_bin(const uint64_t *in, uint64_t *out, size_t n) {
+    diagRotate45_batchFrom(in, out, 0, n, 1);
+}
+
+static inline void diagRotate45_antiClock_batch_bin(const uint64_t *in, uint64_t *out, size_t n) {
+    diagRotate45_batchFrom(in, out, 0, n, 0);
+}
+
+#ifdef DIAG_X86
+// The columns in 'mask' take the bits of 'rotated'
+DIAG_INLINE __m128i diagRotate45_swap_x2(const __m128i boards, const __m128i rotated, const __m128i mask) {
+    return _mm_xor_si128(boards, _mm_and_si128(mask, _mm_xor_si128(boards, rotated)));
+}
+
+DIAG_INLINE __m128i diagRotate45_sse_x2(__m128i boards, const int clockwise) {
+    const __m128i k1 = _mm_set1_epi8((char)0xAA), k2 = _mm_set1_epi8((char)0xCC), k4 = _mm_set1_epi8((char)0xF0);
+
+    const __m128i rotated8 = clockwise? _mm_or_si128(_mm_srli_epi64(boards, 8), _mm_slli_epi64(boards, 56))
+                                      : _mm_or_si128(_mm_slli_epi64(boards, 8), _mm_srli_epi64(boards, 56));
+    boards = diagRotate45_swap_x2(boards, rotated8, k1);
+
+    const __m128i rotated16 = clockwise? _mm_shufflehi_epi16(_mm_shufflelo_epi16(boards, _MM_SHUFFLE(0, 3, 2, 1)), _MM_SHUFFLE(0, 3, 2, 1))
+                                       : _mm_shufflehi_epi16(_mm_shufflelo_epi16(boards, _MM_SHUFFLE(2, 1, 0, 3)), _MM_SHUFFLE(2, 1, 0, 3));
+    boards = diagRotate45_swap_x2(boards, rotated16, k2);
+
+    return diagRotate45_swap_x2(boards, _mm_shuffle_epi32(boards, _MM_SHUFFLE(2, 3, 0, 1)), k4);
+}
+
+// A single board in the low lane, for comparison: the scalar swaps need fewer instructions
+DIAG_INLINE uint64_t diagRotate45_clockwise_sse(const uint64_t board) {
+    if (DIAG_IS_CONSTANT(board)) return diagRotate45_clockwise_bin(board);
+    return (uint64_t)_mm_cvtsi128_si64(diagRotate45_sse_x2(_mm_cvtsi64_si128((long long)board), 1));
+}
+
+DIAG_INLINE uint64_t diagRotate45_antiClock_sse(const uint64_t board) {
+    if (DIAG_IS_CONSTANT(board)) return diagRotate45_antiClock_bin(board);
+    return (uint64_t)_mm_cvtsi128_si64(diagRotate45_sse_x2(_mm_cvtsi64_si128((long long)board), 0));
+}
+
+// 2 boards per iteration, the odd one out in the low lane of its own vector
+static inline void diagRotate45_batch_sse(const uint64_t *in, uint64_t *out, size_t n, const int clockwise) {
+    size_t i = 0;
+    for (; i + 2 <= n; i += 2)
+        _mm_storeu_si128((__m128i*)(out + i), diagRotate45_sse_x2(_mm_loadu_si128((const __m128i*)(in + i)), clockwise));
+
+    for (; i < n; i++)
+        out[i] = (uint64_t)_mm_cvtsi128_si64(diagRotate45_sse_x2(_mm_cvtsi64_si128((long long)in[i]), clockwise));
+}
+
+static inline void diagRotate45_clockwise_batch_sse(const uint64_t *in, uint64_t *out, size_t n) {
+    diagRotate45_batch_sse(in, out, n, 1);
+}
+
+static inline void diagRotate45_antiClock_batch_sse(const uint64_t *in, uint64_t *out, size_t n) {
+    diagRotate45_batch_sse(in, out, n, 0);
+}
+#endif
+
+#ifdef COMPILE_AVX2
+// Byte 'i' of each board from byte 'i + n' (mod 8): the board rotated right by 'n' rows
+#define ROTATE45_ROWS_RIGHT(n) \
+    (0+(n))&7, (1+(n))&7, (2+(n))&7, (3+(n))&7, (4+(n))&7, (5+(n))&7, (6+(n))&7, (7+(n))&7, \
+    8+((0+(n))&7), 8+((1+(n))&7), 8+((2+(n))&7), 8+((3+(n))&7), 8+((4+(n))&7), 8+((5+(n))&7), 8+((6+(n))&7), 8+((7+(n))&7)
+
+static inline TARGET_AVX2 __m256i diagRotate45_swap_x4(const __m256i boards, const __m256i rotated, const __m256i mask) {
+    return _mm256_xor_si256(boards, _mm256_and_si256(mask, _mm256_xor_si256(boards, rotated)));
+}
+
+static inline TARGET_AVX2 __m256i diagRotate45_x4(__m256i boards, const int clockwise) {
+    const __m256i k1 = _mm256_set1_epi8((char)0xAA), k2 = _mm256_set1_epi8((char)0xCC), k4 = _mm256_set1_epi8((char)0xF0);
+    const __m256i rows1 = _mm256_broadcastsi128_si256(clockwise? _mm_setr_epi8(ROTATE45_ROWS_RIGHT(1)) : _mm_setr_epi8(ROTATE45_ROWS_RIGHT(7)));
+    const __m256i rows2 = _mm256_broadcastsi128_si256(clockwise? _mm_setr_epi8(ROTATE45_ROWS_RIGHT(2)) : _mm_setr_epi8(ROTATE45_ROWS_RIGHT(6)));
+
+    boards = diagRotate45_swap_x4(boards, _mm256_shuffle_epi8(boards, rows1), k1);
+    boards = diagRotate45_swap_x4(boards, _mm256_shuffle_epi8(boards, rows2), k2);
+    return diagRotate45_swap_x4(boards, _mm256_shuffle_epi32(boards, _MM_SHUFFLE(2, 3, 0, 1)), k4);
+}
+
+// 4 boards per iteration, the remainder is passed to the SSE version
+static inline TARGET_AVX2 void diagRotate45_batch_avx2(const uint64_t *in, uint64_t *out, size_t n, const int clockwise) {
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4)
+        _mm256_storeu_si256((__m256i*)(out + i), diagRotate45_x4(_mm256_loadu_si256((const __m256i*)(in + i)), clockwise));
+
+    diagRotate45_batch_sse(in + i, out + i, n - i, clockwise);
+}
+
+static inline TARGET_AVX2 void diagRotate45_clockwise_batch_avx2(const uint64_t *in, uint64_t *out, size_t n) {
+    diagRotate45_batch_avx2(in, out, n, 1);
+}
+
+static inline TARGET_AVX2 void diagRotate45_antiClock_batch_avx2(const uint64_t *in, uint64_t *out, size_t n) {
+    diagRotate45_batch_avx2(in, out, n, 0);
+}
+#endif
+
+#ifdef COMPILE_AVX512
+static inline TARGET_AVX512 __m512i diagRotate45_x8(__m512i boards, const int clockwise) {
+    const __m512i k1 = _mm512_set1_epi8((char)0xAA), k2 = _mm512_set1_epi8((char)0xCC), k4 = _mm512_set1_epi8((char)0xF0);
+    boards = _mm512_ternarylogic_epi64(k1, boards, clockwise? _mm512_ror_epi64(boards, 8) : _mm512_rol_epi64(boards, 8), ROTATE45_SELECT);
+    boards = _mm512_ternarylogic_epi64(k2, boards, clockwise? _mm512_ror_epi64(boards, 16) : _mm512_rol_epi64(boards, 16), ROTATE45_SELECT);
+    return _mm512_ternarylogic_epi64(k4, boards, _mm512_ror_epi64(boards, 32), ROTATE45_SELECT);
+}
+
+// 8 boards per iteration, the remainder is passed to the SSE version
+static inline TARGET_AVX512 void diagRotate45_batch_avx512(const uint64_t *in, uint64_t *out, size_t n, const int clockwise) {
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8)
+        _mm512_storeu_si512(out + i, diagRotate45_x8(_mm512_loadu_si512(in + i), clockwise));
+
+    diagRotate45_batch_sse(in + i, out + i, n - i, clockwise);
+}
+
+static inline TARGET_AVX512 void diagRotate45_clockwise_batch_avx512(const uint64_t *in, uint64_t *out, size_t n) {
+    diagRotate45_batch_avx512(in, out, n, 1);
+}
+
+static inline TARGET_AVX512 void diagRotate45_antiClock_batch_avx512(const uint64_t *in, uint64_t *out, size_t n) {
+    diagRotate45_batch_avx512(in, out, n, 0);
+}
+#endif
+
+// The same swaps on GCC/Clang vectors of boards
+#ifdef COMPILE_VECTOR
+DIAG_INLINE diagVec_u64 diagRotate45_vec(diagVec_u64 boards, const int clockwise) {
+    const diagVec_u64 rotated8 = clockwise? (boards >> 8) | (boards << 56) : (boards << 8) | (boards >> 56);
+    boards ^= 0xAAAAAAAAAAAAAAAAULL & (boards ^ rotated8);
+    const diagVec_u64 rotated16 = clockwise? (boards >> 16) | (boards << 48) : (boards << 16) | (boards >> 48);
+    boards ^= 0xCCCCCCCCCCCCCCCCULL & (boards ^ rotated16);
+    boards ^= 0xF0F0F0F0F0F0F0F0ULL & (boards ^ ((boards >> 32) | (boards << 32)));
+    return boards;
+}
+
+static inline void diagRotate45_batch_vec(const uint64_t *in, uint64_t *out, size_t n, const int clockwise) {
+    size_t i = 0;
+    for (; i + DIAG_VECTOR_BOARDS <= n; i += DIAG_VECTOR_BOARDS) {
+        diagVec_u64 boards;
+        memcpy(&boards, in + i, sizeof(boards));
+        boards = diagRotate45_vec(boards, clockwise);
+        memcpy(out + i, &boards, sizeof(boards));
+    }
+    diagRotate45_batchFrom(in, out, i, n, clockwise);
+}
+
+static inline void diagRotate45_clockwise_batch_vec(const uint64_t *in, uint64_t *out, size_t n) {
+    diagRotate45_batch_vec(in, out, n, 1);
+}
+
+static inline void diagRotate45_antiClock_batch_vec(const uint64_t *in, uint64_t *out, size_t n) {
+    diagRotate45_batch_vec(in, out, n, 0);
+}
+#endif
+
+
+// A single board: the scalar swaps, or 'vprorq' & 'vpternlogq' with AVX-512. The batches take the widest known to be
+// supported at compile time. Each rotation is undone by the other, the 'diagUnrotate45_*' names are for readability
+#if defined(CPU_HAS_AVX512) && !defined(DIAG_PORTABLE)
+    #define diagRotate45_clockwise  diagRotate45_clockwise_avx512
+    #define diagRotate45_antiClock  diagRotate45_antiClock_avx512
+#else
+    #define diagRotate45_clockwise  diagRotate45_clockwise_bin
+    #define diagRotate45_antiClock  diagRotate45_antiClock_bin
+#endif
+#define diagUnrotate45_clockwise    diagRotate45_antiClock
+#define diagUnrotate45_antiClock    diagRotate45_clockwise
+
+static inline void diagRotate45_clockwise_batch(const uint64_t *in, uint64_t *out, size_t n) {
+#if defined(DIAG_PORTABLE)
+    diagRotate45_clockwise_batch_vec(in, out, n);
+#elif defined(CPU_HAS_AVX512)
+    diagRotate45_clockwise_batch_avx512(in, out, n);
+#elif defined(CPU_HAS_AVX2)
+    diagRotate45_clockwise_batch_avx2(in, out, n);
+#else
+    diagRotate45_clockwise_batch_sse(in, out, n);
+#endif
+}
+
+static inline void diagRotate45_antiClock_batch(const uint64_t *in, uint64_t *out, size_t n) {
+#if defined(DIAG_PORTABLE)
+    diagRotate45_antiClock_batch_vec(in, out, n);
+#elif defined(CPU_HAS_AVX512)
+    diagRotate45_antiClock_batch_avx512(in, out, n);
+#elif defined(CPU_HAS_AVX2)
+    diagRotate45_antiClock_batch_avx2(in, out, n);
+#else
+    diagRotate45_antiClock_batch_sse(in, out, n);
+#endif
+}
+#define diagUnrotate45_clockwise_batch  diagRotate45_antiClock_batch
+#define diagUnrotate45_antiClock_batch  diagRotate45_clockwise_batch
+
+#endif
@@ -0,0 +1,105 @@
+#ifndef ROTATED_BOARDS_H
+#define ROTATED_BOARDS_H
+
+#include <stdint.h>
+
+#include "tableGen.h"       // TABLE_64
+#include "diagBitboard.h"   // The kernels of the full update
+
+// The occupancy together with its transposed, diagonally shifted & pseudo-rotated (by 45) views, kept up to date by
+// make/unmake move instead of recomputed from the board after every move.
+//
+// Each view only moves (or drops) squares, so it is linear: view(board ^ changed) = view(board) ^ view(changed).
+// A move toggles 2 to 4 squares, so the views' change is the xor of those squares' rows of 'rotatedBoards_squares'
+// (each square as seen in every view), and the whole set is updated by xoring that in. Unmake is the same update.
+// 'rotatedBoards_set' recomputes every view from the board, for a new position or as a check.
+
+enum RotatedView {
+    ROTATED_BOARD,
+    ROTATED_TRANSPOSED,     // 'diag_transpose'
+    ROTATED_SHIFT_BL,       // 'diag_shift_bl' ...
+    ROTATED_SHIFT_TL,
+    ROTATED_SHIFT_BR,
+    ROTATED_SHIFT_TR,
+    ROTATED_CLOCKWISE,      // 'diag_rotate45_clockwise'
+    ROTATED_ANTICLOCK,      // 'diag_rotate45_antiClock'
+    ROTATED_VIEW_COUNT
+};
+
+// 64 bytes, so an update is a single cache line (& register with AVX-512)
+typedef struct {
+    _Alignas(64) uint64_t views[ROTATED_VIEW_COUNT];
+} RotatedBoards;
+
+
+// ==================
+//       Tables
+// ==================
+// Square (r, c) in each view: the shifts move row 'r' by 'r' or '7 - r' columns and drop what leaves the board
+// (see 'diagShift_bl_lin'), the rotations move column 'c' by 'c' rows (see 'rotated45_clockwiseSquare')
+#define ROTATED_ROW(square)     ((square) >> 3)
+#define ROTATED_COLUMN(square)  ((square) & 7)
+#define ROTATED_LEFT(square, by)    ((ROTATED_COLUMN(square) + (by) <= 7)? 1ULL << ((square) + (by)) : 0)
+#define ROTATED_RIGHT(square, by)   ((ROTATED_COLUMN(square) >= (by))? 1ULL << ((square) - (by)) : 0)
+
+#define ROTATED_SQUARE(square, unused) {{ \
+    1ULL << (square), \
+    1ULL << (ROTATED_COLUMN(square) << 3 | ROTATED_ROW(square)), \
+    ROTATED_LEFT(square, 7 - ROTATED_ROW(square)), \
+    ROTATED_LEFT(square, ROTATED_ROW(square)), \
+    ROTATED_RIGHT(square, 7 - ROTATED_ROW(square)), \
+    ROTATED_RIGHT(square, ROTATED_ROW(square)), \
+    1ULL << (((ROTATED_ROW(square) - ROTATED_COLUMN(square)) & 7) << 3 | ROTATED_COLUMN(square)), \
+    1ULL << (((ROTATED_ROW(square) + ROTATED_COLUMN(square)) & 7) << 3 | ROTATED_COLUMN(square)), \
+}}
+
+// Each square as a set with only it occupied (4KB)
+static const RotatedBoards rotatedBoards_squares[64] = { TABLE_64(ROTATED_SQUARE, 0) };
+
+
+// ==================
+//      Updates
+// ==================
+// Every view from scratch
+DIAG_INLINE void rotatedBoards_set(RotatedBoards *set, const uint64_t board) {
+    set->views[ROTATED_BOARD] = board;
+    set->views[ROTATED_TRANSPOSED] = diag_transpose(board);
+    set->views[ROTATED_SHIFT_BL] = diag_shift_bl(board);
+    set->views[ROTATED_SHIFT_TL] = diag_shift_tl(board);
+    set->views[ROTATED_SHIFT_BR] = diag_shift_br(board);
+    set->views[ROTATED_SHIFT_TR] = diag_shift_tr(board);
+    set->views[ROTATED_CLOCKWISE] = diag_rotate45_clockwise(board);
+    set->views[ROTATED_ANTICLOCK] = diag_rotate45_antiClock(board);
+}
+
+// The loops are a single xor of 8 lanes (2 AVX2 or 1 AVX-512 register once vectorised)
+DIAG_INLINE void rotatedBoards_xor(RotatedBoards *set, const RotatedBoards *change) {
+    for (int v=0; v < ROTATED_VIEW_COUNT; v++)
+        set->views[v] ^= change->views[v];
+}
+
+// A piece put on, or taken off, 'square' (a capture is the mover's 'from' alone)
+DIAG_INLINE void rotatedBoards_toggle(RotatedBoards *set, const unsigned square) {
+    rotatedBoards_xor(set, &rotatedBoards_squares[square]);
+}
+
+// A quiet move, made or unmade
+DIAG_INLINE void rotatedBoards_move(RotatedBoards *set, const unsigned from, const unsigned to) {
+    RotatedBoards change;
+    for (int v=0; v < ROTATED_VIEW_COUNT; v++)
+        change.views[v] = rotatedBoards_squares[from].views[v] ^ rotatedBoards_squares[to].views[v];
+    rotatedBoards_xor(set, &change);
+}
+
+// Any squares toggled at once (castling, en passant), made or unmade
+DIAG_INLINE void rotatedBoards_update(RotatedBoards *set, uint64_t changed) {
+    RotatedBoards change = {{0}};
+    for (; changed; changed &= changed - 1) {
+        const RotatedBoards *square = &rotatedBoards_squares[__builtin_ctzll(changed)];
+        for (int v=0; v < ROTATED_VIEW_COUNT; v++)
+            change.views[v] ^= square->views[v];
+    }
+    rotatedBoards_xor(set, &change);
+}
+
+#endif
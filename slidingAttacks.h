@@ -0,0 +1,269 @@
+#ifndef SLIDING_ATTACKS_H
+#define SLIDING_ATTACKS_H
+
+#include <stdint.h>
+
+#include "cpuFeatures.h"
+#include "diagShift.h"      // backDiagonals & fwdDiagonals
+#include "horizontalTo64.h" // toVertical_mul
+#include "tableGen.h"
+#ifdef DIAG_X86
+#include <immintrin.h>  // SSE2, pext & pdep
+#endif
+
+// Bishop, rook & queen attacks ("kindergarten" bitboards), built from the diagonal extract & deposit.
+// Every line through the square is packed into a byte, looked up in the first rank attacks, then spread back over the line.
+// Squares are 'row * 8 + column' (bit 'c' of byte 'r', same as the rest of the library).
+//
+// A diagonal has a single square in each column, so it packs by column (same as the SAD extract),
+// and its attacks spread back by broadcasting to every row & masking (same as 'toDiag_back_mul').
+// The tables are the 8x256 first rank attacks (2KB) & the 2 diagonals through each square (1KB).
+
+#define MAIN_BACK_DIAG  0x8040201008040201ULL // (\)
+#define MAIN_FWD_DIAG   0x0102040810204080ULL // (/)
+#define FILE_A          0x0101010101010101ULL
+#define RANK_1          0x00000000000000FFULL
+
+// Diagonals through 'square', diagonal 'k' is 'column - row' (\) or 'column + row - 7' (/)
+DIAG_INLINE uint64_t backDiagonalMask(const unsigned square) {
+    return backDiagonals[(int)(square & 7) - (int)(square >> 3) + 7];
+}
+
+DIAG_INLINE uint64_t fwdDiagonalMask(const unsigned square) {
+    return fwdDiagonals[(int)(square & 7) + (int)(square >> 3)];
+}
+
+
+// Both tables are generated at compile time ('tableGen.h'), so constant squares & occupancies fold.
+// Squares above 'column' up to & including the first blocker: "lowest - 1 | lowest" is every square up to
+// the lowest blocker, or all of them when there is none. Below is the same on the reversed rank
+#define RANK_ABOVE(column)              ((0xFEu << (column)) & 0xFFu)
+#define RANK_BLOCKERS(column, occupied) ((unsigned)(occupied) & RANK_ABOVE(column))
+#define RANK_LOWEST(column, occupied)   (RANK_BLOCKERS(column, occupied) & (0u - RANK_BLOCKERS(column, occupied)))
+#define RANK_RAY_UP(column, occupied)   (((RANK_LOWEST(column, occupied) - 1) | RANK_LOWEST(column, occupied)) & RANK_ABOVE(column))
+#define RANK_ATTACKS(occupied, column)  \
+    (uint8_t)(RANK_RAY_UP(column, occupied) | REVERSE_BYTE(RANK_RAY_UP(7 - (column), REVERSE_BYTE(occupied, 0)), 0))
+
+#define SQUARE_DIAGONALS(square, unused) \
+    { BACK_DIAGONAL(((square) & 7) - ((square) >> 3)), FWD_DIAGONAL(((square) & 7) + ((square) >> 3) - 7) }
+
+// Squares attacked by a slider at 'column' of a rank with the 'occupied' squares (the slider's own bit is ignored)
+static const uint8_t firstRankAttacks[8][256] = {
+    { TABLE_256(RANK_ATTACKS, 0) }, { TABLE_256(RANK_ATTACKS, 1) }, { TABLE_256(RANK_ATTACKS, 2) }, { TABLE_256(RANK_ATTACKS, 3) },
+    { TABLE_256(RANK_ATTACKS, 4) }, { TABLE_256(RANK_ATTACKS, 5) }, { TABLE_256(RANK_ATTACKS, 6) }, { TABLE_256(RANK_ATTACKS, 7) }
+};
+
+// (\) & (/) through each square
+static const uint64_t diagonalMasks[64][2] = { TABLE_64(SQUARE_DIAGONALS, 0) };
+
+
+// ==================
+//   Multiplication
+// ==================
+// Classic kindergarten: the multiply by 'FILE_A' adds every row into the top byte
+DIAG_INLINE uint64_t bishopAttacks_mul(const unsigned square, const uint64_t occupied) {
+    const unsigned column = square & 7;
+    const uint64_t backMask = diagonalMasks[square][0], fwdMask = diagonalMasks[square][1];
+
+    const uint8_t backOccupied = ((occupied & backMask) * FILE_A) >> 56;
+    const uint8_t fwdOccupied = ((occupied & fwdMask) * FILE_A) >> 56;
+
+    const uint64_t backAttacks = (firstRankAttacks[column][backOccupied] * FILE_A) & backMask;
+    const uint64_t fwdAttacks = (firstRankAttacks[column][fwdOccupied] * FILE_A) & fwdMask;
+    return backAttacks | fwdAttacks;
+}
+
+// The rank is already a byte. The file is packed by row with the same multiply as the diagonals (no carries, 1 bit per row),
+// and spread back by 'toVertical_mul'
+DIAG_INLINE uint64_t rookAttacks_mul(const unsigned square, const uint64_t occupied) {
+    const unsigned row = square >> 3, column = square & 7;
+
+    const uint8_t rankOccupied = occupied >> 8*row;
+    const uint64_t rankAttacks = (uint64_t)firstRankAttacks[column][rankOccupied] << 8*row;
+
+    const uint8_t fileOccupied = (((occupied >> column) & FILE_A) * MAIN_FWD_DIAG) >> 56;
+    const uint64_t fileAttacks = toVertical_mul(firstRankAttacks[row][fileOccupied]) << column;
+    return rankAttacks | fileAttacks;
+}
+
+DIAG_INLINE uint64_t queenAttacks_mul(const unsigned square, const uint64_t occupied) {
+    return bishopAttacks_mul(square, occupied) | rookAttacks_mul(square, occupied);
+}
+
+
+// ==================
+//        SAD
+// ==================
+// Both diagonals at once: the sum of each 64-bit half is the OR of its masked rows, same as the multiply
+#ifdef DIAG_X86
+DIAG_INLINE uint64_t bishopAttacks_SAD(const unsigned square, const uint64_t occupied) {
+    if (DIAG_IS_CONSTANT(square) && DIAG_IS_CONSTANT(occupied)) return bishopAttacks_mul(square, occupied);
+
+    const unsigned column = square & 7;
+    const uint64_t backMask = diagonalMasks[square][0], fwdMask = diagonalMasks[square][1];
+
+    __m128i diagonalsOnly = _mm_and_si128(_mm_set1_epi64x(occupied), _mm_loadu_si128((const __m128i*)diagonalMasks[square]));
+    __m128i packed = _mm_sad_epu8(diagonalsOnly, _mm_setzero_si128());
+    const uint8_t backOccupied = _mm_cvtsi128_si32(packed);
+    const uint8_t fwdOccupied = _mm_extract_epi16(packed, 4);
+
+    // Broadcast & mask (like 'toDiag_back_mul'), for any diagonal
+    const uint64_t backAttacks = (firstRankAttacks[column][backOccupied] * FILE_A) & backMask;
+    const uint64_t fwdAttacks = (firstRankAttacks[column][fwdOccupied] * FILE_A) & fwdMask;
+    return backAttacks | fwdAttacks;
+}
+#endif
+
+
+// ==================
+//     Pext/pdep
+// ==================
+// Any line packs in order with 'pext', the slider's index along it is where its own bit lands
+#ifdef COMPILE_BMI2
+static inline TARGET_BMI2 uint64_t lineAttacks_pext(const unsigned square, const uint64_t occupied, const uint64_t lineMask) {
+    const unsigned index = __builtin_ctzll(_pext_u64(1ULL << square, lineMask));
+    return _pdep_u64(firstRankAttacks[index][_pext_u64(occupied, lineMask)], lineMask);
+}
+
+static inline TARGET_BMI2 uint64_t bishopAttacks_pext(const unsigned square, const uint64_t occupied) {
+    if (DIAG_IS_CONSTANT(square) && DIAG_IS_CONSTANT(occupied)) return bishopAttacks_mul(square, occupied);
+
+    return lineAttacks_pext(square, occupied, diagonalMasks[square][0])
+        | lineAttacks_pext(square, occupied, diagonalMasks[square][1]);
+}
+
+static inline TARGET_BMI2 uint64_t rookAttacks_pext(const unsigned square, const uint64_t occupied) {
+    if (DIAG_IS_CONSTANT(square) && DIAG_IS_CONSTANT(occupied)) return rookAttacks_mul(square, occupied);
+
+    return lineAttacks_pext(square, occupied, RANK_1 << (square & ~7u))
+        | lineAttacks_pext(square, occupied, FILE_A << (square & 7));
+}
+
+static inline TARGET_BMI2 uint64_t queenAttacks_pext(const unsigned square, const uint64_t occupied) {
+    return bishopAttacks_pext(square, occupied) | rookAttacks_pext(square, occupied);
+}
+#endif
+
+
+// ==================
+//      Setwise
+// ==================
+// The union of the attacks of all the 'sliders' (every bishop & queen of a side) at once, as an occluded fill from
+// each of them over the 'empty' squares, up to & including the first blocker.
+// Kogge-Stone: 3 steps double the distance filled, 'gen' is what was reached & 'pro' where the fill may go on.
+DIAG_INLINE uint64_t setwiseFill_up(uint64_t gen, uint64_t pro, const unsigned shift, const uint64_t notWrapped) {
+    pro &= notWrapped;
+    gen |= pro & (gen << shift);
+    pro &= pro << shift;
+    gen |= pro & (gen << 2*shift);
+    pro &= pro << 2*shift;
+    gen |= pro & (gen << 4*shift);
+    return (gen << shift) & notWrapped;
+}
+
+DIAG_INLINE uint64_t setwiseFill_down(uint64_t gen, uint64_t pro, const unsigned shift, const uint64_t notWrapped) {
+    pro &= notWrapped;
+    gen |= pro & (gen >> shift);
+    pro &= pro >> shift;
+    gen |= pro & (gen >> 2*shift);
+    pro &= pro >> 2*shift;
+    gen |= pro & (gen >> 4*shift);
+    return (gen >> shift) & notWrapped;
+}
+
+// The 4 diagonal directions, each masking out what wrapped around to the other side of the board
+DIAG_INLINE uint64_t diagonalAttacksSetwise_bin(const uint64_t sliders, const uint64_t empty) {
+    return setwiseFill_up(sliders, empty, 9, ~FILE_A) | setwiseFill_up(sliders, empty, 7, ~(FILE_A << 7))
+        | setwiseFill_down(sliders, empty, 7, ~FILE_A) | setwiseFill_down(sliders, empty, 9, ~(FILE_A << 7));
+}
+
+// Shifted, every diagonal is a file: 'diagShift_bl' moves (\) diagonal 'k' <= 0 to column '7 + k', 'diagShift_tr' those
+// >= 0 to column 'k', and 'diagShift_tl' & 'diagShift_br' the (/) ones. A file only needs the fills up & down, which never
+// wrap around, and the shift back ('br' for 'bl', 'tr' for 'tl' ...) drops whatever a fill reached past its diagonal.
+// The squares shifted in from outside the board are never empty, so no fill goes through them.
+#ifdef DIAG_X86
+// Both fills of every lane
+DIAG_INLINE __m128i setwiseFileAttacks_x2(__m128i gen, __m128i pro) {
+    __m128i up = gen, down = gen, proUp = pro, proDown = pro;
+    up = _mm_or_si128(up, _mm_and_si128(proUp, _mm_slli_epi64(up, 8)));
+    down = _mm_or_si128(down, _mm_and_si128(proDown, _mm_srli_epi64(down, 8)));
+    proUp = _mm_and_si128(proUp, _mm_slli_epi64(proUp, 8));
+    proDown = _mm_and_si128(proDown, _mm_srli_epi64(proDown, 8));
+    up = _mm_or_si128(up, _mm_and_si128(proUp, _mm_slli_epi64(up, 16)));
+    down = _mm_or_si128(down, _mm_and_si128(proDown, _mm_srli_epi64(down, 16)));
+    proUp = _mm_and_si128(proUp, _mm_slli_epi64(proUp, 16));
+    proDown = _mm_and_si128(proDown, _mm_srli_epi64(proDown, 16));
+    up = _mm_or_si128(up, _mm_and_si128(proUp, _mm_slli_epi64(up, 32)));
+    down = _mm_or_si128(down, _mm_and_si128(proDown, _mm_srli_epi64(down, 32)));
+    return _mm_or_si128(_mm_slli_epi64(up, 8), _mm_srli_epi64(down, 8));
+}
+
+// The diagonals below the main ones (\ & /) in one register, those above in another
+DIAG_INLINE uint64_t diagonalAttacksSetwise_sse(const uint64_t sliders, const uint64_t empty) {
+    if (DIAG_IS_CONSTANT(sliders) && DIAG_IS_CONSTANT(empty)) return diagonalAttacksSetwise_bin(sliders, empty);
+
+    const __m128i slidersBoth = _mm_set1_epi64x(sliders), emptyBoth = _mm_set1_epi64x(empty);
+    const __m128i lower = setwiseFileAttacks_x2(
+        diagShift_left_x2_lanes(slidersBoth, DIAG_SHIFT_BL_POWERS, DIAG_SHIFT_TL_POWERS),
+        diagShift_left_x2_lanes(emptyBoth, DIAG_SHIFT_BL_POWERS, DIAG_SHIFT_TL_POWERS));
+    const __m128i upper = setwiseFileAttacks_x2(
+        diagShift_right_x2_lanes(slidersBoth, DIAG_SHIFT_TR_POWERS, DIAG_SHIFT_BR_POWERS),
+        diagShift_right_x2_lanes(emptyBoth, DIAG_SHIFT_TR_POWERS, DIAG_SHIFT_BR_POWERS));
+
+    const __m128i attacks = _mm_or_si128(
+        diagShift_right_x2_lanes(lower, DIAG_SHIFT_BR_POWERS, DIAG_SHIFT_TR_POWERS),
+        diagShift_left_x2_lanes(upper, DIAG_SHIFT_TL_POWERS, DIAG_SHIFT_BL_POWERS));
+    return _mm_cvtsi128_si64(_mm_or_si128(attacks, _mm_unpackhi_epi64(attacks, attacks)));
+}
+#endif
+
+// AVX2 shifts each lane by its own count, so the 4 directions are the 4 lanes of one register, without the shifts
+#ifdef COMPILE_AVX2
+// 'vpsllvq' & 'vpsrlvq', a count of 64 or more gives 0
+static inline TARGET_AVX2 __m256i setwiseShift_x4(const __m256i boards, const __m256i left, const __m256i right) {
+    return _mm256_or_si256(_mm256_sllv_epi64(boards, left), _mm256_srlv_epi64(boards, right));
+}
+
+static inline TARGET_AVX2 uint64_t diagonalAttacksSetwise_avx2(const uint64_t sliders, const uint64_t empty) {
+    if (DIAG_IS_CONSTANT(sliders) && DIAG_IS_CONSTANT(empty)) return diagonalAttacksSetwise_bin(sliders, empty);
+
+    // Up right, up left, down right, down left: 9, 7, -7 & -9
+    const __m256i notWrapped = _mm256_set_epi64x(~(FILE_A << 7), ~FILE_A, ~(FILE_A << 7), ~FILE_A);
+    const __m256i left1 = _mm256_set_epi64x(64, 64, 7, 9), right1 = _mm256_set_epi64x(9, 7, 64, 64);
+    const __m256i left2 = _mm256_add_epi64(left1, left1), right2 = _mm256_add_epi64(right1, right1);
+    const __m256i left4 = _mm256_add_epi64(left2, left2), right4 = _mm256_add_epi64(right2, right2);
+
+    __m256i gen = _mm256_set1_epi64x((long long)sliders);
+    __m256i pro = _mm256_and_si256(_mm256_set1_epi64x((long long)empty), notWrapped);
+    gen = _mm256_or_si256(gen, _mm256_and_si256(pro, setwiseShift_x4(gen, left1, right1)));
+    pro = _mm256_and_si256(pro, setwiseShift_x4(pro, left1, right1));
+    gen = _mm256_or_si256(gen, _mm256_and_si256(pro, setwiseShift_x4(gen, left2, right2)));
+    pro = _mm256_and_si256(pro, setwiseShift_x4(pro, left2, right2));
+    gen = _mm256_or_si256(gen, _mm256_and_si256(pro, setwiseShift_x4(gen, left4, right4)));
+    const __m256i attacks = _mm256_and_si256(setwiseShift_x4(gen, left1, right1), notWrapped);
+
+    const __m128i half = _mm_or_si128(_mm256_castsi256_si128(attacks), _mm256_extracti128_si256(attacks, 1));
+    return _mm_cvtsi128_si64(_mm_or_si128(half, _mm_unpackhi_epi64(half, half)));
+}
+#endif
+
+
+// pext/pdep when known to be available at compile time, otherwise the multiplies (the SAD's trips to the vector registers cost more)
+#ifdef CPU_HAS_BMI2
+    #define bishopAttacks bishopAttacks_pext
+    #define rookAttacks   rookAttacks_pext
+    #define queenAttacks  queenAttacks_pext
+#else
+    #define bishopAttacks bishopAttacks_mul
+    #define rookAttacks   rookAttacks_mul
+    #define queenAttacks  queenAttacks_mul
+#endif
+
+// The shifts to & from the files cost more than the 4 scalar fills, so the SSE version is never the default
+#if defined(CPU_HAS_AVX2) && !defined(DIAG_PORTABLE)
+    #define diagonalAttacksSetwise diagonalAttacksSetwise_avx2
+#else
+    #define diagonalAttacksSetwise diagonalAttacksSetwise_bin
+#endif
+
+#endif
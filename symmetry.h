@@ -0,0 +1,345 @@
+#ifndef SYMMETRY_H
+#define SYMMETRY_H
+
+#include <stdint.h>
+#include <stddef.h>     // size_t
+#include <string.h>     // memcpy
+
+#include "cpuFeatures.h"
+#include "transpose.h"  // flipDiagA1H8 & its vectors
+#ifdef DIAG_X86
+#include <immintrin.h>  // SSE2, AVX2, AVX512bw
+#endif
+
+// The 8 symmetries of the board (rotations & reflections): every one is a transpose (or not), then a mirror of the
+// columns (or not), then a flip of the rows (or not). Image 's' has the transpose if 's & 1', the mirror if 's & 2'
+// and the flip if 's & 4': 0 is the board, 1 the transpose, 2 & 4 the mirror & the flip, 6 the 180 rotation.
+//
+// So the 8 images only take 1 transpose, 2 mirrors & 4 flips: each one starts from one of the others.
+// The canonical board is the smallest of its 8 images, the same for every board it can be rotated or reflected to.
+
+// Bits of each row reversed (a1 <-> h1): swap the halves, pairs & single bits of every byte
+DIAG_INLINE uint64_t mirrorColumns(uint64_t x) {
+    x = ((x >> 1) & 0x5555555555555555ULL) | ((x & 0x5555555555555555ULL) << 1);
+    x = ((x >> 2) & 0x3333333333333333ULL) | ((x & 0x3333333333333333ULL) << 2);
+    x = ((x >> 4) & 0x0F0F0F0F0F0F0F0FULL) | ((x & 0x0F0F0F0F0F0F0F0FULL) << 4);
+    return x;
+}
+
+// Rows reversed (a1 <-> a8), compilers turn this into a 'bswap'
+DIAG_INLINE uint64_t flipRows(uint64_t x) {
+    x = ((x >> 8) & 0x00FF00FF00FF00FFULL) | ((x & 0x00FF00FF00FF00FFULL) << 8);
+    x = ((x >> 16) & 0x0000FFFF0000FFFFULL) | ((x & 0x0000FFFF0000FFFFULL) << 16);
+    return (x >> 32) | (x << 32);
+}
+
+// A single image
+DIAG_INLINE uint64_t diagSymmetry(uint64_t board, const unsigned symmetry) {
+    if (symmetry & 1) board = flipDiagA1H8(board);
+    if (symmetry & 2) board = mirrorColumns(board);
+    if (symmetry & 4) board = flipRows(board);
+    return board;
+}
+
+DIAG_INLINE void diagSymmetries_bin(const uint64_t board, uint64_t images[8]) {
+    images[0] = board;
+    images[1] = flipDiagA1H8(board);
+    images[2] = mirrorColumns(images[0]);
+    images[3] = mirrorColumns(images[1]);
+    for (int s=0; s < 4; s++)
+        images[s + 4] = flipRows(images[s]);
+}
+
+DIAG_INLINE uint64_t diagCanonical_bin(const uint64_t board) {
+    uint64_t images[8];
+    diagSymmetries_bin(board, images);
+
+    uint64_t smallest = images[0];
+    for (int s=1; s < 8; s++)
+        smallest = (images[s] < smallest)? images[s] : smallest;
+    return smallest;
+}
+
+
+// ==================
+//        SSE
+// ==================
+// The board & its transpose in the 2 lanes, then both mirrored, then all 4 flipped
+#ifdef DIAG_X86
+// Same swaps as 'mirrorColumns', no bits cross a byte
+DIAG_INLINE __m128i mirrorColumns_x2(__m128i x) {
+    const __m128i k1 = _mm_set1_epi8(0x55), k2 = _mm_set1_epi8(0x33), k4 = _mm_set1_epi8(0x0F);
+    x = _mm_or_si128(_mm_and_si128(_mm_srli_epi64(x, 1), k1), _mm_slli_epi64(_mm_and_si128(x, k1), 1));
+    x = _mm_or_si128(_mm_and_si128(_mm_srli_epi64(x, 2), k2), _mm_slli_epi64(_mm_and_si128(x, k2), 2));
+    x = _mm_or_si128(_mm_and_si128(_mm_srli_epi64(x, 4), k4), _mm_slli_epi64(_mm_and_si128(x, k4), 4));
+    return x;
+}
+
+// No byte shuffle in SSE2: reverse the 16-bit words, then the bytes of each word
+DIAG_INLINE __m128i flipRows_x2(__m128i x) {
+    x = _mm_shufflelo_epi16(x, _MM_SHUFFLE(0, 1, 2, 3));
+    x = _mm_shufflehi_epi16(x, _MM_SHUFFLE(0, 1, 2, 3));
+    return _mm_or_si128(_mm_slli_epi16(x, 8), _mm_srli_epi16(x, 8));
+}
+
+DIAG_INLINE void diagSymmetries_sse(const uint64_t board, uint64_t images[8]) {
+    const __m128i broadcasted = _mm_set1_epi64x(board);
+    const __m128i boards = _mm_unpacklo_epi64(broadcasted, flipDiagA1H8_x2(broadcasted));
+    const __m128i mirrored = mirrorColumns_x2(boards);
+
+    _mm_storeu_si128((__m128i*)(images + 0), boards);
+    _mm_storeu_si128((__m128i*)(images + 2), mirrored);
+    _mm_storeu_si128((__m128i*)(images + 4), flipRows_x2(boards));
+    _mm_storeu_si128((__m128i*)(images + 6), flipRows_x2(mirrored));
+}
+#endif
+
+
+// ==================
+//    AVX2 & AVX512
+// ==================
+// 'pshufb' reverses the bits of each nibble (one table per half of the byte), and the bytes of each board.
+// AVX2: the board & its transpose twice, the upper half mirrored, then all 4 flipped.
+// AVX512: one image per lane, blended in as each step is done to all 8.
+#define REVERSED_NIBBLES(shift) \
+    0 << (shift), 8 << (shift), 4 << (shift), 12 << (shift), 2 << (shift), 10 << (shift), 6 << (shift), 14 << (shift), \
+    1 << (shift), 9 << (shift), 5 << (shift), 13 << (shift), 3 << (shift), 11 << (shift), 7 << (shift), 15 << (shift)
+
+#ifdef COMPILE_AVX2
+static inline TARGET_AVX2 __m256i mirrorColumns_x4(const __m256i x) {
+    const __m256i reversedLow = _mm256_broadcastsi128_si256(_mm_setr_epi8(REVERSED_NIBBLES(4)));
+    const __m256i reversedHigh = _mm256_broadcastsi128_si256(_mm_setr_epi8(REVERSED_NIBBLES(0)));
+    const __m256i nibble = _mm256_set1_epi8(0x0F);
+
+    const __m256i low = _mm256_and_si256(x, nibble), high = _mm256_and_si256(_mm256_srli_epi16(x, 4), nibble);
+    return _mm256_or_si256(_mm256_shuffle_epi8(reversedLow, low), _mm256_shuffle_epi8(reversedHigh, high));
+}
+
+static inline TARGET_AVX2 __m256i flipRows_x4(const __m256i x) {
+    const __m256i reverseRows = _mm256_broadcastsi128_si256(_mm_set_epi8(8, 9, 10, 11, 12, 13, 14, 15, 0, 1, 2, 3, 4, 5, 6, 7));
+    return _mm256_shuffle_epi8(x, reverseRows);
+}
+
+static inline TARGET_AVX2 void diagSymmetries_avx2(const uint64_t board, uint64_t images[8]) {
+    __m256i boards = _mm256_set1_epi64x(board);
+    boards = _mm256_blend_epi32(boards, flipDiagA1H8_x4(boards), 0xCC);   // Lanes 1 & 3
+    boards = _mm256_blend_epi32(boards, mirrorColumns_x4(boards), 0xF0);  // Lanes 2 & 3
+
+    _mm256_storeu_si256((__m256i*)(images + 0), boards);
+    _mm256_storeu_si256((__m256i*)(images + 4), flipRows_x4(boards));
+}
+
+// Smallest unsigned lane: AVX2 only compares signed, so the top bits are flipped first
+static inline TARGET_AVX2 uint64_t diagCanonical_avx2(const uint64_t board) {
+    const __m256i signBit = _mm256_set1_epi64x((long long)0x8000000000000000ULL);
+    __m256i boards = _mm256_set1_epi64x(board);
+    boards = _mm256_blend_epi32(boards, flipDiagA1H8_x4(boards), 0xCC);
+    boards = _mm256_blend_epi32(boards, mirrorColumns_x4(boards), 0xF0);
+
+    __m256i a = _mm256_xor_si256(boards, signBit), b = _mm256_xor_si256(flipRows_x4(boards), signBit);
+    a = _mm256_blendv_epi8(a, b, _mm256_cmpgt_epi64(a, b));
+    b = _mm256_permute4x64_epi64(a, _MM_SHUFFLE(1, 0, 3, 2));
+    a = _mm256_blendv_epi8(a, b, _mm256_cmpgt_epi64(a, b));
+    b = _mm256_shuffle_epi32(a, _MM_SHUFFLE(1, 0, 3, 2));
+    a = _mm256_blendv_epi8(a, b, _mm256_cmpgt_epi64(a, b));
+    return (uint64_t)_mm_cvtsi128_si64(_mm256_castsi256_si128(a)) ^ 0x8000000000000000ULL;
+}
+#endif
+
+#ifdef COMPILE_AVX512
+static inline TARGET_AVX512 __m512i mirrorColumns_x8(const __m512i x) {
+    const __m512i reversedLow = _mm512_broadcast_i32x4(_mm_setr_epi8(REVERSED_NIBBLES(4)));
+    const __m512i reversedHigh = _mm512_broadcast_i32x4(_mm_setr_epi8(REVERSED_NIBBLES(0)));
+    const __m512i nibble = _mm512_set1_epi8(0x0F);
+
+    const __m512i low = _mm512_and_si512(x, nibble), high = _mm512_and_si512(_mm512_srli_epi16(x, 4), nibble);
+    return _mm512_or_si512(_mm512_shuffle_epi8(reversedLow, low), _mm512_shuffle_epi8(reversedHigh, high));
+}
+
+static inline TARGET_AVX512 __m512i flipRows_x8(const __m512i x) {
+    const __m512i reverseRows = _mm512_broadcast_i32x4(_mm_set_epi8(8, 9, 10, 11, 12, 13, 14, 15, 0, 1, 2, 3, 4, 5, 6, 7));
+    return _mm512_shuffle_epi8(x, reverseRows);
+}
+
+static inline TARGET_AVX512 __m512i diagSymmetries_x8(const uint64_t board) {
+    __m512i images = _mm512_set1_epi64(board);
+    images = _mm512_mask_mov_epi64(images, 0xAA, flipDiagA1H8_x8(images));
+    images = _mm512_mask_mov_epi64(images, 0xCC, mirrorColumns_x8(images));
+    return _mm512_mask_mov_epi64(images, 0xF0, flipRows_x8(images));
+}
+
+static inline TARGET_AVX512 void diagSymmetries_avx512(const uint64_t board, uint64_t images[8]) {
+    _mm512_storeu_si512(images, diagSymmetries_x8(board));
+}
+
+static inline TARGET_AVX512 uint64_t diagCanonical_avx512(const uint64_t board) {
+    return _mm512_reduce_min_epu64(diagSymmetries_x8(board));
+}
+#endif
+
+
+
+// ==================
+//      Batched
+// ==================
+// 'n' boards in, 8 arrays of 'n' images out: image 's' of 'in[i]' is 'out[s*n + i]'.
+// With positions of several planes (bitboards) each, every array is then the same positions, with their planes in the same order.
+// Every lane is its own board: 1 transpose, 2 mirrors & 4 flips of a whole vector.
+
+// Boards 'i' to 'n' one at a time, the end of the vector loops
+static inline void diagSymmetries_batchFrom(const uint64_t *in, uint64_t *out, size_t i, const size_t n) {
+    for (; i < n; i++) {
+        uint64_t images[8];
+        diagSymmetries_bin(in[i], images);
+        for (int s=0; s < 8; s++)
+            out[s*n + i] = images[s];
+    }
+}
+
+static inline void diagSymmetries_batch_bin(const uint64_t *in, uint64_t *out, size_t n) {
+    diagSymmetries_batchFrom(in, out, 0, n);
+}
+
+#ifdef DIAG_X86
+static inline void diagSymmetries_batch_sse(const uint64_t *in, uint64_t *out, size_t n) {
+    size_t i = 0;
+    for (; i + 2 <= n; i += 2) {
+        __m128i images[8];
+        images[0] = _mm_loadu_si128((const __m128i*)(in + i));
+        images[1] = flipDiagA1H8_x2(images[0]);
+        images[2] = mirrorColumns_x2(images[0]);
+        images[3] = mirrorColumns_x2(images[1]);
+        for (int s=0; s < 4; s++)
+            images[s + 4] = flipRows_x2(images[s]);
+
+        for (int s=0; s < 8; s++)
+            _mm_storeu_si128((__m128i*)(out + s*n + i), images[s]);
+    }
+    diagSymmetries_batchFrom(in, out, i, n);
+}
+#endif
+
+#ifdef COMPILE_AVX2
+static inline TARGET_AVX2 void diagSymmetries_batch_avx2(const uint64_t *in, uint64_t *out, size_t n) {
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m256i images[8];
+        images[0] = _mm256_loadu_si256((const __m256i*)(in + i));
+        images[1] = flipDiagA1H8_x4(images[0]);
+        images[2] = mirrorColumns_x4(images[0]);
+        images[3] = mirrorColumns_x4(images[1]);
+        for (int s=0; s < 4; s++)
+            images[s + 4] = flipRows_x4(images[s]);
+
+        for (int s=0; s < 8; s++)
+            _mm256_storeu_si256((__m256i*)(out + s*n + i), images[s]);
+    }
+    diagSymmetries_batchFrom(in, out, i, n);
+}
+#endif
+
+#ifdef COMPILE_AVX512
+static inline TARGET_AVX512 void diagSymmetries_batch_avx512(const uint64_t *in, uint64_t *out, size_t n) {
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m512i images[8];
+        images[0] = _mm512_loadu_si512(in + i);
+        images[1] = flipDiagA1H8_x8(images[0]);
+        images[2] = mirrorColumns_x8(images[0]);
+        images[3] = mirrorColumns_x8(images[1]);
+        for (int s=0; s < 4; s++)
+            images[s + 4] = flipRows_x8(images[s]);
+
+        for (int s=0; s < 8; s++)
+            _mm512_storeu_si512(out + s*n + i, images[s]);
+    }
+    diagSymmetries_batchFrom(in, out, i, n);
+}
+#endif
+
+// The same swaps on GCC/Clang vectors of boards
+#ifdef COMPILE_VECTOR
+DIAG_INLINE diagVec_u64 mirrorColumns_vec(diagVec_u64 x) {
+    x = ((x >> 1) & 0x5555555555555555ULL) | ((x & 0x5555555555555555ULL) << 1);
+    x = ((x >> 2) & 0x3333333333333333ULL) | ((x & 0x3333333333333333ULL) << 2);
+    x = ((x >> 4) & 0x0F0F0F0F0F0F0F0FULL) | ((x & 0x0F0F0F0F0F0F0F0FULL) << 4);
+    return x;
+}
+
+DIAG_INLINE diagVec_u64 flipRows_vec(diagVec_u64 x) {
+    x = ((x >> 8) & 0x00FF00FF00FF00FFULL) | ((x & 0x00FF00FF00FF00FFULL) << 8);
+    x = ((x >> 16) & 0x0000FFFF0000FFFFULL) | ((x & 0x0000FFFF0000FFFFULL) << 16);
+    return (x >> 32) | (x << 32);
+}
+
+static inline void diagSymmetries_batch_vec(const uint64_t *in, uint64_t *out, size_t n) {
+    size_t i = 0;
+    for (; i + DIAG_VECTOR_BOARDS <= n; i += DIAG_VECTOR_BOARDS) {
+        diagVec_u64 images[8];
+        memcpy(&images[0], in + i, sizeof(images[0]));
+        images[1] = flipDiagA1H8_vec(images[0]);
+        images[2] = mirrorColumns_vec(images[0]);
+        images[3] = mirrorColumns_vec(images[1]);
+        for (int s=0; s < 4; s++)
+            images[s + 4] = flipRows_vec(images[s]);
+
+        for (int s=0; s < 8; s++)
+            memcpy(out + s*n + i, &images[s], sizeof(images[s]));
+    }
+    diagSymmetries_batchFrom(in, out, i, n);
+}
+#endif
+
+
+// A single board: the scalar swaps are as fast as the AVX2 & AVX512 versions (the SSE one is slower, it has no byte shuffle),
+// only the smallest image is faster with AVX512's 'vpminuq'. The batches take the widest known to be supported at compile time
+#define diagSymmetries diagSymmetries_bin
+
+#if defined(CPU_HAS_AVX512) && !defined(DIAG_PORTABLE)
+    #define diagCanonical diagCanonical_avx512
+#else
+    #define diagCanonical diagCanonical_bin
+#endif
+
+static inline void diagSymmetries_batch(const uint64_t *in, uint64_t *out, size_t n) {
+#if defined(DIAG_PORTABLE)
+    diagSymmetries_batch_vec(in, out, n);
+#elif defined(CPU_HAS_AVX512)
+    diagSymmetries_batch_avx512(in, out, n);
+#elif defined(CPU_HAS_AVX2)
+    diagSymmetries_batch_avx2(in, out, n);
+#else
+    diagSymmetries_batch_sse(in, out, n);
+#endif
+}
+
+
+// ==================
+//  Canonical planes
+// ==================
+// A position of several planes has to use the same symmetry for all of them: the one whose planes are the smallest,
+// compared plane by plane (the first plane that differs decides). Writes them to 'out', returns the symmetry.
+// Ties (a symmetric position) go to the lowest symmetry, so the same position always gets the same one.
+static inline unsigned diagCanonicalPlanes(const uint64_t *planes, const size_t count, uint64_t *out) {
+    unsigned candidates = 0xFF;
+
+    // Only the symmetries that were the smallest on every plane so far are kept
+    for (size_t p=0; p < count && (candidates & (candidates - 1)); p++) {
+        uint64_t images[8], smallest = UINT64_MAX;
+        diagSymmetries(planes[p], images);
+
+        for (unsigned s=0; s < 8; s++)
+            if ((candidates >> s & 1) && images[s] < smallest) smallest = images[s];
+        for (unsigned s=0; s < 8; s++)
+            if (images[s] != smallest) candidates &= ~(1u << s);
+    }
+
+    unsigned symmetry = 0;
+    while (!(candidates >> symmetry & 1)) symmetry++;
+
+    for (size_t p=0; p < count; p++)
+        out[p] = diagSymmetry(planes[p], symmetry);
+    return symmetry;
+}
+
+#endif
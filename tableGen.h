@@ -0,0 +1,23 @@
+#ifndef TABLE_GEN_H
+#define TABLE_GEN_H
+
+// A board as its rows in hex, top (r7) to bottom (r0): 'hex2d_as_u64(80, 40, 20, 10, 08, 04, 02, 01)' is the (\) diagonal
+#define hex2d_as_u64(r7, r6, r5, r4, r3, r2, r1, r0) (0x ## r7 ## r6 ## r5 ## r4 ## r3 ## r2 ## r1 ## r0 ## ULL)
+
+// Lookup tables built by the compiler instead of pasted in or filled in at startup.
+// 'TABLE_256(entry, arg)' is "entry(0, arg), entry(1, arg), ... entry(255, arg)", where 'entry(i, arg)' is a constant expression.
+// So the tables can be 'static const': no startup code, and a lookup with a constant index folds to its value.
+
+#define TABLE_4(entry, i, arg)      entry((i) + 0, arg), entry((i) + 1, arg), entry((i) + 2, arg), entry((i) + 3, arg)
+#define TABLE_16_AT(entry, i, arg)  TABLE_4(entry, (i) + 0, arg), TABLE_4(entry, (i) + 4, arg), TABLE_4(entry, (i) + 8, arg), TABLE_4(entry, (i) + 12, arg)
+#define TABLE_64_AT(entry, i, arg)  TABLE_16_AT(entry, (i) + 0, arg), TABLE_16_AT(entry, (i) + 16, arg), TABLE_16_AT(entry, (i) + 32, arg), TABLE_16_AT(entry, (i) + 48, arg)
+#define TABLE_256_AT(entry, i, arg) TABLE_64_AT(entry, (i) + 0, arg), TABLE_64_AT(entry, (i) + 64, arg), TABLE_64_AT(entry, (i) + 128, arg), TABLE_64_AT(entry, (i) + 192, arg)
+
+#define TABLE_16(entry, arg)    TABLE_16_AT(entry, 0, arg)
+#define TABLE_64(entry, arg)    TABLE_64_AT(entry, 0, arg)
+#define TABLE_256(entry, arg)   TABLE_256_AT(entry, 0, arg)
+
+// Reverses the bits of a byte (3 ops: spread 5 copies, keep 1 bit of each group of 10, sum the groups)
+#define REVERSE_BYTE(b, unused) ((uint8_t)((((b) * 0x0202020202ULL) & 0x010884422010ULL) % 1023))
+
+#endif
@@ -2,18 +2,33 @@
 # include <stdint.h>
 # include <emmintrin.h> // SSE2
 # include <stdlib.h>    // Create random array
+# include <string.h>    // memset, memcmp
 # include <time.h>      // Performance messuring
 # include <immintrin.h> // Rotation shift
+# include <x86intrin.h> // rdtsc
 
-//#define CPU_HAS_BMI2
-//#define CPU_HAS_AVX2
+// Compile every method, the ones the CPU doesn't support are skipped at runtime
+#define DIAG_RUNTIME_DISPATCH
 
 # include "diagShift.h"
 # include "diagToHorizontal.h"
 # include "horizontalTo64.h"
 # include "transpose.h"
-
-#define hex2d_as_u64(r7, r6, r5, r4, r3, r2, r1, r0) (0x ## r7 ## r6 ## r5 ## r4 ## r3 ## r2 ## r1 ## r0 ## ULL)
+# include "dispatch.h"        // diagOps, checked by --dispatch
+# include "bitmapRotate.h"
+# include "slidingAttacks.h"
+# include "boardGeometry.h"
+# include "perft.h"
+# include "symmetry.h"
+# include "diagPopcount.h"
+# include "rotate45.h"
+# include "wideBoard.h"
+# include "diagRegister.h"
+# include "rotatedBoards.h"
+# include "byteShift.h"
+# include "boolMatrix.h"
+# include "perfCounters.h"
+# include "diagBitboard.h"    // Inlined, or only declared with DIAG_LIBRARY (then linked to the library)
 
 void printSSE_16(const __m128i vecToPrint) {
     union {__m128i vec; uint16_t el[8];} parts;
@@ -27,81 +42,2254 @@ void printSSE_16(const __m128i vecToPrint) {
 }
 
 
-uint64_t antiClock_rot45(uint64_t toRotate) {
-#if 0
-    // https://www.chessprogramming.org/Flipping_Mirroring_and_Rotating#Pseudo-Rotation_by_45_degrees
-    const uint64_t k1 = 0xAAAAAAAAAAAAAAAALLU;
-    const uint64_t k2 = 0xCCCCCCCCCCCCCCCCLLU;
-    const uint64_t k4 = 0xF0F0F0F0F0F0F0F0LLU;
+// Other board sizes in use, generated from their width & height
+BOARD_GEOMETRY(board4x4, uint32_t, 4, 4)
+BOARD_GEOMETRY(board6x6, uint64_t, 6, 6)
+BOARD_GEOMETRY(board7x7, uint64_t, 7, 7)
+BOARD_GEOMETRY(board8x4, uint32_t, 8, 4)
+BOARD_GEOMETRY_SSE(board8x4, uint32_t, 4)
+// Must be the same as the hand-written kernels
+BOARD_GEOMETRY(board8x8, uint64_t, 8, 8)
+// Shogi, Gomoku & Go, a row per 16 or 32-bit lane
+WIDE_BOARD16(board9x9, 9, 9)
+WIDE_BOARD16(board15x15, 15, 15)
+WIDE_BOARD32(board19x19, 19, 19)
+
+enum GeometryShift {GEOMETRY_BL, GEOMETRY_TL, GEOMETRY_BR, GEOMETRY_TR};
+
+// Row by row references for any width & height. The bottom row moves the most for 'bl' & 'br', the top row for 'tl' & 'tr'
+uint64_t geometryShift_naive(const uint64_t board, const int width, const int height, const enum GeometryShift direction) {
+    const uint64_t rowMask = (1ULL << width) - 1;
+    uint64_t result = 0;
 
-    toRotate ^= k1 & (toRotate ^ _lrotr(toRotate,  8));
-    toRotate ^= k2 & (toRotate ^ _lrotr(toRotate, 16));
-    toRotate ^= k4 & (toRotate ^ _lrotr(toRotate, 32));
-    return toRotate;
-#else
-    // "Binary" method
-    uint64_t result, keptSame, changed;
+    for (int row = 0; row < height; row++) {
+        const int amount = (direction == GEOMETRY_BL || direction == GEOMETRY_BR)? height - 1 - row : row;
+        uint64_t bits = (board >> row*width) & rowMask;
 
-    keptSame = toRotate &            0xE1E1E1E1E1E1E1E1ULL;
-    changed = _rotl(toRotate, 32) & ~0xE1E1E1E1E1E1E1E1ULL;
-    result = keptSame | changed;
+        if (amount >= width) bits = 0;
+        else if (direction == GEOMETRY_BL || direction == GEOMETRY_TL) bits = (bits << amount) & rowMask;
+        else bits >>= amount;
 
-    keptSame = result &            0x9999999999999999ULL;
-    changed = _rotl(result, 16) & ~0x9999999999999999ULL;
-    result = keptSame | changed;
+        result |= bits << row*width;
+    }
+    return result;
+}
 
-    keptSame = result &           0x5555555555555555ULL;
-    changed = _rotl(result, 8) & ~0x5555555555555555ULL;
-    result = keptSame | changed;
+// By column, (\) starts at the bottom left & (/) at the bottom right
+uint8_t geometryExtract_naive(const uint64_t board, const int width, const int height, const int fwd) {
+    uint8_t result = 0;
+    for (int row = 0; row < height && row < width; row++) {
+        const int column = fwd? width - 1 - row : row;
+        if (board >> (row*width + column) & 1)
+            result |= 1 << column;
+    }
+    return result;
+}
 
+uint64_t geometryDeposit_naive(const uint8_t input, const int width, const int height, const int fwd) {
+    uint64_t result = 0;
+    for (int row = 0; row < height && row < width; row++) {
+        const int column = fwd? width - 1 - row : row;
+        if (input >> column & 1)
+            result |= 1ULL << (row*width + column);
+    }
     return result;
-#endif
 }
 
 
+// Row by row (and square by square) references of the wide boards, 'wideBoard16_*' & 'wideBoard32_*'
+#define WIDE_NAIVE(prefix, Board, Row) \
+    void prefix##_shift_naive(const Board *board, Board *result, const int width, const int height, const enum GeometryShift direction) { \
+        const uint64_t rowMask = (1ULL << width) - 1; \
+        Board shifted = {{0}}; \
+        for (int row = 0; row < height; row++) { \
+            const int amount = (direction == GEOMETRY_BL || direction == GEOMETRY_BR)? height - 1 - row : row; \
+            const uint64_t bits = board->rows[row] & rowMask; \
+            if (amount >= width) continue; \
+            shifted.rows[row] = (Row)((direction == GEOMETRY_BL || direction == GEOMETRY_TL)? (bits << amount) & rowMask : bits >> amount); \
+        } \
+        *result = shifted; \
+    } \
+    Row prefix##_extract_naive(const Board *board, const int width, const int height, const int fwd) { \
+        Row result = 0; \
+        for (int row = 0; row < height && row < width; row++) { \
+            const int column = fwd? width - 1 - row : row; \
+            if (board->rows[row] >> column & 1) \
+                result |= (Row)1 << column; \
+        } \
+        return result; \
+    } \
+    void prefix##_deposit_naive(const Row input, Board *result, const int width, const int height, const int fwd) { \
+        *result = (Board){{0}}; \
+        for (int row = 0; row < height && row < width; row++) { \
+            const int column = fwd? width - 1 - row : row; \
+            result->rows[row] = input & ((Row)1 << column); \
+        } \
+    } \
+    void prefix##_transpose_naive(const Board *board, Board *result, const int width, const int height) { \
+        Board transposed = {{0}}; \
+        for (int row = 0; row < height; row++) \
+            for (int column = 0; column < width; column++) \
+                if (board->rows[row] >> column & 1) \
+                    transposed.rows[column] |= (Row)1 << row; \
+        *result = transposed; \
+    }
 
-// Not a square (8x4)
-#define hex2d_as_u32(r3, r2, r1, r0) (0x ## r3 ## r2 ## r1 ## r0 ## U)
-uint32_t diagShift32_bin(const uint32_t toShift) {
-    uint32_t result, keptSame, changed;
+WIDE_NAIVE(wideBoard16, WideBoard16, uint16_t)
+WIDE_NAIVE(wideBoard32, WideBoard32, uint32_t)
 
-    keptSame = toShift &        hex2d_as_u32(F, F, 0, 0);
-    changed = (toShift << 2) &  hex2d_as_u32(0, 0, C, C);
-    result = keptSame | changed;
+// Square by square references for 'diagExtract_*' & 'diagDeposit_*' (diagonal 'k' is 'column - row' or 'column + row - 7')
+uint8_t diagExtract_back_naive(const uint64_t board, const int k) {
+    uint8_t result = 0;
+    for (int column = 0; column < 8; column++) {
+        const int row = column - k;
+        if (row >= 0 && row < 8 && (board >> (row*8 + column) & 1))
+            result |= 1 << column;
+    }
+    return result;
+}
 
-    keptSame = result &         hex2d_as_u32(F, 0, F, 0);
-    changed = (result << 1) &   hex2d_as_u32(0, E, 0, E);
-    result = keptSame | changed;
-    
+uint8_t diagExtract_fwd_naive(const uint64_t board, const int k) {
+    uint8_t result = 0;
+    for (int column = 0; column < 8; column++) {
+        const int row = 7 + k - column;
+        if (row >= 0 && row < 8 && (board >> (row*8 + column) & 1))
+            result |= 1 << (7 - column);
+    }
     return result;
 }
 
+uint64_t diagDeposit_back_naive(const uint8_t input, const int k) {
+    uint64_t result = 0;
+    for (int column = 0; column < 8; column++) {
+        const int row = column - k;
+        if (row >= 0 && row < 8 && (input >> column & 1))
+            result |= 1ULL << (row*8 + column);
+    }
+    return result;
+}
 
-int main() {
-    const uint64_t rising =  0x8040201008040201ULL;
-    const uint64_t falling = 0x0102040810204080ULL;
+uint64_t diagDeposit_fwd_naive(const uint8_t input, const int k) {
+    uint64_t result = 0;
+    for (int column = 0; column < 8; column++) {
+        const int row = 7 + k - column;
+        if (row >= 0 && row < 8 && (input >> (7 - column) & 1))
+            result |= 1ULL << (row*8 + column);
+    }
+    return result;
+}
 
-    //printf("0x%llX\n", antiClock_rot45(rising));
-    //printf("0x%llX\n", diagToHorizontal_fwd_SSE(falling));
-    //printf("0x%llX\n", diagShift_tr_SSE(UINT64_MAX));
-    printf("0x%llX\n", diagToHorizontal_fwd_SAD(falling));
+// Square by square: transpose (r, c) -> (c, r), then mirror (r, c) -> (r, 7 - c), then flip (r, c) -> (7 - r, c)
+uint64_t diagSymmetry_naive(const uint64_t board, const unsigned symmetry) {
+    uint64_t result = 0;
+    for (int row = 0; row < 8; row++) {
+        for (int column = 0; column < 8; column++) {
+            int r = row, c = column;
+            if (symmetry & 1) { const int t = r; r = c; c = t; }
+            if (symmetry & 2) c = 7 - c;
+            if (symmetry & 4) r = 7 - r;
+            result |= (board >> (row*8 + column) & 1) << (r*8 + c);
+        }
+    }
+    return result;
+}
 
+void diagSymmetries_naive(const uint64_t board, uint64_t images[8]) {
+    for (unsigned s=0; s < 8; s++)
+        images[s] = diagSymmetry_naive(board, s);
+}
 
-    // Performance messuring
-    enum PERF_SAMPLE {TOTAL_INTS = 20000};
+uint64_t diagCanonical_naive(const uint64_t board) {
+    uint64_t smallest = UINT64_MAX;
+    for (unsigned s=0; s < 8; s++)
+        if (diagSymmetry_naive(board, s) < smallest) smallest = diagSymmetry_naive(board, s);
+    return smallest;
+}
 
-    uint64_t rand_ints[TOTAL_INTS];
-    for (size_t i=0; i < TOTAL_INTS; i++)
-        rand_ints[i] = ((uint64_t)rand() << 32) | rand();
+// Brute force: each symmetry's planes compared to the best so far, the lowest symmetry wins a tie
+unsigned diagCanonicalPlanes_naive(const uint64_t *planes, const size_t count, uint64_t *out) {
+    unsigned best = 0;
+    for (unsigned s=1; s < 8; s++) {
+        for (size_t p=0; p < count; p++) {
+            const uint64_t image = diagSymmetry_naive(planes[p], s), smallest = diagSymmetry_naive(planes[p], best);
+            if (image != smallest) {
+                if (image < smallest) best = s;
+                break;
+            }
+        }
+    }
+    for (size_t p=0; p < count; p++)
+        out[p] = diagSymmetry_naive(planes[p], best);
+    return best;
+}
+
+void diagSymmetries_batch_naive(const uint64_t *in, uint64_t *out, size_t n) {
+    for (size_t i=0; i < n; i++)
+        for (unsigned s=0; s < 8; s++)
+            out[s*n + i] = diagSymmetry_naive(in[i], s);
+}
+
+
+// Square by square: (r, c) of the rotated board is ((r + c) & 7, c) of the board clockwise, ((r - c) & 7, c) anti-clockwise
+uint64_t diagRotate45_naive(const uint64_t board, const int clockwise) {
+    uint64_t result = 0;
+    for (int row = 0; row < 8; row++)
+        for (int column = 0; column < 8; column++) {
+            const int from = (clockwise? row + column : row - column) & 7;
+            result |= (board >> (from*8 + column) & 1) << (row*8 + column);
+        }
+    return result;
+}
+
+uint64_t diagRotate45_clockwise_naive(const uint64_t board) { return diagRotate45_naive(board, 1); }
+uint64_t diagRotate45_antiClock_naive(const uint64_t board) { return diagRotate45_naive(board, 0); }
+
+// Every square moved back from where 'rotated45_*Square' put it
+uint64_t diagUnrotate45_naive(const uint64_t rotated, const int clockwise) {
+    uint64_t result = 0;
+    for (unsigned square = 0; square < 64; square++) {
+        const unsigned from = clockwise? rotated45_clockwiseSquare(square) : rotated45_antiClockSquare(square);
+        result |= (rotated >> from & 1) << square;
+    }
+    return result;
+}
+
+uint64_t diagUnrotate45_clockwise_naive(const uint64_t rotated) { return diagUnrotate45_naive(rotated, 1); }
+uint64_t diagUnrotate45_antiClock_naive(const uint64_t rotated) { return diagUnrotate45_naive(rotated, 0); }
+
+void diagRotate45_clockwise_batch_naive(const uint64_t *in, uint64_t *out, size_t n) {
+    for (size_t i=0; i < n; i++) out[i] = diagRotate45_clockwise_naive(in[i]);
+}
+
+void diagRotate45_antiClock_batch_naive(const uint64_t *in, uint64_t *out, size_t n) {
+    for (size_t i=0; i < n; i++) out[i] = diagRotate45_antiClock_naive(in[i]);
+}
+
+// One mask & popcount per diagonal
+void diagPopcounts_back_naive(const uint64_t board, uint8_t out[15]) {
+    for (int d=0; d < 15; d++)
+        out[d] = (uint8_t)__builtin_popcountll(board & backDiagonals[d]);
+}
+
+void diagPopcounts_fwd_naive(const uint64_t board, uint8_t out[15]) {
+    for (int d=0; d < 15; d++)
+        out[d] = (uint8_t)__builtin_popcountll(board & fwdDiagonals[d]);
+}
+
+void diagPopcounts_back_batch_naive(const uint64_t *in, uint8_t *out, size_t n) {
+    for (size_t i=0; i < n; i++)
+        diagPopcounts_back_naive(in[i], out + 15*i);
+}
+
+void diagPopcounts_fwd_batch_naive(const uint64_t *in, uint8_t *out, size_t n) {
+    for (size_t i=0; i < n; i++)
+        diagPopcounts_fwd_naive(in[i], out + 15*i);
+}
+
+// Bit-by-bit reference for 'bitmapRotate'
+void bitmapRotate_naive(const uint8_t *src, size_t srcStride, uint8_t *dst, size_t dstStride, size_t width, size_t height, enum BitmapRotation rotation) {
+    for (size_t y=0; y < height; y++) {
+        for (size_t x=0; x < width; x++) {
+            if ( !((src[y*srcStride + x/8] >> (x%8)) & 1) ) continue;
+
+            size_t dstX, dstY;
+            switch (rotation) {
+                case BITMAP_TRANSPOSE:  dstX = y;            dstY = x;              break;
+                case BITMAP_ROT90:      dstX = height-1 - y; dstY = x;              break;
+                case BITMAP_ROT180:     dstX = width-1 - x;  dstY = height-1 - y;   break;
+                default:                dstX = y;            dstY = width-1 - x;    break;
+            }
+            dst[dstY*dstStride + dstX/8] |= 1 << (dstX%8);
+        }
+    }
+}
+
+double secondsSince(const struct timespec start) {
+    struct timespec end;
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    return (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) * 1e-9;
+}
+
+// Every rotation of a 'width' x 'height' bitmap of random bytes against the naive one. Returns the mismatches.
+// Untimed, the strides are padded by an odd number of bytes (nothing is aligned, the source's padding is random),
+// timed they are the row's bytes
+int benchmarkBitmapRotate(const size_t width, const size_t height, const unsigned threads, const int timed) {
+    const size_t srcStride = (width + 7) / 8 + (timed? 0 : 3);
+    uint8_t *src = malloc(srcStride * height);
+    for (size_t i=0; i < srcStride * height; i++)
+        src[i] = rand();
+
+    const char *NAMES[] = {"Transpose", "Rot 90", "Rot 180", "Rot 270"};
+    if (timed) printf("%zux%zu bitmap (%u threads):\n", width, height, threads);
+    int mismatches = 0;
+
+    for (int rotation=BITMAP_TRANSPOSE; rotation <= BITMAP_ROT270; rotation++) {
+        const size_t dstWidth = (rotation == BITMAP_ROT180)? width : height;
+        const size_t dstHeight = (rotation == BITMAP_ROT180)? height : width;
+        const size_t dstStride = (dstWidth + 7) / 8 + (timed? 0 : 5);
+        uint8_t *dst = calloc(dstStride * dstHeight, 1), *expected = calloc(dstStride * dstHeight, 1);
+        struct timespec start;
+
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        bitmapRotate_naive(src, srcStride, expected, dstStride, width, height, rotation);
+        const double naiveTime = secondsSince(start);
+
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        bitmapRotate(src, srcStride, dst, dstStride, width, height, rotation, threads);
+        const double tiledTime = secondsSince(start);
+
+        const int mismatch = memcmp(dst, expected, dstStride * dstHeight) != 0;
+        if (timed)
+            printf("\t%-10s naive: %7.4fs, tiled: %7.4fs %s\n", NAMES[rotation], naiveTime, tiledTime, mismatch? "(MISMATCH)" : "");
+        if (mismatch)
+            fprintf(stderr, "MISMATCH: bitmapRotate %s of %zux%zu (%u threads)\n", NAMES[rotation], width, height, threads);
+        mismatches += mismatch;
+        free(dst); free(expected);
+    }
+
+    free(src);
+    return mismatches;
+}
+
+// The edges first: partial tiles, non-square images & rows of blocks split between threads (512 pixels each, so the
+// tallest have 3), then 'side' x 'side' & a quarter of it timed. Exits with 1 on a mismatch
+int checkBitmapRotate(const size_t side) {
+    static const size_t SIZES[][2] = {{1, 1}, {13, 7}, {7, 13}, {100, 37}, {37, 100}, {64, 9}, {600, 520}, {77, 1100}, {1100, 1030}};
+    static const unsigned THREADS[] = {1, 2, 3, 5};
+    int mismatches = 0;
+
+    for (size_t s=0; s < sizeof(SIZES) / sizeof(SIZES[0]); s++)
+        for (size_t t=0; t < sizeof(THREADS) / sizeof(THREADS[0]); t++)
+            mismatches += benchmarkBitmapRotate(SIZES[s][0], SIZES[s][1], THREADS[t], 0);
+    printf("Edge cases: %d mismatches\n", mismatches);
+
+    mismatches += benchmarkBitmapRotate(side / 4, side / 4, 1, 1);
+    mismatches += benchmarkBitmapRotate(side, side, 1, 1);
+    mismatches += benchmarkBitmapRotate(side, side, 4, 1);
+    return mismatches? 1 : 0;
+}
+
+// ==================
+//       Inputs
+// ==================
+uint64_t splitmix64(uint64_t *state) {
+    uint64_t z = (*state += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+enum Distribution {DIST_UNIFORM, DIST_SPARSE};
+const char *DIST_NAMES[] = {"uniform", "sparse"};
+
+// Starting occupancy with a random share of the pieces captured, then a few of the rest moved to empty squares.
+// Ends up with 2-32 pieces, mostly near the back ranks, like the positions an engine sees.
+uint64_t randomPosition(uint64_t *state) {
+    uint64_t occupied = hex2d_as_u64(FF, FF, 00, 00, 00, 00, FF, FF);
+    const unsigned captureChance = splitmix64(state) % 90;
+
+    for (unsigned sq=0; sq < 64; sq++) {
+        if ((occupied >> sq & 1) && splitmix64(state) % 100 < captureChance)
+            occupied &= ~(1ULL << sq);
+    }
+
+    for (unsigned moves = splitmix64(state) % 12; moves > 0; moves--) {
+        const unsigned from = splitmix64(state) % 64, to = splitmix64(state) % 64;
+        if ((occupied >> from & 1) && !(occupied >> to & 1))
+            occupied ^= (1ULL << from) | (1ULL << to);
+    }
+
+    // Never empty, a king of each side remains
+    return occupied | (1ULL << 4) | (1ULL << 60);
+}
+
+// The u8 inputs are a random rank of each board
+void fillInputs(uint64_t *boards, uint8_t *ranks, const size_t n, const enum Distribution dist, uint64_t seed) {
+    for (size_t i=0; i < n; i++) {
+        boards[i] = (dist == DIST_SPARSE)? randomPosition(&seed) : splitmix64(&seed);
+        ranks[i] = boards[i] >> 8*(splitmix64(&seed) % 8);
+    }
+}
+
+
+// ==================
+//  Sliding attacks
+// ==================
+const int BISHOP_DIRECTIONS[4][2] = {{1, 1}, {1, -1}, {-1, 1}, {-1, -1}};
+const int ROOK_DIRECTIONS[4][2] = {{1, 0}, {-1, 0}, {0, 1}, {0, -1}};
+
+// Square by square along each ray, up to & including the first blocker
+uint64_t slidingAttacks_naive(const unsigned square, const uint64_t occupied, const int directions[4][2]) {
+    uint64_t attacks = 0;
+    for (int d=0; d < 4; d++) {
+        int row = square / 8 + directions[d][0], column = square % 8 + directions[d][1];
+        for (; row >= 0 && row < 8 && column >= 0 && column < 8; row += directions[d][0], column += directions[d][1]) {
+            attacks |= 1ULL << (row*8 + column);
+            if (occupied >> (row*8 + column) & 1) break;
+        }
+    }
+    return attacks;
+}
+
+uint64_t bishopAttacks_naive(const unsigned square, const uint64_t occupied) { return slidingAttacks_naive(square, occupied, BISHOP_DIRECTIONS); }
+uint64_t rookAttacks_naive(const unsigned square, const uint64_t occupied) { return slidingAttacks_naive(square, occupied, ROOK_DIRECTIONS); }
+uint64_t queenAttacks_naive(const unsigned square, const uint64_t occupied) { return bishopAttacks_naive(square, occupied) | rookAttacks_naive(square, occupied); }
+
+
+// "Fancy" magic bitboards, what the kindergarten attacks are compared against.
+// Each square's relevant occupancy (the edges never block) is hashed into its own slice of one shared table.
+typedef struct {
+    uint64_t mask, magic;
+    const uint64_t *attacks;
+    unsigned shift;
+} Magic;
+
+enum {BISHOP_MAGIC_ENTRIES = 5248, ROOK_MAGIC_ENTRIES = 102400};
+static uint64_t magicAttacks[BISHOP_MAGIC_ENTRIES + ROOK_MAGIC_ENTRIES];
+static Magic bishopMagics[64], rookMagics[64];
+
+// Random sparse candidates until every occupancy maps to a slot that is empty or has the same attacks
+size_t findMagics(Magic *magics, uint64_t *table, const int directions[4][2], uint64_t *seed) {
+    static uint64_t occupancies[4096], reference[4096];
+    static unsigned tried[4096];
+    unsigned attempt = 0;
+    size_t used = 0;
+
+    for (unsigned sq=0; sq < 64; sq++) {
+        const uint64_t edges = ((0xFFULL | 0xFFULL << 56) & ~(0xFFULL << (sq & ~7u)))
+            | ((FILE_A | FILE_A << 7) & ~(FILE_A << (sq & 7)));
+        Magic *m = &magics[sq];
+        m->mask = slidingAttacks_naive(sq, 0, directions) & ~edges;
+        m->shift = 64 - __builtin_popcountll(m->mask);
+        m->attacks = table + used;
+
+        // Every subset of the mask (carry rippler)
+        size_t count = 0;
+        uint64_t subset = 0;
+        do {
+            occupancies[count] = subset;
+            reference[count++] = slidingAttacks_naive(sq, subset, directions);
+            subset = (subset - m->mask) & m->mask;
+        } while (subset);
+
+        for (int found = 0; !found; ) {
+            m->magic = splitmix64(seed) & splitmix64(seed) & splitmix64(seed);
+            if (__builtin_popcountll((m->mask * m->magic) >> 56) < 6) continue;
+
+            attempt++;
+            found = 1;
+            for (size_t i=0; i < count && found; i++) {
+                const size_t idx = (occupancies[i] * m->magic) >> m->shift;
+                if (tried[idx] != attempt) {
+                    tried[idx] = attempt;
+                    table[used + idx] = reference[i];
+                } else if (table[used + idx] != reference[i])
+                    found = 0;
+            }
+        }
+        used += count;
+    }
+    return used;
+}
+
+void magicBitboards_init(void) {
+    uint64_t seed = 0x3A61C;
+    const size_t bishopEntries = findMagics(bishopMagics, magicAttacks, BISHOP_DIRECTIONS, &seed);
+    findMagics(rookMagics, magicAttacks + bishopEntries, ROOK_DIRECTIONS, &seed);
+}
+
+uint64_t bishopAttacks_magic(const unsigned square, const uint64_t occupied) {
+    const Magic *m = &bishopMagics[square];
+    return m->attacks[((occupied & m->mask) * m->magic) >> m->shift];
+}
+
+uint64_t rookAttacks_magic(const unsigned square, const uint64_t occupied) {
+    const Magic *m = &rookMagics[square];
+    return m->attacks[((occupied & m->mask) * m->magic) >> m->shift];
+}
+
+uint64_t queenAttacks_magic(const unsigned square, const uint64_t occupied) {
+    return bishopAttacks_magic(square, occupied) | rookAttacks_magic(square, occupied);
+}
+
+// Lookup tables each method touches, as that is what competes with the rest of a search for L1/L2
+void printAttackFootprint(void) {
+    printf("%-24s %10s\n", "Method", "Bytes");
+    printf("%-24s %10zu\n", "Kindergarten (all)", sizeof(firstRankAttacks) + sizeof(diagonalMasks));
+    printf("%-24s %10zu\n", "Magic bishop", BISHOP_MAGIC_ENTRIES * sizeof(uint64_t) + sizeof(bishopMagics));
+    printf("%-24s %10zu\n", "Magic rook", ROOK_MAGIC_ENTRIES * sizeof(uint64_t) + sizeof(rookMagics));
+    printf("%-24s %10zu\n", "Magic queen", sizeof(magicAttacks) + sizeof(bishopMagics) + sizeof(rookMagics));
+}
+
+
+
+// ==================
+//      Registry
+// ==================
+typedef struct {
+    const uint64_t *in64; const uint8_t *in8;
+    uint64_t *out64; uint8_t *out8;
+    size_t n;
+} BenchData;
+
+// Runs the kernel over every input 'rounds' times, returns something that depends on the results
+typedef uint64_t (*BenchLoop)(const BenchData *data, size_t rounds);
+
+enum Signature {U64_TO_U64, U64_TO_U8, U8_TO_U64};
+
+enum Requirement {
+    REQ_BMI2 = 1 << 0, REQ_PCLMUL = 1 << 1, REQ_AVX2 = 1 << 2, REQ_AVX512 = 1 << 3, REQ_GFNI = 1 << 4,
+    REQ_VBMI = 1 << 5, REQ_BITALG = 1 << 6, REQ_SSSE3 = 1 << 7
+};
+
+typedef struct {
+    const char *name;
+    const char *family;     // Every kernel in a family must give the same results
+    enum Signature signature;
+    unsigned requires;
+    BenchLoop latency;      // NULL for batched kernels
+    BenchLoop throughput;
+} Kernel;
+
+
+// Latency: the next input depends on the previous result (through a xor, which adds ~1 cycle).
+// Throughput: independent inputs, the empty asm keeps each result in a register so the loop isn't auto-vectorized.
+#define BENCH_U64_TO_U64(fn, target) \
+    target uint64_t latency_##fn(const BenchData *d, size_t rounds) { \
+        uint64_t acc = 0; \
+        for (size_t r=0; r < rounds; r++) \
+            for (size_t i=0; i < d->n; i++) acc = fn(d->in64[i] ^ acc); \
+        return acc; \
+    } \
+    target uint64_t throughput_##fn(const BenchData *d, size_t rounds) { \
+        for (size_t r=0; r < rounds; r++) \
+            for (size_t i=0; i < d->n; i++) { uint64_t res = fn(d->in64[i]); __asm__("" : "+r"(res)); d->out64[i] = res; } \
+        return d->out64[0]; \
+    }
+
+#define BENCH_U64_TO_U8(fn, target) \
+    target uint64_t latency_##fn(const BenchData *d, size_t rounds) { \
+        uint64_t acc = 0; \
+        for (size_t r=0; r < rounds; r++) \
+            for (size_t i=0; i < d->n; i++) acc = (uint8_t)fn(d->in64[i] ^ acc); \
+        return acc; \
+    } \
+    target uint64_t throughput_##fn(const BenchData *d, size_t rounds) { \
+        for (size_t r=0; r < rounds; r++) \
+            for (size_t i=0; i < d->n; i++) { uint64_t res = fn(d->in64[i]); __asm__("" : "+r"(res)); d->out8[i] = res; } \
+        return d->out8[0]; \
+    }
+
+#define BENCH_U8_TO_U64(fn, target) \
+    target uint64_t latency_##fn(const BenchData *d, size_t rounds) { \
+        uint64_t acc = 0; \
+        for (size_t r=0; r < rounds; r++) \
+            for (size_t i=0; i < d->n; i++) acc = fn((uint8_t)(d->in8[i] ^ acc)); \
+        return acc; \
+    } \
+    target uint64_t throughput_##fn(const BenchData *d, size_t rounds) { \
+        for (size_t r=0; r < rounds; r++) \
+            for (size_t i=0; i < d->n; i++) { uint64_t res = fn(d->in8[i]); __asm__("" : "+r"(res)); d->out64[i] = res; } \
+        return d->out64[0]; \
+    }
+
+#define BENCH_BATCH(fn, in, out) \
+    uint64_t throughput_##fn(const BenchData *d, size_t rounds) { \
+        for (size_t r=0; r < rounds; r++) \
+            fn(d->in, d->out, d->n); \
+        return d->out[0]; \
+    }
+
+#define NO_TARGET
+
+// Vector in & out
+uint64_t flipDiagA1H8_epi64_u64(uint64_t x) {
+    return _mm_cvtsi128_si64(flipDiagA1H8_epi64(_mm_cvtsi64_si128(x)));
+}
+
+BENCH_U64_TO_U64(diagShift_bl_lin, NO_TARGET)
+BENCH_U64_TO_U64(diagShift_bl_bin, NO_TARGET)
+BENCH_U64_TO_U64(diagShift_tl_bin, NO_TARGET)
+BENCH_U64_TO_U64(diagShift_br_bin, NO_TARGET)
+BENCH_U64_TO_U64(diagShift_tr_bin, NO_TARGET)
+BENCH_U64_TO_U64(diagShift_bl_SSE, NO_TARGET)
+BENCH_U64_TO_U64(diagShift_tl_SSE, NO_TARGET)
+BENCH_U64_TO_U64(diagShift_br_SSE, NO_TARGET)
+BENCH_U64_TO_U64(diagShift_tr_SSE, NO_TARGET)
+BENCH_U64_TO_U64(diagShift_bl_gfni, TARGET_GFNI)
+BENCH_U64_TO_U64(diagShift_tl_gfni, TARGET_GFNI)
+BENCH_U64_TO_U64(diagShift_br_gfni, TARGET_GFNI)
+BENCH_U64_TO_U64(diagShift_tr_gfni, TARGET_GFNI)
+BENCH_U64_TO_U64(diagShift_bl_vbmi, TARGET_VBMI)
+BENCH_U64_TO_U64(diagShift_tl_vbmi, TARGET_VBMI)
+BENCH_U64_TO_U64(diagShift_br_vbmi, TARGET_VBMI)
+BENCH_U64_TO_U64(diagShift_tr_vbmi, TARGET_VBMI)
+BENCH_U64_TO_U64(diagShift_bl_vec, NO_TARGET)
+BENCH_U64_TO_U64(diagShift_tl_vec, NO_TARGET)
+BENCH_U64_TO_U64(diagShift_br_vec, NO_TARGET)
+BENCH_U64_TO_U64(diagShift_tr_vec, NO_TARGET)
+
+BENCH_U64_TO_U8(diagToHorizontal_back_mul, NO_TARGET)
+BENCH_U64_TO_U8(diagToHorizontal_fwd_mul, NO_TARGET)
+BENCH_U64_TO_U8(diagToHorizontal_back_pext, TARGET_BMI2)
+BENCH_U64_TO_U8(diagToHorizontal_fwd_pext, TARGET_BMI2)
+BENCH_U64_TO_U8(diagToHorizontal_back_SSE, NO_TARGET)
+BENCH_U64_TO_U8(diagToHorizontal_back_SAD, NO_TARGET)
+BENCH_U64_TO_U8(diagToHorizontal_fwd_SSE, NO_TARGET)
+BENCH_U64_TO_U8(diagToHorizontal_fwd_SAD_ANTI, NO_TARGET)
+BENCH_U64_TO_U8(diagToHorizontal_fwd_SAD, NO_TARGET)
+BENCH_U64_TO_U8(diagToHorizontal_back_gfni, TARGET_GFNI)
+BENCH_U64_TO_U8(diagToHorizontal_fwd_gfni, TARGET_GFNI)
+BENCH_U64_TO_U8(diagToHorizontal_back_bitalg, TARGET_BITALG)
+BENCH_U64_TO_U8(diagToHorizontal_fwd_bitalg, TARGET_BITALG)
+BENCH_U64_TO_U8(diagToHorizontal_back_vec, NO_TARGET)
+BENCH_U64_TO_U8(diagToHorizontal_fwd_vec, NO_TARGET)
+
+BENCH_U8_TO_U64(toDiag_back_mul, NO_TARGET)
+BENCH_U8_TO_U64(toDiag_back_sse, NO_TARGET)
+BENCH_U8_TO_U64(toDiag_fwd_mul, NO_TARGET)
+BENCH_U8_TO_U64(toDiag_fwd_sse, NO_TARGET)
+BENCH_U8_TO_U64(toDiagonal_fwd_pdep, TARGET_BMI2)
+BENCH_U8_TO_U64(toVertical_mul, NO_TARGET)
+BENCH_U8_TO_U64(toVertical_sse, NO_TARGET)
+BENCH_U8_TO_U64(toVertical_bin, NO_TARGET)
+BENCH_U8_TO_U64(toVertical_clMul, TARGET_PCLMUL)
+BENCH_U8_TO_U64(toVertical_pdep, TARGET_BMI2)
+BENCH_U8_TO_U64(toDiag_fwd_gfni, TARGET_GFNI)
+BENCH_U8_TO_U64(toVertical_gfni, TARGET_GFNI)
+BENCH_U8_TO_U64(toDiag_back_avx512, TARGET_AVX512)
+BENCH_U8_TO_U64(toDiag_fwd_avx512, TARGET_AVX512)
+BENCH_U8_TO_U64(toVertical_avx512, TARGET_AVX512)
+BENCH_U8_TO_U64(toDiag_back_vec, NO_TARGET)
+BENCH_U8_TO_U64(toDiag_fwd_vec, NO_TARGET)
+BENCH_U8_TO_U64(toVertical_vec, NO_TARGET)
+
+BENCH_U64_TO_U64(flipDiagA1H8, NO_TARGET)
+BENCH_U64_TO_U64(flipDiagA1H8_epi64_u64, NO_TARGET)
+BENCH_U64_TO_U64(diagTranspose_sse, NO_TARGET)
+BENCH_U64_TO_U64(diagTranspose_avx2, TARGET_AVX2)
+BENCH_U64_TO_U64(diagTranspose_avx512, TARGET_AVX512)
+BENCH_U64_TO_U64(diagTranspose_gfni, TARGET_GFNI)
+BENCH_U64_TO_U64(diagTranspose_vec, NO_TARGET)
+
+#define ROTATE45_BENCH(direction) \
+    BENCH_U64_TO_U64(diagRotate45_##direction##_naive, NO_TARGET) \
+    BENCH_U64_TO_U64(diagRotate45_##direction##_bin, NO_TARGET) \
+    BENCH_U64_TO_U64(diagRotate45_##direction##_sse, NO_TARGET) \
+    BENCH_U64_TO_U64(diagRotate45_##direction##_avx512, TARGET_AVX512) \
+    BENCH_U64_TO_U64(diag_rotate45_##direction, NO_TARGET) \
+    BENCH_U64_TO_U64(diagUnrotate45_##direction##_naive, NO_TARGET) \
+    BENCH_U64_TO_U64(diag_unrotate45_##direction, NO_TARGET) \
+    BENCH_BATCH(diagRotate45_##direction##_batch_naive, in64, out64) \
+    BENCH_BATCH(diagRotate45_##direction##_batch_bin, in64, out64) \
+    BENCH_BATCH(diagRotate45_##direction##_batch_sse, in64, out64) \
+    TARGET_AVX2 BENCH_BATCH(diagRotate45_##direction##_batch_avx2, in64, out64) \
+    TARGET_AVX512 BENCH_BATCH(diagRotate45_##direction##_batch_avx512, in64, out64) \
+    BENCH_BATCH(diagRotate45_##direction##_batch_vec, in64, out64) \
+    BENCH_BATCH(diag_rotate45_##direction##_batch, in64, out64)
+
+ROTATE45_BENCH(clockwise)
+ROTATE45_BENCH(antiClock)
+
+// The input is the occupancy, the square comes from a hash of it (so it is part of the latency chain)
+#define ATTACKS_U64(fn, target) \
+    target uint64_t fn##_u64(uint64_t occupied) { return fn((unsigned)((occupied * 0x9E3779B97F4A7C15ULL) >> 58), occupied); } \
+    BENCH_U64_TO_U64(fn##_u64, target)
+
+ATTACKS_U64(bishopAttacks_naive, NO_TARGET)
+ATTACKS_U64(bishopAttacks_SAD, NO_TARGET)
+ATTACKS_U64(bishopAttacks_mul, NO_TARGET)
+ATTACKS_U64(bishopAttacks_pext, TARGET_BMI2)
+ATTACKS_U64(bishopAttacks_magic, NO_TARGET)
+ATTACKS_U64(rookAttacks_naive, NO_TARGET)
+ATTACKS_U64(rookAttacks_mul, NO_TARGET)
+ATTACKS_U64(rookAttacks_pext, TARGET_BMI2)
+ATTACKS_U64(rookAttacks_magic, NO_TARGET)
+ATTACKS_U64(queenAttacks_naive, NO_TARGET)
+ATTACKS_U64(queenAttacks_mul, NO_TARGET)
+ATTACKS_U64(queenAttacks_pext, TARGET_BMI2)
+ATTACKS_U64(queenAttacks_magic, NO_TARGET)
+
+// Every input on each of the 15 diagonals, so every 'k' sees all of them. The empty asm hides 'k' (the loop isn't
+// unrolled into 15 constant ones), the results are folded by an odd multiply so a single wrong one always shows
+#define ANY_DIAG_EXTRACT(fn, target) \
+    target uint8_t fn##_u64(uint64_t board) { \
+        uint8_t folded = 0; \
+        for (int k=-7; k <= 7; k++) { \
+            int hidden = k; \
+            __asm__("" : "+r"(hidden)); \
+            folded = (uint8_t)((folded ^ fn(board, hidden)) * 0x9Du); \
+        } \
+        return folded; \
+    } \
+    BENCH_U64_TO_U8(fn##_u64, target)
+#define ANY_DIAG_DEPOSIT(fn, target) \
+    target uint64_t fn##_u8(uint8_t input) { \
+        uint64_t folded = 0; \
+        for (int k=-7; k <= 7; k++) { \
+            int hidden = k; \
+            __asm__("" : "+r"(hidden)); \
+            folded = (folded ^ fn(input, hidden)) * 0x9E3779B97F4A7C15ULL; \
+        } \
+        return folded; \
+    } \
+    BENCH_U8_TO_U64(fn##_u8, target)
+
+// Read from the rotated board (the rotation included), the (/) bits reversed to the order of 'diagExtract_fwd'
+uint8_t diagExtract_back_rotated45(const uint64_t board, const int k) { return rotated45_back(diagRotate45_clockwise(board), k); }
+uint8_t diagExtract_fwd_rotated45(const uint64_t board, const int k) { return reverseBitsLUT[rotated45_fwd(diagRotate45_antiClock(board), k)]; }
+
+ANY_DIAG_EXTRACT(diagExtract_back_naive, NO_TARGET)
+ANY_DIAG_EXTRACT(diagExtract_back_SAD, NO_TARGET)
+ANY_DIAG_EXTRACT(diagExtract_back_mul, NO_TARGET)
+ANY_DIAG_EXTRACT(diagExtract_back_pext, TARGET_BMI2)
+ANY_DIAG_EXTRACT(diagExtract_back_rotated45, NO_TARGET)
+ANY_DIAG_EXTRACT(diagExtract_fwd_naive, NO_TARGET)
+ANY_DIAG_EXTRACT(diagExtract_fwd_SAD, NO_TARGET)
+ANY_DIAG_EXTRACT(diagExtract_fwd_mul, NO_TARGET)
+ANY_DIAG_EXTRACT(diagExtract_fwd_pext, TARGET_BMI2)
+ANY_DIAG_EXTRACT(diagExtract_fwd_rotated45, NO_TARGET)
+ANY_DIAG_DEPOSIT(diagDeposit_back_naive, NO_TARGET)
+ANY_DIAG_DEPOSIT(diagDeposit_back_mul, NO_TARGET)
+ANY_DIAG_DEPOSIT(diagDeposit_back_sse, NO_TARGET)
+ANY_DIAG_DEPOSIT(diagDeposit_back_pdep, TARGET_BMI2)
+ANY_DIAG_DEPOSIT(diagDeposit_fwd_naive, NO_TARGET)
+ANY_DIAG_DEPOSIT(diagDeposit_fwd_mul, NO_TARGET)
+ANY_DIAG_DEPOSIT(diagDeposit_fwd_sse, NO_TARGET)
+ANY_DIAG_DEPOSIT(diagDeposit_fwd_pdep, TARGET_BMI2)
+
+// The generated kernels take the low 'W*H' bits of the input, the references only read those
+#define GEOMETRY_BENCH(name, W, H) \
+    uint64_t name##_shift_bl_naive(uint64_t board) { return geometryShift_naive(board, W, H, GEOMETRY_BL); } \
+    uint64_t name##_shift_tl_naive(uint64_t board) { return geometryShift_naive(board, W, H, GEOMETRY_TL); } \
+    uint64_t name##_shift_br_naive(uint64_t board) { return geometryShift_naive(board, W, H, GEOMETRY_BR); } \
+    uint64_t name##_shift_tr_naive(uint64_t board) { return geometryShift_naive(board, W, H, GEOMETRY_TR); } \
+    uint8_t name##_extract_back_naive(uint64_t board) { return geometryExtract_naive(board, W, H, 0); } \
+    uint8_t name##_extract_fwd_naive(uint64_t board) { return geometryExtract_naive(board, W, H, 1); } \
+    uint64_t name##_deposit_back_naive(uint8_t input) { return geometryDeposit_naive(input, W, H, 0); } \
+    uint64_t name##_deposit_fwd_naive(uint8_t input) { return geometryDeposit_naive(input, W, H, 1); } \
+    BENCH_U64_TO_U64(name##_shift_bl_naive, NO_TARGET) BENCH_U64_TO_U64(name##_shift_bl, NO_TARGET) \
+    BENCH_U64_TO_U64(name##_shift_tl_naive, NO_TARGET) BENCH_U64_TO_U64(name##_shift_tl, NO_TARGET) \
+    BENCH_U64_TO_U64(name##_shift_br_naive, NO_TARGET) BENCH_U64_TO_U64(name##_shift_br, NO_TARGET) \
+    BENCH_U64_TO_U64(name##_shift_tr_naive, NO_TARGET) BENCH_U64_TO_U64(name##_shift_tr, NO_TARGET) \
+    BENCH_U64_TO_U8(name##_extract_back_naive, NO_TARGET) BENCH_U64_TO_U8(name##_extract_back, NO_TARGET) \
+    BENCH_U64_TO_U8(name##_extract_fwd_naive, NO_TARGET) BENCH_U64_TO_U8(name##_extract_fwd, NO_TARGET) \
+    BENCH_U8_TO_U64(name##_deposit_back_naive, NO_TARGET) BENCH_U8_TO_U64(name##_deposit_back, NO_TARGET) \
+    BENCH_U8_TO_U64(name##_deposit_fwd_naive, NO_TARGET) BENCH_U8_TO_U64(name##_deposit_fwd, NO_TARGET)
+
+GEOMETRY_BENCH(board4x4, 4, 4)
+GEOMETRY_BENCH(board6x6, 6, 6)
+GEOMETRY_BENCH(board7x7, 7, 7)
+GEOMETRY_BENCH(board8x4, 8, 4)
+BENCH_U64_TO_U64(board8x4_shift_bl_SSE, NO_TARGET)
+BENCH_U64_TO_U64(board8x4_shift_tl_SSE, NO_TARGET)
+BENCH_U64_TO_U64(board8x4_shift_br_SSE, NO_TARGET)
+BENCH_U64_TO_U64(board8x4_shift_tr_SSE, NO_TARGET)
+BENCH_U64_TO_U64(board8x8_shift_bl, NO_TARGET)
+BENCH_U64_TO_U64(board8x8_shift_tl, NO_TARGET)
+BENCH_U64_TO_U64(board8x8_shift_br, NO_TARGET)
+BENCH_U64_TO_U64(board8x8_shift_tr, NO_TARGET)
+BENCH_U64_TO_U8(board8x8_extract_back, NO_TARGET)
+BENCH_U64_TO_U8(board8x8_extract_fwd, NO_TARGET)
+BENCH_U8_TO_U64(board8x8_deposit_back, NO_TARGET)
+
+// Every call is a board, read from (and written to) the word arrays in place: 'sizeof(Board) / 8' words each, the inputs
+// are reused ('main' aligns the arrays for the boards). Latency chains the shifts & transposes on their own result (they
+// don't depend on the data), and xors the previous result into row 0 of the next extract & deposit
+#define BENCH_WIDE(fn, Board, target) \
+    target uint64_t latency_##fn(const BenchData *d, size_t rounds) { \
+        Board acc = *(const Board*)d->in64; \
+        for (size_t r=0; r < rounds; r++) \
+            for (size_t i=0; i < d->n; i++) fn(&acc, &acc); \
+        return acc.rows[0]; \
+    } \
+    target uint64_t throughput_##fn(const BenchData *d, size_t rounds) { \
+        const size_t boards = d->n * sizeof(uint64_t) / sizeof(Board); \
+        const Board *in = (const Board*)d->in64; \
+        Board *out = (Board*)d->out64; \
+        for (size_t r=0; r < rounds; r++) \
+            for (size_t i=0, j=0; i < d->n; i++, j = (j + 1 == boards)? 0 : j + 1) \
+                fn(in + j, out + j); \
+        return out[0].rows[0]; \
+    }
+
+#define BENCH_WIDE_EXTRACT(fn, Board, target) \
+    target uint64_t latency_##fn(const BenchData *d, size_t rounds) { \
+        const size_t boards = d->n * sizeof(uint64_t) / sizeof(Board); \
+        const Board *in = (const Board*)d->in64; \
+        uint64_t acc = 0; \
+        for (size_t r=0; r < rounds; r++) \
+            for (size_t i=0, j=0; i < d->n; i++, j = (j + 1 == boards)? 0 : j + 1) { \
+                Board board = in[j]; \
+                board.rows[0] ^= acc; \
+                acc = fn(&board); \
+            } \
+        return acc; \
+    } \
+    target uint64_t throughput_##fn(const BenchData *d, size_t rounds) { \
+        const size_t boards = d->n * sizeof(uint64_t) / sizeof(Board); \
+        const Board *in = (const Board*)d->in64; \
+        for (size_t r=0; r < rounds; r++) \
+            for (size_t i=0, j=0; i < d->n; i++, j = (j + 1 == boards)? 0 : j + 1) { \
+                uint64_t res = fn(in + j); \
+                __asm__("" : "+r"(res)); \
+                d->out64[i] = res; \
+            } \
+        return d->out64[0]; \
+    }
+
+#define BENCH_WIDE_DEPOSIT(fn, Board, target) \
+    target uint64_t latency_##fn(const BenchData *d, size_t rounds) { \
+        Board acc = {{0}}; \
+        for (size_t r=0; r < rounds; r++) \
+            for (size_t i=0; i < d->n; i++) fn(d->in64[i] ^ acc.rows[0], &acc); \
+        return acc.rows[0]; \
+    } \
+    target uint64_t throughput_##fn(const BenchData *d, size_t rounds) { \
+        const size_t boards = d->n * sizeof(uint64_t) / sizeof(Board); \
+        Board *out = (Board*)d->out64; \
+        for (size_t r=0; r < rounds; r++) \
+            for (size_t i=0, j=0; i < d->n; i++, j = (j + 1 == boards)? 0 : j + 1) \
+                fn(d->in64[i], out + j); \
+        return out[0].rows[0]; \
+    }
+
+// Each operation of a wide board: the scalar reference, then the methods the row width has (they expand to nothing without one)
+#define WIDE_BENCH_OP(name, op, Board, bench, methods) \
+    bench(name##_##op##_naive, Board, NO_TARGET) \
+    bench(name##_##op, Board, NO_TARGET) \
+    methods(name, op, bench, Board)
+
+#define WIDE_METHODS_ALL(name, op, bench, Board) \
+    bench(name##_##op##_sse, Board, NO_TARGET) \
+    bench(name##_##op##_avx2, Board, TARGET_AVX2) \
+    bench(name##_##op##_avx512, Board, TARGET_AVX512) \
+    bench(name##_##op##_vec, Board, NO_TARGET)
+#define WIDE_METHODS_NO_AVX512(name, op, bench, Board) \
+    bench(name##_##op##_sse, Board, NO_TARGET) \
+    bench(name##_##op##_avx2, Board, TARGET_AVX2) \
+    bench(name##_##op##_vec, Board, NO_TARGET)
+#define WIDE_METHODS_NO_SSE(name, op, bench, Board) \
+    bench(name##_##op##_avx2, Board, TARGET_AVX2) \
+    bench(name##_##op##_avx512, Board, TARGET_AVX512) \
+    bench(name##_##op##_vec, Board, NO_TARGET)
+#define WIDE_METHODS_AVX2(name, op, bench, Board) \
+    bench(name##_##op##_avx2, Board, TARGET_AVX2) \
+    bench(name##_##op##_vec, Board, NO_TARGET)
+#define WIDE_METHODS_AVX512(name, op, bench, Board) \
+    bench(name##_##op##_avx512, Board, TARGET_AVX512) \
+    bench(name##_##op##_vec, Board, NO_TARGET)
+
+// The references of a W x H board, then its methods (16 or 32-bit rows)
+#define WIDE_BENCH_NAIVE(name, prefix, Board, Row, W, H) \
+    void name##_shift_bl_naive(const Board *board, Board *result) { prefix##_shift_naive(board, result, W, H, GEOMETRY_BL); } \
+    void name##_shift_tl_naive(const Board *board, Board *result) { prefix##_shift_naive(board, result, W, H, GEOMETRY_TL); } \
+    void name##_shift_br_naive(const Board *board, Board *result) { prefix##_shift_naive(board, result, W, H, GEOMETRY_BR); } \
+    void name##_shift_tr_naive(const Board *board, Board *result) { prefix##_shift_naive(board, result, W, H, GEOMETRY_TR); } \
+    Row name##_extract_back_naive(const Board *board) { return prefix##_extract_naive(board, W, H, 0); } \
+    Row name##_extract_fwd_naive(const Board *board) { return prefix##_extract_naive(board, W, H, 1); } \
+    void name##_deposit_back_naive(const Row input, Board *result) { prefix##_deposit_naive(input, result, W, H, 0); } \
+    void name##_deposit_fwd_naive(const Row input, Board *result) { prefix##_deposit_naive(input, result, W, H, 1); } \
+    void name##_transpose_naive(const Board *board, Board *result) { prefix##_transpose_naive(board, result, W, H); }
+
+#define WIDE_BENCH16(name, W, H) \
+    WIDE_BENCH_NAIVE(name, wideBoard16, WideBoard16, uint16_t, W, H) \
+    WIDE_BENCH_OP(name, shift_bl, WideBoard16, BENCH_WIDE, WIDE_METHODS_ALL) \
+    WIDE_BENCH_OP(name, shift_tl, WideBoard16, BENCH_WIDE, WIDE_METHODS_ALL) \
+    WIDE_BENCH_OP(name, shift_br, WideBoard16, BENCH_WIDE, WIDE_METHODS_ALL) \
+    WIDE_BENCH_OP(name, shift_tr, WideBoard16, BENCH_WIDE, WIDE_METHODS_ALL) \
+    WIDE_BENCH_OP(name, extract_back, WideBoard16, BENCH_WIDE_EXTRACT, WIDE_METHODS_ALL) \
+    WIDE_BENCH_OP(name, extract_fwd, WideBoard16, BENCH_WIDE_EXTRACT, WIDE_METHODS_ALL) \
+    WIDE_BENCH_OP(name, deposit_back, WideBoard16, BENCH_WIDE_DEPOSIT, WIDE_METHODS_NO_AVX512) \
+    WIDE_BENCH_OP(name, deposit_fwd, WideBoard16, BENCH_WIDE_DEPOSIT, WIDE_METHODS_NO_AVX512) \
+    WIDE_BENCH_OP(name, transpose, WideBoard16, BENCH_WIDE, WIDE_METHODS_ALL)
+
+#define WIDE_BENCH32(name, W, H) \
+    WIDE_BENCH_NAIVE(name, wideBoard32, WideBoard32, uint32_t, W, H) \
+    WIDE_BENCH_OP(name, shift_bl, WideBoard32, BENCH_WIDE, WIDE_METHODS_NO_SSE) \
+    WIDE_BENCH_OP(name, shift_tl, WideBoard32, BENCH_WIDE, WIDE_METHODS_NO_SSE) \
+    WIDE_BENCH_OP(name, shift_br, WideBoard32, BENCH_WIDE, WIDE_METHODS_NO_SSE) \
+    WIDE_BENCH_OP(name, shift_tr, WideBoard32, BENCH_WIDE, WIDE_METHODS_NO_SSE) \
+    WIDE_BENCH_OP(name, extract_back, WideBoard32, BENCH_WIDE_EXTRACT, WIDE_METHODS_NO_SSE) \
+    WIDE_BENCH_OP(name, extract_fwd, WideBoard32, BENCH_WIDE_EXTRACT, WIDE_METHODS_NO_SSE) \
+    WIDE_BENCH_OP(name, deposit_back, WideBoard32, BENCH_WIDE_DEPOSIT, WIDE_METHODS_AVX2) \
+    WIDE_BENCH_OP(name, deposit_fwd, WideBoard32, BENCH_WIDE_DEPOSIT, WIDE_METHODS_AVX2) \
+    WIDE_BENCH_OP(name, transpose, WideBoard32, BENCH_WIDE, WIDE_METHODS_AVX512)
+
+WIDE_BENCH16(board9x9, 9, 9)
+WIDE_BENCH16(board15x15, 15, 15)
+WIDE_BENCH32(board19x19, 19, 19)
+
+// Chains of kernels: the portable versions (reference), the single board SSE kernels one after the other (the board goes
+// back to a general purpose register between every step), then the same 'DIAG_PIPELINE' fused in the vector registers.
+// Main (\) diagonal to the 'a' file
+uint64_t chainDiagToFile_scalar(uint64_t board) { return toVertical_mul(diagToHorizontal_back_mul(board)); }
+uint64_t chainDiagToFile_sse(uint64_t board) { return toVertical_sse((uint8_t)diagToHorizontal_back_SAD(board)); }
+DIAG_PIPELINE(chainDiagToFile, diagToHorizontal_back, toVertical)
+
+// The lower (\) diagonals to columns, then to rows
+uint64_t chainDiagonalsToRanks_scalar(uint64_t board) { return flipDiagA1H8(diagShift_bl_bin(board)); }
+uint64_t chainDiagonalsToRanks_sse(uint64_t board) { return diagTranspose_sse(diagShift_bl_SSE(board)); }
+DIAG_PIPELINE(chainDiagonalsToRanks, diagShift_bl, diagTranspose)
+
+// Shift, extract, deposit & transpose
+uint64_t chainShiftToTranspose_scalar(uint64_t board) {
+    return flipDiagA1H8(toDiag_fwd_mul(diagToHorizontal_back_mul(diagShift_br_bin(board))));
+}
+uint64_t chainShiftToTranspose_sse(uint64_t board) {
+    return diagTranspose_sse(toDiag_fwd_sse((uint8_t)diagToHorizontal_back_SAD(diagShift_br_SSE(board))));
+}
+DIAG_PIPELINE(chainShiftToTranspose, diagShift_br, diagToHorizontal_back, toDiag_fwd, diagTranspose)
+
+#define CHAIN_BENCH(name) \
+    BENCH_U64_TO_U64(name##_scalar, NO_TARGET) \
+    BENCH_U64_TO_U64(name##_sse, NO_TARGET) \
+    BENCH_U64_TO_U64(name, NO_TARGET) \
+    BENCH_BATCH(name##_batch_sse, in64, out64) \
+    TARGET_AVX2 BENCH_BATCH(name##_batch_avx2, in64, out64)
+
+CHAIN_BENCH(chainDiagToFile)
+CHAIN_BENCH(chainDiagonalsToRanks)
+CHAIN_BENCH(chainShiftToTranspose)
+
+// The rotated boards set up from scratch (reference), and toggled a square at a time from an empty set
+uint64_t rotatedBoards_hash(const RotatedBoards *set) {
+    uint64_t hash = 0;
+    for (int v=0; v < ROTATED_VIEW_COUNT; v++)
+        hash = hash * 0x9E3779B97F4A7C15ULL + set->views[v];
+    return hash;
+}
+uint64_t rotatedViews_set(uint64_t board) { RotatedBoards set; rotatedBoards_set(&set, board); return rotatedBoards_hash(&set); }
+uint64_t rotatedViews_update(uint64_t board) { RotatedBoards set = {{0}}; rotatedBoards_update(&set, board); return rotatedBoards_hash(&set); }
+BENCH_U64_TO_U64(rotatedViews_set, NO_TARGET)
+BENCH_U64_TO_U64(rotatedViews_update, NO_TARGET)
+
+// The union of the attacks of 1 to 4 bishops, on squares hashed from the occupancy (they may coincide) & added to it:
+// square by square (the naive one is the reference), then setwise
+uint64_t setwiseSliders(const uint64_t occupied, const int count) {
+    const uint64_t hash = occupied * 0x9E3779B97F4A7C15ULL;
+    uint64_t sliders = 0;
+    for (int i=0; i < count; i++)
+        sliders |= 1ULL << (hash >> (58 - 6*i) & 63);
+    return sliders;
+}
+#define SETWISE_LOOP(name, count, attacks) \
+    uint64_t setwise##count##_##name(uint64_t occupied) { \
+        uint64_t sliders = setwiseSliders(occupied, count), result = 0; \
+        occupied |= sliders; \
+        for (; sliders; sliders &= sliders - 1) result |= attacks(__builtin_ctzll(sliders), occupied); \
+        return result; \
+    } \
+    BENCH_U64_TO_U64(setwise##count##_##name, NO_TARGET)
+#define SETWISE_FILL(name, count, method, target) \
+    target uint64_t setwise##count##_##name(uint64_t occupied) { \
+        const uint64_t sliders = setwiseSliders(occupied, count); \
+        return method(sliders, ~(occupied | sliders)); \
+    } \
+    BENCH_U64_TO_U64(setwise##count##_##name, target)
+#define SETWISE_BENCH(count) \
+    SETWISE_LOOP(naive, count, bishopAttacks_naive) \
+    SETWISE_LOOP(loop, count, bishopAttacks) \
+    SETWISE_FILL(bin, count, diagonalAttacksSetwise_bin, NO_TARGET) \
+    SETWISE_FILL(sse, count, diagonalAttacksSetwise_sse, NO_TARGET) \
+    SETWISE_FILL(avx2, count, diagonalAttacksSetwise_avx2, TARGET_AVX2) \
+    SETWISE_FILL(diag, count, diag_bishopAttacksSetwise, NO_TARGET)
+
+SETWISE_BENCH(1)
+SETWISE_BENCH(2)
+SETWISE_BENCH(3)
+SETWISE_BENCH(4)
+
+// Per-row shifts of -8 to 7 hashed from the board (-8 clears the row), then a fixed vector (9 & -9 clear theirs).
+// Every method of the fixed one against its linear version, the batches too. 'byteShiftConst_bl' is 'diagShift_bl'
+void byteShiftHashed(const uint64_t board, int8_t shifts[8]) {
+    const uint64_t hash = board * 0x9E3779B97F4A7C15ULL;
+    for (size_t r=0; r < 8; r++)
+        shifts[r] = (int8_t)(hash >> 8*r) >> 4;
+}
+static const int8_t byteShiftFixed[8] = {2, 1, -1, -2, 9, -9, 0, 3};
+#define BYTE_SHIFT_BENCH(method, target) \
+    target uint64_t byteShiftHashed_##method(uint64_t board) { \
+        int8_t shifts[8]; \
+        byteShiftHashed(board, shifts); \
+        return byteShiftVar_##method(board, shifts); \
+    } \
+    target uint64_t byteShiftFixed_##method(uint64_t board) { return byteShiftVar_##method(board, byteShiftFixed); } \
+    BENCH_U64_TO_U64(byteShiftHashed_##method, target) \
+    BENCH_U64_TO_U64(byteShiftFixed_##method, target)
+#define BYTE_SHIFT_BATCH(method, target) \
+    target void byteShiftFixed_batch_##method(const uint64_t *in, uint64_t *out, size_t n) { \
+        byteShiftVar_batch_##method(in, out, n, byteShiftFixed); \
+    } \
+    BENCH_BATCH(byteShiftFixed_batch_##method, in64, out64)
+
+BYTE_SHIFT_BENCH(lin, NO_TARGET)
+BYTE_SHIFT_BENCH(bin, NO_TARGET)
+BYTE_SHIFT_BENCH(sse, NO_TARGET)
+BYTE_SHIFT_BENCH(ssse3, TARGET_SSSE3)
+BYTE_SHIFT_BENCH(avx2, TARGET_AVX2)
+BYTE_SHIFT_BENCH(avx512, TARGET_AVX512)
+uint64_t byteShiftHashed_diag(uint64_t board) {
+    int8_t shifts[8];
+    byteShiftHashed(board, shifts);
+    return diag_byteShift(board, shifts);
+}
+uint64_t byteShiftFixed_const(uint64_t board) { return byteShiftConst(board, 2, 1, -1, -2, 9, -9, 0, 3); }
+uint64_t byteShiftFixed_diag(uint64_t board) { return diag_byteShift(board, byteShiftFixed); }
+uint64_t byteShiftConst_bl(uint64_t board) { return byteShiftConst(board, 7, 6, 5, 4, 3, 2, 1, 0); }
+BENCH_U64_TO_U64(byteShiftHashed_diag, NO_TARGET)
+BENCH_U64_TO_U64(byteShiftFixed_const, NO_TARGET)
+BENCH_U64_TO_U64(byteShiftFixed_diag, NO_TARGET)
+BENCH_U64_TO_U64(byteShiftConst_bl, NO_TARGET)
+
+BYTE_SHIFT_BATCH(bin, NO_TARGET)
+BYTE_SHIFT_BATCH(sse, NO_TARGET)
+BYTE_SHIFT_BATCH(avx2, TARGET_AVX2)
+BYTE_SHIFT_BATCH(avx512, TARGET_AVX512)
+void byteShiftFixed_batch_diag(const uint64_t *in, uint64_t *out, size_t n) { diag_byteShift_batch(in, out, n, byteShiftFixed); }
+BENCH_BATCH(byteShiftFixed_batch_diag, in64, out64)
+
+// Boolean matrix products: each board times itself rotated by 37 (as sparse as it is), & its transitive closure.
+// 64 nodes: the inputs as matrices of 64 tiles, each times the next one (the last times the first), or closed
+#define BOOL_MATRIX_BENCH(method, target) \
+    target uint64_t boolMatMul_##method##_rotated(uint64_t a) { return boolMatMul_##method(a, a << 37 | a >> 27); } \
+    BENCH_U64_TO_U64(boolMatMul_##method##_rotated, target) \
+    BENCH_U64_TO_U64(boolClosure_##method, target)
+#define BOOL_MATRIX64_BENCH(method, target) \
+    target void boolMatMul64_##method##_batch(const uint64_t *in, uint64_t *out, size_t n) { \
+        const size_t count = n / 64; \
+        for (size_t m=0; m < count; m++) \
+            boolMatMul64_##method(in + 64*m, in + 64*((m + 1) % count), out + 64*m); \
+        memset(out + 64*count, 0, (n - 64*count) * sizeof(uint64_t)); \
+    } \
+    target void boolClosure64_##method##_batch(const uint64_t *in, uint64_t *out, size_t n) { \
+        memcpy(out, in, n * sizeof(uint64_t)); \
+        for (size_t m=0; m < n / 64; m++) \
+            boolClosure64_##method(out + 64*m); \
+    } \
+    BENCH_BATCH(boolMatMul64_##method##_batch, in64, out64) \
+    BENCH_BATCH(boolClosure64_##method##_batch, in64, out64)
+
+BOOL_MATRIX_BENCH(naive, NO_TARGET)
+BOOL_MATRIX_BENCH(bin, NO_TARGET)
+BOOL_MATRIX_BENCH(sse, NO_TARGET)
+BOOL_MATRIX_BENCH(avx2, TARGET_AVX2)
+BOOL_MATRIX_BENCH(avx512, TARGET_AVX512)
+BOOL_MATRIX_BENCH(gfni, TARGET_GFNI)
+uint64_t boolMatMul_diag_rotated(uint64_t a) { return diag_boolMatMul(a, a << 37 | a >> 27); }
+BENCH_U64_TO_U64(boolMatMul_diag_rotated, NO_TARGET)
+BENCH_U64_TO_U64(diag_boolClosure, NO_TARGET)
+
+BOOL_MATRIX64_BENCH(naive, NO_TARGET)
+BOOL_MATRIX64_BENCH(bin, NO_TARGET)
+BOOL_MATRIX64_BENCH(sse, NO_TARGET)
+BOOL_MATRIX64_BENCH(avx2, TARGET_AVX2)
+BOOL_MATRIX64_BENCH(avx512, TARGET_AVX512)
+#define boolMatMul64_diag diag_boolMatMul64
+#define boolClosure64_diag diag_boolClosure64
+BOOL_MATRIX64_BENCH(diag, NO_TARGET)
+
+// Make & unmake of a move, as in a search, from the starting position: the views after the move (xored together, so
+// none is left out), then back. The move toggles the 2 squares of the input's low 12 bits.
+// The reference recomputes the views after the move & restores a copy, the others update them both ways.
+// The empty 'asm' is the search in between, so the compiler can't skip the stores of the make & unmake
+static RotatedBoards rotatedPosition; // The starting position's, set up in main
+#define ROTATED_MOVE_FROM(x)    ((unsigned)(x) & 63)
+#define ROTATED_MOVE_TO(x)      ((unsigned)((x) >> 6) & 63)
+
+uint64_t rotatedBoards_fold(const RotatedBoards *set) {
+    uint64_t fold = 0;
+    for (int v=0; v < ROTATED_VIEW_COUNT; v++)
+        fold ^= set->views[v];
+    return fold;
+}
+uint64_t rotatedMakeUnmake_recompute(uint64_t x) {
+    const RotatedBoards saved = rotatedPosition;
+    rotatedBoards_set(&rotatedPosition, saved.views[ROTATED_BOARD] ^ (1ULL << ROTATED_MOVE_FROM(x)) ^ (1ULL << ROTATED_MOVE_TO(x)));
+    const uint64_t fold = rotatedBoards_fold(&rotatedPosition);
+    __asm__ volatile("" ::: "memory");
+    rotatedPosition = saved;
+    return fold;
+}
+uint64_t rotatedMakeUnmake_move(uint64_t x) {
+    rotatedBoards_move(&rotatedPosition, ROTATED_MOVE_FROM(x), ROTATED_MOVE_TO(x));
+    const uint64_t fold = rotatedBoards_fold(&rotatedPosition);
+    __asm__ volatile("" ::: "memory");
+    rotatedBoards_move(&rotatedPosition, ROTATED_MOVE_FROM(x), ROTATED_MOVE_TO(x));
+    return fold;
+}
+uint64_t rotatedMakeUnmake_update(uint64_t x) {
+    const uint64_t changed = (1ULL << ROTATED_MOVE_FROM(x)) ^ (1ULL << ROTATED_MOVE_TO(x));
+    rotatedBoards_update(&rotatedPosition, changed);
+    const uint64_t fold = rotatedBoards_fold(&rotatedPosition);
+    __asm__ volatile("" ::: "memory");
+    rotatedBoards_update(&rotatedPosition, changed);
+    return fold;
+}
+BENCH_U64_TO_U64(rotatedMakeUnmake_recompute, NO_TARGET)
+BENCH_U64_TO_U64(rotatedMakeUnmake_move, NO_TARGET)
+BENCH_U64_TO_U64(rotatedMakeUnmake_update, NO_TARGET)
+
+// The 'diag_' API: the same kernels as above when inlined, a call each when built with DIAG_LIBRARY
+BENCH_U64_TO_U64(diag_shift_bl, NO_TARGET)
+BENCH_U64_TO_U8(diag_extract_back, NO_TARGET)
+BENCH_U8_TO_U64(diag_toDiag_fwd, NO_TARGET)
+BENCH_U8_TO_U64(diag_toVertical, NO_TARGET)
+BENCH_U64_TO_U64(diag_transpose, NO_TARGET)
+ATTACKS_U64(diag_bishopAttacks, NO_TARGET)
+BENCH_BATCH(diag_shift_bl_batch, in64, out64)
+BENCH_U64_TO_U64(diag_canonical, NO_TARGET)
+
+// The 8 images folded into one result (rotates & xors, ~4 cycles more), so a wrong or misplaced image is a mismatch
+#define SYMMETRIES_U64(fn, target) \
+    target uint64_t fn##_u64(const uint64_t board) { \
+        uint64_t images[8], folded = 0; \
+        fn(board, images); \
+        for (unsigned s=0; s < 8; s++) folded ^= (images[s] << 7*s) | (images[s] >> ((64 - 7*s) & 63)); \
+        return folded; \
+    } \
+    BENCH_U64_TO_U64(fn##_u64, target)
+
+// The batches make 8 outputs per input: only the first 'n / 8' inputs, so their 'n' outputs fit
+#define SYMMETRIES_BATCH(fn, target) \
+    target void fn##_eighth(const uint64_t *in, uint64_t *out, size_t n) { fn(in, out, n / 8); } \
+    target BENCH_BATCH(fn##_eighth, in64, out64)
+
+SYMMETRIES_U64(diagSymmetries_naive, NO_TARGET)
+SYMMETRIES_U64(diagSymmetries_bin, NO_TARGET)
+SYMMETRIES_U64(diagSymmetries_sse, NO_TARGET)
+SYMMETRIES_U64(diagSymmetries_avx2, TARGET_AVX2)
+SYMMETRIES_U64(diagSymmetries_avx512, TARGET_AVX512)
+SYMMETRIES_U64(diag_symmetries, NO_TARGET)
+BENCH_U64_TO_U64(diagCanonical_naive, NO_TARGET)
+BENCH_U64_TO_U64(diagCanonical_bin, NO_TARGET)
+BENCH_U64_TO_U64(diagCanonical_avx2, TARGET_AVX2)
+BENCH_U64_TO_U64(diagCanonical_avx512, TARGET_AVX512)
+// Positions of 1 to 3 planes made from the board, the symmetry & the planes out hashed together: a first plane that is
+// symmetric under the 180 degree rotation (ties to be decided by the next), & a single fully symmetric plane (every
+// symmetry ties). The images are the same for every method, only the canonical planes differ
+#define CANONICAL_PLANES_U64(fn) \
+    uint64_t fn##_hashed(const uint64_t board) { \
+        uint64_t images[8], symmetric = 0; \
+        diagSymmetries_bin(board, images); \
+        for (unsigned s=0; s < 8; s++) symmetric |= images[s]; \
+        const uint64_t positions[3][3] = { \
+            {board | images[6], board & 0x00FF00FF00FF00FFULL, board}, \
+            {symmetric}, \
+            {board, board >> 8}, \
+        }; \
+        static const size_t counts[3] = {3, 1, 2}; \
+        uint64_t hash = 0, out[3]; \
+        for (int position=0; position < 3; position++) { \
+            hash = (hash ^ fn(positions[position], counts[position], out)) * 0x9E3779B97F4A7C15ULL; \
+            for (size_t p=0; p < counts[position]; p++) \
+                hash = (hash ^ out[p]) * 0x9E3779B97F4A7C15ULL; \
+        } \
+        return hash; \
+    } \
+    BENCH_U64_TO_U64(fn##_hashed, NO_TARGET)
+
+CANONICAL_PLANES_U64(diagCanonicalPlanes_naive)
+CANONICAL_PLANES_U64(diagCanonicalPlanes)
+CANONICAL_PLANES_U64(diag_canonicalPlanes)
+SYMMETRIES_BATCH(diagSymmetries_batch_naive, NO_TARGET)
+SYMMETRIES_BATCH(diagSymmetries_batch_bin, NO_TARGET)
+SYMMETRIES_BATCH(diagSymmetries_batch_sse, NO_TARGET)
+SYMMETRIES_BATCH(diagSymmetries_batch_avx2, TARGET_AVX2)
+SYMMETRIES_BATCH(diagSymmetries_batch_avx512, TARGET_AVX512)
+SYMMETRIES_BATCH(diagSymmetries_batch_vec, NO_TARGET)
+SYMMETRIES_BATCH(diag_symmetries_batch, NO_TARGET)
+
+// The 15 counts folded into one result: each is at most 8, so counts 0-7 & 7-14 fit in the low & high nibbles
+#define POPCOUNTS_U64(fn, target) \
+    target uint64_t fn##_u64(const uint64_t board) { \
+        uint8_t counts[15]; \
+        fn(board, counts); \
+        uint64_t lower, upper; \
+        memcpy(&lower, counts, 8); \
+        memcpy(&upper, counts + 7, 8); \
+        return lower | upper << 4; \
+    } \
+    BENCH_U64_TO_U64(fn##_u64, target)
+
+// 15 output bytes per input: only the first 'n / 15' inputs, so their counts fit
+#define POPCOUNTS_BATCH(fn, target) \
+    target void fn##_fifteenth(const uint64_t *in, uint8_t *out, size_t n) { fn(in, out, n / 15); } \
+    target BENCH_BATCH(fn##_fifteenth, in64, out8)
+
+#define POPCOUNTS_KERNELS(orientation) \
+    POPCOUNTS_U64(diagPopcounts_##orientation##_naive, NO_TARGET) \
+    POPCOUNTS_U64(diagPopcounts_##orientation##_bin, NO_TARGET) \
+    POPCOUNTS_U64(diagPopcounts_##orientation##_sse, NO_TARGET) \
+    POPCOUNTS_U64(diagPopcounts_##orientation##_bitalg, TARGET_BITALG) \
+    POPCOUNTS_U64(diag_popcounts_##orientation, NO_TARGET) \
+    POPCOUNTS_BATCH(diagPopcounts_##orientation##_batch_naive, NO_TARGET) \
+    POPCOUNTS_BATCH(diagPopcounts_##orientation##_batch_bin, NO_TARGET) \
+    POPCOUNTS_BATCH(diagPopcounts_##orientation##_batch_sse, NO_TARGET) \
+    POPCOUNTS_BATCH(diagPopcounts_##orientation##_batch_avx2, TARGET_AVX2) \
+    POPCOUNTS_BATCH(diagPopcounts_##orientation##_batch_avx512, TARGET_AVX512) \
+    POPCOUNTS_BATCH(diagPopcounts_##orientation##_batch_bitalg, TARGET_BITALG) \
+    POPCOUNTS_BATCH(diagPopcounts_##orientation##_batch_vec, NO_TARGET) \
+    POPCOUNTS_BATCH(diag_popcounts_##orientation##_batch, NO_TARGET)
+
+POPCOUNTS_KERNELS(back)
+POPCOUNTS_KERNELS(fwd)
+
+
+// Every width of the batched kernels, instead of the one picked at compile time
+#define BATCH_VARIANTS(op, shape, core, ...) \
+    void op##_batch_sse(shape) { core##_sse(__VA_ARGS__); } \
+    TARGET_AVX2 void op##_batch_avx2(shape) { core##_avx2(__VA_ARGS__); } \
+    TARGET_AVX512 void op##_batch_avx512(shape) { core##_avx512(__VA_ARGS__); } \
+    TARGET_GFNI void op##_batch_gfni(shape) { core##_gfni(__VA_ARGS__); } \
+    TARGET_GFNI_AVX2 void op##_batch_gfni_avx2(shape) { core##_gfni_avx2(__VA_ARGS__); } \
+    TARGET_GFNI_AVX512 void op##_batch_gfni_avx512(shape) { core##_gfni_avx512(__VA_ARGS__); }
+
+#define SHAPE_U64_U64 const uint64_t *in, uint64_t *out, size_t n
+#define SHAPE_U64_U8  const uint64_t *in, uint8_t *out, size_t n
+#define SHAPE_U8_U64  const uint8_t *in, uint64_t *out, size_t n
+
+BATCH_VARIANTS(shift_bl, SHAPE_U64_U64, diagShift_batch_left, in, out, n, DIAG_SHIFT_BL_POWERS)
+BATCH_VARIANTS(shift_tl, SHAPE_U64_U64, diagShift_batch_left, in, out, n, DIAG_SHIFT_TL_POWERS)
+BATCH_VARIANTS(shift_br, SHAPE_U64_U64, diagShift_batch_right, in, out, n, DIAG_SHIFT_BR_POWERS)
+BATCH_VARIANTS(shift_tr, SHAPE_U64_U64, diagShift_batch_right, in, out, n, DIAG_SHIFT_TR_POWERS)
+BATCH_VARIANTS(extract_back, SHAPE_U64_U8, diagToHorizontal_batch, in, out, n, DIAG_SHIFT_BL_POWERS)
+BATCH_VARIANTS(extract_fwd, SHAPE_U64_U8, diagToHorizontal_batch, in, out, n, DIAG_SHIFT_TL_POWERS)
+BATCH_VARIANTS(toDiag_back, SHAPE_U8_U64, toBytes_batch, in, out, n, 0x8040201008040201ULL, 0)
+BATCH_VARIANTS(toDiag_fwd, SHAPE_U8_U64, toBytes_batch, in, out, n, 0x0102040810204080ULL, 1)
+BATCH_VARIANTS(toVertical, SHAPE_U8_U64, toBytes_batch, in, out, n, 0x0101010101010101ULL, 1)
+BATCH_VARIANTS(transpose, SHAPE_U64_U64, diagTranspose_batch, in, out, n)
+
+#define BENCH_BATCH_VARIANTS(op, in, out) \
+    BENCH_BATCH(op##_batch_sse, in, out) BENCH_BATCH(op##_batch_avx2, in, out) BENCH_BATCH(op##_batch_avx512, in, out) \
+    BENCH_BATCH(op##_batch_gfni, in, out) BENCH_BATCH(op##_batch_gfni_avx2, in, out) BENCH_BATCH(op##_batch_gfni_avx512, in, out)
+
+BENCH_BATCH_VARIANTS(shift_bl, in64, out64)
+BENCH_BATCH_VARIANTS(shift_tl, in64, out64)
+BENCH_BATCH_VARIANTS(shift_br, in64, out64)
+BENCH_BATCH_VARIANTS(shift_tr, in64, out64)
+BENCH_BATCH_VARIANTS(extract_back, in64, out8)
+BENCH_BATCH_VARIANTS(extract_fwd, in64, out8)
+BENCH_BATCH_VARIANTS(toDiag_back, in8, out64)
+BENCH_BATCH_VARIANTS(toDiag_fwd, in8, out64)
+BENCH_BATCH_VARIANTS(toVertical, in8, out64)
+BENCH_BATCH_VARIANTS(transpose, in64, out64)
+
+// VBMI shifts & BITALG extracts, 8 boards per iteration
+TARGET_VBMI void shift_bl_batch_vbmi(SHAPE_U64_U64) { diagShift_batch_left_vbmi(in, out, n, DIAG_SHIFT_BL_POWERS); }
+TARGET_VBMI void shift_tl_batch_vbmi(SHAPE_U64_U64) { diagShift_batch_left_vbmi(in, out, n, DIAG_SHIFT_TL_POWERS); }
+TARGET_VBMI void shift_br_batch_vbmi(SHAPE_U64_U64) { diagShift_batch_right_vbmi(in, out, n, DIAG_SHIFT_BR_POWERS); }
+TARGET_VBMI void shift_tr_batch_vbmi(SHAPE_U64_U64) { diagShift_batch_right_vbmi(in, out, n, DIAG_SHIFT_TR_POWERS); }
+TARGET_BITALG void extract_back_batch_bitalg(SHAPE_U64_U8) { diagToHorizontal_batch_bitalg(in, out, n, DIAG_SHIFT_BL_POWERS); }
+TARGET_BITALG void extract_fwd_batch_bitalg(SHAPE_U64_U8) { diagToHorizontal_batch_bitalg(in, out, n, DIAG_SHIFT_TL_POWERS); }
+
+BENCH_BATCH(shift_bl_batch_vbmi, in64, out64)
+BENCH_BATCH(shift_tl_batch_vbmi, in64, out64)
+BENCH_BATCH(shift_br_batch_vbmi, in64, out64)
+BENCH_BATCH(shift_tr_batch_vbmi, in64, out64)
+BENCH_BATCH(extract_back_batch_bitalg, in64, out8)
+BENCH_BATCH(extract_fwd_batch_bitalg, in64, out8)
+
+// Vector extension batches, 'DIAG_VECTOR_BOARDS' at a time
+BENCH_BATCH(diagShift_bl_batch_vec, in64, out64)
+BENCH_BATCH(diagShift_tl_batch_vec, in64, out64)
+BENCH_BATCH(diagShift_br_batch_vec, in64, out64)
+BENCH_BATCH(diagShift_tr_batch_vec, in64, out64)
+BENCH_BATCH(diagToHorizontal_back_batch_vec, in64, out8)
+BENCH_BATCH(diagToHorizontal_fwd_batch_vec, in64, out8)
+BENCH_BATCH(toDiag_back_batch_vec, in8, out64)
+BENCH_BATCH(toDiag_fwd_batch_vec, in8, out64)
+BENCH_BATCH(toVertical_batch_vec, in8, out64)
+BENCH_BATCH(diagTranspose_batch_vec, in64, out64)
+
+
+#define KERNEL(fn, family, signature, requires) {#fn, family, signature, requires, latency_##fn, throughput_##fn}
+#define BATCH_KERNEL(fn, family, signature) {#fn, family, signature, 0, NULL, throughput_##fn}
+#define BATCH_KERNELS(op, family, signature) \
+    {#op "_batch_sse", family, signature, 0, NULL, throughput_##op##_batch_sse}, \
+    {#op "_batch_avx2", family, signature, REQ_AVX2, NULL, throughput_##op##_batch_avx2}, \
+    {#op "_batch_avx512", family, signature, REQ_AVX512, NULL, throughput_##op##_batch_avx512}, \
+    {#op "_batch_gfni", family, signature, REQ_GFNI, NULL, throughput_##op##_batch_gfni}, \
+    {#op "_batch_gfni_avx2", family, signature, REQ_GFNI | REQ_AVX2, NULL, throughput_##op##_batch_gfni_avx2}, \
+    {#op "_batch_gfni_avx512", family, signature, REQ_GFNI | REQ_AVX512, NULL, throughput_##op##_batch_gfni_avx512}
+// Reference & generated kernel of a family, then any 'extra' kernels of the same family (e.g. the SSE shifts)
+#define GEOMETRY_PAIR(name, op, family, size, signature, ...) \
+    KERNEL(name##_##op##_naive, family "_" size, signature, 0), KERNEL(name##_##op, family "_" size, signature, 0), ##__VA_ARGS__
+// Wide boards: every output is compared as words, the extracts' as one per word
+#define WIDE_KERNEL(fn, family, requires) KERNEL(fn, family, U64_TO_U64, requires)
+#define WIDE_KERNELS_OP(name, op, size, ...) \
+    WIDE_KERNEL(name##_##op##_naive, "wide_" #op "_" size, 0), WIDE_KERNEL(name##_##op, "wide_" #op "_" size, 0), __VA_ARGS__
+#define WIDE_KERNELS_ALL(name, op, size) WIDE_KERNELS_OP(name, op, size, \
+    WIDE_KERNEL(name##_##op##_sse, "wide_" #op "_" size, 0), WIDE_KERNEL(name##_##op##_avx2, "wide_" #op "_" size, REQ_AVX2), \
+    WIDE_KERNEL(name##_##op##_avx512, "wide_" #op "_" size, REQ_AVX512), WIDE_KERNEL(name##_##op##_vec, "wide_" #op "_" size, 0))
+#define WIDE_KERNELS_NO_AVX512(name, op, size) WIDE_KERNELS_OP(name, op, size, \
+    WIDE_KERNEL(name##_##op##_sse, "wide_" #op "_" size, 0), WIDE_KERNEL(name##_##op##_avx2, "wide_" #op "_" size, REQ_AVX2), \
+    WIDE_KERNEL(name##_##op##_vec, "wide_" #op "_" size, 0))
+#define WIDE_KERNELS_NO_SSE(name, op, size) WIDE_KERNELS_OP(name, op, size, \
+    WIDE_KERNEL(name##_##op##_avx2, "wide_" #op "_" size, REQ_AVX2), WIDE_KERNEL(name##_##op##_avx512, "wide_" #op "_" size, REQ_AVX512), \
+    WIDE_KERNEL(name##_##op##_vec, "wide_" #op "_" size, 0))
+#define WIDE_KERNELS_AVX2(name, op, size) WIDE_KERNELS_OP(name, op, size, \
+    WIDE_KERNEL(name##_##op##_avx2, "wide_" #op "_" size, REQ_AVX2), WIDE_KERNEL(name##_##op##_vec, "wide_" #op "_" size, 0))
+#define WIDE_KERNELS_AVX512(name, op, size) WIDE_KERNELS_OP(name, op, size, \
+    WIDE_KERNEL(name##_##op##_avx512, "wide_" #op "_" size, REQ_AVX512), WIDE_KERNEL(name##_##op##_vec, "wide_" #op "_" size, 0))
+
+#define WIDE_KERNELS16(name, size) \
+    WIDE_KERNELS_ALL(name, shift_bl, size), WIDE_KERNELS_ALL(name, shift_tl, size), \
+    WIDE_KERNELS_ALL(name, shift_br, size), WIDE_KERNELS_ALL(name, shift_tr, size), \
+    WIDE_KERNELS_ALL(name, extract_back, size), WIDE_KERNELS_ALL(name, extract_fwd, size), \
+    WIDE_KERNELS_NO_AVX512(name, deposit_back, size), WIDE_KERNELS_NO_AVX512(name, deposit_fwd, size), \
+    WIDE_KERNELS_ALL(name, transpose, size)
+#define WIDE_KERNELS32(name, size) \
+    WIDE_KERNELS_NO_SSE(name, shift_bl, size), WIDE_KERNELS_NO_SSE(name, shift_tl, size), \
+    WIDE_KERNELS_NO_SSE(name, shift_br, size), WIDE_KERNELS_NO_SSE(name, shift_tr, size), \
+    WIDE_KERNELS_NO_SSE(name, extract_back, size), WIDE_KERNELS_NO_SSE(name, extract_fwd, size), \
+    WIDE_KERNELS_AVX2(name, deposit_back, size), WIDE_KERNELS_AVX2(name, deposit_fwd, size), \
+    WIDE_KERNELS_AVX512(name, transpose, size)
+#define GEOMETRY_KERNELS(name, size) \
+    GEOMETRY_PAIR(name, shift_bl, "shift_bl", size, U64_TO_U64), GEOMETRY_PAIR(name, shift_tl, "shift_tl", size, U64_TO_U64), \
+    GEOMETRY_PAIR(name, shift_br, "shift_br", size, U64_TO_U64), GEOMETRY_PAIR(name, shift_tr, "shift_tr", size, U64_TO_U64), \
+    GEOMETRY_PAIR(name, extract_back, "extract_back", size, U64_TO_U8), GEOMETRY_PAIR(name, extract_fwd, "extract_fwd", size, U64_TO_U8), \
+    GEOMETRY_PAIR(name, deposit_back, "toDiag_back", size, U8_TO_U64), GEOMETRY_PAIR(name, deposit_fwd, "toDiag_fwd", size, U8_TO_U64)
+
+#define CHAIN_KERNELS(name, family) \
+    KERNEL(name##_scalar, family, U64_TO_U64, 0), KERNEL(name##_sse, family, U64_TO_U64, 0), KERNEL(name, family, U64_TO_U64, 0), \
+    BATCH_KERNEL(name##_batch_sse, family, U64_TO_U64), \
+    {#name "_batch_avx2", family, U64_TO_U64, REQ_AVX2, NULL, throughput_##name##_batch_avx2}
+
+#define SETWISE_KERNELS(count, family) \
+    KERNEL(setwise##count##_naive, family, U64_TO_U64, 0), KERNEL(setwise##count##_loop, family, U64_TO_U64, 0), \
+    KERNEL(setwise##count##_bin, family, U64_TO_U64, 0), KERNEL(setwise##count##_sse, family, U64_TO_U64, 0), \
+    KERNEL(setwise##count##_avx2, family, U64_TO_U64, REQ_AVX2), KERNEL(setwise##count##_diag, family, U64_TO_U64, 0)
+
+#define BYTE_SHIFT_KERNELS(name, family) \
+    KERNEL(name##_lin, family, U64_TO_U64, 0), KERNEL(name##_bin, family, U64_TO_U64, 0), \
+    KERNEL(name##_sse, family, U64_TO_U64, 0), KERNEL(name##_ssse3, family, U64_TO_U64, REQ_SSSE3), \
+    KERNEL(name##_avx2, family, U64_TO_U64, REQ_AVX2), KERNEL(name##_avx512, family, U64_TO_U64, REQ_AVX512)
+
+#define BOOL_MATRIX_KERNELS(op, suffix, family) \
+    KERNEL(op##_naive##suffix, family, U64_TO_U64, 0), KERNEL(op##_bin##suffix, family, U64_TO_U64, 0), \
+    KERNEL(op##_sse##suffix, family, U64_TO_U64, 0), KERNEL(op##_avx2##suffix, family, U64_TO_U64, REQ_AVX2), \
+    KERNEL(op##_avx512##suffix, family, U64_TO_U64, REQ_AVX512), KERNEL(op##_gfni##suffix, family, U64_TO_U64, REQ_GFNI)
+#define BOOL_MATRIX64_KERNELS(op, family) \
+    BATCH_KERNEL(op##_naive_batch, family, U64_TO_U64), BATCH_KERNEL(op##_bin_batch, family, U64_TO_U64), \
+    BATCH_KERNEL(op##_sse_batch, family, U64_TO_U64), \
+    {#op "_avx2_batch", family, U64_TO_U64, REQ_AVX2, NULL, throughput_##op##_avx2_batch}, \
+    {#op "_avx512_batch", family, U64_TO_U64, REQ_AVX512, NULL, throughput_##op##_avx512_batch}, \
+    BATCH_KERNEL(op##_diag_batch, family, U64_TO_U64)
+
+#define POPCOUNTS_FAMILY(orientation) \
+    KERNEL(diagPopcounts_##orientation##_naive_u64, "popcounts_" #orientation, U64_TO_U64, 0), \
+    KERNEL(diagPopcounts_##orientation##_bin_u64, "popcounts_" #orientation, U64_TO_U64, 0), \
+    KERNEL(diagPopcounts_##orientation##_sse_u64, "popcounts_" #orientation, U64_TO_U64, 0), \
+    KERNEL(diagPopcounts_##orientation##_bitalg_u64, "popcounts_" #orientation, U64_TO_U64, REQ_BITALG), \
+    KERNEL(diag_popcounts_##orientation##_u64, "popcounts_" #orientation, U64_TO_U64, 0), \
+    BATCH_KERNEL(diagPopcounts_##orientation##_batch_naive_fifteenth, "popcounts_" #orientation "_batch", U64_TO_U8), \
+    BATCH_KERNEL(diagPopcounts_##orientation##_batch_bin_fifteenth, "popcounts_" #orientation "_batch", U64_TO_U8), \
+    BATCH_KERNEL(diagPopcounts_##orientation##_batch_sse_fifteenth, "popcounts_" #orientation "_batch", U64_TO_U8), \
+    {"diagPopcounts_" #orientation "_batch_avx2_fifteenth", "popcounts_" #orientation "_batch", U64_TO_U8, REQ_AVX2, NULL, \
+        throughput_diagPopcounts_##orientation##_batch_avx2_fifteenth}, \
+    {"diagPopcounts_" #orientation "_batch_avx512_fifteenth", "popcounts_" #orientation "_batch", U64_TO_U8, REQ_AVX512, NULL, \
+        throughput_diagPopcounts_##orientation##_batch_avx512_fifteenth}, \
+    {"diagPopcounts_" #orientation "_batch_bitalg_fifteenth", "popcounts_" #orientation "_batch", U64_TO_U8, REQ_BITALG, NULL, \
+        throughput_diagPopcounts_##orientation##_batch_bitalg_fifteenth}, \
+    BATCH_KERNEL(diagPopcounts_##orientation##_batch_vec_fifteenth, "popcounts_" #orientation "_batch", U64_TO_U8), \
+    BATCH_KERNEL(diag_popcounts_##orientation##_batch_fifteenth, "popcounts_" #orientation "_batch", U64_TO_U8)
+
+#define ROTATE45_KERNELS(direction) \
+    KERNEL(diagRotate45_##direction##_naive, "rotate45_" #direction, U64_TO_U64, 0), \
+    KERNEL(diagRotate45_##direction##_bin, "rotate45_" #direction, U64_TO_U64, 0), \
+    KERNEL(diagRotate45_##direction##_sse, "rotate45_" #direction, U64_TO_U64, 0), \
+    KERNEL(diagRotate45_##direction##_avx512, "rotate45_" #direction, U64_TO_U64, REQ_AVX512), \
+    KERNEL(diag_rotate45_##direction, "rotate45_" #direction, U64_TO_U64, 0), \
+    BATCH_KERNEL(diagRotate45_##direction##_batch_naive, "rotate45_" #direction, U64_TO_U64), \
+    BATCH_KERNEL(diagRotate45_##direction##_batch_bin, "rotate45_" #direction, U64_TO_U64), \
+    BATCH_KERNEL(diagRotate45_##direction##_batch_sse, "rotate45_" #direction, U64_TO_U64), \
+    {"diagRotate45_" #direction "_batch_avx2", "rotate45_" #direction, U64_TO_U64, REQ_AVX2, NULL, throughput_diagRotate45_##direction##_batch_avx2}, \
+    {"diagRotate45_" #direction "_batch_avx512", "rotate45_" #direction, U64_TO_U64, REQ_AVX512, NULL, throughput_diagRotate45_##direction##_batch_avx512}, \
+    BATCH_KERNEL(diagRotate45_##direction##_batch_vec, "rotate45_" #direction, U64_TO_U64), \
+    BATCH_KERNEL(diag_rotate45_##direction##_batch, "rotate45_" #direction, U64_TO_U64), \
+    KERNEL(diagUnrotate45_##direction##_naive, "unrotate45_" #direction, U64_TO_U64, 0), \
+    KERNEL(diag_unrotate45_##direction, "unrotate45_" #direction, U64_TO_U64, 0)
+
+// The first of each family is the reference the others are checked against
+const Kernel KERNELS[] = {
+    KERNEL(diagShift_bl_lin, "shift_bl", U64_TO_U64, 0),
+    KERNEL(diagShift_bl_bin, "shift_bl", U64_TO_U64, 0),
+    KERNEL(board8x8_shift_bl, "shift_bl", U64_TO_U64, 0),
+    KERNEL(diagShift_bl_SSE, "shift_bl", U64_TO_U64, 0),
+    KERNEL(diagShift_bl_gfni, "shift_bl", U64_TO_U64, REQ_GFNI),
+    KERNEL(diagShift_bl_vbmi, "shift_bl", U64_TO_U64, REQ_VBMI),
+    KERNEL(diagShift_bl_vec, "shift_bl", U64_TO_U64, 0),
+    KERNEL(byteShiftConst_bl, "shift_bl", U64_TO_U64, 0),
+    BATCH_KERNELS(shift_bl, "shift_bl", U64_TO_U64),
+    {"shift_bl_batch_vbmi", "shift_bl", U64_TO_U64, REQ_VBMI, NULL, throughput_shift_bl_batch_vbmi},
+    BATCH_KERNEL(diagShift_bl_batch_vec, "shift_bl", U64_TO_U64),
+    KERNEL(diag_shift_bl, "shift_bl", U64_TO_U64, 0),
+    BATCH_KERNEL(diag_shift_bl_batch, "shift_bl", U64_TO_U64),
+    KERNEL(diagShift_tl_bin, "shift_tl", U64_TO_U64, 0),
+    KERNEL(board8x8_shift_tl, "shift_tl", U64_TO_U64, 0),
+    KERNEL(diagShift_tl_SSE, "shift_tl", U64_TO_U64, 0),
+    KERNEL(diagShift_tl_gfni, "shift_tl", U64_TO_U64, REQ_GFNI),
+    KERNEL(diagShift_tl_vbmi, "shift_tl", U64_TO_U64, REQ_VBMI),
+    KERNEL(diagShift_tl_vec, "shift_tl", U64_TO_U64, 0),
+    BATCH_KERNELS(shift_tl, "shift_tl", U64_TO_U64),
+    {"shift_tl_batch_vbmi", "shift_tl", U64_TO_U64, REQ_VBMI, NULL, throughput_shift_tl_batch_vbmi},
+    BATCH_KERNEL(diagShift_tl_batch_vec, "shift_tl", U64_TO_U64),
+    KERNEL(diagShift_br_bin, "shift_br", U64_TO_U64, 0),
+    KERNEL(board8x8_shift_br, "shift_br", U64_TO_U64, 0),
+    KERNEL(diagShift_br_SSE, "shift_br", U64_TO_U64, 0),
+    KERNEL(diagShift_br_gfni, "shift_br", U64_TO_U64, REQ_GFNI),
+    KERNEL(diagShift_br_vbmi, "shift_br", U64_TO_U64, REQ_VBMI),
+    KERNEL(diagShift_br_vec, "shift_br", U64_TO_U64, 0),
+    BATCH_KERNELS(shift_br, "shift_br", U64_TO_U64),
+    {"shift_br_batch_vbmi", "shift_br", U64_TO_U64, REQ_VBMI, NULL, throughput_shift_br_batch_vbmi},
+    BATCH_KERNEL(diagShift_br_batch_vec, "shift_br", U64_TO_U64),
+    KERNEL(diagShift_tr_bin, "shift_tr", U64_TO_U64, 0),
+    KERNEL(board8x8_shift_tr, "shift_tr", U64_TO_U64, 0),
+    KERNEL(diagShift_tr_SSE, "shift_tr", U64_TO_U64, 0),
+    KERNEL(diagShift_tr_gfni, "shift_tr", U64_TO_U64, REQ_GFNI),
+    KERNEL(diagShift_tr_vbmi, "shift_tr", U64_TO_U64, REQ_VBMI),
+    KERNEL(diagShift_tr_vec, "shift_tr", U64_TO_U64, 0),
+    BATCH_KERNELS(shift_tr, "shift_tr", U64_TO_U64),
+    {"shift_tr_batch_vbmi", "shift_tr", U64_TO_U64, REQ_VBMI, NULL, throughput_shift_tr_batch_vbmi},
+    BATCH_KERNEL(diagShift_tr_batch_vec, "shift_tr", U64_TO_U64),
+
+    KERNEL(diagToHorizontal_back_SAD, "extract_back", U64_TO_U8, 0),
+    KERNEL(diagToHorizontal_back_SSE, "extract_back", U64_TO_U8, 0),
+    KERNEL(diagToHorizontal_back_mul, "extract_back", U64_TO_U8, 0),
+    KERNEL(diagToHorizontal_back_pext, "extract_back", U64_TO_U8, REQ_BMI2),
+    KERNEL(diagToHorizontal_back_gfni, "extract_back", U64_TO_U8, REQ_GFNI),
+    KERNEL(diagToHorizontal_back_bitalg, "extract_back", U64_TO_U8, REQ_BITALG),
+    KERNEL(board8x8_extract_back, "extract_back", U64_TO_U8, 0),
+    KERNEL(diagToHorizontal_back_vec, "extract_back", U64_TO_U8, 0),
+    BATCH_KERNELS(extract_back, "extract_back", U64_TO_U8),
+    {"extract_back_batch_bitalg", "extract_back", U64_TO_U8, REQ_BITALG, NULL, throughput_extract_back_batch_bitalg},
+    BATCH_KERNEL(diagToHorizontal_back_batch_vec, "extract_back", U64_TO_U8),
+    KERNEL(diag_extract_back, "extract_back", U64_TO_U8, 0),
+    KERNEL(diagToHorizontal_fwd_SAD, "extract_fwd", U64_TO_U8, 0),
+    KERNEL(diagToHorizontal_fwd_SSE, "extract_fwd", U64_TO_U8, 0),
+    KERNEL(diagToHorizontal_fwd_mul, "extract_fwd", U64_TO_U8, 0),
+    KERNEL(diagToHorizontal_fwd_pext, "extract_fwd", U64_TO_U8, REQ_BMI2),
+    KERNEL(diagToHorizontal_fwd_gfni, "extract_fwd", U64_TO_U8, REQ_GFNI),
+    KERNEL(diagToHorizontal_fwd_bitalg, "extract_fwd", U64_TO_U8, REQ_BITALG),
+    KERNEL(diagToHorizontal_fwd_vec, "extract_fwd", U64_TO_U8, 0),
+    BATCH_KERNELS(extract_fwd, "extract_fwd", U64_TO_U8),
+    {"extract_fwd_batch_bitalg", "extract_fwd", U64_TO_U8, REQ_BITALG, NULL, throughput_extract_fwd_batch_bitalg},
+    BATCH_KERNEL(diagToHorizontal_fwd_batch_vec, "extract_fwd", U64_TO_U8),
+    KERNEL(diagToHorizontal_fwd_SAD_ANTI, "extract_fwd_reversed", U64_TO_U8, 0),
+    KERNEL(board8x8_extract_fwd, "extract_fwd_reversed", U64_TO_U8, 0),
+    KERNEL(diagExtract_back_naive_u64, "extract_back_any", U64_TO_U8, 0),
+    KERNEL(diagExtract_back_SAD_u64, "extract_back_any", U64_TO_U8, 0),
+    KERNEL(diagExtract_back_mul_u64, "extract_back_any", U64_TO_U8, 0),
+    KERNEL(diagExtract_back_pext_u64, "extract_back_any", U64_TO_U8, REQ_BMI2),
+    KERNEL(diagExtract_back_rotated45_u64, "extract_back_any", U64_TO_U8, 0),
+    KERNEL(diagExtract_fwd_naive_u64, "extract_fwd_any", U64_TO_U8, 0),
+    KERNEL(diagExtract_fwd_SAD_u64, "extract_fwd_any", U64_TO_U8, 0),
+    KERNEL(diagExtract_fwd_mul_u64, "extract_fwd_any", U64_TO_U8, 0),
+    KERNEL(diagExtract_fwd_pext_u64, "extract_fwd_any", U64_TO_U8, REQ_BMI2),
+    KERNEL(diagExtract_fwd_rotated45_u64, "extract_fwd_any", U64_TO_U8, 0),
+
+    KERNEL(toDiag_back_mul, "toDiag_back", U8_TO_U64, 0),
+    KERNEL(toDiag_back_sse, "toDiag_back", U8_TO_U64, 0),
+    KERNEL(toDiag_back_avx512, "toDiag_back", U8_TO_U64, REQ_AVX512),
+    KERNEL(board8x8_deposit_back, "toDiag_back", U8_TO_U64, 0),
+    KERNEL(toDiag_back_vec, "toDiag_back", U8_TO_U64, 0),
+    BATCH_KERNELS(toDiag_back, "toDiag_back", U8_TO_U64),
+    BATCH_KERNEL(toDiag_back_batch_vec, "toDiag_back", U8_TO_U64),
+    KERNEL(toDiag_fwd_mul, "toDiag_fwd", U8_TO_U64, 0),
+    KERNEL(toDiag_fwd_sse, "toDiag_fwd", U8_TO_U64, 0),
+    KERNEL(toDiagonal_fwd_pdep, "toDiag_fwd", U8_TO_U64, REQ_BMI2),
+    KERNEL(toDiag_fwd_gfni, "toDiag_fwd", U8_TO_U64, REQ_GFNI),
+    KERNEL(toDiag_fwd_avx512, "toDiag_fwd", U8_TO_U64, REQ_AVX512),
+    KERNEL(toDiag_fwd_vec, "toDiag_fwd", U8_TO_U64, 0),
+    BATCH_KERNELS(toDiag_fwd, "toDiag_fwd", U8_TO_U64),
+    BATCH_KERNEL(toDiag_fwd_batch_vec, "toDiag_fwd", U8_TO_U64),
+    KERNEL(diag_toDiag_fwd, "toDiag_fwd", U8_TO_U64, 0),
+    KERNEL(diagDeposit_back_naive_u8, "toDiag_back_any", U8_TO_U64, 0),
+    KERNEL(diagDeposit_back_mul_u8, "toDiag_back_any", U8_TO_U64, 0),
+    KERNEL(diagDeposit_back_sse_u8, "toDiag_back_any", U8_TO_U64, 0),
+    KERNEL(diagDeposit_back_pdep_u8, "toDiag_back_any", U8_TO_U64, REQ_BMI2),
+    KERNEL(diagDeposit_fwd_naive_u8, "toDiag_fwd_any", U8_TO_U64, 0),
+    KERNEL(diagDeposit_fwd_mul_u8, "toDiag_fwd_any", U8_TO_U64, 0),
+    KERNEL(diagDeposit_fwd_sse_u8, "toDiag_fwd_any", U8_TO_U64, 0),
+    KERNEL(diagDeposit_fwd_pdep_u8, "toDiag_fwd_any", U8_TO_U64, REQ_BMI2),
+    KERNEL(toVertical_mul, "toVertical", U8_TO_U64, 0),
+    KERNEL(toVertical_bin, "toVertical", U8_TO_U64, 0),
+    KERNEL(toVertical_sse, "toVertical", U8_TO_U64, 0),
+    KERNEL(toVertical_clMul, "toVertical", U8_TO_U64, REQ_PCLMUL),
+    KERNEL(toVertical_pdep, "toVertical", U8_TO_U64, REQ_BMI2),
+    KERNEL(toVertical_gfni, "toVertical", U8_TO_U64, REQ_GFNI),
+    KERNEL(toVertical_avx512, "toVertical", U8_TO_U64, REQ_AVX512),
+    KERNEL(toVertical_vec, "toVertical", U8_TO_U64, 0),
+    BATCH_KERNELS(toVertical, "toVertical", U8_TO_U64),
+    BATCH_KERNEL(toVertical_batch_vec, "toVertical", U8_TO_U64),
+    KERNEL(diag_toVertical, "toVertical", U8_TO_U64, 0),
+
+    KERNEL(flipDiagA1H8, "transpose", U64_TO_U64, 0),
+    KERNEL(diagTranspose_sse, "transpose", U64_TO_U64, 0),
+    KERNEL(diagTranspose_avx2, "transpose", U64_TO_U64, REQ_AVX2),
+    KERNEL(diagTranspose_avx512, "transpose", U64_TO_U64, REQ_AVX512),
+    KERNEL(diagTranspose_gfni, "transpose", U64_TO_U64, REQ_GFNI),
+    KERNEL(diagTranspose_vec, "transpose", U64_TO_U64, 0),
+    BATCH_KERNELS(transpose, "transpose", U64_TO_U64),
+    BATCH_KERNEL(diagTranspose_batch_vec, "transpose", U64_TO_U64),
+    KERNEL(diag_transpose, "transpose", U64_TO_U64, 0),
+    KERNEL(flipDiagA1H8_epi64_u64, "flip_antiDiag", U64_TO_U64, 0),
+
+    ROTATE45_KERNELS(clockwise),
+    ROTATE45_KERNELS(antiClock),
+
+    KERNEL(diagSymmetries_naive_u64, "symmetries", U64_TO_U64, 0),
+    KERNEL(diagSymmetries_bin_u64, "symmetries", U64_TO_U64, 0),
+    KERNEL(diagSymmetries_sse_u64, "symmetries", U64_TO_U64, 0),
+    KERNEL(diagSymmetries_avx2_u64, "symmetries", U64_TO_U64, REQ_AVX2),
+    KERNEL(diagSymmetries_avx512_u64, "symmetries", U64_TO_U64, REQ_AVX512),
+    KERNEL(diag_symmetries_u64, "symmetries", U64_TO_U64, 0),
+    BATCH_KERNEL(diagSymmetries_batch_naive_eighth, "symmetries_batch", U64_TO_U64),
+    BATCH_KERNEL(diagSymmetries_batch_bin_eighth, "symmetries_batch", U64_TO_U64),
+    BATCH_KERNEL(diagSymmetries_batch_sse_eighth, "symmetries_batch", U64_TO_U64),
+    {"diagSymmetries_batch_avx2_eighth", "symmetries_batch", U64_TO_U64, REQ_AVX2, NULL, throughput_diagSymmetries_batch_avx2_eighth},
+    {"diagSymmetries_batch_avx512_eighth", "symmetries_batch", U64_TO_U64, REQ_AVX512, NULL, throughput_diagSymmetries_batch_avx512_eighth},
+    BATCH_KERNEL(diagSymmetries_batch_vec_eighth, "symmetries_batch", U64_TO_U64),
+    BATCH_KERNEL(diag_symmetries_batch_eighth, "symmetries_batch", U64_TO_U64),
+    KERNEL(diagCanonical_naive, "canonical", U64_TO_U64, 0),
+    KERNEL(diagCanonical_bin, "canonical", U64_TO_U64, 0),
+    KERNEL(diagCanonical_avx2, "canonical", U64_TO_U64, REQ_AVX2),
+    KERNEL(diagCanonical_avx512, "canonical", U64_TO_U64, REQ_AVX512),
+    KERNEL(diag_canonical, "canonical", U64_TO_U64, 0),
+    KERNEL(diagCanonicalPlanes_naive_hashed, "canonicalPlanes", U64_TO_U64, 0),
+    KERNEL(diagCanonicalPlanes_hashed, "canonicalPlanes", U64_TO_U64, 0),
+    KERNEL(diag_canonicalPlanes_hashed, "canonicalPlanes", U64_TO_U64, 0),
+
+    POPCOUNTS_FAMILY(back),
+    POPCOUNTS_FAMILY(fwd),
+
+    KERNEL(bishopAttacks_naive_u64, "bishop", U64_TO_U64, 0),
+    KERNEL(bishopAttacks_SAD_u64, "bishop", U64_TO_U64, 0),
+    KERNEL(bishopAttacks_mul_u64, "bishop", U64_TO_U64, 0),
+    KERNEL(bishopAttacks_pext_u64, "bishop", U64_TO_U64, REQ_BMI2),
+    KERNEL(bishopAttacks_magic_u64, "bishop", U64_TO_U64, 0),
+    KERNEL(diag_bishopAttacks_u64, "bishop", U64_TO_U64, 0),
+    KERNEL(rookAttacks_naive_u64, "rook", U64_TO_U64, 0),
+    KERNEL(rookAttacks_mul_u64, "rook", U64_TO_U64, 0),
+    KERNEL(rookAttacks_pext_u64, "rook", U64_TO_U64, REQ_BMI2),
+    KERNEL(rookAttacks_magic_u64, "rook", U64_TO_U64, 0),
+    KERNEL(queenAttacks_naive_u64, "queen", U64_TO_U64, 0),
+    KERNEL(queenAttacks_mul_u64, "queen", U64_TO_U64, 0),
+    KERNEL(queenAttacks_pext_u64, "queen", U64_TO_U64, REQ_BMI2),
+    KERNEL(queenAttacks_magic_u64, "queen", U64_TO_U64, 0),
+
+    GEOMETRY_KERNELS(board4x4, "4x4"),
+    GEOMETRY_KERNELS(board6x6, "6x6"),
+    GEOMETRY_KERNELS(board7x7, "7x7"),
+    GEOMETRY_PAIR(board8x4, shift_bl, "shift_bl", "8x4", U64_TO_U64, KERNEL(board8x4_shift_bl_SSE, "shift_bl_8x4", U64_TO_U64, 0)),
+    GEOMETRY_PAIR(board8x4, shift_tl, "shift_tl", "8x4", U64_TO_U64, KERNEL(board8x4_shift_tl_SSE, "shift_tl_8x4", U64_TO_U64, 0)),
+    GEOMETRY_PAIR(board8x4, shift_br, "shift_br", "8x4", U64_TO_U64, KERNEL(board8x4_shift_br_SSE, "shift_br_8x4", U64_TO_U64, 0)),
+    GEOMETRY_PAIR(board8x4, shift_tr, "shift_tr", "8x4", U64_TO_U64, KERNEL(board8x4_shift_tr_SSE, "shift_tr_8x4", U64_TO_U64, 0)),
+    GEOMETRY_PAIR(board8x4, extract_back, "extract_back", "8x4", U64_TO_U8),
+    GEOMETRY_PAIR(board8x4, extract_fwd, "extract_fwd", "8x4", U64_TO_U8),
+    GEOMETRY_PAIR(board8x4, deposit_back, "toDiag_back", "8x4", U8_TO_U64),
+    GEOMETRY_PAIR(board8x4, deposit_fwd, "toDiag_fwd", "8x4", U8_TO_U64),
+
+    WIDE_KERNELS16(board9x9, "9x9"),
+    WIDE_KERNELS16(board15x15, "15x15"),
+    WIDE_KERNELS32(board19x19, "19x19"),
+    CHAIN_KERNELS(chainDiagToFile, "chain_diagToFile"),
+    CHAIN_KERNELS(chainDiagonalsToRanks, "chain_diagonalsToRanks"),
+    CHAIN_KERNELS(chainShiftToTranspose, "chain_shiftToTranspose"),
+    KERNEL(rotatedViews_set, "rotated_views", U64_TO_U64, 0),
+    KERNEL(rotatedViews_update, "rotated_views", U64_TO_U64, 0),
+    KERNEL(rotatedMakeUnmake_recompute, "rotated_makeUnmake", U64_TO_U64, 0),
+    KERNEL(rotatedMakeUnmake_move, "rotated_makeUnmake", U64_TO_U64, 0),
+    KERNEL(rotatedMakeUnmake_update, "rotated_makeUnmake", U64_TO_U64, 0),
+    SETWISE_KERNELS(1, "setwise_1"),
+    SETWISE_KERNELS(2, "setwise_2"),
+    SETWISE_KERNELS(3, "setwise_3"),
+    SETWISE_KERNELS(4, "setwise_4"),
+    BYTE_SHIFT_KERNELS(byteShiftHashed, "byteShift_hashed"),
+    KERNEL(byteShiftHashed_diag, "byteShift_hashed", U64_TO_U64, 0),
+    BYTE_SHIFT_KERNELS(byteShiftFixed, "byteShift_fixed"),
+    KERNEL(byteShiftFixed_const, "byteShift_fixed", U64_TO_U64, 0),
+    KERNEL(byteShiftFixed_diag, "byteShift_fixed", U64_TO_U64, 0),
+    BATCH_KERNEL(byteShiftFixed_batch_bin, "byteShift_fixed", U64_TO_U64),
+    BATCH_KERNEL(byteShiftFixed_batch_sse, "byteShift_fixed", U64_TO_U64),
+    {"byteShiftFixed_batch_avx2", "byteShift_fixed", U64_TO_U64, REQ_AVX2, NULL, throughput_byteShiftFixed_batch_avx2},
+    {"byteShiftFixed_batch_avx512", "byteShift_fixed", U64_TO_U64, REQ_AVX512, NULL, throughput_byteShiftFixed_batch_avx512},
+    BATCH_KERNEL(byteShiftFixed_batch_diag, "byteShift_fixed", U64_TO_U64),
+    BOOL_MATRIX_KERNELS(boolMatMul, _rotated, "boolMatMul"),
+    KERNEL(boolMatMul_diag_rotated, "boolMatMul", U64_TO_U64, 0),
+    BOOL_MATRIX_KERNELS(boolClosure, , "boolClosure"),
+    KERNEL(diag_boolClosure, "boolClosure", U64_TO_U64, 0),
+    BOOL_MATRIX64_KERNELS(boolMatMul64, "boolMatMul64"),
+    BOOL_MATRIX64_KERNELS(boolClosure64, "boolClosure64"),
+};
+enum {KERNEL_COUNT = sizeof(KERNELS) / sizeof(KERNELS[0])};
+
+unsigned supportedRequirements(void) {
+    __builtin_cpu_init();
+    unsigned supported = 0;
+
+    if (__builtin_cpu_supports("bmi2"))     supported |= REQ_BMI2;
+    if (__builtin_cpu_supports("pclmul"))   supported |= REQ_PCLMUL;
+    if (__builtin_cpu_supports("ssse3"))    supported |= REQ_SSSE3;
+    if (__builtin_cpu_supports("avx2"))     supported |= REQ_AVX2;
+    if (__builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw") && __builtin_cpu_supports("avx512vl"))
+        supported |= REQ_AVX512;
+    if (__builtin_cpu_supports("gfni"))     supported |= REQ_GFNI;
+    if ((supported & REQ_AVX512) && __builtin_cpu_supports("avx512vbmi"))   supported |= REQ_VBMI;
+    if ((supported & REQ_AVX512) && __builtin_cpu_supports("avx512bitalg")) supported |= REQ_BITALG;
+
+    return supported;
+}
+
+// A single round with the outputs compared to the family's reference
+int matchesReference(const Kernel *kernel, const Kernel *reference, BenchData *data, uint64_t *expected64, uint8_t *expected8) {
+    reference->throughput(data, 1);
+    memcpy(expected64, data->out64, data->n * sizeof(uint64_t));
+    memcpy(expected8, data->out8, data->n);
+
+    kernel->throughput(data, 1);
+    return (kernel->signature == U64_TO_U8)
+        ? memcmp(expected8, data->out8, data->n) == 0
+        : memcmp(expected64, data->out64, data->n * sizeof(uint64_t)) == 0;
+}
+
+
+
+// ==================
+//      Measuring
+// ==================
+typedef struct {
+    double tscPerOp, nsPerOp;
+    double perOp[PERF_COUNTER_COUNT];   // Hardware counters per call, only those in 'counted'
+    unsigned counted;
+} Measurement;
+
+int compareDoubles(const void *a, const void *b) {
+    const double x = *(const double*)a, y = *(const double*)b;
+    return (x > y) - (x < y);
+}
+
+// Median of the repetitions, after the warmups are discarded.
+// rdtsc counts at the base frequency, not the core clock, so it is only equal to cycles without turbo.
+// The hardware counters (NULL, or none open, for only the timers) are read around the same repetitions, each with its own median
+Measurement measure(const BenchLoop loop, const BenchData *data, const size_t rounds, const int warmups, const int reps, const PerfCounters *counters) {
+    enum {MAX_REPS = 101};
+    double tsc[MAX_REPS], ns[MAX_REPS], counts[PERF_COUNTER_COUNT][MAX_REPS];
+    const double ops = (double)rounds * data->n;
+    unsigned counted = counters? ~0u : 0;
+    volatile uint64_t sink;
+
+    for (int w=0; w < warmups; w++)
+        sink = loop(data, rounds);
+
+    for (int rep=0; rep < reps; rep++) {
+        uint64_t values[PERF_COUNTER_COUNT];
+        struct timespec startTime, endTime;
+        if (counters) perfCounters_start(counters);
+        clock_gettime(CLOCK_MONOTONIC, &startTime);
+        _mm_lfence();
+        const uint64_t start = __rdtsc();
+        _mm_lfence();
+
+        sink = loop(data, rounds);
+
+        _mm_lfence();
+        const uint64_t end = __rdtsc();
+        clock_gettime(CLOCK_MONOTONIC, &endTime);
+        if (counters) counted &= perfCounters_stop(counters, values);
+
+        tsc[rep] = (end - start) / ops;
+        ns[rep] = ((endTime.tv_sec - startTime.tv_sec) * 1e9 + (endTime.tv_nsec - startTime.tv_nsec)) / ops;
+        for (int c=0; c < PERF_COUNTER_COUNT; c++)
+            counts[c][rep] = counters? values[c] / ops : 0;
+    }
+    (void)sink;
+
+    Measurement result = {0};
+    qsort(tsc, reps, sizeof(double), compareDoubles);
+    qsort(ns, reps, sizeof(double), compareDoubles);
+    result.tscPerOp = tsc[reps / 2];
+    result.nsPerOp = ns[reps / 2];
+
+    result.counted = counted & ((1u << PERF_COUNTER_COUNT) - 1);
+    for (int c=0; c < PERF_COUNTER_COUNT; c++) {
+        if (!(result.counted >> c & 1)) continue;
+        qsort(counts[c], reps, sizeof(double), compareDoubles);
+        result.perOp[c] = counts[c][reps / 2];
+    }
+    return result;
+}
+
+// Distribution of the cost of a call, in rdtsc ticks. A single call is shorter than the timer itself, so each sample
+// times 'HISTOGRAM_CALLS' consecutive ones (the same loop as 'measure', over a slice of the inputs), minus the cost of an empty sample.
+// Prints the percentiles, then the samples up to the 99th percentile in 'HISTOGRAM_BUCKETS' equal buckets
+enum {HISTOGRAM_CALLS = 32, HISTOGRAM_BUCKETS = 12};
+
+static inline uint64_t timerStart(void) {
+    _mm_lfence();
+    const uint64_t start = __rdtsc();
+    _mm_lfence();
+    return start;
+}
+
+static inline uint64_t timerEnd(void) {
+    unsigned int aux;
+    const uint64_t end = __rdtscp(&aux);
+    _mm_lfence();
+    return end;
+}
+
+void printLatencyHistogram(FILE *to, const char *title, const BenchLoop loop, const BenchData *data, const size_t rounds) {
+    const size_t slices = data->n / HISTOGRAM_CALLS, count = rounds * slices;
+    double *samples = malloc(count * sizeof(double));
+    if (!samples || count == 0) {
+        free(samples);
+        return;
+    }
+
+    double overhead = 1e30;
+    for (int i=0; i < 256; i++) {
+        const uint64_t start = timerStart();
+        const uint64_t end = timerEnd();
+        if (end - start < overhead) overhead = end - start;
+    }
+
+    volatile uint64_t sink;
+    for (size_t i=0; i < count; i++) {
+        const size_t offset = (i % slices) * HISTOGRAM_CALLS;
+        const BenchData slice = {data->in64 + offset, data->in8 + offset, data->out64 + offset, data->out8 + offset, HISTOGRAM_CALLS};
+
+        const uint64_t start = timerStart();
+        sink = loop(&slice, 1);
+        const uint64_t end = timerEnd();
+
+        const double perCall = ((double)(end - start) - overhead) / HISTOGRAM_CALLS;
+        samples[i] = perCall > 0? perCall : 0;
+    }
+    (void)sink;
+    qsort(samples, count, sizeof(double), compareDoubles);
+
+    const double low = samples[0], high = samples[count * 99 / 100];
+    const double width = (high > low)? (high - low) / HISTOGRAM_BUCKETS : 1;
+    size_t buckets[HISTOGRAM_BUCKETS + 1] = {0}, largest = 1; // The last one is above the 99th percentile
+    for (size_t i=0; i < count; i++) {
+        size_t b = (samples[i] - low) / width;
+        if (samples[i] > high) b = HISTOGRAM_BUCKETS;
+        else if (b >= HISTOGRAM_BUCKETS) b = HISTOGRAM_BUCKETS - 1;
+        buckets[b]++;
+    }
+    for (int b=0; b <= HISTOGRAM_BUCKETS; b++)
+        if (buckets[b] > largest) largest = buckets[b];
+
+    fprintf(to, "\n%s, TSC/call over %zu samples of %d calls: min %.2f, p50 %.2f, p90 %.2f, p99 %.2f, max %.2f\n", title, count, HISTOGRAM_CALLS,
+        low, samples[count / 2], samples[count * 9 / 10], high, samples[count - 1]);
+    for (int b=0; b <= HISTOGRAM_BUCKETS; b++) {
+        char bar[41];
+        const int length = buckets[b] * 40 / largest;
+        memset(bar, '#', length);
+        bar[length] = '\0';
+
+        if (b < HISTOGRAM_BUCKETS) fprintf(to, "  %8.2f  %-40s %zu\n", low + b * width, bar, buckets[b]);
+        else                       fprintf(to, "  %8s  %-40s %zu\n", "> p99", bar, buckets[b]);
+    }
+    free(samples);
+}
 
-    
-    volatile uint64_t result = 0;
-    clock_t start_t = clock();
 
-    for (size_t i=0; i< 1000000000LL; i++)
-        result = diagToHorizontal_fwd_SAD(rand_ints[i % TOTAL_INTS]);
 
-    clock_t end_t = clock();
+// ==================
+//      Reporting
+// ==================
+enum Mode {MODE_LATENCY, MODE_THROUGHPUT};
+const char *MODE_NAMES[] = {"latency", "throughput"};
 
-    printf("\t%llu\nSeconds to finish: %.2f\n", result, (float)(end_t-start_t) / CLOCKS_PER_SEC);
-}
\ No newline at end of file
+typedef struct {
+    const char *name, *family;
+    enum Mode mode;
+    enum Distribution dist;
+    Measurement result;
+} Result;
+
+enum Format {FORMAT_TABLE, FORMAT_CSV, FORMAT_JSON};
+
+// A hardware counter per call, or 'missing' when it wasn't counted
+const char *formatCounter(char *buffer, const size_t size, const Measurement *m, const int counter, const char *missing) {
+    if (!(m->counted >> counter & 1)) return missing;
+    snprintf(buffer, size, "%.3f", m->perOp[counter]);
+    return buffer;
+}
+
+// Instructions per cycle, from the hardware counters
+const char *formatIPC(char *buffer, const size_t size, const Measurement *m, const char *missing) {
+    const unsigned both = 1u << PERF_CYCLES | 1u << PERF_INSTRUCTIONS;
+    if ((m->counted & both) != both || m->perOp[PERF_CYCLES] <= 0) return missing;
+    snprintf(buffer, size, "%.2f", m->perOp[PERF_INSTRUCTIONS] / m->perOp[PERF_CYCLES]);
+    return buffer;
+}
+
+// 'withCounters' adds cycles, IPC, instructions, uops, branch & L1d misses per call (after the timings, so the CSV stays a valid baseline)
+void printResults(FILE *to, const Result *results, const size_t count, const enum Format format, const int withCounters) {
+    static const char *const CSV_COUNTERS[PERF_COUNTER_COUNT] = {"cycles", "instructions", "uops", "branch_misses", "l1d_misses"};
+
+    if (format == FORMAT_CSV) {
+        fprintf(to, "name,family,mode,distribution,tsc_per_op,ns_per_op");
+        if (withCounters) {
+            for (int c=0; c < PERF_COUNTER_COUNT; c++)
+                fprintf(to, ",%s_per_op", CSV_COUNTERS[c]);
+            fprintf(to, ",ipc");
+        }
+        fprintf(to, "\n");
+    } else if (format == FORMAT_JSON)
+        fprintf(to, "[\n");
+    else {
+        fprintf(to, "%-32s %-20s %-10s %-8s %10s %10s", "Name", "Family", "Mode", "Inputs", "TSC/op", "ns/op");
+        if (withCounters)
+            fprintf(to, " %10s %6s %10s %10s %10s %10s", "cycles/op", "IPC", "instr/op", "uops/op", "brmiss/op", "L1miss/op");
+        fprintf(to, "\n");
+    }
+
+    for (size_t i=0; i < count; i++) {
+        const Result *r = &results[i];
+        char counters[PERF_COUNTER_COUNT][32], ipc[32];
+
+        if (format == FORMAT_CSV) {
+            fprintf(to, "%s,%s,%s,%s,%.4f,%.4f", r->name, r->family, MODE_NAMES[r->mode], DIST_NAMES[r->dist], r->result.tscPerOp, r->result.nsPerOp);
+            if (withCounters) {
+                for (int c=0; c < PERF_COUNTER_COUNT; c++)
+                    fprintf(to, ",%s", formatCounter(counters[c], 32, &r->result, c, ""));
+                fprintf(to, ",%s", formatIPC(ipc, 32, &r->result, ""));
+            }
+            fprintf(to, "\n");
+        } else if (format == FORMAT_JSON) {
+            fprintf(to, "  {\"name\": \"%s\", \"family\": \"%s\", \"mode\": \"%s\", \"distribution\": \"%s\", \"tsc_per_op\": %.4f, \"ns_per_op\": %.4f",
+                r->name, r->family, MODE_NAMES[r->mode], DIST_NAMES[r->dist], r->result.tscPerOp, r->result.nsPerOp);
+            if (withCounters) {
+                for (int c=0; c < PERF_COUNTER_COUNT; c++)
+                    fprintf(to, ", \"%s_per_op\": %s", CSV_COUNTERS[c], formatCounter(counters[c], 32, &r->result, c, "null"));
+                fprintf(to, ", \"ipc\": %s", formatIPC(ipc, 32, &r->result, "null"));
+            }
+            fprintf(to, "}%s\n", (i + 1 < count)? "," : "");
+        } else {
+            fprintf(to, "%-32s %-20s %-10s %-8s %10.2f %10.3f", r->name, r->family, MODE_NAMES[r->mode], DIST_NAMES[r->dist], r->result.tscPerOp, r->result.nsPerOp);
+            if (withCounters)
+                fprintf(to, " %10s %6s %10s %10s %10s %10s", formatCounter(counters[PERF_CYCLES], 32, &r->result, PERF_CYCLES, "-"),
+                    formatIPC(ipc, 32, &r->result, "-"),
+                    formatCounter(counters[PERF_INSTRUCTIONS], 32, &r->result, PERF_INSTRUCTIONS, "-"),
+                    formatCounter(counters[PERF_UOPS], 32, &r->result, PERF_UOPS, "-"),
+                    formatCounter(counters[PERF_BRANCH_MISSES], 32, &r->result, PERF_BRANCH_MISSES, "-"),
+                    formatCounter(counters[PERF_L1D_MISSES], 32, &r->result, PERF_L1D_MISSES, "-"));
+            fprintf(to, "\n");
+        }
+    }
+
+    if (format == FORMAT_JSON)
+        fprintf(to, "]\n");
+}
+
+// Reads a CSV written by '--format csv', and flags every result that is slower by more than 'thresholdPercent'.
+// Returns the number of regressions, or -1 if the baseline couldn't be read.
+int compareToBaseline(const char *path, const Result *results, const size_t count, const double thresholdPercent) {
+    FILE *baseline = fopen(path, "r");
+    if (!baseline) {
+        perror(path);
+        return -1;
+    }
+
+    char line[256], name[64], family[32], mode[16], dist[16];
+    double oldTsc, oldNs;
+    int regressions = 0;
+
+    printf("\nCompared to '%s' (regression: > %.1f%% slower)\n", path, thresholdPercent);
+    while (fgets(line, sizeof(line), baseline)) {
+        if (sscanf(line, "%63[^,],%31[^,],%15[^,],%15[^,],%lf,%lf", name, family, mode, dist, &oldTsc, &oldNs) != 6)
+            continue; // Header
+
+        for (size_t i=0; i < count; i++) {
+            const Result *r = &results[i];
+            if (strcmp(r->name, name) || strcmp(MODE_NAMES[r->mode], mode) || strcmp(DIST_NAMES[r->dist], dist))
+                continue;
+
+            const double change = (r->result.tscPerOp / oldTsc - 1) * 100;
+            const int regressed = change > thresholdPercent;
+            regressions += regressed;
+
+            printf("%-32s %-10s %-8s %8.2f -> %8.2f (%+6.1f%%)%s\n", name, mode, dist, oldTsc, r->result.tscPerOp, change, regressed? "  REGRESSION" : "");
+        }
+    }
+
+    fclose(baseline);
+    return regressions;
+}
+
+
+// ==================
+//       Perft
+// ==================
+// Bishop attacks from the extract & deposit of any diagonal ('diagToHorizontal.h' & 'horizontalTo64.h').
+// (/) is packed from column 7 (bit 'i' is column '7 - i'), so the slider's index along it is '7 - column'
+#define BISHOP_FROM_DIAGONALS(extract, deposit, target) \
+    static inline target uint64_t bishopDiagonals_##extract##_##deposit(const unsigned square, const uint64_t occupied) { \
+        const int row = square >> 3, column = square & 7, back = column - row, fwd = column + row - 7; \
+        return diagDeposit_back_##deposit(firstRankAttacks[column][diagExtract_back_##extract(occupied, back)], back) \
+            | diagDeposit_fwd_##deposit(firstRankAttacks[7 - column][diagExtract_fwd_##extract(occupied, fwd)], fwd); \
+    }
+
+BISHOP_FROM_DIAGONALS(mul, mul, NO_TARGET)
+BISHOP_FROM_DIAGONALS(SAD, mul, NO_TARGET)
+BISHOP_FROM_DIAGONALS(SAD, sse, NO_TARGET)
+BISHOP_FROM_DIAGONALS(pext, pdep, TARGET_BMI2)
+
+// The rotated boards are made on every call, where an engine with rotated bitboards would keep them up to date
+DIAG_INLINE uint64_t bishopAttacks_rot45(const unsigned square, const uint64_t occupied) {
+    const int row = square >> 3, column = square & 7, back = column - row, fwd = column + row - 7;
+
+    const uint8_t backOccupied = rotated45_back(diagRotate45_clockwise(occupied), back);
+    const uint8_t fwdOccupied = rotated45_fwd(diagRotate45_antiClock(occupied), fwd);
+
+    return ((firstRankAttacks[column][backOccupied] * FILE_A) & backDiagonals[back + 7])
+        | ((firstRankAttacks[column][fwdOccupied] * FILE_A) & fwdDiagonals[fwd + 7]);
+}
+
+// Only the diagonal sliders change, the rooks are always 'rookAttacks_mul'
+PERFT(bishopAttacks_magic, bishopAttacks_magic, rookAttacks_mul, NO_TARGET)
+PERFT(bishopAttacks_mul, bishopAttacks_mul, rookAttacks_mul, NO_TARGET)
+PERFT(bishopAttacks_SAD, bishopAttacks_SAD, rookAttacks_mul, NO_TARGET)
+PERFT(bishopAttacks_pext, bishopAttacks_pext, rookAttacks_mul, TARGET_BMI2)
+PERFT(bishopDiagonals_mul_mul, bishopDiagonals_mul_mul, rookAttacks_mul, NO_TARGET)
+PERFT(bishopDiagonals_SAD_mul, bishopDiagonals_SAD_mul, rookAttacks_mul, NO_TARGET)
+PERFT(bishopDiagonals_SAD_sse, bishopDiagonals_SAD_sse, rookAttacks_mul, NO_TARGET)
+PERFT(bishopDiagonals_pext_pdep, bishopDiagonals_pext_pdep, rookAttacks_mul, TARGET_BMI2)
+PERFT(bishopAttacks_rot45, bishopAttacks_rot45, rookAttacks_mul, NO_TARGET)
+PERFT(diag_bishopAttacks, diag_bishopAttacks, rookAttacks_mul, NO_TARGET)
+
+typedef struct {
+    const char *name;
+    uint64_t (*perft)(const PerftPosition*, int);
+    unsigned requires;
+} PerftSliders;
+
+#define PERFT_SLIDERS(name, requires) {#name, perft_##name, requires}
+
+const PerftSliders PERFT_SLIDERS_LIST[] = {
+    PERFT_SLIDERS(bishopAttacks_magic, 0),
+    PERFT_SLIDERS(bishopAttacks_mul, 0),
+    PERFT_SLIDERS(bishopAttacks_SAD, 0),
+    PERFT_SLIDERS(bishopAttacks_pext, REQ_BMI2),
+    PERFT_SLIDERS(bishopDiagonals_mul_mul, 0),
+    PERFT_SLIDERS(bishopDiagonals_SAD_mul, 0),
+    PERFT_SLIDERS(bishopDiagonals_SAD_sse, 0),
+    PERFT_SLIDERS(bishopDiagonals_pext_pdep, REQ_BMI2),
+    PERFT_SLIDERS(bishopAttacks_rot45, 0),
+    PERFT_SLIDERS(diag_bishopAttacks, 0),
+};
+
+// The usual perft test positions & their node counts at depth 1 to 5 (from chessprogramming.org).
+// Each is searched to its 'depth' by default, a few million nodes
+typedef struct {
+    const char *name, *fen;
+    int depth;
+    uint64_t nodes[5];
+} PerftTest;
+
+const PerftTest PERFT_TESTS[] = {
+    {"start", "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1", 5, {20, 400, 8902, 197281, 4865609}},
+    {"kiwipete", "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1", 4, {48, 2039, 97862, 4085603, 193690690}},
+    {"endgame", "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1", 5, {14, 191, 2812, 43238, 674624}},
+    {"promotions", "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1", 4, {6, 264, 9467, 422333, 15833292}},
+    {"middlegame", "rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8", 4, {44, 1486, 62379, 2103487, 89941194}},
+};
+
+// Every test position with each set of sliders, in nodes per second. Exits with 1 if a count is wrong
+int benchmarkPerft(const int maxDepth, const char *filter, const unsigned supported) {
+    enum {TEST_COUNT = sizeof(PERFT_TESTS) / sizeof(PERFT_TESTS[0])};
+    PerftPosition positions[TEST_COUNT];
+    int mismatches = 0;
+
+    for (size_t t=0; t < TEST_COUNT; t++) {
+        if (!perft_fromFEN(&positions[t], PERFT_TESTS[t].fen)) {
+            fprintf(stderr, "Invalid FEN: %s\n", PERFT_TESTS[t].fen);
+            return 1;
+        }
+    }
+
+    printf("%-28s %12s %10s %10s\n", "Sliders", "Nodes", "Seconds", "Mnodes/s");
+    for (size_t s=0; s < sizeof(PERFT_SLIDERS_LIST) / sizeof(PERFT_SLIDERS_LIST[0]); s++) {
+        const PerftSliders *sliders = &PERFT_SLIDERS_LIST[s];
+        if ((sliders->requires & supported) != sliders->requires) continue;
+        if (filter && !strstr(sliders->name, filter)) continue;
+
+        uint64_t totalNodes = 0;
+        double totalSeconds = 0;
+        for (size_t t=0; t < TEST_COUNT; t++) {
+            const PerftTest *test = &PERFT_TESTS[t];
+            const int depth = (maxDepth > 0 && maxDepth < test->depth)? maxDepth : test->depth;
+            struct timespec start;
+
+            clock_gettime(CLOCK_MONOTONIC, &start);
+            const uint64_t nodes = sliders->perft(&positions[t], depth);
+            totalSeconds += secondsSince(start);
+            totalNodes += nodes;
+
+            if (nodes != test->nodes[depth - 1]) {
+                fprintf(stderr, "MISMATCH: %s, %s depth %d: %llu nodes instead of %llu\n", sliders->name, test->name, depth,
+                    (unsigned long long)nodes, (unsigned long long)test->nodes[depth - 1]);
+                mismatches++;
+            }
+        }
+        printf("%-28s %12llu %10.3f %10.2f\n", sliders->name, (unsigned long long)totalNodes, totalSeconds, totalNodes / totalSeconds * 1e-6);
+    }
+    return mismatches? 1 : 0;
+}
+
+
+// =====================
+//   Runtime dispatch
+// =====================
+// The 'diagOps' table bound to every feature subset the CPU supports, each op against its family's reference.
+// Exits with 1 on a mismatch
+#define DISPATCH_CHECK(op, ...) \
+    if (!(__VA_ARGS__)) { \
+        fprintf(stderr, "MISMATCH: diagOps." op " bound to features 0x%02X\n", features); \
+        mismatches++; \
+    }
+
+#define DISPATCH_SINGLE(op, reference, in) { \
+    int same = 1; \
+    for (size_t i=0; i < n; i++) same &= diagOps.op(in[i]) == reference(in[i]); \
+    DISPATCH_CHECK(#op, same) \
+}
+
+#define DISPATCH_BATCH(op, reference, in, out) { \
+    int same = 1; \
+    memset(out, 0, sizeof(out)); \
+    diagOps_##op##_batch(in, out, n); \
+    for (size_t i=0; i < n; i++) same &= out[i] == reference(in[i]); \
+    DISPATCH_CHECK(#op "_batch", same) \
+}
+
+int checkDispatch(const unsigned supported) {
+    static const unsigned REQUIRES[] = {REQ_BMI2, REQ_AVX2, REQ_AVX512, REQ_GFNI, REQ_VBMI, REQ_BITALG}; // DIAG_CPU_* order
+    enum {FEATURE_COUNT = sizeof(REQUIRES) / sizeof(REQUIRES[0]), n = 1021}; // Odd, so every batch has a tail
+    static uint64_t boards[n], out64[n];
+    static uint8_t ranks[n], out8[n];
+    int mismatches = 0, subsets = 0;
+
+    // pext/pdep are never picked where they are microcoded
+    const unsigned detected = diagOps.features;
+    unsigned features = detected;
+    DISPATCH_CHECK("features", !(detected & DIAG_CPU_BMI2) == (!(supported & REQ_BMI2) || diagOps_hasSlowPdep()))
+
+    for (features=0; features < 1u << FEATURE_COUNT; features++) {
+        unsigned requires = 0;
+        for (int f=0; f < FEATURE_COUNT; f++)
+            if (features & 1u << f) requires |= REQUIRES[f];
+        if ((requires & supported) != requires) continue;
+        if ((features & (DIAG_CPU_VBMI | DIAG_CPU_BITALG)) && !(features & DIAG_CPU_AVX512)) continue;
+
+        diagOps_bind(features);
+        subsets++;
+        for (int dist=DIST_UNIFORM; dist <= DIST_SPARSE; dist++) {
+            fillInputs(boards, ranks, n, (enum Distribution)dist, 1 + features);
+            for (size_t i=0; i < 256; i++) ranks[i] = (uint8_t)i;
+
+            DISPATCH_SINGLE(shift_bl, diagShift_bl_bin, boards)
+            DISPATCH_SINGLE(shift_tl, diagShift_tl_bin, boards)
+            DISPATCH_SINGLE(shift_br, diagShift_br_bin, boards)
+            DISPATCH_SINGLE(shift_tr, diagShift_tr_bin, boards)
+            DISPATCH_SINGLE(extract_back, diagToHorizontal_back_mul, boards)
+            DISPATCH_SINGLE(extract_fwd, diagToHorizontal_fwd_mul, boards)
+            DISPATCH_SINGLE(toDiag_back, toDiag_back_mul, ranks)
+            DISPATCH_SINGLE(toDiag_fwd, toDiag_fwd_mul, ranks)
+            DISPATCH_SINGLE(toVertical, toVertical_mul, ranks)
+            DISPATCH_SINGLE(transpose, flipDiagA1H8, boards)
+
+            DISPATCH_BATCH(shift_bl, diagShift_bl_bin, boards, out64)
+            DISPATCH_BATCH(shift_tl, diagShift_tl_bin, boards, out64)
+            DISPATCH_BATCH(shift_br, diagShift_br_bin, boards, out64)
+            DISPATCH_BATCH(shift_tr, diagShift_tr_bin, boards, out64)
+            DISPATCH_BATCH(extract_back, diagToHorizontal_back_mul, boards, out8)
+            DISPATCH_BATCH(extract_fwd, diagToHorizontal_fwd_mul, boards, out8)
+            DISPATCH_BATCH(toDiag_back, toDiag_back_mul, ranks, out64)
+            DISPATCH_BATCH(toDiag_fwd, toDiag_fwd_mul, ranks, out64)
+            DISPATCH_BATCH(toVertical, toVertical_mul, ranks, out64)
+            DISPATCH_BATCH(transpose, flipDiagA1H8, boards, out64)
+        }
+
+        // Only the features asked for are used
+        DISPATCH_CHECK("features", diagOps.features == features)
+        DISPATCH_CHECK("extract_back", (diagOps.extract_back == diagToHorizontal_back_pext) == !!(features & DIAG_CPU_BMI2))
+        DISPATCH_CHECK("toDiag_fwd", (diagOps.toDiag_fwd == toDiagonal_fwd_pdep) == !!(features & DIAG_CPU_BMI2))
+        DISPATCH_CHECK("toDiag_back", (diagOps.toDiag_back == toDiag_back_avx512) == !!(features & DIAG_CPU_AVX512))
+    }
+
+    diagOps_bind(detected);
+    printf("diagOps: %d feature subsets checked (detected 0x%02X), %d mismatches\n", subsets, detected, mismatches);
+    return mismatches? 1 : 0;
+}
+
+void printUsage(const char *program) {
+    printf(
+        "Usage: %s [options]\n"
+        "  --mode latency|throughput|both   (default: both)\n"
+        "  --dist uniform|sparse|both       (default: uniform)\n"
+        "  --filter TEXT      only kernels whose name or family contains TEXT\n"
+        "  --reps N           timed repetitions, the median is reported (default: 15)\n"
+        "  --warmup N         untimed repetitions first (default: 2)\n"
+        "  --rounds N         passes over the 2048 inputs per repetition (default: 256)\n"
+        "  --format table|csv|json\n"
+        "  --output FILE      write the results to FILE instead of stdout\n"
+        "  --compare FILE     compare against a CSV baseline, exits with 1 on a regression\n"
+        "  --threshold PCT    slowdown counted as a regression (default: 5)\n"
+        "  --counters         hardware counters per call (cycles, IPC, instructions, uops, branch & L1d misses), Linux only\n"
+        "  --histogram        distribution of the ticks per call of each kernel (use with --filter)\n"
+        "  --bitmap           bitmap rotation check (odd sizes, 1 to 5 threads) & benchmark instead\n"
+        "  --side N           side of the largest bitmap benchmarked (default: 16384)\n"
+        "  --footprint        table sizes of the sliding attack methods\n"
+        "  --perft            perft of the test positions with each diagonal slider (--filter picks the sliders)\n"
+        "  --depth N          perft depth limit (default: each position's own, 4 or 5)\n"
+        "  --dispatch         the runtime dispatch table bound to every supported feature subset, against the references\n"
+        "  --list             list the kernels\n",
+        program
+    );
+}
+
+int main(int argc, char **argv) {
+    int modes[2] = {1, 1}, dists[2] = {1, 0};
+    const char *filter = NULL, *outputPath = NULL, *baselinePath = NULL;
+    int reps = 15, warmups = 2, list = 0, perft = 0, dispatch = 0, bitmap = 0, perftDepth = 0, useCounters = 0, histogram = 0;
+    size_t rounds = 256, bitmapSide = 16384;
+    double threshold = 5;
+    enum Format format = FORMAT_TABLE;
+
+    for (int i=1; i < argc; i++) {
+        const char *arg = argv[i], *value = (i + 1 < argc)? argv[i + 1] : "";
+
+        if (!strcmp(arg, "--mode")) {
+            modes[MODE_LATENCY] = !strcmp(value, "latency") || !strcmp(value, "both");
+            modes[MODE_THROUGHPUT] = !strcmp(value, "throughput") || !strcmp(value, "both");
+            i++;
+        } else if (!strcmp(arg, "--dist")) {
+            dists[DIST_UNIFORM] = !strcmp(value, "uniform") || !strcmp(value, "both");
+            dists[DIST_SPARSE] = !strcmp(value, "sparse") || !strcmp(value, "both");
+            i++;
+        } else if (!strcmp(arg, "--filter"))    { filter = value; i++; }
+        else if (!strcmp(arg, "--reps"))        { reps = atoi(value); i++; }
+        else if (!strcmp(arg, "--warmup"))      { warmups = atoi(value); i++; }
+        else if (!strcmp(arg, "--rounds"))      { rounds = strtoull(value, NULL, 10); i++; }
+        else if (!strcmp(arg, "--output"))      { outputPath = value; i++; }
+        else if (!strcmp(arg, "--compare"))     { baselinePath = value; i++; }
+        else if (!strcmp(arg, "--threshold"))   { threshold = atof(value); i++; }
+        else if (!strcmp(arg, "--format")) {
+            format = !strcmp(value, "csv")? FORMAT_CSV : !strcmp(value, "json")? FORMAT_JSON : FORMAT_TABLE;
+            i++;
+        }
+        else if (!strcmp(arg, "--list"))        list = 1;
+        else if (!strcmp(arg, "--counters"))    useCounters = 1;
+        else if (!strcmp(arg, "--histogram"))   histogram = 1;
+        else if (!strcmp(arg, "--perft"))       perft = 1;
+        else if (!strcmp(arg, "--dispatch"))    dispatch = 1;
+        else if (!strcmp(arg, "--depth"))       { perftDepth = atoi(value); i++; }
+        else if (!strcmp(arg, "--bitmap"))      bitmap = 1;
+        else if (!strcmp(arg, "--side"))        { bitmapSide = strtoull(value, NULL, 10); i++; }
+        else if (!strcmp(arg, "--footprint")) {
+            printAttackFootprint();
+            return 0;
+        } else {
+            printUsage(argv[0]);
+            return !!strcmp(arg, "--help");
+        }
+    }
+
+    if (bitmap)
+        return checkBitmapRotate(bitmapSide);
+    if (reps < 1) reps = 1;
+    if (reps > 101) reps = 101;
+    if (rounds < 1) rounds = 1;
+
+    const unsigned supported = supportedRequirements();
+    magicBitboards_init();
+    rotatedBoards_set(&rotatedPosition, 0xFFFF00000000FFFFULL);
+    if (perft)
+        return benchmarkPerft(perftDepth, filter, supported);
+    if (dispatch)
+        return checkDispatch(supported);
+    if (list) {
+        for (size_t k=0; k < KERNEL_COUNT; k++)
+            printf("%-32s %-20s%s\n", KERNELS[k].name, KERNELS[k].family, ((KERNELS[k].requires & supported) != KERNELS[k].requires)? " (unsupported)" : "");
+        return 0;
+    }
+
+
+    enum {INPUT_COUNT = 2048}; // Inputs and outputs fit in L1
+    // Aligned for the wide boards, which are read & written in place
+    static _Alignas(64) uint64_t in64[INPUT_COUNT], out64[INPUT_COUNT], expected64[INPUT_COUNT];
+    static uint8_t in8[INPUT_COUNT], out8[INPUT_COUNT], expected8[INPUT_COUNT];
+    BenchData data = {in64, in8, out64, out8, INPUT_COUNT};
+
+    static Result results[KERNEL_COUNT * 4];
+    size_t resultCount = 0;
+    int mismatches = 0;
+
+    // Containers & VMs usually refuse them, then only the timers are reported
+    PerfCounters counters;
+    if (useCounters && perfCounters_open(&counters) == 0) {
+        fprintf(stderr, "Hardware counters unavailable (%s), check /proc/sys/kernel/perf_event_paranoid\n", strerror(counters.error));
+        useCounters = 0;
+    }
+    // Before the results, so away from a CSV or JSON on stdout
+    FILE *histogramTo = (outputPath || format == FORMAT_TABLE)? stdout : stderr;
+
+    for (int dist=DIST_UNIFORM; dist <= DIST_SPARSE; dist++) {
+        if (!dists[dist]) continue;
+        fillInputs(in64, in8, INPUT_COUNT, dist, 0x5EED);
+
+        const Kernel *reference = NULL;
+        for (size_t k=0; k < KERNEL_COUNT; k++) {
+            const Kernel *kernel = &KERNELS[k];
+            if (!reference || strcmp(reference->family, kernel->family))
+                reference = kernel;
+
+            if ((kernel->requires & supported) != kernel->requires) continue;
+            if (filter && !strstr(kernel->name, filter) && !strstr(kernel->family, filter)) continue;
+
+            if (!matchesReference(kernel, reference, &data, expected64, expected8)) {
+                fprintf(stderr, "MISMATCH: %s differs from %s (%s inputs)\n", kernel->name, reference->name, DIST_NAMES[dist]);
+                mismatches++;
+            }
+
+            for (int mode=MODE_LATENCY; mode <= MODE_THROUGHPUT; mode++) {
+                const BenchLoop loop = (mode == MODE_LATENCY)? kernel->latency : kernel->throughput;
+                if (!modes[mode] || !loop) continue;
+
+                results[resultCount++] = (Result){kernel->name, kernel->family, mode, dist,
+                    measure(loop, &data, rounds, warmups, reps, useCounters? &counters : NULL)};
+
+                if (histogram) {
+                    char title[128];
+                    snprintf(title, sizeof(title), "%s (%s, %s inputs)", kernel->name, MODE_NAMES[mode], DIST_NAMES[dist]);
+                    printLatencyHistogram(histogramTo, title, loop, &data, rounds);
+                }
+            }
+        }
+    }
+
+
+    FILE *output = outputPath? fopen(outputPath, "w") : stdout;
+    if (!output) {
+        perror(outputPath);
+        return 1;
+    }
+    printResults(output, results, resultCount, format, useCounters);
+    if (output != stdout)
+        fclose(output);
+    if (useCounters)
+        perfCounters_close(&counters);
+
+    if (baselinePath) {
+        const int regressions = compareToBaseline(baselinePath, results, resultCount, threshold);
+        if (regressions != 0)
+            return 1;
+    }
+    return mismatches? 1 : 0;
+}
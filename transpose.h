@@ -1,11 +1,17 @@
 #pragma once
 
 #include <stdint.h>
-#include <immintrin.h> // SSE2, AVX2, AVX512bw
+#include <stddef.h>     // size_t
+#include <string.h>     // memcpy
+
+#include "cpuFeatures.h"
+#ifdef DIAG_X86
+#include <immintrin.h> // SSE2, AVX2, AVX512bw, GFNI
+#endif
 
 
 // https://www.chessprogramming.org/Flipping_Mirroring_and_Rotating#FlipabouttheDiagonal
-uint64_t flipDiagA1H8(uint64_t x) {
+DIAG_INLINE uint64_t flipDiagA1H8(uint64_t x) {
     uint64_t t;
     const uint64_t k1 = UINT64_C(0x5500550055005500);
     const uint64_t k2 = UINT64_C(0x3333000033330000);
@@ -20,8 +26,9 @@ uint64_t flipDiagA1H8(uint64_t x) {
     return x;
 }
 
+#ifdef DIAG_X86
 // Vectorized version of above
-__m128i flipDiagA1H8_epi64(__m128i m) {
+DIAG_INLINE __m128i flipDiagA1H8_epi64(__m128i m) {
     const __m128i k1 = _mm_set1_epi64x(0xaa00aa00aa00aa00ull);
     const __m128i k2 = _mm_set1_epi64x(0xcccc0000cccc0000ull);
     const __m128i k4 = _mm_set1_epi64x(0xf0f0f0f00f0f0f0full);
@@ -39,7 +46,10 @@ __m128i flipDiagA1H8_epi64(__m128i m) {
 
 
 
-uint64_t diagTranspose_sse(uint64_t x) {
+// A board known at compile time takes 'flipDiagA1H8' instead, which folds
+DIAG_INLINE uint64_t diagTranspose_sse(uint64_t x) {
+    if (DIAG_IS_CONSTANT(x)) return flipDiagA1H8(x);
+
     // We can transpose two rows at once, so offset lower lane
     __m128i inLowOnly = _mm_cvtsi64_si128(x);
     __m128i duplicatedHiLow = _mm_shuffle_epi32(inLowOnly, _MM_SHUFFLE(1,0,1,0));
@@ -58,10 +68,13 @@ uint64_t diagTranspose_sse(uint64_t x) {
     uint64_t highTranspose = (hiHi << 16) | hiLo;
     return (highTranspose << 32) | (loHi << 16) | loLo; 
 }
+#endif
+
 
+#ifdef COMPILE_AVX2
+static inline TARGET_AVX2 uint64_t diagTranspose_avx2(uint64_t x) {
+    if (DIAG_IS_CONSTANT(x)) return flipDiagA1H8(x);
 
-#ifdef CPU_HAS_AVX2
-uint64_t diagTranspose_avx2(uint64_t x) {
     __m256i vec = _mm256_set1_epi64x(x);
     __m256i vecOffset = _mm256_sllv_epi64(vec, _mm256_setr_epi64x(3,2,1,0));
 
@@ -72,11 +85,211 @@ uint64_t diagTranspose_avx2(uint64_t x) {
 }
 #endif
 
-#ifdef CPU_HAS_AVX512 // avx512bw
-uint64_t diagTranspose_avx512(uint64_t x) {
+#ifdef COMPILE_AVX512 // avx512bw
+static inline TARGET_AVX512 uint64_t diagTranspose_avx512(uint64_t x) {
+    if (DIAG_IS_CONSTANT(x)) return flipDiagA1H8(x);
+
     __m512i vec = _mm512_set1_epi64(x);
     __m512i vecOffset = _mm512_sllv_epi64(vec, _mm512_setr_epi64(7,6,5,4,3,2,1,0));
 
     return (uint64_t)_mm512_movepi8_mask(vecOffset);
 }
-#endif
\ No newline at end of file
+#endif
+
+
+
+// ==================
+//      Batched
+// ==================
+// Same 3 delta swaps as 'flipDiagA1H8', where every 64-bit lane holds its own board
+#ifdef DIAG_X86
+DIAG_INLINE __m128i flipDiagA1H8_x2(__m128i x) {
+    const __m128i k1 = _mm_set1_epi64x(0x5500550055005500ull);
+    const __m128i k2 = _mm_set1_epi64x(0x3333000033330000ull);
+    const __m128i k4 = _mm_set1_epi64x(0x0f0f0f0f00000000ull);
+
+    __m128i t = _mm_and_si128( k4, _mm_xor_si128(x, _mm_slli_epi64(x, 28)) );
+    x =         _mm_xor_si128( x,  _mm_xor_si128(t, _mm_srli_epi64(t, 28)) );
+    t =         _mm_and_si128( k2, _mm_xor_si128(x, _mm_slli_epi64(x, 14)) );
+    x =         _mm_xor_si128( x,  _mm_xor_si128(t, _mm_srli_epi64(t, 14)) );
+    t =         _mm_and_si128( k1, _mm_xor_si128(x, _mm_slli_epi64(x, 7 )) );
+    x =         _mm_xor_si128( x,  _mm_xor_si128(t, _mm_srli_epi64(t, 7 )) );
+    return x;
+}
+
+// 2 boards per iteration, the odd one out uses the scalar delta swap
+static inline void diagTranspose_batch_sse(const uint64_t *in, uint64_t *out, size_t n) {
+    size_t i = 0;
+    for (; i + 2 <= n; i += 2)
+        _mm_storeu_si128((__m128i*)(out + i), flipDiagA1H8_x2(_mm_loadu_si128((const __m128i*)(in + i))));
+
+    for (; i < n; i++)
+        out[i] = flipDiagA1H8(in[i]);
+}
+#endif
+
+
+#ifdef COMPILE_AVX2
+static inline TARGET_AVX2 __m256i flipDiagA1H8_x4(__m256i x) {
+    const __m256i k1 = _mm256_set1_epi64x(0x5500550055005500ull);
+    const __m256i k2 = _mm256_set1_epi64x(0x3333000033330000ull);
+    const __m256i k4 = _mm256_set1_epi64x(0x0f0f0f0f00000000ull);
+
+    __m256i t = _mm256_and_si256( k4, _mm256_xor_si256(x, _mm256_slli_epi64(x, 28)) );
+    x =         _mm256_xor_si256( x,  _mm256_xor_si256(t, _mm256_srli_epi64(t, 28)) );
+    t =         _mm256_and_si256( k2, _mm256_xor_si256(x, _mm256_slli_epi64(x, 14)) );
+    x =         _mm256_xor_si256( x,  _mm256_xor_si256(t, _mm256_srli_epi64(t, 14)) );
+    t =         _mm256_and_si256( k1, _mm256_xor_si256(x, _mm256_slli_epi64(x, 7 )) );
+    x =         _mm256_xor_si256( x,  _mm256_xor_si256(t, _mm256_srli_epi64(t, 7 )) );
+    return x;
+}
+
+static inline TARGET_AVX2 void diagTranspose_batch_avx2(const uint64_t *in, uint64_t *out, size_t n) {
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4)
+        _mm256_storeu_si256((__m256i*)(out + i), flipDiagA1H8_x4(_mm256_loadu_si256((const __m256i*)(in + i))));
+
+    diagTranspose_batch_sse(in + i, out + i, n - i);
+}
+#endif
+
+
+#ifdef COMPILE_AVX512
+// 'ternarylogic' merges each "x ^ (t ^ (t >> n))" into a single instruction
+static inline TARGET_AVX512 __m512i flipDiagA1H8_x8(__m512i x) {
+    const __m512i k1 = _mm512_set1_epi64(0x5500550055005500ull);
+    const __m512i k2 = _mm512_set1_epi64(0x3333000033330000ull);
+    const __m512i k4 = _mm512_set1_epi64(0x0f0f0f0f00000000ull);
+
+    // 0x96: a ^ b ^ c
+    __m512i t = _mm512_and_si512( k4, _mm512_xor_si512(x, _mm512_slli_epi64(x, 28)) );
+    x =         _mm512_ternarylogic_epi64(x, t, _mm512_srli_epi64(t, 28), 0x96);
+    t =         _mm512_and_si512( k2, _mm512_xor_si512(x, _mm512_slli_epi64(x, 14)) );
+    x =         _mm512_ternarylogic_epi64(x, t, _mm512_srli_epi64(t, 14), 0x96);
+    t =         _mm512_and_si512( k1, _mm512_xor_si512(x, _mm512_slli_epi64(x, 7 )) );
+    x =         _mm512_ternarylogic_epi64(x, t, _mm512_srli_epi64(t, 7 ), 0x96);
+    return x;
+}
+
+static inline TARGET_AVX512 void diagTranspose_batch_avx512(const uint64_t *in, uint64_t *out, size_t n) {
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8)
+        _mm512_storeu_si512(out + i, flipDiagA1H8_x8(_mm512_loadu_si512(in + i)));
+
+    diagTranspose_batch_sse(in + i, out + i, n - i);
+}
+#endif
+
+
+// ==================
+//       GFNI
+// ==================
+// 'gf2p8affine(x, A)' output bit 'i' of byte 'j' is the parity of "A.byte[7-i] & x.byte[j]".
+// With the board (rows reversed) as the matrix and 'x.byte[j] = 1 << j', that is bit 'j' of row 'i': a transpose.
+#ifdef COMPILE_GFNI
+static inline TARGET_GFNI uint64_t diagTranspose_gfni(uint64_t x) {
+    if (DIAG_IS_CONSTANT(x)) return flipDiagA1H8(x);
+
+    __m128i reversedRows = _mm_cvtsi64_si128((long long)_bswap64((long long)x));
+    return _mm_cvtsi128_si64(_mm_gf2p8affine_epi64_epi8(_mm_cvtsi64_si128(GF2P8_SELECT_COLUMN), reversedRows, 0));
+}
+
+// 'pshufb' reverses the rows of each board
+static inline TARGET_GFNI __m128i diagTranspose_gfni_x2(__m128i x) {
+    const __m128i reverseRows = _mm_set_epi8(8, 9, 10, 11, 12, 13, 14, 15, 0, 1, 2, 3, 4, 5, 6, 7);
+    return _mm_gf2p8affine_epi64_epi8(_mm_set1_epi64x(GF2P8_SELECT_COLUMN), _mm_shuffle_epi8(x, reverseRows), 0);
+}
+
+static inline TARGET_GFNI void diagTranspose_batch_gfni(const uint64_t *in, uint64_t *out, size_t n) {
+    size_t i = 0;
+    for (; i + 2 <= n; i += 2)
+        _mm_storeu_si128((__m128i*)(out + i), diagTranspose_gfni_x2(_mm_loadu_si128((const __m128i*)(in + i))));
+
+    for (; i < n; i++)
+        out[i] = diagTranspose_gfni(in[i]);
+}
+#endif
+
+#if defined(COMPILE_GFNI) && defined(COMPILE_AVX2)
+static inline TARGET_GFNI_AVX2 __m256i diagTranspose_gfni_x4(__m256i x) {
+    const __m256i reverseRows = _mm256_broadcastsi128_si256(_mm_set_epi8(8, 9, 10, 11, 12, 13, 14, 15, 0, 1, 2, 3, 4, 5, 6, 7));
+    return _mm256_gf2p8affine_epi64_epi8(_mm256_set1_epi64x(GF2P8_SELECT_COLUMN), _mm256_shuffle_epi8(x, reverseRows), 0);
+}
+
+static inline TARGET_GFNI_AVX2 void diagTranspose_batch_gfni_avx2(const uint64_t *in, uint64_t *out, size_t n) {
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4)
+        _mm256_storeu_si256((__m256i*)(out + i), diagTranspose_gfni_x4(_mm256_loadu_si256((const __m256i*)(in + i))));
+
+    diagTranspose_batch_gfni(in + i, out + i, n - i);
+}
+#endif
+
+#if defined(COMPILE_GFNI) && defined(COMPILE_AVX512)
+static inline TARGET_GFNI_AVX512 __m512i diagTranspose_gfni_x8(__m512i x) {
+    const __m512i reverseRows = _mm512_broadcast_i32x4(_mm_set_epi8(8, 9, 10, 11, 12, 13, 14, 15, 0, 1, 2, 3, 4, 5, 6, 7));
+    return _mm512_gf2p8affine_epi64_epi8(_mm512_set1_epi64(GF2P8_SELECT_COLUMN), _mm512_shuffle_epi8(x, reverseRows), 0);
+}
+
+static inline TARGET_GFNI_AVX512 void diagTranspose_batch_gfni_avx512(const uint64_t *in, uint64_t *out, size_t n) {
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8)
+        _mm512_storeu_si512(out + i, diagTranspose_gfni_x8(_mm512_loadu_si512(in + i)));
+
+    diagTranspose_batch_gfni(in + i, out + i, n - i);
+}
+#endif
+
+
+// ==================
+//  Vector extensions
+// ==================
+// The delta swaps again, on GCC/Clang vectors of boards
+#ifdef COMPILE_VECTOR
+DIAG_INLINE diagVec_u64 flipDiagA1H8_vec(diagVec_u64 x) {
+    diagVec_u64 t;
+    t  = (x ^ (x << 28)) & 0x0f0f0f0f00000000ULL;
+    x ^=       t ^ (t >> 28) ;
+    t  = (x ^ (x << 14)) & 0x3333000033330000ULL;
+    x ^=       t ^ (t >> 14) ;
+    t  = (x ^ (x <<  7)) & 0x5500550055005500ULL;
+    x ^=       t ^ (t >>  7) ;
+    return x;
+}
+
+DIAG_INLINE uint64_t diagTranspose_vec(uint64_t x) {
+    return flipDiagA1H8_vec((diagVec_u64){x})[0];
+}
+
+static inline void diagTranspose_batch_vec(const uint64_t *in, uint64_t *out, size_t n) {
+    size_t i = 0;
+    for (; i + DIAG_VECTOR_BOARDS <= n; i += DIAG_VECTOR_BOARDS) {
+        diagVec_u64 boards;
+        memcpy(&boards, in + i, sizeof(boards));
+        boards = flipDiagA1H8_vec(boards);
+        memcpy(out + i, &boards, sizeof(boards));
+    }
+
+    for (; i < n; i++)
+        out[i] = flipDiagA1H8(in[i]);
+}
+#endif
+
+
+static inline void diagTranspose_batch(const uint64_t *in, uint64_t *out, size_t n) {
+#if defined(DIAG_PORTABLE)
+    diagTranspose_batch_vec(in, out, n);
+#elif defined(CPU_HAS_GFNI) && defined(CPU_HAS_AVX512)
+    diagTranspose_batch_gfni_avx512(in, out, n);
+#elif defined(CPU_HAS_GFNI) && defined(CPU_HAS_AVX2)
+    diagTranspose_batch_gfni_avx2(in, out, n);
+#elif defined(CPU_HAS_GFNI)
+    diagTranspose_batch_gfni(in, out, n);
+#elif defined(CPU_HAS_AVX512)
+    diagTranspose_batch_avx512(in, out, n);
+#elif defined(CPU_HAS_AVX2)
+    diagTranspose_batch_avx2(in, out, n);
+#else
+    diagTranspose_batch_sse(in, out, n);
+#endif
+}
\ No newline at end of file
@@ -0,0 +1,538 @@
+#ifndef WIDE_BOARD_H
+#define WIDE_BOARD_H
+
+#include <stdint.h>
+
+#include "cpuFeatures.h"
+#ifdef DIAG_X86
+#include <immintrin.h>  // SSE2, AVX2, AVX512bw
+#endif
+
+// Diagonal shifts, extract & deposit of the main diagonals and transpose, for boards wider than 8 columns:
+// Shogi (9x9), Gomoku (15x15) and Go (19x19). Every row is padded to its own lane of a vector, so the row-wise
+// instructions of the 8x8 kernels work on the whole board at once:
+// - 'WideBoard16': a row per 16-bit lane, up to 16x16 (9x9 & 15x15). 2 SSE registers, or 1 AVX2 register.
+//   The shifts are the 'mullo' / 'mulhi_epu16' multiplies of 'diagShift_bl_SSE', on 16-bit rows instead of 8.
+// - 'WideBoard32': a row per 32-bit lane, up to 32x32 (19x19). 19 columns don't fit in 16 bits, and SSE2 has no 32-bit
+//   multiply, so it is the AVX2 & AVX-512 variable shifts (4 or 2 registers), or the vector extensions.
+// Row 'r' is 'rows[r]', column 'c' its bit 'c' (the 8x8 layout, with wider rows). Both main diagonals are by column, like
+// 'boardGeometry.h': (\) is square (c, c), (/) square (W-1 - c, c) and both are bit 'c' of the extract & deposit.
+//
+// 'WIDE_BOARD16(name, W, H)' & 'WIDE_BOARD32(name, W, H)' define the kernels of a W x H board. The per row constants are
+// vector extension expressions of W & H, which the compiler folds: nothing is computed or looked up at runtime.
+// Bits & rows past the board are ignored by the kernels and are 0 in their results.
+// The boards are read from & written to pointers ('result' may be 'board'), aligned to the struct's alignment.
+// Needs GCC or Clang (the vector extensions).
+
+#ifdef COMPILE_VECTOR
+
+typedef struct { _Alignas(32) uint16_t rows[16]; } WideBoard16;
+typedef struct { _Alignas(64) uint32_t rows[32]; } WideBoard32;
+
+// Only for the constants. The boards are passed by pointer: as a struct argument or return value, the compiler copies
+// them through memory in pieces, which stalls every load that reads a whole register of a piece
+typedef uint16_t wideVec16 __attribute__((vector_size(32)));
+typedef uint32_t wideVec32 __attribute__((vector_size(128)));
+
+
+// ==================
+//     Constants
+// ==================
+#define WIDE_ROWS_16 ((wideVec16){0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15})
+#define WIDE_ROWS_32 ((wideVec32){0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, \
+    16, 17, 18, 19, 20, 21, 22, 23, 24, 25, 26, 27, 28, 29, 30, 31})
+#define WIDE_ROW(W)         ((1ULL << (W)) - 1)
+
+// How far each row moves: the bottom row the most (\ -> | left, / -> | right), or the top row.
+// Rows past the top wrap around to a large amount
+#define WIDE_FROM_BOTTOM(H, rows)   ((H) - 1 - (rows))
+#define WIDE_FROM_TOP(H, rows)      (rows)
+
+// All ones in the rows of the board that keep some of their bits after the shift, 0 elsewhere
+#define WIDE_KEPT(vec, W, H, rows, amount)      ((vec)(((rows) < (H)) & (amount(H, rows) < (W))))
+// The amount of those rows, 0 for the others (a vector shift by the lane width or more is undefined)
+#define WIDE_AMOUNTS(vec, W, H, rows, amount)   (amount(H, rows) & WIDE_KEPT(vec, W, H, rows, amount))
+// What the board keeps: 'left' masks after the shift, 'right' before
+#define WIDE_SHIFT_MASKS(vec, W, H, rows, amount) (WIDE_KEPT(vec, W, H, rows, amount) & WIDE_ROW(W))
+
+// Square (r, r) & (r, W-1 - r) of every row on both diagonals
+#define WIDE_ON_DIAG(vec, W, H, rows)   ((vec)(((rows) < (W)) & ((rows) < (H))))
+#define WIDE_BACK_DIAG(vec, W, H, rows) (WIDE_ON_DIAG(vec, W, H, rows) & ((vec){0} + 1) << (rows))
+#define WIDE_FWD_DIAG(vec, W, H, rows) \
+    (WIDE_ON_DIAG(vec, W, H, rows) & ((vec){0} + 1) << (((W) - 1 - (rows)) & WIDE_ON_DIAG(vec, W, H, rows)))
+
+// The board, every row masked to W columns
+#define WIDE_BOARD_MASK(vec, W, H, rows)    ((vec)((rows) < (H)) & WIDE_ROW(W))
+
+// Chunks of a board or of a constant (a local vector, aligned to its size), by register width
+#define WIDE_LOAD128(pointer, i)        _mm_load_si128((const __m128i*)(pointer) + (i))
+#define WIDE_LOAD256(pointer, i)        _mm256_load_si256((const __m256i*)(pointer) + (i))
+#define WIDE_LOAD512(pointer, i)        _mm512_load_si512((const __m512i*)(pointer) + (i))
+#define WIDE_STORE128(pointer, i, x)    _mm_store_si128((__m128i*)(pointer) + (i), x)
+#define WIDE_STORE256(pointer, i, x)    _mm256_store_si256((__m256i*)(pointer) + (i), x)
+#define WIDE_STORE512(pointer, i, x)    _mm512_store_si512((__m512i*)(pointer) + (i), x)
+
+
+
+// ==================
+//  Vector extension
+// ==================
+// Any target, each shift by its own amount is as many lanes at once as the target's shifts allow
+#define WIDE_SHIFT_VEC(name, Board, vec, rowsConstant, W, H, amount, left) \
+    DIAG_INLINE void name(const Board *board, Board *result) { \
+        const vec rows = rowsConstant; \
+        vec x; \
+        __builtin_memcpy(&x, board->rows, sizeof(x)); \
+        if (left) x = (x << WIDE_AMOUNTS(vec, W, H, rows, amount)) & WIDE_SHIFT_MASKS(vec, W, H, rows, amount); \
+        else      x = (x & WIDE_SHIFT_MASKS(vec, W, H, rows, amount)) >> WIDE_AMOUNTS(vec, W, H, rows, amount); \
+        __builtin_memcpy(result->rows, &x, sizeof(x)); \
+    }
+
+// The rows' bits are all in different columns, so or-ing the rows adds them
+#define WIDE_EXTRACT_VEC(name, Board, Row, vec, rowsConstant, W, H, diagonal) \
+    DIAG_INLINE Row name(const Board *board) { \
+        const vec rows = rowsConstant; \
+        vec x; \
+        __builtin_memcpy(&x, board->rows, sizeof(x)); \
+        x &= diagonal(vec, W, H, rows); \
+        Row result = 0; \
+        for (unsigned r=0; r < (H) && r < (W); r++) result |= x[r]; \
+        return result; \
+    }
+
+#define WIDE_DEPOSIT_VEC(name, Board, Row, vec, rowsConstant, W, H, diagonal) \
+    DIAG_INLINE void name(const Row input, Board *result) { \
+        const vec rows = rowsConstant; \
+        const vec x = ((vec){0} + input) & diagonal(vec, W, H, rows); \
+        __builtin_memcpy(result->rows, &x, sizeof(x)); \
+    }
+
+// Column 'c' to row 'c': every row's bit 'c' to bit 'r', or-ed together
+#define WIDE_TRANSPOSE_VEC(name, Board, Row, vec, rowsConstant, W, H) \
+    DIAG_INLINE void name(const Board *board, Board *result) { \
+        const vec rows = rowsConstant; \
+        vec x; \
+        __builtin_memcpy(&x, board->rows, sizeof(x)); \
+        x &= WIDE_BOARD_MASK(vec, W, H, rows); \
+        *result = (Board){{0}}; \
+        for (unsigned c=0; c < (W); c++) { \
+            const vec column = ((x >> c) & 1) << rows; \
+            Row row = 0; \
+            for (unsigned r=0; r < (H); r++) row |= column[r]; \
+            result->rows[c] = row; \
+        } \
+    }
+
+#define WIDE_VEC(name, Board, Row, vec, rowsConstant, W, H) \
+    WIDE_SHIFT_VEC(name##_shift_bl_vec, Board, vec, rowsConstant, W, H, WIDE_FROM_BOTTOM, 1) \
+    WIDE_SHIFT_VEC(name##_shift_tl_vec, Board, vec, rowsConstant, W, H, WIDE_FROM_TOP, 1) \
+    WIDE_SHIFT_VEC(name##_shift_br_vec, Board, vec, rowsConstant, W, H, WIDE_FROM_BOTTOM, 0) \
+    WIDE_SHIFT_VEC(name##_shift_tr_vec, Board, vec, rowsConstant, W, H, WIDE_FROM_TOP, 0) \
+    WIDE_EXTRACT_VEC(name##_extract_back_vec, Board, Row, vec, rowsConstant, W, H, WIDE_BACK_DIAG) \
+    WIDE_EXTRACT_VEC(name##_extract_fwd_vec, Board, Row, vec, rowsConstant, W, H, WIDE_FWD_DIAG) \
+    WIDE_DEPOSIT_VEC(name##_deposit_back_vec, Board, Row, vec, rowsConstant, W, H, WIDE_BACK_DIAG) \
+    WIDE_DEPOSIT_VEC(name##_deposit_fwd_vec, Board, Row, vec, rowsConstant, W, H, WIDE_FWD_DIAG) \
+    WIDE_TRANSPOSE_VEC(name##_transpose_vec, Board, Row, vec, rowsConstant, W, H)
+
+
+
+// ==================
+//     SSE (16)
+// ==================
+// Same as 'diagShift_bl_SSE' & 'diagShift_br_SSE' on 16-bit rows: left by 's' is 'mullo' by '2^s', right the high half
+// of a multiply by '2^(16 - s)'. That is 2^16 for the row that doesn't move, so it is 'mulhi' by 1 (0) & or-ed back in.
+// The 16 rows are 2 halves of 8
+#ifdef DIAG_X86
+#define WIDE16_SHIFT_SSE_LEFT(name, W, H, amount) \
+    DIAG_INLINE void name(const WideBoard16 *board, WideBoard16 *result) { \
+        const wideVec16 rows = WIDE_ROWS_16; \
+        const wideVec16 powers = ((wideVec16){0} + 1) << WIDE_AMOUNTS(wideVec16, W, H, rows, amount); \
+        const wideVec16 masks = WIDE_SHIFT_MASKS(wideVec16, W, H, rows, amount); \
+        for (int i=0; i < 2; i++) \
+            WIDE_STORE128(result->rows, i, _mm_and_si128(_mm_mullo_epi16(WIDE_LOAD128(board->rows, i), WIDE_LOAD128(&powers, i)), WIDE_LOAD128(&masks, i))); \
+    }
+
+#define WIDE16_SHIFT_SSE_RIGHT(name, W, H, amount) \
+    DIAG_INLINE void name(const WideBoard16 *board, WideBoard16 *result) { \
+        const wideVec16 rows = WIDE_ROWS_16; \
+        const wideVec16 amounts = WIDE_AMOUNTS(wideVec16, W, H, rows, amount); \
+        const wideVec16 powers = ((wideVec16){0} + 1) << ((16 - amounts) & 15); \
+        const wideVec16 masks = WIDE_SHIFT_MASKS(wideVec16, W, H, rows, amount); \
+        const wideVec16 unmoved = masks & (wideVec16)(amounts == 0); \
+        for (int i=0; i < 2; i++) { \
+            const __m128i x = WIDE_LOAD128(board->rows, i); \
+            const __m128i shifted = _mm_mulhi_epu16(_mm_and_si128(x, WIDE_LOAD128(&masks, i)), WIDE_LOAD128(&powers, i)); \
+            WIDE_STORE128(result->rows, i, _mm_or_si128(shifted, _mm_and_si128(x, WIDE_LOAD128(&unmoved, i)))); \
+        } \
+    }
+
+// The rows of both halves or-ed together, then the 8 lanes
+#define WIDE16_EXTRACT_SSE(name, W, H, diagonal) \
+    DIAG_INLINE uint16_t name(const WideBoard16 *board) { \
+        const wideVec16 rows = WIDE_ROWS_16; \
+        const wideVec16 masks = diagonal(wideVec16, W, H, rows); \
+        __m128i x = _mm_or_si128(_mm_and_si128(WIDE_LOAD128(board->rows, 0), WIDE_LOAD128(&masks, 0)), \
+            _mm_and_si128(WIDE_LOAD128(board->rows, 1), WIDE_LOAD128(&masks, 1))); \
+        x = _mm_or_si128(x, _mm_srli_si128(x, 8)); \
+        x = _mm_or_si128(x, _mm_srli_si128(x, 4)); \
+        x = _mm_or_si128(x, _mm_srli_si128(x, 2)); \
+        return (uint16_t)_mm_cvtsi128_si32(x); \
+    }
+
+#define WIDE16_DEPOSIT_SSE(name, W, H, diagonal) \
+    DIAG_INLINE void name(const uint16_t input, WideBoard16 *result) { \
+        const wideVec16 rows = WIDE_ROWS_16; \
+        const wideVec16 masks = diagonal(wideVec16, W, H, rows); \
+        const __m128i x = _mm_set1_epi16((short)input); \
+        for (int i=0; i < 2; i++) \
+            WIDE_STORE128(result->rows, i, _mm_and_si128(x, WIDE_LOAD128(&masks, i))); \
+    }
+
+// The low & high bytes of the 16 rows, each in a vector. Shifted left by '7 - b', 'movemask' takes bit 'b' of every row:
+// row 'b' and 'b + 8' of the transpose
+#define WIDE16_TRANSPOSE_SSE(name, W, H) \
+    DIAG_INLINE void name(const WideBoard16 *board, WideBoard16 *result) { \
+        const wideVec16 rows = WIDE_ROWS_16; \
+        const wideVec16 masks = WIDE_BOARD_MASK(wideVec16, W, H, rows); \
+        const __m128i lower = _mm_and_si128(WIDE_LOAD128(board->rows, 0), WIDE_LOAD128(&masks, 0)); \
+        const __m128i upper = _mm_and_si128(WIDE_LOAD128(board->rows, 1), WIDE_LOAD128(&masks, 1)); \
+        const __m128i low = _mm_packus_epi16(_mm_and_si128(lower, _mm_set1_epi16(0xFF)), _mm_and_si128(upper, _mm_set1_epi16(0xFF))); \
+        const __m128i high = _mm_packus_epi16(_mm_srli_epi16(lower, 8), _mm_srli_epi16(upper, 8)); \
+        for (int b=0; b < 8; b++) { \
+            result->rows[b] = (uint16_t)_mm_movemask_epi8(_mm_slli_epi64(low, 7 - b)); \
+            result->rows[b + 8] = (uint16_t)_mm_movemask_epi8(_mm_slli_epi64(high, 7 - b)); \
+        } \
+    }
+
+#define WIDE16_SSE(name, W, H) \
+    WIDE16_SHIFT_SSE_LEFT(name##_shift_bl_sse, W, H, WIDE_FROM_BOTTOM) \
+    WIDE16_SHIFT_SSE_LEFT(name##_shift_tl_sse, W, H, WIDE_FROM_TOP) \
+    WIDE16_SHIFT_SSE_RIGHT(name##_shift_br_sse, W, H, WIDE_FROM_BOTTOM) \
+    WIDE16_SHIFT_SSE_RIGHT(name##_shift_tr_sse, W, H, WIDE_FROM_TOP) \
+    WIDE16_EXTRACT_SSE(name##_extract_back_sse, W, H, WIDE_BACK_DIAG) \
+    WIDE16_EXTRACT_SSE(name##_extract_fwd_sse, W, H, WIDE_FWD_DIAG) \
+    WIDE16_DEPOSIT_SSE(name##_deposit_back_sse, W, H, WIDE_BACK_DIAG) \
+    WIDE16_DEPOSIT_SSE(name##_deposit_fwd_sse, W, H, WIDE_FWD_DIAG) \
+    WIDE16_TRANSPOSE_SSE(name##_transpose_sse, W, H)
+#else
+#define WIDE16_SSE(name, W, H)
+#endif
+
+
+
+// ==================
+//       AVX2
+// ==================
+// 16: the SSE multiplies on the whole board in 1 register. 32: 'vpsllvd' & 'vpsrlvd', 8 rows per register
+#ifdef COMPILE_AVX2
+#define WIDE16_SHIFT_AVX2_LEFT(name, W, H, amount) \
+    static inline TARGET_AVX2 void name(const WideBoard16 *board, WideBoard16 *result) { \
+        const wideVec16 rows = WIDE_ROWS_16; \
+        const wideVec16 powers = ((wideVec16){0} + 1) << WIDE_AMOUNTS(wideVec16, W, H, rows, amount); \
+        const wideVec16 masks = WIDE_SHIFT_MASKS(wideVec16, W, H, rows, amount); \
+        WIDE_STORE256(result->rows, 0, _mm256_and_si256(_mm256_mullo_epi16(WIDE_LOAD256(board->rows, 0), WIDE_LOAD256(&powers, 0)), WIDE_LOAD256(&masks, 0))); \
+    }
+
+#define WIDE16_SHIFT_AVX2_RIGHT(name, W, H, amount) \
+    static inline TARGET_AVX2 void name(const WideBoard16 *board, WideBoard16 *result) { \
+        const wideVec16 rows = WIDE_ROWS_16; \
+        const wideVec16 amounts = WIDE_AMOUNTS(wideVec16, W, H, rows, amount); \
+        const wideVec16 powers = ((wideVec16){0} + 1) << ((16 - amounts) & 15); \
+        const wideVec16 masks = WIDE_SHIFT_MASKS(wideVec16, W, H, rows, amount); \
+        const wideVec16 unmoved = masks & (wideVec16)(amounts == 0); \
+        const __m256i x = WIDE_LOAD256(board->rows, 0); \
+        const __m256i shifted = _mm256_mulhi_epu16(_mm256_and_si256(x, WIDE_LOAD256(&masks, 0)), WIDE_LOAD256(&powers, 0)); \
+        WIDE_STORE256(result->rows, 0, _mm256_or_si256(shifted, _mm256_and_si256(x, WIDE_LOAD256(&unmoved, 0)))); \
+    }
+
+#define WIDE16_EXTRACT_AVX2(name, W, H, diagonal) \
+    static inline TARGET_AVX2 uint16_t name(const WideBoard16 *board) { \
+        const wideVec16 rows = WIDE_ROWS_16; \
+        const wideVec16 masks = diagonal(wideVec16, W, H, rows); \
+        const __m256i both = _mm256_and_si256(WIDE_LOAD256(board->rows, 0), WIDE_LOAD256(&masks, 0)); \
+        __m128i x = _mm_or_si128(_mm256_castsi256_si128(both), _mm256_extracti128_si256(both, 1)); \
+        x = _mm_or_si128(x, _mm_srli_si128(x, 8)); \
+        x = _mm_or_si128(x, _mm_srli_si128(x, 4)); \
+        x = _mm_or_si128(x, _mm_srli_si128(x, 2)); \
+        return (uint16_t)_mm_cvtsi128_si32(x); \
+    }
+
+#define WIDE16_DEPOSIT_AVX2(name, W, H, diagonal) \
+    static inline TARGET_AVX2 void name(const uint16_t input, WideBoard16 *result) { \
+        const wideVec16 rows = WIDE_ROWS_16; \
+        const wideVec16 masks = diagonal(wideVec16, W, H, rows); \
+        WIDE_STORE256(result->rows, 0, _mm256_and_si256(_mm256_set1_epi16((short)input), WIDE_LOAD256(&masks, 0))); \
+    }
+
+// Same as the SSE transpose, with the low & high bytes in the 2 halves of a register: 1 'movemask' for both rows.
+// 'packus' works per 128 bits, so the halves are low & high of rows 0-7, then of 8-15, put in order by 'permute4x64'
+#define WIDE16_TRANSPOSE_AVX2(name, W, H) \
+    static inline TARGET_AVX2 void name(const WideBoard16 *board, WideBoard16 *result) { \
+        const wideVec16 rows = WIDE_ROWS_16; \
+        const wideVec16 masks = WIDE_BOARD_MASK(wideVec16, W, H, rows); \
+        const __m256i x = _mm256_and_si256(WIDE_LOAD256(board->rows, 0), WIDE_LOAD256(&masks, 0)); \
+        const __m256i packed = _mm256_packus_epi16(_mm256_and_si256(x, _mm256_set1_epi16(0xFF)), _mm256_srli_epi16(x, 8)); \
+        const __m256i bytes = _mm256_permute4x64_epi64(packed, _MM_SHUFFLE(3, 1, 2, 0)); \
+        for (int b=0; b < 8; b++) { \
+            const uint32_t both = (uint32_t)_mm256_movemask_epi8(_mm256_slli_epi64(bytes, 7 - b)); \
+            result->rows[b] = (uint16_t)both; \
+            result->rows[b + 8] = (uint16_t)(both >> 16); \
+        } \
+    }
+
+#define WIDE16_AVX2(name, W, H) \
+    WIDE16_SHIFT_AVX2_LEFT(name##_shift_bl_avx2, W, H, WIDE_FROM_BOTTOM) \
+    WIDE16_SHIFT_AVX2_LEFT(name##_shift_tl_avx2, W, H, WIDE_FROM_TOP) \
+    WIDE16_SHIFT_AVX2_RIGHT(name##_shift_br_avx2, W, H, WIDE_FROM_BOTTOM) \
+    WIDE16_SHIFT_AVX2_RIGHT(name##_shift_tr_avx2, W, H, WIDE_FROM_TOP) \
+    WIDE16_EXTRACT_AVX2(name##_extract_back_avx2, W, H, WIDE_BACK_DIAG) \
+    WIDE16_EXTRACT_AVX2(name##_extract_fwd_avx2, W, H, WIDE_FWD_DIAG) \
+    WIDE16_DEPOSIT_AVX2(name##_deposit_back_avx2, W, H, WIDE_BACK_DIAG) \
+    WIDE16_DEPOSIT_AVX2(name##_deposit_fwd_avx2, W, H, WIDE_FWD_DIAG) \
+    WIDE16_TRANSPOSE_AVX2(name##_transpose_avx2, W, H)
+
+#define WIDE32_SHIFT_AVX2(name, W, H, amount, shift, left) \
+    static inline TARGET_AVX2 void name(const WideBoard32 *board, WideBoard32 *result) { \
+        const wideVec32 rows = WIDE_ROWS_32; \
+        const wideVec32 amounts = WIDE_AMOUNTS(wideVec32, W, H, rows, amount); \
+        const wideVec32 masks = WIDE_SHIFT_MASKS(wideVec32, W, H, rows, amount); \
+        for (int i=0; i < 4; i++) { \
+            const __m256i x = WIDE_LOAD256(board->rows, i), mask = WIDE_LOAD256(&masks, i); \
+            WIDE_STORE256(result->rows, i, left? _mm256_and_si256(shift(x, WIDE_LOAD256(&amounts, i)), mask) \
+                : shift(_mm256_and_si256(x, mask), WIDE_LOAD256(&amounts, i))); \
+        } \
+    }
+
+#define WIDE32_EXTRACT_AVX2(name, W, H, diagonal) \
+    static inline TARGET_AVX2 uint32_t name(const WideBoard32 *board) { \
+        const wideVec32 rows = WIDE_ROWS_32; \
+        const wideVec32 masks = diagonal(wideVec32, W, H, rows); \
+        __m256i all = _mm256_setzero_si256(); \
+        for (int i=0; i < 4; i++) \
+            all = _mm256_or_si256(all, _mm256_and_si256(WIDE_LOAD256(board->rows, i), WIDE_LOAD256(&masks, i))); \
+        __m128i x = _mm_or_si128(_mm256_castsi256_si128(all), _mm256_extracti128_si256(all, 1)); \
+        x = _mm_or_si128(x, _mm_srli_si128(x, 8)); \
+        x = _mm_or_si128(x, _mm_srli_si128(x, 4)); \
+        return (uint32_t)_mm_cvtsi128_si32(x); \
+    }
+
+#define WIDE32_DEPOSIT_AVX2(name, W, H, diagonal) \
+    static inline TARGET_AVX2 void name(const uint32_t input, WideBoard32 *result) { \
+        const wideVec32 rows = WIDE_ROWS_32; \
+        const wideVec32 masks = diagonal(wideVec32, W, H, rows); \
+        const __m256i x = _mm256_set1_epi32((int)input); \
+        for (int i=0; i < 4; i++) \
+            WIDE_STORE256(result->rows, i, _mm256_and_si256(x, WIDE_LOAD256(&masks, i))); \
+    }
+
+#define WIDE32_AVX2(name, W, H) \
+    WIDE32_SHIFT_AVX2(name##_shift_bl_avx2, W, H, WIDE_FROM_BOTTOM, _mm256_sllv_epi32, 1) \
+    WIDE32_SHIFT_AVX2(name##_shift_tl_avx2, W, H, WIDE_FROM_TOP, _mm256_sllv_epi32, 1) \
+    WIDE32_SHIFT_AVX2(name##_shift_br_avx2, W, H, WIDE_FROM_BOTTOM, _mm256_srlv_epi32, 0) \
+    WIDE32_SHIFT_AVX2(name##_shift_tr_avx2, W, H, WIDE_FROM_TOP, _mm256_srlv_epi32, 0) \
+    WIDE32_EXTRACT_AVX2(name##_extract_back_avx2, W, H, WIDE_BACK_DIAG) \
+    WIDE32_EXTRACT_AVX2(name##_extract_fwd_avx2, W, H, WIDE_FWD_DIAG) \
+    WIDE32_DEPOSIT_AVX2(name##_deposit_back_avx2, W, H, WIDE_BACK_DIAG) \
+    WIDE32_DEPOSIT_AVX2(name##_deposit_fwd_avx2, W, H, WIDE_FWD_DIAG)
+#else
+#define WIDE16_AVX2(name, W, H)
+#define WIDE32_AVX2(name, W, H)
+#endif
+
+
+
+// ==================
+//      AVX-512
+// ==================
+// 16: 'vpsllvw' & 'vpsrlvw' shift every row by its own amount, no multiply (BW & VL on a 256-bit register).
+// Extracts: 'vptestmw' sets a mask bit per row holding its diagonal square, which is already by column for (\).
+// (/) is permuted first, lane 'c' taking the row of column 'c' ('W-1 - c'). Transpose: a 'vptestmw' per column.
+// 32: the same with 32-bit lanes, 16 rows per register
+#ifdef COMPILE_AVX512
+#define WIDE16_SHIFT_AVX512(name, W, H, amount, shift, left) \
+    static inline TARGET_AVX512 void name(const WideBoard16 *board, WideBoard16 *result) { \
+        const wideVec16 rows = WIDE_ROWS_16; \
+        const wideVec16 amounts = WIDE_AMOUNTS(wideVec16, W, H, rows, amount); \
+        const wideVec16 masks = WIDE_SHIFT_MASKS(wideVec16, W, H, rows, amount); \
+        const __m256i x = WIDE_LOAD256(board->rows, 0), mask = WIDE_LOAD256(&masks, 0); \
+        WIDE_STORE256(result->rows, 0, left? _mm256_and_si256(shift(x, WIDE_LOAD256(&amounts, 0)), mask) \
+            : shift(_mm256_and_si256(x, mask), WIDE_LOAD256(&amounts, 0))); \
+    }
+
+#define WIDE16_EXTRACT_BACK_AVX512(name, W, H) \
+    static inline TARGET_AVX512 uint16_t name(const WideBoard16 *board) { \
+        const wideVec16 rows = WIDE_ROWS_16; \
+        const wideVec16 masks = WIDE_BACK_DIAG(wideVec16, W, H, rows); \
+        return _mm256_test_epi16_mask(WIDE_LOAD256(board->rows, 0), WIDE_LOAD256(&masks, 0)); \
+    }
+
+// Lane 'c' is row 'W-1 - c', its square of (/) is column 'c', so the mask is the same as (\) (of the rows on the board)
+#define WIDE16_EXTRACT_FWD_AVX512(name, W, H) \
+    static inline TARGET_AVX512 uint16_t name(const WideBoard16 *board) { \
+        const wideVec16 columns = WIDE_ROWS_16; \
+        const wideVec16 onBoard = (wideVec16)(columns < (W)) & (wideVec16)((W) - 1 - columns < (H)); \
+        const wideVec16 fromRows = ((W) - 1 - columns) & onBoard; \
+        const wideVec16 masks = onBoard & ((wideVec16){0} + 1) << columns; \
+        const __m256i permuted = _mm256_permutexvar_epi16(WIDE_LOAD256(&fromRows, 0), WIDE_LOAD256(board->rows, 0)); \
+        return _mm256_test_epi16_mask(permuted, WIDE_LOAD256(&masks, 0)); \
+    }
+
+#define WIDE16_TRANSPOSE_AVX512(name, W, H) \
+    static inline TARGET_AVX512 void name(const WideBoard16 *board, WideBoard16 *result) { \
+        const wideVec16 rows = WIDE_ROWS_16; \
+        const wideVec16 masks = WIDE_BOARD_MASK(wideVec16, W, H, rows); \
+        const __m256i x = _mm256_and_si256(WIDE_LOAD256(board->rows, 0), WIDE_LOAD256(&masks, 0)); \
+        *result = (WideBoard16){{0}}; \
+        for (int c=0; c < (W); c++) \
+            result->rows[c] = _mm256_test_epi16_mask(x, _mm256_set1_epi16((short)(1u << c))); \
+    }
+
+#define WIDE16_AVX512(name, W, H) \
+    WIDE16_SHIFT_AVX512(name##_shift_bl_avx512, W, H, WIDE_FROM_BOTTOM, _mm256_sllv_epi16, 1) \
+    WIDE16_SHIFT_AVX512(name##_shift_tl_avx512, W, H, WIDE_FROM_TOP, _mm256_sllv_epi16, 1) \
+    WIDE16_SHIFT_AVX512(name##_shift_br_avx512, W, H, WIDE_FROM_BOTTOM, _mm256_srlv_epi16, 0) \
+    WIDE16_SHIFT_AVX512(name##_shift_tr_avx512, W, H, WIDE_FROM_TOP, _mm256_srlv_epi16, 0) \
+    WIDE16_EXTRACT_BACK_AVX512(name##_extract_back_avx512, W, H) \
+    WIDE16_EXTRACT_FWD_AVX512(name##_extract_fwd_avx512, W, H) \
+    WIDE16_TRANSPOSE_AVX512(name##_transpose_avx512, W, H)
+
+#define WIDE32_SHIFT_AVX512(name, W, H, amount, shift, left) \
+    static inline TARGET_AVX512 void name(const WideBoard32 *board, WideBoard32 *result) { \
+        const wideVec32 rows = WIDE_ROWS_32; \
+        const wideVec32 amounts = WIDE_AMOUNTS(wideVec32, W, H, rows, amount); \
+        const wideVec32 masks = WIDE_SHIFT_MASKS(wideVec32, W, H, rows, amount); \
+        for (int i=0; i < 2; i++) { \
+            const __m512i x = WIDE_LOAD512(board->rows, i), mask = WIDE_LOAD512(&masks, i); \
+            WIDE_STORE512(result->rows, i, left? _mm512_and_si512(shift(x, WIDE_LOAD512(&amounts, i)), mask) \
+                : shift(_mm512_and_si512(x, mask), WIDE_LOAD512(&amounts, i))); \
+        } \
+    }
+
+#define WIDE32_EXTRACT_BACK_AVX512(name, W, H) \
+    static inline TARGET_AVX512 uint32_t name(const WideBoard32 *board) { \
+        const wideVec32 rows = WIDE_ROWS_32; \
+        const wideVec32 masks = WIDE_BACK_DIAG(wideVec32, W, H, rows); \
+        return _mm512_test_epi32_mask(WIDE_LOAD512(board->rows, 0), WIDE_LOAD512(&masks, 0)) \
+            | (uint32_t)_mm512_test_epi32_mask(WIDE_LOAD512(board->rows, 1), WIDE_LOAD512(&masks, 1)) << 16; \
+    }
+
+// 'vpermt2d' picks from both registers, index bit 4 is the register
+#define WIDE32_EXTRACT_FWD_AVX512(name, W, H) \
+    static inline TARGET_AVX512 uint32_t name(const WideBoard32 *board) { \
+        const wideVec32 columns = WIDE_ROWS_32; \
+        const wideVec32 onBoard = (wideVec32)(columns < (W)) & (wideVec32)((W) - 1 - columns < (H)); \
+        const wideVec32 fromRows = ((W) - 1 - columns) & onBoard; \
+        const wideVec32 masks = onBoard & ((wideVec32){0} + 1) << columns; \
+        const __m512i lower = WIDE_LOAD512(board->rows, 0), upper = WIDE_LOAD512(board->rows, 1); \
+        uint32_t result = 0; \
+        for (int i=0; i < 2; i++) \
+            result |= (uint32_t)_mm512_test_epi32_mask(_mm512_permutex2var_epi32(lower, WIDE_LOAD512(&fromRows, i), upper), WIDE_LOAD512(&masks, i)) << 16*i; \
+        return result; \
+    }
+
+#define WIDE32_TRANSPOSE_AVX512(name, W, H) \
+    static inline TARGET_AVX512 void name(const WideBoard32 *board, WideBoard32 *result) { \
+        const wideVec32 rows = WIDE_ROWS_32; \
+        const wideVec32 masks = WIDE_BOARD_MASK(wideVec32, W, H, rows); \
+        const __m512i lower = _mm512_and_si512(WIDE_LOAD512(board->rows, 0), WIDE_LOAD512(&masks, 0)); \
+        const __m512i upper = _mm512_and_si512(WIDE_LOAD512(board->rows, 1), WIDE_LOAD512(&masks, 1)); \
+        *result = (WideBoard32){{0}}; \
+        for (int c=0; c < (W); c++) { \
+            const __m512i bit = _mm512_set1_epi32((int)(1u << c)); \
+            result->rows[c] = _mm512_test_epi32_mask(lower, bit) | (uint32_t)_mm512_test_epi32_mask(upper, bit) << 16; \
+        } \
+    }
+
+#define WIDE32_AVX512(name, W, H) \
+    WIDE32_SHIFT_AVX512(name##_shift_bl_avx512, W, H, WIDE_FROM_BOTTOM, _mm512_sllv_epi32, 1) \
+    WIDE32_SHIFT_AVX512(name##_shift_tl_avx512, W, H, WIDE_FROM_TOP, _mm512_sllv_epi32, 1) \
+    WIDE32_SHIFT_AVX512(name##_shift_br_avx512, W, H, WIDE_FROM_BOTTOM, _mm512_srlv_epi32, 0) \
+    WIDE32_SHIFT_AVX512(name##_shift_tr_avx512, W, H, WIDE_FROM_TOP, _mm512_srlv_epi32, 0) \
+    WIDE32_EXTRACT_BACK_AVX512(name##_extract_back_avx512, W, H) \
+    WIDE32_EXTRACT_FWD_AVX512(name##_extract_fwd_avx512, W, H) \
+    WIDE32_TRANSPOSE_AVX512(name##_transpose_avx512, W, H)
+#else
+#define WIDE16_AVX512(name, W, H)
+#define WIDE32_AVX512(name, W, H)
+#endif
+
+
+
+// ==================
+//      Defaults
+// ==================
+// The fastest method of each operation for the target: the AVX-512 variable shifts, extracts & transpose,
+// otherwise the AVX2 or SSE multiplies. The deposits are a broadcast & mask, which the compiler widens by itself for '_vec'
+// (and 2 SSE 'and's are as fast as 1 with AVX2)
+#define WIDE_METHOD(name, op, method)   WIDE_METHOD_(name, op, method)
+#define WIDE_METHOD_(name, op, method)  name##_##op##_##method
+
+#if defined(DIAG_PORTABLE)
+    #define WIDE16_SHIFTS   vec
+    #define WIDE16_EXTRACTS vec
+    #define WIDE16_DEPOSITS vec
+    #define WIDE32_SHIFTS   vec
+    #define WIDE32_EXTRACTS vec
+    #define WIDE32_DEPOSITS vec
+#elif defined(CPU_HAS_AVX512)
+    #define WIDE16_SHIFTS   avx512
+    #define WIDE16_EXTRACTS avx512
+    #define WIDE16_DEPOSITS sse
+    #define WIDE32_SHIFTS   avx512
+    #define WIDE32_EXTRACTS avx512
+    #define WIDE32_DEPOSITS vec
+#elif defined(CPU_HAS_AVX2)
+    #define WIDE16_SHIFTS   avx2
+    #define WIDE16_EXTRACTS avx2
+    #define WIDE16_DEPOSITS avx2
+    #define WIDE32_SHIFTS   avx2
+    #define WIDE32_EXTRACTS avx2
+    #define WIDE32_DEPOSITS avx2
+#else
+    #define WIDE16_SHIFTS   sse
+    #define WIDE16_EXTRACTS sse
+    #define WIDE16_DEPOSITS sse
+    #define WIDE32_SHIFTS   vec
+    #define WIDE32_EXTRACTS vec
+    #define WIDE32_DEPOSITS vec
+#endif
+// There's no AVX2 transpose of 32-bit rows
+#define WIDE16_TRANSPOSES   WIDE16_EXTRACTS
+#if defined(CPU_HAS_AVX512) && !defined(DIAG_PORTABLE)
+    #define WIDE32_TRANSPOSES avx512
+#else
+    #define WIDE32_TRANSPOSES vec
+#endif
+
+#define WIDE_DEFAULTS(name, Board, Row, size) \
+    DIAG_INLINE void name##_shift_bl(const Board *board, Board *result) { WIDE_METHOD(name, shift_bl, WIDE##size##_SHIFTS)(board, result); } \
+    DIAG_INLINE void name##_shift_tl(const Board *board, Board *result) { WIDE_METHOD(name, shift_tl, WIDE##size##_SHIFTS)(board, result); } \
+    DIAG_INLINE void name##_shift_br(const Board *board, Board *result) { WIDE_METHOD(name, shift_br, WIDE##size##_SHIFTS)(board, result); } \
+    DIAG_INLINE void name##_shift_tr(const Board *board, Board *result) { WIDE_METHOD(name, shift_tr, WIDE##size##_SHIFTS)(board, result); } \
+    DIAG_INLINE Row name##_extract_back(const Board *board) { return WIDE_METHOD(name, extract_back, WIDE##size##_EXTRACTS)(board); } \
+    DIAG_INLINE Row name##_extract_fwd(const Board *board) { return WIDE_METHOD(name, extract_fwd, WIDE##size##_EXTRACTS)(board); } \
+    DIAG_INLINE void name##_deposit_back(const Row input, Board *result) { WIDE_METHOD(name, deposit_back, WIDE##size##_DEPOSITS)(input, result); } \
+    DIAG_INLINE void name##_deposit_fwd(const Row input, Board *result) { WIDE_METHOD(name, deposit_fwd, WIDE##size##_DEPOSITS)(input, result); } \
+    DIAG_INLINE void name##_transpose(const Board *board, Board *result) { WIDE_METHOD(name, transpose, WIDE##size##_TRANSPOSES)(board, result); }
+
+
+// Every method & the defaults of a W x H board: 'name_shift_bl' (tl, br, tr), 'name_extract_back' (fwd),
+// 'name_deposit_back' (fwd) & 'name_transpose' (to H x W), each also as '_sse', '_avx2', '_avx512' & '_vec'.
+// W & H up to 16
+#define WIDE_BOARD16(name, W, H) \
+    WIDE_VEC(name, WideBoard16, uint16_t, wideVec16, WIDE_ROWS_16, W, H) \
+    WIDE16_SSE(name, W, H) \
+    WIDE16_AVX2(name, W, H) \
+    WIDE16_AVX512(name, W, H) \
+    WIDE_DEFAULTS(name, WideBoard16, uint16_t, 16)
+
+// The same up to 32 columns & rows, without '_sse' (nor an AVX2 transpose, or AVX-512 deposits)
+#define WIDE_BOARD32(name, W, H) \
+    WIDE_VEC(name, WideBoard32, uint32_t, wideVec32, WIDE_ROWS_32, W, H) \
+    WIDE32_AVX2(name, W, H) \
+    WIDE32_AVX512(name, W, H) \
+    WIDE_DEFAULTS(name, WideBoard32, uint32_t, 32)
+
+#endif
+
+#endif